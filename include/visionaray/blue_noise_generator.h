@@ -0,0 +1,103 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_BLUE_NOISE_GENERATOR_H
+#define VSNRAY_BLUE_NOISE_GENERATOR_H 1
+
+#include <type_traits>
+
+#include "detail/blue_noise_tile.h"
+#include "detail/low_discrepancy.h"
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+#include "sobol_generator.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Blue-noise generator
+//
+// Sobol sequence that is shifted (Cranley-Patterson rotation) by the value of a tiled
+// blue-noise mask at the pixel position. All pixels use the same scrambling, so in each
+// sample, the error is distributed as blue noise in screen space, while the samples of
+// each pixel retain the stratification of the Sobol sequence.
+//
+// Each dimension uses a differently shifted copy of the tile. The seed is not used.
+//
+
+template <typename T, typename = void>
+class blue_noise_generator
+{
+public:
+
+    using value_type = T;
+
+public:
+
+    blue_noise_generator() = default;
+
+    VSNRAY_FUNC blue_noise_generator(int x, int y, unsigned first_sample = 0)
+        : sobol_(0, first_sample)
+        , x_(x)
+        , y_(y)
+    {
+    }
+
+    // Pixel sampler interface
+    VSNRAY_FUNC blue_noise_generator(unsigned seed, int x, int y, unsigned first_sample)
+        : blue_noise_generator(x, y, first_sample)
+    {
+        VSNRAY_UNUSED(seed);
+    }
+
+    VSNRAY_FUNC void begin_sample(unsigned sample)
+    {
+        sobol_.begin_sample(sample);
+        dim_ = 0;
+    }
+
+    VSNRAY_FUNC T next()
+    {
+        return T(next_uint() >> 8) * T(1.0f / 16777216.0f);
+    }
+
+    VSNRAY_FUNC unsigned next_uint()
+    {
+        unsigned h = detail::ld_hash(dim_++);
+
+        int tx = x_ + static_cast<int>(h & 0x3F);
+        int ty = y_ + static_cast<int>((h >> 6) & 0x3F);
+
+        // Rank in [0..4096) to 32-bit fixed point, centered in the rank's interval
+        unsigned shift = (detail::blue_noise_rank(tx, ty) << 20) | 0x80000u;
+
+        // Fixed point addition wraps around, i.e. computes the shift modulo 1
+        return sobol_.next_uint() + shift;
+    }
+
+private:
+
+    sobol_generator<float> sobol_;
+
+    int x_ = 0;
+    int y_ = 0;
+    unsigned dim_ = 0;
+
+};
+
+template <typename T>
+class blue_noise_generator<T, typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+    : public detail::simd_low_discrepancy_generator<T, blue_noise_generator<float>>
+{
+public:
+
+    using detail::simd_low_discrepancy_generator<T, blue_noise_generator<float>>::simd_low_discrepancy_generator;
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_BLUE_NOISE_GENERATOR_H
@@ -6,8 +6,11 @@
 #ifndef VSNRAY_BVH_H
 #define VSNRAY_BVH_H 1
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <type_traits>
 
 #ifdef __CUDACC__
@@ -139,21 +142,464 @@ inline bool operator==(bvh_node const& a, bvh_node const& b)
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// bvh_wide_node
+//
+// Collapsed node with up to N children. Child bounds are stored in SoA layout so that
+// all child boxes can be tested against a single ray with one N-wide SIMD slab test.
+// Each child slot is either empty, an inner node (index into the node array), or a
+// leaf (range of primitives). Non-empty slots precede empty ones.
+//
+
+template <unsigned N>
+struct VSNRAY_ALIGN(32) bvh_wide_node
+{
+    enum { Width = N };
+
+    float min_x[N];
+    float min_y[N];
+    float min_z[N];
+    float max_x[N];
+    float max_y[N];
+    float max_z[N];
+
+    // Index of child node (inner) or first primitive (leaf), ~0U for empty slots
+    unsigned child[N];
+
+    // Number of primitives (leaf) or 0 (inner and empty slots)
+    unsigned num_prims[N];
+
+    VSNRAY_FUNC bool is_empty(unsigned i) const { return child[i] == ~0U; }
+    VSNRAY_FUNC bool is_inner(unsigned i) const { return num_prims[i] == 0 && child[i] != ~0U; }
+    VSNRAY_FUNC bool is_leaf(unsigned i) const { return num_prims[i] != 0; }
+
+    VSNRAY_FUNC aabb get_bounds(unsigned i) const
+    {
+        return aabb(
+                vec3(min_x[i], min_y[i], min_z[i]),
+                vec3(max_x[i], max_y[i], max_z[i])
+                );
+    }
+
+    // Union of the bounds of all non-empty child slots
+    VSNRAY_FUNC aabb get_bounds() const
+    {
+        aabb result;
+        result.invalidate();
+
+        for (unsigned i = 0; i < N && !is_empty(i); ++i)
+        {
+            result = combine(result, get_bounds(i));
+        }
+
+        return result;
+    }
+
+    VSNRAY_FUNC unsigned get_child(unsigned i) const
+    {
+        assert(is_inner(i));
+        return child[i];
+    }
+
+    VSNRAY_FUNC bvh_node::index_range get_indices(unsigned i) const
+    {
+        assert(is_leaf(i));
+        return { child[i], child[i] + num_prims[i] };
+    }
+
+    VSNRAY_FUNC unsigned get_num_children() const
+    {
+        unsigned result = 0;
+
+        while (result < N && !is_empty(result))
+        {
+            ++result;
+        }
+
+        return result;
+    }
+
+    VSNRAY_FUNC void set_inner(unsigned i, aabb const& bounds, unsigned child_index)
+    {
+        set_bounds(i, bounds);
+        child[i] = child_index;
+        num_prims[i] = 0;
+    }
+
+    VSNRAY_FUNC void set_leaf(unsigned i, aabb const& bounds, unsigned first_primitive_index, unsigned count)
+    {
+        assert(count > 0);
+
+        set_bounds(i, bounds);
+        child[i] = first_primitive_index;
+        num_prims[i] = count;
+    }
+
+    VSNRAY_FUNC void set_empty(unsigned i)
+    {
+        // Degenerate box, empty slots are never traversed
+        set_bounds(i, aabb(vec3(0.0f), vec3(0.0f)));
+        child[i] = ~0U;
+        num_prims[i] = 0;
+    }
+
+private:
+
+    VSNRAY_FUNC void set_bounds(unsigned i, aabb const& bounds)
+    {
+        min_x[i] = bounds.min.x;
+        min_y[i] = bounds.min.y;
+        min_z[i] = bounds.min.z;
+        max_x[i] = bounds.max.x;
+        max_y[i] = bounds.max.y;
+        max_z[i] = bounds.max.z;
+    }
+};
+
+using bvh4_node = bvh_wide_node<4>;
+using bvh8_node = bvh_wide_node<8>;
+
+static_assert( sizeof(bvh4_node) == 128, "Size mismatch" );
+static_assert( sizeof(bvh8_node) == 256, "Size mismatch" );
+
+
+//--------------------------------------------------------------------------------------------------
+// bvh_quantized_node
+//
+// Compressed wide node with up to N children. Child bounds are stored with 8 bits per plane
+// relative to a local grid: plane q on axis a lies at origin[a] + q * 2^exponent[a]. The
+// grid spans the union of the child bounds. Quantization rounds outwards, so the decoded
+// child boxes are conservative. With N = 8, a node takes half the memory of a bvh8_node.
+//
+// The grid must be set with set_grid() before child slots are set.
+//
+
+template <unsigned N>
+struct VSNRAY_ALIGN(32) bvh_quantized_node
+{
+    enum { Width = N };
+
+    float origin[3];
+    signed char exponent[3];
+    unsigned char padding;
+
+    unsigned char qmin_x[N];
+    unsigned char qmin_y[N];
+    unsigned char qmin_z[N];
+    unsigned char qmax_x[N];
+    unsigned char qmax_y[N];
+    unsigned char qmax_z[N];
+
+    // Index of child node (inner) or first primitive (leaf), ~0U for empty slots
+    unsigned child[N];
+
+    // Number of primitives (leaf) or 0 (inner and empty slots)
+    unsigned num_prims[N];
+
+    VSNRAY_FUNC bool is_empty(unsigned i) const { return child[i] == ~0U; }
+    VSNRAY_FUNC bool is_inner(unsigned i) const { return num_prims[i] == 0 && child[i] != ~0U; }
+    VSNRAY_FUNC bool is_leaf(unsigned i) const { return num_prims[i] != 0; }
+
+    // Grid spacing along each axis
+    VSNRAY_FUNC vec3 get_scale() const
+    {
+        return vec3(exp2i(exponent[0]), exp2i(exponent[1]), exp2i(exponent[2]));
+    }
+
+    VSNRAY_FUNC aabb get_bounds(unsigned i) const
+    {
+        vec3 o(origin[0], origin[1], origin[2]);
+        vec3 s = get_scale();
+
+        return aabb(
+                o + vec3(qmin_x[i], qmin_y[i], qmin_z[i]) * s,
+                o + vec3(qmax_x[i], qmax_y[i], qmax_z[i]) * s
+                );
+    }
+
+    // Union of the (decoded) bounds of all non-empty child slots
+    VSNRAY_FUNC aabb get_bounds() const
+    {
+        aabb result;
+        result.invalidate();
+
+        for (unsigned i = 0; i < N && !is_empty(i); ++i)
+        {
+            result = combine(result, get_bounds(i));
+        }
+
+        return result;
+    }
+
+    VSNRAY_FUNC unsigned get_child(unsigned i) const
+    {
+        assert(is_inner(i));
+        return child[i];
+    }
+
+    VSNRAY_FUNC bvh_node::index_range get_indices(unsigned i) const
+    {
+        assert(is_leaf(i));
+        return { child[i], child[i] + num_prims[i] };
+    }
+
+    VSNRAY_FUNC unsigned get_num_children() const
+    {
+        unsigned result = 0;
+
+        while (result < N && !is_empty(result))
+        {
+            ++result;
+        }
+
+        return result;
+    }
+
+    // Choose the grid so that 255 cells cover bounds
+    void set_grid(aabb const& bounds)
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            float extent = bounds.max[a] - bounds.min[a];
+
+            int e = -126;
+
+            if (extent > 0.0f)
+            {
+                std::frexp(extent / 255.0f, &e);
+                e = std::max(e - 1, -126);
+            }
+
+            // Rounding of origin + 255 * scale
+            while (e < 127 && bounds.min[a] + 255.0f * exp2i(e) < bounds.max[a])
+            {
+                ++e;
+            }
+
+            origin[a] = bounds.min[a];
+            exponent[a] = static_cast<signed char>(e);
+        }
+
+        padding = 0;
+    }
+
+    void set_inner(unsigned i, aabb const& bounds, unsigned child_index)
+    {
+        set_bounds(i, bounds);
+        child[i] = child_index;
+        num_prims[i] = 0;
+    }
+
+    void set_leaf(unsigned i, aabb const& bounds, unsigned first_primitive_index, unsigned count)
+    {
+        assert(count > 0);
+
+        set_bounds(i, bounds);
+        child[i] = first_primitive_index;
+        num_prims[i] = count;
+    }
+
+    VSNRAY_FUNC void set_empty(unsigned i)
+    {
+        // Degenerate box, empty slots are never traversed
+        qmin_x[i] = qmin_y[i] = qmin_z[i] = 0;
+        qmax_x[i] = qmax_y[i] = qmax_z[i] = 0;
+        child[i] = ~0U;
+        num_prims[i] = 0;
+    }
+
+private:
+
+    // 2^e for e in [-126..127]
+    VSNRAY_FUNC static float exp2i(int e)
+    {
+        unsigned bits = static_cast<unsigned>(e + 127) << 23;
+        float result;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    // Round outwards, then correct for rounding in the decoding
+    void set_bounds(unsigned i, aabb const& bounds)
+    {
+        unsigned char* qmin[] = { qmin_x, qmin_y, qmin_z };
+        unsigned char* qmax[] = { qmax_x, qmax_y, qmax_z };
+
+        for (int a = 0; a < 3; ++a)
+        {
+            float s = exp2i(exponent[a]);
+
+            auto decode = [&](int q) { return origin[a] + static_cast<float>(q) * s; };
+
+            int lo = static_cast<int>(std::floor((bounds.min[a] - origin[a]) / s));
+            int hi = static_cast<int>(std::ceil((bounds.max[a] - origin[a]) / s));
+
+            lo = std::min(std::max(lo, 0), 255);
+            hi = std::min(std::max(hi, 0), 255);
+
+            while (lo > 0 && decode(lo) > bounds.min[a])
+            {
+                --lo;
+            }
+
+            while (hi < 255 && decode(hi) < bounds.max[a])
+            {
+                ++hi;
+            }
+
+            qmin[a][i] = static_cast<unsigned char>(lo);
+            qmax[a][i] = static_cast<unsigned char>(hi);
+        }
+    }
+};
+
+using bvh4q_node = bvh_quantized_node<4>;
+using bvh8q_node = bvh_quantized_node<8>;
+
+static_assert( sizeof(bvh4q_node) == 96, "Size mismatch" );
+static_assert( sizeof(bvh8q_node) == 128, "Size mismatch" );
+
+
+//--------------------------------------------------------------------------------------------------
+// bvh_motion_node
+//
+// Binary node that stores its bounds at K keyframes evenly spaced over the shutter
+// interval (multi-segment motion BVH). The bounds at keyframe k contain the bounds of
+// the subtree's primitives at keyframe k. Primitives move linearly between keyframes,
+// so the bounds linearly interpolated for a ray's time sample contain them as well.
+//
+
+template <unsigned K>
+struct VSNRAY_ALIGN(32) bvh_motion_node
+{
+    enum { Keyframes = K };
+
+    aabb bbox[K];
+    union
+    {
+        unsigned first_child;
+        unsigned first_prim;
+    };
+    unsigned num_prims;
+
+    VSNRAY_FUNC bool is_inner() const { return num_prims == 0; }
+    VSNRAY_FUNC bool is_leaf() const { return num_prims != 0; }
+
+    // Bounds at keyframe k
+    VSNRAY_FUNC aabb const& get_bounds(unsigned k) const
+    {
+        return bbox[k];
+    }
+
+    // Bounds over the whole shutter interval
+    VSNRAY_FUNC aabb get_bounds() const
+    {
+        aabb result = bbox[0];
+
+        for (unsigned k = 1; k < K; ++k)
+        {
+            result = combine(result, bbox[k]);
+        }
+
+        return result;
+    }
+
+    // Bounds interpolated for time, SIMD lanes interpolate for their own time sample
+    template <typename T>
+    VSNRAY_FUNC basic_aabb<T> get_bounds_at(T const& time) const
+    {
+        using V = vector<3, T>;
+
+        return basic_aabb<T>(
+                lerp_keyframes<K, V>([&](unsigned k) { return bbox[k].min; }, time),
+                lerp_keyframes<K, V>([&](unsigned k) { return bbox[k].max; }, time)
+                );
+    }
+
+    VSNRAY_FUNC unsigned get_child(unsigned i = 0) const
+    {
+        assert(is_inner());
+        return first_child + i;
+    }
+
+    VSNRAY_FUNC bvh_node::index_range get_indices() const
+    {
+        assert(is_leaf());
+        return { first_prim, first_prim + num_prims };
+    }
+
+    VSNRAY_FUNC unsigned get_first_primitive() const
+    {
+        assert(is_leaf());
+        return first_prim;
+    }
+
+    VSNRAY_FUNC unsigned get_num_primitives() const
+    {
+        assert(is_leaf());
+        return num_prims;
+    }
+
+    VSNRAY_FUNC void set_inner(aabb const* bounds, unsigned first_child_index)
+    {
+        set_bounds(bounds);
+        first_child = first_child_index;
+        num_prims = 0;
+    }
+
+    VSNRAY_FUNC void set_leaf(aabb const* bounds, unsigned first_primitive_index, unsigned count)
+    {
+        assert(count > 0);
+
+        set_bounds(bounds);
+        first_prim = first_primitive_index;
+        num_prims = count;
+    }
+
+private:
+
+    VSNRAY_FUNC void set_bounds(aabb const* bounds)
+    {
+        for (unsigned k = 0; k < K; ++k)
+        {
+            bbox[k] = bounds[k];
+        }
+    }
+};
+
+static_assert( sizeof(bvh_motion_node<2>) == 64, "Size mismatch" );
+
+template <unsigned K>
+VSNRAY_FUNC
+inline bool is_inner(bvh_motion_node<K> const& node)
+{
+    return node.is_inner();
+}
+
+template <unsigned K>
+VSNRAY_FUNC
+inline bool is_leaf(bvh_motion_node<K> const& node)
+{
+    return node.is_leaf();
+}
+
+
 //--------------------------------------------------------------------------------------------------
 // [index_]bvh_ref_t
 //
 
-template <typename PrimitiveType>
+template <typename PrimitiveType, typename NodeType = bvh_node>
 class bvh_ref_t
 {
 public:
 
     using primitive_type = PrimitiveType;
+    using node_type      = NodeType;
 
 private:
 
     using P = const PrimitiveType;
-    using N = const bvh_node;
+    using N = const NodeType;
 
     P* primitives_first;
     P* primitives_last;
@@ -194,17 +640,18 @@ public:
     }
 };
 
-template <typename PrimitiveType>
+template <typename PrimitiveType, typename NodeType = bvh_node>
 class index_bvh_ref_t
 {
 public:
 
     using primitive_type = PrimitiveType;
+    using node_type      = NodeType;
 
 private:
 
     using P = const PrimitiveType;
-    using N = const bvh_node;
+    using N = const NodeType;
     using I = const unsigned;
 
     P* primitives_first;
@@ -258,23 +705,24 @@ public:
 // [index_]bvh_inst_t
 //
 
-template <typename PrimitiveType>
+template <typename PrimitiveType, typename NodeType = bvh_node>
 class bvh_inst_t
 {
 public:
 
     using primitive_type = PrimitiveType;
+    using node_type      = NodeType;
 
 private:
 
     using P = const PrimitiveType;
-    using N = const bvh_node;
+    using N = const NodeType;
 
 public:
 
     bvh_inst_t() = default;
 
-    bvh_inst_t(bvh_ref_t<PrimitiveType> const& ref, mat4x3 const& transform)
+    bvh_inst_t(bvh_ref_t<PrimitiveType, NodeType> const& ref, mat4x3 const& transform)
         : ref_(ref)
         , affine_inv_(inverse(top_left(transform)))
         , trans_inv_(-transform(3))
@@ -301,7 +749,7 @@ public:
         return ref_.node(index);
     }
 
-    VSNRAY_FUNC bvh_ref_t<PrimitiveType> get_ref() const
+    VSNRAY_FUNC bvh_ref_t<PrimitiveType, NodeType> get_ref() const
     {
         return ref_;
     }
@@ -327,14 +775,14 @@ public:
         using T = typename Ray::scalar_type;
 
         matrix<3, 3, T> aff_inv(affine_inv_);
-        r.ori = aff_inv * r.ori + vector<3, T>(trans_inv_);
+        r.ori = aff_inv * (r.ori + vector<3, T>(trans_inv_));
         r.dir = aff_inv * r.dir;
     }
 
 private:
 
     // BVH ref
-    bvh_ref_t<PrimitiveType> ref_;
+    bvh_ref_t<PrimitiveType, NodeType> ref_;
 
     // Inverse affine transformation matrix
     mat3 affine_inv_;
@@ -344,23 +792,24 @@ private:
 
 };
 
-template <typename PrimitiveType>
+template <typename PrimitiveType, typename NodeType = bvh_node>
 class index_bvh_inst_t
 {
 public:
 
     using primitive_type = PrimitiveType;
+    using node_type      = NodeType;
 
 private:
 
     using P = const PrimitiveType;
-    using N = const bvh_node;
+    using N = const NodeType;
 
 public:
 
     index_bvh_inst_t() = default;
 
-    index_bvh_inst_t(index_bvh_ref_t<PrimitiveType> const& ref, mat4x3 const& transform)
+    index_bvh_inst_t(index_bvh_ref_t<PrimitiveType, NodeType> const& ref, mat4x3 const& transform)
         : ref_(ref)
         , affine_inv_(inverse(top_left(transform)))
         , trans_inv_(-transform(3))
@@ -392,7 +841,7 @@ public:
         return ref_.node(index);
     }
 
-    VSNRAY_FUNC index_bvh_ref_t<PrimitiveType> get_ref() const
+    VSNRAY_FUNC index_bvh_ref_t<PrimitiveType, NodeType> get_ref() const
     {
         return ref_;
     }
@@ -425,7 +874,7 @@ public:
 private:
 
     // BVH ref
-    index_bvh_ref_t<PrimitiveType> ref_;
+    index_bvh_ref_t<PrimitiveType, NodeType> ref_;
 
     // Inverse affine transformation matrix
     mat3 affine_inv_;
@@ -435,6 +884,138 @@ private:
 };
 
 
+//--------------------------------------------------------------------------------------------------
+// bvh_motion_inst_t
+//
+// Instance of a [index_]bvh with K transforms evenly spaced over the shutter interval.
+// Rays are transformed with the transform linearly interpolated for their time sample.
+//
+
+template <typename BVHRef, unsigned K>
+class bvh_motion_inst_t
+{
+public:
+
+    using primitive_type = typename BVHRef::primitive_type;
+    using node_type      = typename BVHRef::node_type;
+
+    enum { Keyframes = K };
+
+private:
+
+    using P = const primitive_type;
+    using N = const node_type;
+
+public:
+
+    bvh_motion_inst_t() = default;
+
+    // Instance with K transforms, one per keyframe
+    bvh_motion_inst_t(BVHRef const& ref, mat4x3 const* transforms)
+        : ref_(ref)
+    {
+        for (unsigned k = 0; k < K; ++k)
+        {
+            affine_[k] = top_left(transforms[k]);
+            trans_[k] = transforms[k](3);
+        }
+    }
+
+    VSNRAY_FUNC size_t num_primitives() const
+    {
+        return ref_.num_primitives();
+    }
+
+    VSNRAY_FUNC size_t num_nodes() const
+    {
+        return ref_.num_nodes();
+    }
+
+    VSNRAY_FUNC size_t num_indices() const
+    {
+        return ref_.num_indices();
+    }
+
+    VSNRAY_FUNC P& primitive(size_t index) const
+    {
+        return ref_.primitive(index);
+    }
+
+    VSNRAY_FUNC N& node(size_t index) const
+    {
+        return ref_.node(index);
+    }
+
+    VSNRAY_FUNC BVHRef get_ref() const
+    {
+        return ref_;
+    }
+
+    // Affine transformation matrix at keyframe k
+    VSNRAY_FUNC mat3 const& affine(unsigned k) const
+    {
+        return affine_[k];
+    }
+
+    // Translation at keyframe k
+    VSNRAY_FUNC vec3 const& trans(unsigned k) const
+    {
+        return trans_[k];
+    }
+
+    VSNRAY_FUNC bool operator==(bvh_motion_inst_t const& rhs) const
+    {
+        if (!(ref_ == rhs.ref_))
+        {
+            return false;
+        }
+
+        for (unsigned k = 0; k < K; ++k)
+        {
+            if (affine_[k] != rhs.affine_[k] || trans_[k] != rhs.trans_[k])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename Ray>
+    VSNRAY_FUNC void transform_ray(Ray& r) const
+    {
+        using T = typename Ray::scalar_type;
+        using V = vector<3, T>;
+
+        T time = get_time(r);
+
+        matrix<3, 3, T> affine(
+                lerp_keyframes<K, V>([&](unsigned k) { return affine_[k].col0; }, time),
+                lerp_keyframes<K, V>([&](unsigned k) { return affine_[k].col1; }, time),
+                lerp_keyframes<K, V>([&](unsigned k) { return affine_[k].col2; }, time)
+                );
+
+        V trans = lerp_keyframes<K, V>([&](unsigned k) { return trans_[k]; }, time);
+
+        matrix<3, 3, T> aff_inv = inverse(affine);
+        r.ori = aff_inv * (r.ori - trans);
+        r.dir = aff_inv * r.dir;
+    }
+
+private:
+
+    // BVH ref
+    BVHRef ref_;
+
+    // Affine transformation matrices at the keyframes
+    mat3 affine_[K];
+
+    // Translations at the keyframes
+    vec3 trans_[K];
+
+};
+
+
 //--------------------------------------------------------------------------------------------------
 // [index_]bvh_t
 //
@@ -449,8 +1030,11 @@ public:
     using node_type         = typename NodeVector::value_type;
     using node_vector       = NodeVector;
 
-    using bvh_ref  = bvh_ref_t<primitive_type>;
-    using bvh_inst = bvh_inst_t<primitive_type>;
+    using bvh_ref  = bvh_ref_t<primitive_type, node_type>;
+    using bvh_inst = bvh_inst_t<primitive_type, node_type>;
+
+    template <unsigned K>
+    using bvh_motion_inst = bvh_motion_inst_t<bvh_ref, K>;
 
 public:
 
@@ -495,6 +1079,13 @@ public:
         return bvh_inst(ref(), transform);
     }
 
+    // Instance with one transform per keyframe
+    template <unsigned K>
+    bvh_motion_inst<K> motion_inst(mat4x3 const (&transforms)[K])
+    {
+        return bvh_motion_inst<K>(ref(), transforms);
+    }
+
     primitive_type const& primitive(size_t index) const
     {
         return primitives_[index];
@@ -529,8 +1120,11 @@ public:
     using node_vector       = NodeVector;
     using index_vector      = IndexVector;
 
-    using bvh_ref  = index_bvh_ref_t<primitive_type>;
-    using bvh_inst = index_bvh_inst_t<primitive_type>;
+    using bvh_ref  = index_bvh_ref_t<primitive_type, node_type>;
+    using bvh_inst = index_bvh_inst_t<primitive_type, node_type>;
+
+    template <unsigned K>
+    using bvh_motion_inst = bvh_motion_inst_t<bvh_ref, K>;
 
 public:
 
@@ -584,6 +1178,13 @@ public:
         return bvh_inst(ref(), transform);
     }
 
+    // Instance with one transform per keyframe
+    template <unsigned K>
+    bvh_motion_inst<K> motion_inst(mat4x3 const (&transforms)[K])
+    {
+        return bvh_motion_inst<K>(ref(), transforms);
+    }
+
     primitive_type const& primitive(size_t indirect_index) const
     {
         return primitives_[indices_[indirect_index]];
@@ -674,11 +1275,14 @@ struct is_bvh : std::false_type {};
 template <typename T1, typename T2>
 struct is_bvh<bvh_t<T1, T2>> : std::true_type {};
 
-template <typename T>
-struct is_bvh<bvh_ref_t<T>> : std::true_type {};
+template <typename T, typename N>
+struct is_bvh<bvh_ref_t<T, N>> : std::true_type {};
 
-template <typename T>
-struct is_bvh<bvh_inst_t<T>> : std::true_type {};
+template <typename T, typename N>
+struct is_bvh<bvh_inst_t<T, N>> : std::true_type {};
+
+template <typename R, unsigned K>
+struct is_bvh<bvh_motion_inst_t<R, K>> : is_bvh<R> {};
 
 template <typename T>
 struct is_index_bvh : std::false_type {};
@@ -686,11 +1290,14 @@ struct is_index_bvh : std::false_type {};
 template <typename T1, typename T2, typename T3>
 struct is_index_bvh<index_bvh_t<T1, T2, T3>> : std::true_type {};
 
-template <typename T>
-struct is_index_bvh<index_bvh_ref_t<T>> : std::true_type {};
+template <typename T, typename N>
+struct is_index_bvh<index_bvh_ref_t<T, N>> : std::true_type {};
 
-template <typename T>
-struct is_index_bvh<index_bvh_inst_t<T>> : std::true_type {};
+template <typename T, typename N>
+struct is_index_bvh<index_bvh_inst_t<T, N>> : std::true_type {};
+
+template <typename R, unsigned K>
+struct is_index_bvh<bvh_motion_inst_t<R, K>> : is_index_bvh<R> {};
 
 template <typename T>
 struct is_any_bvh : std::integral_constant<bool, is_bvh<T>::value || is_index_bvh<T>::value>
@@ -701,14 +1308,20 @@ struct is_any_bvh : std::integral_constant<bool, is_bvh<T>::value || is_index_bv
 template <typename T>
 struct is_bvh_inst : std::false_type {};
 
-template <typename T>
-struct is_bvh_inst<bvh_inst_t<T>> : std::true_type {};
+template <typename T, typename N>
+struct is_bvh_inst<bvh_inst_t<T, N>> : std::true_type {};
+
+template <typename R, unsigned K>
+struct is_bvh_inst<bvh_motion_inst_t<R, K>> : is_bvh<R> {};
 
 template <typename T>
 struct is_index_bvh_inst : std::false_type {};
 
-template <typename T>
-struct is_index_bvh_inst<index_bvh_inst_t<T>> : std::true_type {};
+template <typename T, typename N>
+struct is_index_bvh_inst<index_bvh_inst_t<T, N>> : std::true_type {};
+
+template <typename R, unsigned K>
+struct is_index_bvh_inst<bvh_motion_inst_t<R, K>> : is_index_bvh<R> {};
 
 template <typename T>
 struct is_any_bvh_inst : std::integral_constant<bool, is_bvh_inst<T>::value || is_index_bvh_inst<T>::value>
@@ -716,6 +1329,93 @@ struct is_any_bvh_inst : std::integral_constant<bool, is_bvh_inst<T>::value || i
 };
 
 
+template <typename T>
+struct is_wide_bvh_node : std::false_type {};
+
+template <unsigned N>
+struct is_wide_bvh_node<bvh_wide_node<N>> : std::true_type {};
+
+template <unsigned N>
+struct is_wide_bvh_node<bvh_quantized_node<N>> : std::true_type {};
+
+template <typename T>
+struct is_wide_bvh : std::false_type {};
+
+template <typename T1, typename T2>
+struct is_wide_bvh<bvh_t<T1, T2>> : is_wide_bvh_node<typename T2::value_type> {};
+
+template <typename T1, typename T2, typename T3>
+struct is_wide_bvh<index_bvh_t<T1, T2, T3>> : is_wide_bvh_node<typename T2::value_type> {};
+
+template <typename T, typename N>
+struct is_wide_bvh<bvh_ref_t<T, N>> : is_wide_bvh_node<N> {};
+
+template <typename T, typename N>
+struct is_wide_bvh<index_bvh_ref_t<T, N>> : is_wide_bvh_node<N> {};
+
+template <typename T, typename N>
+struct is_wide_bvh<bvh_inst_t<T, N>> : is_wide_bvh_node<N> {};
+
+template <typename T, typename N>
+struct is_wide_bvh<index_bvh_inst_t<T, N>> : is_wide_bvh_node<N> {};
+
+template <typename R, unsigned K>
+struct is_wide_bvh<bvh_motion_inst_t<R, K>> : is_wide_bvh<R> {};
+
+
+template <typename T>
+struct is_multi_triangle : std::false_type {};
+
+template <size_t N, typename T, typename P>
+struct is_multi_triangle<basic_multi_triangle<N, T, P>> : std::true_type {};
+
+template <typename T>
+struct is_multi_triangle_bvh : std::false_type {};
+
+template <typename T1, typename T2>
+struct is_multi_triangle_bvh<bvh_t<T1, T2>> : is_multi_triangle<typename T1::value_type> {};
+
+template <typename T1, typename T2, typename T3>
+struct is_multi_triangle_bvh<index_bvh_t<T1, T2, T3>> : is_multi_triangle<typename T1::value_type> {};
+
+
+template <typename T>
+struct is_motion_bvh_node : std::false_type {};
+
+template <unsigned K>
+struct is_motion_bvh_node<bvh_motion_node<K>> : std::true_type {};
+
+template <typename T>
+struct is_motion_bvh : std::false_type {};
+
+template <typename T1, typename T2>
+struct is_motion_bvh<bvh_t<T1, T2>> : is_motion_bvh_node<typename T2::value_type> {};
+
+template <typename T1, typename T2, typename T3>
+struct is_motion_bvh<index_bvh_t<T1, T2, T3>> : is_motion_bvh_node<typename T2::value_type> {};
+
+template <typename T, typename N>
+struct is_motion_bvh<bvh_ref_t<T, N>> : is_motion_bvh_node<N> {};
+
+template <typename T, typename N>
+struct is_motion_bvh<index_bvh_ref_t<T, N>> : is_motion_bvh_node<N> {};
+
+template <typename T, typename N>
+struct is_motion_bvh<bvh_inst_t<T, N>> : is_motion_bvh_node<N> {};
+
+template <typename T, typename N>
+struct is_motion_bvh<index_bvh_inst_t<T, N>> : is_motion_bvh_node<N> {};
+
+template <typename R, unsigned K>
+struct is_motion_bvh<bvh_motion_inst_t<R, K>> : is_motion_bvh<R> {};
+
+template <typename T>
+struct is_motion_bvh_inst : std::false_type {};
+
+template <typename R, unsigned K>
+struct is_motion_bvh_inst<bvh_motion_inst_t<R, K>> : std::true_type {};
+
+
 //-------------------------------------------------------------------------------------------------
 // Typedefs
 //
@@ -725,6 +1425,29 @@ using bvh               = bvh_t<aligned_vector<P>, aligned_vector<bvh_node, 32>>
 template <typename P>
 using index_bvh         = index_bvh_t<aligned_vector<P>, aligned_vector<bvh_node, 32>, aligned_vector<unsigned>>;
 
+template <typename P>
+using bvh4              = bvh_t<aligned_vector<P>, aligned_vector<bvh4_node, 32>>;
+template <typename P>
+using bvh8              = bvh_t<aligned_vector<P>, aligned_vector<bvh8_node, 32>>;
+template <typename P>
+using index_bvh4        = index_bvh_t<aligned_vector<P>, aligned_vector<bvh4_node, 32>, aligned_vector<unsigned>>;
+template <typename P>
+using index_bvh8        = index_bvh_t<aligned_vector<P>, aligned_vector<bvh8_node, 32>, aligned_vector<unsigned>>;
+
+template <typename P>
+using bvh4q             = bvh_t<aligned_vector<P>, aligned_vector<bvh4q_node, 32>>;
+template <typename P>
+using bvh8q             = bvh_t<aligned_vector<P>, aligned_vector<bvh8q_node, 32>>;
+template <typename P>
+using index_bvh4q       = index_bvh_t<aligned_vector<P>, aligned_vector<bvh4q_node, 32>, aligned_vector<unsigned>>;
+template <typename P>
+using index_bvh8q       = index_bvh_t<aligned_vector<P>, aligned_vector<bvh8q_node, 32>, aligned_vector<unsigned>>;
+
+template <typename P, unsigned K = 2>
+using motion_bvh        = bvh_t<aligned_vector<P>, aligned_vector<bvh_motion_node<K>, 32>>;
+template <typename P, unsigned K = 2>
+using index_motion_bvh  = index_bvh_t<aligned_vector<P>, aligned_vector<bvh_motion_node<K>, 32>, aligned_vector<unsigned>>;
+
 #ifdef __CUDACC__
 template <typename P>
 using cuda_bvh          = bvh_t<thrust::device_vector<P>, thrust::device_vector<bvh_node>>;
@@ -750,17 +1473,26 @@ void traverse_parents(B const& b, N const& n, F func);
 
 } // visionaray
 
+#include "detail/bvh/collapse.h"
 #include "detail/bvh/get_bounds.inl"
 #include "detail/bvh/get_color.h"
 #include "detail/bvh/get_normal.h"
 #include "detail/bvh/get_tex_coord.h"
 #include "detail/bvh/hit_record.h"
+#include "detail/bvh/instance_update.h"
 #include "detail/bvh/intersect.inl"
+#include "detail/bvh/intersect_wide.inl"
 #include "detail/bvh/lbvh.h"
+#include "detail/bvh/motion.h"
+#include "detail/bvh/pack_triangles.h"
+#include "detail/bvh/ploc.h"
 #include "detail/bvh/prim_traits.h"
+#include "detail/bvh/quantize.h"
 #include "detail/bvh/refit.h"
+#include "detail/bvh/reorder.h"
 #include "detail/bvh/sah.h"
 #include "detail/bvh/statistics.h"
 #include "detail/bvh/traverse.h"
+#include "detail/bvh/treelet.h"
 
 #endif // VSNRAY_BVH_H
@@ -101,16 +101,17 @@ void basic_sched<B, R>::frame(K kernel, SP sched_params)
         [=](int x, int y)
         {
             using S = typename R::scalar_type;
-            using I = typename simd::int_type<S>::type;
 
             expand_pixel<S> ep;
-            auto seed = make_random_seed(
-                convert_to_int(ep.y(y)) * sched_params.rt.width() + convert_to_int(ep.x(x)),
-                I(frame_id_)
+            auto gen = make_pixel_generator(
+                S{},
+                sched_params.sample_params,
+                convert_to_int(ep.x(x)),
+                convert_to_int(ep.y(y)),
+                sched_params.rt.width(),
+                frame_id_
                 );
 
-            auto gen = make_generator(S{}, sched_params.sample_params, seed);
-
             basic_sched_impl::call_sample_pixel(
                     typename detail::sched_params_has_intersector<SP>::type(),
                     R{},
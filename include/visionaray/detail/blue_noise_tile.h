@@ -0,0 +1,295 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BLUE_NOISE_TILE_H
+#define VSNRAY_DETAIL_BLUE_NOISE_TILE_H 1
+
+#include "macros.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// 64x64 blue-noise tile, toroidally wrapping
+//
+// Holds the ranks [0..4096) of the pixels, i.e. thresholding at k yields a blue-noise
+// dither pattern with k set pixels. Generated with the void-and-cluster method
+// (R. Ulichney: The void-and-cluster method for dither array generation, 1993), using
+// a Gaussian filter with sigma = 1.5.
+//
+
+enum { BlueNoiseTileSize = 64 };
+
+VSNRAY_FUNC
+inline unsigned blue_noise_rank(int x, int y)
+{
+    static const unsigned short ranks[BlueNoiseTileSize * BlueNoiseTileSize] = {
+         938,  592, 3059, 3607, 1776,  349, 3920, 1561,   86, 3653, 2656, 1550, 2443, 3731, 2965, 1490,
+        3348, 1155, 3632, 1469, 3471, 1810, 3087,  347, 1089, 2782, 1538, 4075, 3050, 2720, 3367,   91,
+         998, 3639, 2777, 1551, 3482, 2525, 3898, 1591,  251, 1038, 1493, 3136,  320,  880, 3599,  497,
+        2016, 2841,  579, 1749, 2762, 2050,  299, 2432, 3246, 1191, 3995,  434, 2096, 1338, 3310, 1842,
+        3451, 1398, 2060, 1005, 2847, 2253,  818, 2914, 2384, 2005,  389, 3941, 1871,  520,  819, 2122,
+         385, 2441, 2925,  435, 2701,  707, 2492, 2000, 3735,  616, 2472, 1930,  243, 1231, 1864, 3948,
+        1479, 2297,  531, 3121,   57, 1270,  584, 2169, 2949, 3410, 2576, 3762, 1729, 3265, 1413, 2692,
+        1020, 3983, 3239, 1349,  128, 1127, 3384, 1634,  400, 2712, 2306, 3395,  805, 2880,   12, 2353,
+         365, 2785, 3891,  246, 3397, 1249, 3698,  492, 3368, 1394,  795, 3183, 1130, 3461, 2760, 4008,
+        3103, 1720,  752, 2069, 4058, 1150, 3391,  136, 2910, 1329, 3423,  986, 3757, 2377,  762, 3111,
+         387, 2878, 1158, 4047, 1977, 3301, 2749, 3728,  811, 2012,   82,  709, 2403, 1962, 3874,   32,
+        2273, 1576,  863, 2390, 3540, 2966, 2227,  830, 3772, 1907,  116, 1560, 3812, 2496, 1036, 4079,
+        2201,  772, 1735, 2457,  606, 1629, 2625, 1846, 1043, 3600, 2716, 2199,   60, 1594, 1960, 1054,
+         134, 1334, 3750, 3199,  189, 2305, 1486, 3892, 1770, 2232,  359, 3138, 1471,  495, 3575, 2577,
+        2062, 3705, 1732,  778, 2357,  997, 1477,  356, 1773, 1246, 4088, 2881, 1107,  433, 2921, 1236,
+        3490, 3037,  335, 3808, 1854,  532, 3977, 1277, 2907, 3472, 1077, 3117,  534, 1880, 3170, 1633,
+        2980, 3738, 1206, 3196, 2136, 4050,  178, 3179, 2163,  253, 1693, 3766, 3025, 2532,  489, 3617,
+        2661, 3322, 1872,  945, 1606, 3056,  543,  957, 3254,  717, 3967, 2650, 2119, 2908, 1675,  976,
+        1357,  109, 3438, 2660,  239, 3846, 3042, 2557, 3538, 3188, 2208, 1549, 3650, 3365,  833, 2545,
+        1834,  678, 2085, 2690,  961, 1485, 2622,  237, 1665,  688, 2116, 2683, 1348, 3579,  262, 1266,
+         518, 2536,   71, 3625,  921, 2868, 1410,  744, 3922, 2958,  586, 1265,  901, 3926, 1382, 2144,
+         667, 2323,  412, 2812, 2465, 3635, 1953, 2733, 2369, 1193, 1708,  209,  858, 3413,  297, 3933,
+        3233,  649, 2177, 1425, 3338, 1861,  722, 2152,  195,  954,  516, 2467,  166, 1704, 2125, 4025,
+         226, 3622, 1157, 3300,   61, 3124, 3572, 1964, 2494, 3716,  381, 4002, 2383,  852, 2045, 3427,
+         973, 1893, 3097, 1543,  372, 1980, 3493, 2396, 1159, 2584, 1993, 3443, 2334,  236, 2926, 3373,
+        1563, 3793, 1227, 3966,  715, 1302,  328, 3831,   93, 3592, 2894, 1994, 3700, 1163, 2328, 1920,
+        2515, 2981, 3761, 1045, 2915,  488, 1312, 3743, 1685, 2799, 3913, 1350, 2728, 3172,  539, 1405,
+        2764, 1605, 2327, 3911, 1740, 2204,  590,  989, 3330, 1259, 3075, 1602,  105, 2875, 3839, 2312,
+        2823, 4011,  666, 2337, 2727, 1079, 3046,   23, 1609, 3687,  353, 1530, 3202,  757, 1831, 1080,
+           5, 3013, 2003,  224, 3129, 2192, 3350, 1800, 1449, 3149,  602, 1380, 2504, 3047,  675, 1437,
+         228,  893, 1780,  341, 2068, 3959, 2495, 3257, 1122, 3118, 2022,  800, 3703, 1124, 2355, 3467,
+         949, 3208,  358,  760, 2851, 1240, 4085, 2950,  137, 2321,  868, 1955, 3369, 1213,  429, 1511,
+         215, 1324, 3441, 1791, 3724,  556, 3903, 1850,  681, 3127, 1003, 4022, 2093, 2795, 3873, 2562,
+        3593,  884, 2663, 3488, 1659, 1021, 2779,  750, 2563, 1001, 2276, 4036,   26, 1696, 3816, 3292,
+        2829, 4076, 2332, 3504, 2746, 1512,  848,  388, 2266,   84, 1570, 3296,  285, 1759, 2961,   52,
+        3771, 1884, 2611, 1461, 3691,  259, 2519, 1487, 1858, 3844, 2814,  529, 3686, 2522, 1818, 3260,
+        2657, 2164,  906,  117, 3245, 1453, 2212, 2838, 3542, 2141, 2614,   95, 1195,  519, 1597,  399,
+        2269, 1853, 1435,  637, 2382, 3665,  444, 3958, 2097, 3505,  409, 3211, 1075, 2719,  471, 2087,
+        1137, 1621,  572, 1241,   39, 3394, 1985, 3676, 2702, 3875,  642, 2552, 2207, 3960,  865, 2075,
+        1313,  617, 3071, 2167, 1033, 3351, 2035,  748, 3516,  363, 1407, 2176, 1030, 3066,  765, 3896,
+         496, 3746, 3005, 2447, 1131, 2639,  229,  942, 1322,  474, 1774, 2929, 3419, 2477, 3707, 1327,
+        3200,  294, 4054, 2976,   88, 1323, 1737, 3051,  192, 1616, 2811, 1852, 2170, 3630,  920, 3487,
+         121, 2623, 3663, 3158, 2431,  658, 2964, 1757, 1325,  900, 3003, 3489, 1253,  546, 2695, 3335,
+        2420, 4032,  138, 3547, 1801,  522, 2758, 3182, 1120, 2400, 3137, 4033, 1671,   24, 2349, 1177,
+        1637, 1937, 1358,  593, 3842, 1739, 3315, 4084, 2488, 3186, 3774, 1438,  766, 1912, 3001,  967,
+        3531, 2752,  782, 2091, 3822, 3251, 2486, 1091, 3645,  807, 1307, 3877,  611, 1442, 2516, 1833,
+        3107, 2159,  810, 1882, 1408, 4006, 1119,  197, 3305, 2151, 1699,  352, 1940, 3620, 1502,  386,
+        1666, 1114, 2724,  835, 2385, 3945, 1585,   50, 3804, 1763,  889,  298, 2634, 3610, 1999, 3396,
+        2589,  321, 3577, 2123, 3114,  380, 2052,  751, 1664,  145, 1046, 2174, 3975,  242, 2374,  630,
+        2135, 1710, 1262, 2603,  933, 1933,  596, 2796, 2025, 2408, 3381,  127, 2943, 3324,  292, 3841,
+        1218,  445, 3912, 2849,  289, 2214, 2674, 3629,  541, 2566, 4072, 1039, 2480, 3139,  959, 2839,
+        3480, 2056, 3205, 1399,  274, 3018, 1189, 2145, 2554,  591, 2869, 3494, 1356,  640, 2993,  950,
+        4060, 3225,  814, 2763, 1522,  980, 3670, 2909, 2304, 3586, 2732,  505, 3099, 1167, 1655, 3881,
+          65, 3029, 3778,  271, 1578, 3407,  148, 1444, 4092,  361, 1789, 2549,  870, 2295, 1626,  740,
+        2686, 1513, 3336, 1041, 1707, 3411,  829, 1905, 1368, 2904,    6, 1527, 3775,  241, 2250, 3905,
+         170,  661, 3798, 1734, 2592, 3609,  679, 3424, 1423, 3247, 1911, 1073, 2133, 3882, 1531,  193,
+        1287, 2249, 1752,   40, 3968, 2598, 1261,  275, 1462,  665, 3307, 1855, 2450, 3562, 2696, 3357,
+        1100, 2422,  600, 3512, 2821, 2322, 3720, 2984,  745, 3227, 1034, 3619, 1269, 4013, 2044, 2923,
+        3588, 2251,   63, 2520, 3792,  451, 3096, 2423, 3730,  770, 3389, 2047, 2751,  622, 1866, 1432,
+        2469, 1047, 2892,  430, 2189,  964, 1945, 2771,  426, 3981,  131, 2511, 3201,  436, 2417, 2863,
+         570, 3535, 1101, 3062, 2188,  527, 3431, 3164, 1991, 3952, 1123, 1537,  114,  799, 1420,  450,
+        1845, 3221, 1505, 2131, 1086,  704, 1816, 1156, 2587, 1613, 2138, 2817,  411, 3206,  106, 1111,
+         555, 1821, 3203,  693, 2074, 1494, 1149,  151, 1662, 2278, 1237, 3061,  915, 3539, 1184, 2941,
+        3375, 2007, 3544, 1290, 4069, 3270,  150, 3747, 1017, 2309, 1622, 3590,  825, 1777, 3695, 1961,
+        3162, 2470,  374, 3776, 1336, 1851, 2348,  923, 2510,  198, 2659, 3763, 3212, 2010, 4071, 2245,
+        2854,  764, 3902,  348, 3110, 3990,  291, 2220, 3548,   10, 3919,  660, 1876, 1458, 2621, 3706,
+        3045, 1337, 4066, 1088, 2944, 3463, 2688, 3880, 3222,  309, 3953,  454, 1649, 2360, 4026,  340,
+         792, 1615,   37, 2734,  619, 1600, 2485, 1825, 1375, 3012,  691, 2761, 1239, 3020,   73,  984,
+        3939, 1552, 2037, 2826,  837, 3559,  329, 3811, 1680, 3055,  832, 2238,  476, 2791,  994,  252,
+        3704, 1171, 2020, 2505, 1421, 2662, 3321, 1500,  608, 3026, 1320, 3374, 2461, 3802,  780, 1722,
+        2405,  265, 2148, 2593,  188, 1799,  607, 2105, 1008, 2828, 1891, 2531, 3422,   87, 2077, 3213,
+        2624, 3858, 2388, 1862, 3143, 1118, 2956,  533, 3347, 3827, 2059,  327, 4000, 2218, 1424, 2711,
+         769,  155, 3456,  564, 2580, 1582, 2897, 1204,  547, 3475, 1910, 1244, 3631, 1677, 3109, 2428,
+        1583, 3267,   42, 3648,  558, 1906,  903, 2844, 3809, 1932, 2338,  940,  174, 2951, 2205,  463,
+        3379,  878, 3601, 1434, 3835,  927, 3556, 2448, 1559,  523, 3624, 1371,  720, 2783, 1071, 1515,
+         563, 1198, 3485,  838, 3906,  245, 3561, 2271,  886,   13, 2583, 1488, 3232,  626, 3598, 1877,
+        2363, 1347, 3090, 1762, 4049,   69, 3328, 2113, 2767, 1457, 4010,    1, 2546,  687, 1315, 3530,
+         612, 2706, 1733, 2959, 1267, 3501,  125, 2287, 1173,  279, 2725, 1670, 3520, 1103, 1387, 3946,
+        2748, 1604, 3120,  355, 1972, 3261, 1351,   55, 3924, 3161, 1132, 2243, 3053, 3795, 1895, 3608,
+        3010, 2233,  378, 1441, 2070, 2633, 1295, 1938, 2855, 1185, 3534, 1889,  993, 2459,  283, 3342,
+        2917, 3847,  909, 2150, 1170, 2426,  856, 3887,  269, 2454,  747, 2952, 3352, 1976, 3936,  171,
+        2130,  991, 4016,  777, 2072, 2468, 3954, 1567, 3337,  817, 3072, 4061,  562, 2015, 3166,  235,
+        1035, 2081,  659, 2857, 2367,  551, 2972, 2630, 2026,  824, 2715,  181, 1590,  360,  875, 2479,
+         124, 1765, 3302, 2458, 3080,  674, 3712,  390, 3969, 1697, 3115,  438, 3745, 2832, 1667, 1102,
+        1944,  230, 2543, 3583,  423, 3156, 1508, 1916, 1022, 3306, 2162, 1623, 1096,  413, 2340, 2935,
+        1363, 3415, 2368,  310, 3243, 1044,  456, 2932, 1875, 3733,  379, 2146, 1492, 2616, 3657, 1793,
+        2489, 3506, 3818, 1134, 1701, 4041, 1050, 1640,  431, 3758, 1769, 3250, 4086, 2175, 3429, 1296,
+        3955,  736, 3660, 1023,   70, 1795, 3231, 1478, 2538,  240, 2288,  822, 2101, 1364, 4093,  526,
+        3462, 1572,  689, 2833, 1702, 3749,  635, 2987, 3644, 1372,  498, 3574, 2710, 3701,  922, 1760,
+        3148,  460, 1611, 3756, 2694, 1428, 3602,  696, 2605, 1308, 2413,  975, 3314,   85,  836, 2985,
+         513, 1343,   17, 2678, 3390,  207, 2270, 3083, 3440, 1291, 2371,  655, 1055, 2612,  552, 2901,
+        2073, 2708, 1517, 2918, 4056, 1176, 2307,  851, 3450, 1098, 3828, 2669, 3382,   97, 3106, 2286,
+        1037, 3760, 3176, 1256, 2041,  282, 2632, 2203,   90, 2509, 3030, 1924,  146, 1460, 2534,  702,
+        3820, 2653, 1186, 1935,  158, 3043, 1787, 2182,   41, 3486, 1687, 3871, 2806, 1288, 2330, 4019,
+        1627, 3277, 2254, 1903,  846, 1482, 3643,  771, 2128,  104, 2927, 3615, 1996, 1409, 3178, 1716,
+        1094,  202, 2262,  535, 1946, 3507, 2772,  469, 2011, 2990, 1514,  538, 1221, 1815,  755, 2742,
+         394, 2223,   43, 2449, 3509, 1016, 4029, 1264, 1753, 3849,  864, 1216, 4046, 3253, 2023, 3484,
+          89, 2194,  890, 3469, 2313,  841, 3935, 2846, 1105, 3163,  651,  273, 1942, 3689,  421, 2065,
+         999, 2815,  676, 3930, 3104, 2540,  369, 2788, 1117, 3965, 1506,  459, 3372,  149, 3789,  428,
+        3564, 3130, 3801,  910, 2573,  176, 1638, 3142, 3999,   53, 1879, 2879, 3692, 2440, 3910, 1386,
+        3031, 1689, 3923,  796, 2934, 1545, 3207,  784, 2840,  354, 3409, 2290,  595, 2882,  376, 1245,
+        1692, 2803, 4064,  544, 3184, 1279,  332, 1535, 3709, 2004, 2503, 3036,  872, 1586, 2595, 3428,
+         161, 3729, 1742,  267, 1247, 2063, 3876, 1683, 3317, 1899, 2665,  895, 2830, 2399, 1913,  861,
+        2526, 1367, 1741, 3344, 1301, 3867,  657, 1138, 2412,  816, 3529, 2165,  995,  200, 3311, 1970,
+         882, 3416, 1210, 1918,  515, 2112,  160, 2366, 3613, 2031, 1429, 2691, 1767, 1015, 2401, 3909,
+        3058,  300, 1497, 2462, 1747, 3565, 2638, 2267,  511,  962, 4040, 1426, 3525, 2871,  631, 1172,
+        3032, 1411, 2302, 2738, 3573,  955,  576, 2391,  231,  701, 2244, 3742, 1657, 1110, 3976, 2962,
+        2100,  581, 2820,  325, 2006, 2942, 2215, 3658, 1727, 2741, 1339,  334, 3177, 1660,  603, 2617,
+        2255,  173, 2582, 3272, 3681, 2668, 3907, 1635,  521, 1074, 3224,  306, 3768, 3150, 1480,  758,
+        2117, 3612, 1078, 2891,   62, 2066,  788, 3316, 2979, 1784,  142, 2308,  383, 2118, 3961, 1826,
+        2475,  739, 3326,  461, 1589, 3185, 2876, 1395, 3491, 3009, 1299,   19, 3155,  621, 1430,  258,
+        3401, 1148, 4017, 2429,  828, 3458, 1445,  257, 3319,  559, 3927, 2957, 2347, 3865, 1268, 3628,
+        1580, 4063,  711, 1446,  317,  943, 1316, 3420, 2906, 2527, 3956,  842, 1997,   36, 3654, 2717,
+         440, 1878, 3366,  694, 3723, 1180, 3994,  219, 1383, 3606, 2726, 3295, 1004, 1355, 3102,  305,
+        3784, 2039, 1028, 4045, 2512,   51, 1917, 3819, 1052, 2561, 4059, 1971, 3550, 2230, 2703, 3661,
+        1678, 2281,  167, 3128, 1812,  487, 2756,  982, 1995, 2476, 1509, 1057,  754, 1901, 2745,  370,
+        2885, 1979, 3021, 2342, 1814, 3146, 2263,  697, 1892,  182, 1496, 2317, 2899, 1228, 1705, 3308,
+        1002, 2581, 1381, 2184, 3078, 1672, 2753, 1934, 2445, 1113,  708, 1928, 3861, 2680,  587, 1610,
+        3417,  123, 2937, 1797, 1225, 3361,  726, 2181,  351, 1766,  540,  977, 2866,  410, 1857,  965,
+        3054,  677, 1566, 3560, 1212, 3780, 2314, 4007, 3094,  129, 3702, 2109, 3502,   29, 3278, 1097,
+         844,  481, 3526, 1125, 3869, 2757,   14, 3805, 1226, 3052, 3621,  425, 3466, 2506,  639, 2160,
+        3751,  122, 3964,  502, 2421,  293,  916, 3421,  542, 3790, 3070, 1503,   25, 2183, 3649, 1070,
+        2735, 1374, 2236,  599, 3623, 2373, 1533, 2784, 3578, 3082, 2435, 1593, 3393, 1286, 3916,   77,
+        2537, 3803, 2845,  888, 2585,    2, 1646,  627, 1281, 1783, 2689,  486, 2861, 1641, 2416, 3824,
+        3334, 1715, 2533,  255,  652, 1491, 2043, 3240, 2438,  971, 2139, 1768,  930, 4083,  216, 2877,
+        1465, 3007, 1805,  970, 3297, 3889, 1416, 2920, 2166, 1624,  371, 2387, 3499,  855, 1724, 2361,
+        3214,  797, 3838, 3089,  296, 1000, 3932,  163,  914, 1377, 3886,  194, 2604,  785, 2300, 3313,
+        2024, 1317,  392, 1883, 3210, 2147, 3377, 2824, 3596,  834, 3332, 1207, 4043,  669, 1346, 2126,
+         102, 1280, 3973, 2180, 3303, 3699,  885,  397, 1581, 3986,  632, 3298, 1422, 3093, 1952, 1151,
+        2335,  730, 3557, 2743, 1587, 2104,  680, 3697,  156, 2714, 4080, 1194, 2889, 3268,  261, 3992,
+         452, 1860, 2568, 1507, 2055, 2651, 3144, 1966, 3414, 2247,  682, 2054, 3755, 2947, 1489,  571,
+        1066, 3519, 2395, 4095,  597, 1384, 1040,  338, 1929, 2283,  263, 2502, 1957, 3226,  395, 2675,
+        3474, 3048,  907, 2809, 1181, 1775, 2544, 3553, 2856,  203, 2723, 2301,  367, 2666,  787, 3814,
+        3262,  272, 1989, 1258,    4, 3039, 2453, 1135, 1881, 3248,  944, 2027,  465, 1448, 2631, 2080,
+        1292, 3570,   92, 1068, 3446,  500, 1647, 1208,  437, 2737, 3271, 1179, 1717,  350, 3194, 3972,
+        1730, 3016,  234, 1525, 2807, 3669, 2626, 3957, 1454, 2888, 3830, 1575,  928, 2911, 3741, 1832,
+        2258, 1588,  517, 1958,  154, 2994,  580, 2202, 1298, 1886, 3682, 1166, 3888, 1822, 3447,  484,
+        1574, 2619, 4037, 3378,  866, 3810,  432, 3406, 1452,  604, 2541, 3566, 1738, 3864, 1032, 2978,
+         767, 3154, 2285, 4074, 2834,  843, 3636, 2424, 3996, 1782,  119, 3638,  815, 2149, 2484,  177,
+        2697,  731, 2239, 3383,  924,  281, 2071,  743, 3175, 1115,  566, 3479,  118, 2315, 1129,  716,
+         264, 3604, 2490, 3840, 3223, 1455, 3938, 1029, 3387, 3006,  850, 1658,   49, 2418, 1345, 2127,
+        2969, 1063,  598, 2272, 2709, 1694, 2034, 2808, 3666, 2256,   64, 2852,  703, 2414,  139, 3662,
+        1541, 2679,  614, 1369, 1771, 2225,   38, 2924,  712, 1401, 3112, 2294, 2890, 1318, 3464, 1019,
+        2002, 3833, 1233, 1847, 2478, 3119, 1571, 2415,   54, 3710, 2115, 2744, 1794, 3291, 1483, 4020,
+         988, 2827, 1305,  798, 2277,  362, 2722, 2042,  103,  549, 2556, 3266, 3567,  974, 3081,  187,
+        3713, 2466, 1856,  314, 1379, 3320, 1064,  222,  820, 1674, 3794, 1361, 3432, 3084, 2198, 1824,
+         357, 3439, 2014,  254, 3263, 3767, 1082, 2021, 3528, 2613,  969,  448, 4067, 1898,  633, 3740,
+        1548, 3068,   80, 3581,  536, 3925, 1072, 3513, 1820, 2555, 1392,  806, 3866,  322, 2529, 2977,
+        2137, 1803,   44, 3527, 1607, 3325,  721, 3580, 1725, 4030, 1417, 2120,  455, 2699, 4001, 1764,
+         793, 1311, 3558, 3086, 3884,  623, 2433, 4031, 3014, 2569, 1025, 1981,  280,  912, 1306, 4012,
+        2517, 1141, 3725, 2953,  774, 2597, 1579, 3167,  214, 1887, 3711, 1569, 2564,   20, 3287, 2770,
+         475, 2370,  873, 2874, 1289, 1986,  205, 2895,  706, 3323,  398, 3125, 1174, 2033,  625, 3385,
+         472, 3901, 3092, 2640, 1923, 1081, 2452, 1326, 3108, 2316,  773, 2919, 1897, 1251,  624, 2291,
+        3273, 2801,   67, 1009, 2111, 2884, 1644, 1285, 2078,  323, 3153, 3944, 2740, 1688, 3354,  628,
+        2900,  854, 1684, 2425, 1255,  331, 3984,  638, 2362, 1140, 3279,  719, 3034, 1175, 1690, 2264,
+        1393, 3241, 3989, 1723, 2620, 3404, 2279, 3850, 1209, 1691, 4052, 2345, 2922, 3647, 1709, 1243,
+        2319, 1466,  902,  578, 4091,  169, 3719, 2816,  287, 1133, 3626,  206, 3823, 3168, 1557,  336,
+        3777, 2048, 1568, 2602,  485, 3582,  115, 3215, 3634,  654, 1516, 2282,  507, 3674, 2372,   16,
+        1954, 3285,  199, 3843, 2108, 3408, 1848, 1332, 2903, 3914,  295, 2240, 1965, 3856,  791, 3605,
+         183, 1048, 2049,  337,  690, 1534,  947,  466, 2648, 2153,  108, 1542,  934,  225, 2643, 3770,
+         284, 3434, 2501, 2095, 2913, 1412, 2209,  643, 1968, 3331, 2599, 1632,  958, 2451, 3508, 2636,
+        1145,  698, 4078, 3242, 1890, 1215, 2386,  925, 1819, 2627, 3392,  879, 1902, 1161, 3190, 1528,
+        3899, 2259, 1362,  588, 3074,  948, 2718, 3571,  420, 1673, 2672, 1373, 3398,  249, 2818, 1817,
+        2645, 3483, 2491, 3783, 3132, 2786, 3656, 1874, 3152, 3752,  663, 2754, 3481, 2228,  741, 3116,
+        2822, 1827, 1169, 3569,  416, 1746, 3363, 1006, 3978, 1385,  377, 3060, 2171,   18,  802, 1948,
+        3015,  227, 2324, 1353,  790, 3857, 2781,  442, 3963, 1232,   96, 3737, 3038,  304, 2586,  700,
+        1092, 2842, 3616, 2579, 1614,   59, 2311,  724, 2088, 3238,  913, 3678,  609, 2392, 1069, 4039,
+         524, 1333,  779, 1599,   30, 1229, 2365,  233, 1388, 1014, 3356, 1963, 1190, 3947, 1650, 1056,
+         560, 3991,  110, 3126,  859, 3859, 2410, 2938,  464, 2292, 1865, 3872, 1211, 3256, 3993, 1443,
+        3667, 1721, 3473, 2658,  162, 3355, 2142, 1472, 2975, 1998, 2427, 2798, 1403, 4090, 2083, 3551,
+        1802,  417,  918, 1941, 4055, 1192, 3349, 3781, 1468, 2500,   81, 2835, 1761, 3079, 1459, 3255,
+        2206, 2999, 1888, 3370, 2154, 4077,  644, 3517, 3004, 2487, 1676,  458, 2859,    9, 3236, 2079,
+        1319, 2397, 1573, 2671, 2018, 1274,   35, 1645, 3218, 3679,  853, 2797,  499, 1781, 2409,  307,
+        2793,  956,  545, 1969, 2983, 1654,  589, 3594,  223, 3346, 1049,  482, 1744,  756, 2940,  164,
+        3174, 2474, 3448,  260, 3147, 2766, 1804,  288, 1099, 4024, 1931, 1257, 3837,  366, 2067,  877,
+         100, 3673,  403, 2707,  905, 2898, 1625, 2036,  839,  344, 3806, 2185, 3555, 1439, 2539, 3688,
+        3386, 3044,  968, 3744,  583, 3510, 2550,  723, 1187, 2667,  143, 1436, 3546, 2955,  662, 1260,
+        2124, 3160, 3951, 1188, 3721,  887, 2571, 1147, 1785,  768, 3894, 2186, 3437, 2393, 1128, 1558,
+        3937, 1203, 2187, 1475,  831,  537, 2237, 3027, 2629,  613, 3282, 2326,  735, 3465, 2596, 3807,
+        1712, 2398, 1143, 3853, 1467,  185, 3264, 2574, 3950, 1470, 2948, 1065,  582, 1914,  883,  256,
+         734, 1919,  364, 2280, 3229, 1809, 2872, 3915, 2140, 1772, 3353, 2352, 2040,  978, 3765, 3333,
+        2523,   74, 1562, 2430,  339, 2224, 3195, 4034, 2813, 2381, 3159, 1300,   56, 3817, 2700,  501,
+        2028,  670, 2991, 3782, 2444, 3646, 1556,  935, 3453, 1679,  384, 2945, 1109, 1630,  266, 1273,
+        2916, 3515,  692, 1943, 2446, 3614,  528, 1121, 1839,   75, 2394, 3280, 2698, 4070, 2974, 2248,
+        1390, 2836, 3934, 1183,  277, 1464,  966,  213, 3618,  569, 1053, 3982,  303, 2637, 1539,  446,
+        1792, 3637,  812, 2837, 3376, 1335,    7, 2008,  512, 1524,  318, 1885, 2963,  939, 1695, 3098,
+        3523, 2567,   34, 1745, 1085, 3249,  112, 3942, 2168, 1341, 3680, 2089, 3904, 2736, 3288, 2274,
+         480, 1529, 3230,  286, 2973, 1303, 2191, 2776, 3345, 3633,  789, 1750,  316, 1196, 1648, 3769,
+         510, 3433, 1608, 2578, 3585, 2057, 3134, 2359, 1359, 2769, 3095, 1652,  753, 3197, 1978, 4062,
+        1084, 2992, 2107,  493, 1837, 3786, 1642, 2996, 1027, 3425, 3759, 2535,  585, 3591, 2298,  211,
+        1427,  911, 3893, 2132,  468, 2607, 1915,  684, 2790,  248, 2558,  908,   11, 1908,  668, 4023,
+         979, 2157, 2681, 3980,  809, 1703, 3821,  926,  419, 2106, 1342, 3885, 2178, 3497,  107, 2646,
+        1108, 2346,  201,  874, 2995,  574, 4073,  382, 3418, 1967,   48, 2499, 3732, 1294,  159, 2713,
+         672, 3511, 1275, 3931,  992, 2685,  710, 3651, 2246, 2673,  869, 1415, 2001, 3235, 1242, 3988,
+        1873, 3309, 2848, 1272, 3584, 3040, 1440, 3739, 1154, 3165, 1786, 3405, 1473, 3023, 1235, 2547,
+        3452,   72, 1778, 1205, 2336, 3500,  120, 3123, 1584, 2628, 3024,  594, 2498,  899, 3077, 2099,
+        4021, 3209, 1830, 3829, 2219, 1681, 1199, 2676, 1554,  849, 3533, 1126, 2143, 2971, 3459, 2221,
+        1510, 2464,  130, 2930, 2284,  319, 3283, 1234,  402, 1755,  132, 4048, 2794,  301,  808, 2729,
+         550, 2325,  324, 1651,  727, 2216,  208, 3380, 2275,  803, 4089,  508, 2402, 3668,  308, 1975,
+        1400, 3057, 3748,  443, 3259,  647, 1974, 2419, 4051, 1067,  147, 3734, 1547, 3340, 1807,  713,
+        1495,  453, 2655, 1314,   79, 2850, 3362,  656, 2289, 3852, 2825,  418, 1743,  577,  931, 3832,
+         406, 3304, 1663, 1959, 3478, 1484, 2471, 2017, 3836, 2931, 3299, 1112, 2235, 1643, 3787, 2161,
+        3455, 1168, 3131, 2514, 4014, 1042, 2664, 1728,  346, 2902, 1230, 2110, 2792,  990, 3180, 3800,
+         759, 2800,  952, 2086, 2606, 1476, 2862, 1238,  494, 3476, 1904, 2802, 1116,  373, 3659, 2775,
+        2193, 3589,  776, 3145, 3714,  932, 1982, 3675,  179, 1829, 1283, 3217, 3997, 2473, 1365, 1868,
+        2750,  996, 3791,  554,  860, 4057,   98, 3171,  821, 1447, 1922,  646, 3521, 3101, 1340,   68,
+        1726,  857, 3715,  141, 1925, 3220,  568, 3854, 1406, 2528, 3708,  113, 1636,  565, 2268, 1731,
+         175, 2354, 1603, 3552,  204, 3879,  786, 3364, 1713, 2261,  794, 3269, 2356, 2030, 1304,   31,
+        3011, 1142, 1950, 2350, 1592,  313, 2507, 1144, 3033, 2594,  749, 2211,  278, 2886, 3388,   28,
+        3122, 2172, 1376, 3049, 2644, 1146, 1843, 2810,  479, 2351, 3696, 2575,  393,  985, 2497, 2989,
+        3595, 2768, 2114, 1504, 2887, 1328, 3524, 2032, 3065,  728, 1900, 3312, 2936, 3962, 1197, 2642,
+        3290, 4044,  504, 3140, 1013, 1811, 3022,   15, 2588, 3773, 1431,  217, 3974,  634, 2518, 3860,
+        1751,  342, 3457,  561, 2780, 4005, 3189, 1498,  503, 3928, 1656, 3445, 1076, 1596, 2084,  823,
+        4027,  477, 2513,  186, 3343, 2260, 3640, 1598, 3921, 1202,   27, 2883, 1686, 3863,  673, 1988,
+         368, 1278,  641, 3883,  414,  876, 2364,   33, 1031, 3576,  470, 1433,  840, 1987, 3514,  415,
+        1026, 1414, 1951, 2687, 1309, 2460, 2155, 3985, 1058,  405, 2731, 3085, 1565, 3518, 2860,  941,
+        3274, 2455, 3895, 1402, 1007, 1840,  718, 2358, 3359, 2058,  126, 2670, 3813,  648, 3652, 2647,
+        1214, 1754, 3693, 2046, 1546,  671,  290,  987, 2548, 3294, 2092, 1391, 3360, 2196, 3151, 1523,
+        4082, 2610, 3192, 2229, 3442, 1841, 2730, 4038, 1617, 2481, 2179, 3851, 2609,  247, 1521, 3076,
+        2134, 3477,  775, 3834,  270, 3641,  530, 1501, 1984, 3198, 1222, 2102,  897, 1867,  184, 1450,
+         742, 2064,  152, 2982, 3339, 2242,    3, 3642, 1059, 2870,  898, 1370, 3041, 2389,  220, 1532,
+        3403, 2853,  761, 1106, 3897, 2704, 3498, 3100, 1863,  610,  904, 3998,  330, 1139,  157, 2436,
+         801, 1870,   83, 1061, 1601, 3091,  326, 1220, 2939, 3275,  153, 1164, 3113, 2293, 3779,  683,
+        2831,   45, 2333, 2946, 1682, 3157,  946, 2705, 3536,  699, 3685, 2493,  441, 3341, 2299, 3788,
+        2893, 1223, 2601, 1698,  439, 3845, 2682, 1397, 1796,  401, 3587, 2156,  462, 1859, 3228,  981,
+        2234,  144, 3554, 3073,  408, 1798, 1254, 2303,  172, 3597, 2968, 2376, 1758, 2759, 3754, 3293,
+        1182, 3537, 2865, 3736, 2442,  737, 3492, 2038,  548,  896, 1835, 3412,  573, 1718, 1093, 2521,
+        1806, 3727, 1544, 1095,  615, 1926, 3449,  191, 2379, 1661,   76, 2905, 4068, 1152, 2684,  491,
+        1836, 4015,  891, 3549, 1310, 2009,  847, 3105, 4094, 2551, 3187, 1612, 3971, 1160, 2553, 3900,
+         620, 1869, 2434, 1463, 2158, 2954,  804, 3949, 1540, 2641, 1276,  427, 3495,  826, 1973,  506,
+        1719, 2310,  685, 1456,  244, 3908, 1352, 2318, 3694, 2787, 3987, 1404, 2721, 3545,  135, 4003,
+        1282,  467, 3371, 2652, 4087, 2257, 1389, 2896, 1153, 3890, 1921, 1419,  781, 2121, 1555, 3496,
+          46, 3141, 2296,  629, 2804, 3252,  302, 2200,  605, 1248,   99, 2341,  746, 3444,  333, 1706,
+        2778, 3327,  951, 4081,   47, 3435, 2560,  490, 2029,  972, 3722, 2231, 3067, 1451, 2565, 3017,
+        3918,  311, 3181, 1909, 2677,  983, 2986, 1714,  196, 1136, 2404,  276, 2051,  867, 2960, 1956,
+        3276,  936, 2094,  168, 3064,  375, 3717,  732, 3289,  343, 2320, 3244, 3627,  218, 3069, 1011,
+        1396, 2019,  315, 3825, 1808, 1083, 3503, 1577, 2998, 1927, 3785, 1087, 2805, 2053, 3019, 1252,
+        3753,  391, 1344, 2693,  686, 1669, 1178, 3568, 3234, 2873,  133, 1639,  653, 4028,   58, 1012,
+        1536, 2774, 1201, 3799, 2173, 3329,  396, 2572, 3399, 1983,  695, 2997, 3868, 2344, 1474,  618,
+        2773, 2407, 3603, 1321, 1736, 1018, 2524, 1619, 2082, 2789, 1010,  509, 2590, 1779, 3870, 2482,
+        3718, 2747, 3400, 1520, 2530,  140, 2343, 3855,  881, 2456, 3258,  447, 3677, 1518,   21, 2406,
+         813, 2197, 3173, 1990, 3690, 3028, 2375,  212, 1790,  729, 3878, 2076, 3286, 1219, 2378, 3671,
+        2098,  738, 3454,   94,  645, 1628, 4065,  862, 1481, 3797, 3204, 1668, 1217,  404, 3191, 3672,
+         232, 1620,  705, 2600, 3848, 2013, 3436,  478, 4018, 1360, 3563, 2967, 1200, 2226,  407,  763,
+        1748, 1162,  525,  919, 2970, 3664, 1354,  473, 2755,  238, 1378, 1823, 2591,  636, 4042, 3135,
+        1631, 3532,  221, 1553, 1062,  449, 2061, 4004, 1366, 2508, 1060, 2654,  312, 2867, 1896,  457,
+        3216, 2608, 1700, 2411, 3088, 1293, 2103, 2912,    8, 2483,  422,  937, 3426, 2618, 1813, 1104,
+        2217, 3917, 3219,  424, 2928,   22, 3133,  892, 2615,  111, 1849,  714, 3940, 1499, 3430, 3002,
+         210, 3281, 2265, 4035, 1939,  650, 2090, 3402, 1756, 4009, 2190, 3522,  960, 3318, 1949, 1024,
+        2635,  575, 2858, 3943, 2542, 3284,  845, 2843,  514, 3193, 1844, 3468, 1418, 3815,  894, 3541,
+        1331,  268, 3979, 1090, 3683, 2739,  483, 3543, 1224, 1838, 2819, 3684, 1992,  101, 4053,  733,
+        2988, 1250, 1936,  963, 1526, 2329, 1263, 1788, 3655, 2195, 3358, 2439,  190, 2765, 1051, 2129,
+        3862, 1564, 2570,   66, 1284, 3237, 2559,  953, 3063, 1165,  664, 3008,  165, 1330, 2331,  250,
+        3826, 1894,  871, 2222,   78, 1271, 3796, 1618, 2252, 3611,    0,  827, 2210,  553, 1653, 2437,
+        3000, 1947,  783, 2213,  345, 1828,  917, 3169, 2339, 3970,  601, 2241, 1297, 2933, 2380, 1595,
+        3470,  180, 2463, 3764, 3460,  725, 3929, 2864,  567, 1519,  929, 3035, 1711, 3726,  557, 2649
+    };
+
+    return ranks[(y & (BlueNoiseTileSize - 1)) * BlueNoiseTileSize + (x & (BlueNoiseTileSize - 1))];
+}
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BLUE_NOISE_TILE_H
@@ -8,11 +8,16 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "../../aligned_vector.h"
 
 #include "../algorithm.h"
+#include "../parallel_for.h"
+#include "../range.h"
 
 namespace visionaray
 {
@@ -79,6 +84,254 @@ inline void build_top_down_impl(
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// build_top_down_parallel_impl
+//
+// Builds the top levels of the hierarchy on the calling thread. The builder may use the
+// thread pool to parallelize binning and partitioning of the large nodes. Subtrees with less
+// than SUBTREE_SIZE primitive references are detached from the builder and deferred. They
+// are later built independently by the thread pool.
+//
+
+template <typename Builder>
+struct deferred_subtree
+{
+    // Index of the subtree's root node in the final tree
+    int index;
+
+    // Builder owning the primitive references of this subtree
+    Builder builder;
+
+    // Root leaf, relative to the builder's primitive references
+    typename Builder::leaf_info leaf;
+
+    // Nodes and indices, relative to this subtree
+    aligned_vector<bvh_node, 32> nodes;
+    aligned_vector<unsigned> indices;
+};
+
+template <
+    typename Nodes,
+    typename Indices,
+    typename Builder,
+    typename LeafInfo,
+    typename Data,
+    typename Pool
+    >
+inline void build_top_down_parallel_impl(
+        int                                     index,
+        Nodes&                                  nodes,
+        Indices&                                indices,
+        Builder&                                builder,
+        LeafInfo const&                         leaf,
+        Data const&                             data,
+        int                                     max_leaf_size,
+        int                                     subtree_size,
+        Pool&                                   pool,
+        std::vector<deferred_subtree<Builder>>& subtrees
+        )
+{
+    if (builder.leaf_size(leaf) < subtree_size)
+    {
+        deferred_subtree<Builder> st;
+        st.index = index;
+
+        builder.detach(st.builder, st.leaf, leaf);
+
+        subtrees.push_back(std::move(st));
+        return;
+    }
+
+    typename Builder::leaf_infos childs;
+
+    auto split = builder.split(childs, leaf, data, max_leaf_size, pool);
+
+    if (split)
+    {
+        auto first_child_index = static_cast<int>(nodes.size());
+
+        nodes[index].set_inner(leaf.prim_bounds, first_child_index);
+
+        nodes.emplace_back();
+        nodes.emplace_back();
+
+        // Construct right subtree
+        build_top_down_parallel_impl(
+                first_child_index + 1,
+                nodes,
+                indices,
+                builder,
+                childs[1],
+                data,
+                max_leaf_size,
+                subtree_size,
+                pool,
+                subtrees
+                );
+
+        // Construct left subtree
+        build_top_down_parallel_impl(
+                first_child_index + 0,
+                nodes,
+                indices,
+                builder,
+                childs[0],
+                data,
+                max_leaf_size,
+                subtree_size,
+                pool,
+                subtrees
+                );
+    }
+    else
+    {
+        auto first = static_cast<int>(indices.size());
+        auto count = builder.insert_indices(indices, leaf);
+
+        nodes[index].set_leaf(leaf.prim_bounds, first, count);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// build_deferred_subtrees
+//
+// Builds the deferred subtrees in parallel and stitches them into NODES and INDICES.
+//
+
+template <typename Nodes, typename Indices, typename Builder, typename Data, typename Pool>
+inline void build_deferred_subtrees(
+        Nodes&                                  nodes,
+        Indices&                                indices,
+        std::vector<deferred_subtree<Builder>>& subtrees,
+        Data const&                             data,
+        int                                     max_leaf_size,
+        Pool&                                   pool
+        )
+{
+    using subtree = deferred_subtree<Builder>;
+
+    // Start with the largest subtrees, the small ones are stolen by idle threads at the end
+    std::sort(
+            subtrees.begin(),
+            subtrees.end(),
+            [](subtree const& a, subtree const& b)
+            {
+                return a.builder.leaf_size(a.leaf) > b.builder.leaf_size(b.leaf);
+            }
+            );
+
+    int num_subtrees = static_cast<int>(subtrees.size());
+
+    parallel_for(
+        pool,
+        tiled_range1d<int>(0, num_subtrees, 1),
+        [&](range1d<int> const& r)
+        {
+            for (int i = r.begin(); i != r.end(); ++i)
+            {
+                auto& st = subtrees[i];
+
+                st.nodes.emplace_back();
+
+                build_top_down_impl(
+                        0, // root node index
+                        st.nodes,
+                        st.indices,
+                        st.builder,
+                        st.leaf,
+                        data,
+                        max_leaf_size
+                        );
+
+                // Release the primitive references early
+                st.builder = Builder();
+            }
+        });
+
+    // Compute the offsets of the subtrees in the final node and index arrays.
+    // Each subtree's root node replaces the placeholder node at st.index
+
+    std::vector<size_t> node_offsets(num_subtrees);
+    std::vector<size_t> index_offsets(num_subtrees);
+
+    size_t num_nodes = nodes.size();
+    size_t num_indices = indices.size();
+
+    for (int i = 0; i < num_subtrees; ++i)
+    {
+        node_offsets[i] = num_nodes;
+        index_offsets[i] = num_indices;
+
+        num_nodes += subtrees[i].nodes.size() - 1;
+        num_indices += subtrees[i].indices.size();
+    }
+
+    nodes.resize(num_nodes);
+    indices.resize(num_indices);
+
+    parallel_for(
+        pool,
+        tiled_range1d<int>(0, num_subtrees, 1),
+        [&](range1d<int> const& r)
+        {
+            for (int i = r.begin(); i != r.end(); ++i)
+            {
+                auto const& st = subtrees[i];
+
+                // Child indices are always > 0, the root is stored at st.index
+                auto node_offset = static_cast<unsigned>(node_offsets[i] - 1);
+                auto index_offset = static_cast<unsigned>(index_offsets[i]);
+
+                for (size_t j = 0; j < st.nodes.size(); ++j)
+                {
+                    bvh_node n = st.nodes[j];
+
+                    if (n.is_inner())
+                    {
+                        n.set_inner(n.get_bounds(), n.get_child(0) + node_offset);
+                    }
+                    else
+                    {
+                        n.set_leaf(n.get_bounds(), n.get_first_primitive() + index_offset, n.get_num_primitives());
+                    }
+
+                    nodes[j == 0 ? st.index : node_offset + j] = n;
+                }
+
+                std::copy(st.indices.begin(), st.indices.end(), indices.begin() + index_offset);
+            }
+        });
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Store the primitives of a bvh in the order of the leaf indices
+//
+
+template <typename Tree>
+inline void assign_primitives(Tree& tree, aligned_vector<unsigned>& indices)
+{
+    if (indices.size() == tree.primitives().size())
+    {
+        // Reorder the primitives according to the indices.
+        algo::reorder_n(indices.begin(), tree.primitives().begin(), indices.size());
+    }
+    else
+    {
+        // Primitives are referenced more than once (pre-splitting)
+        typename Tree::primitive_vector primitives(indices.size());
+
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            primitives[i] = tree.primitives()[indices[i]];
+        }
+
+        tree.primitives() = std::move(primitives);
+    }
+}
+
+
 //--------------------------------------------------------------------------------------------------
 // build_top_down
 //
@@ -139,10 +392,7 @@ inline void build_top_down_work(
 
     builder.use_spatial_splits = uss;
 
-    assert(indices.size() == tree.primitives().size());
-
-    // Reorder the primitives according to the indices.
-    algo::reorder_n(indices.begin(), tree.primitives().begin(), indices.size());
+    assign_primitives(tree, indices);
 }
 
 template <typename Tree, typename Builder, typename I>
@@ -172,6 +422,151 @@ inline void build_top_down(Tree& tree, Builder& builder, I first, I last, int ma
     build_top_down_work(tree, builder, root, first, last, max_leaf_size, is_index_bvh<Tree>());
 }
 
+
+
+//--------------------------------------------------------------------------------------------------
+// build_top_down_parallel
+//
+
+template <typename Nodes, typename Indices, typename Builder, typename Root, typename I, typename Pool>
+inline void build_top_down_parallel_nodes(
+        Nodes&   nodes,
+        Indices& indices,
+        Builder& builder,
+        Root     root,
+        I        first,
+        int      max_leaf_size,
+        int      subtree_size,
+        Pool&    pool
+        )
+{
+    std::vector<deferred_subtree<Builder>> subtrees;
+
+    build_top_down_parallel_impl(
+            0, // root node index
+            nodes,
+            indices,
+            builder,
+            root,
+            first, // primitive data
+            max_leaf_size,
+            subtree_size,
+            pool,
+            subtrees
+            );
+
+    build_deferred_subtrees(nodes, indices, subtrees, first, max_leaf_size, pool);
+}
+
+template <typename Tree, typename Builder, typename Root, typename I, typename Pool>
+inline void build_top_down_parallel_work(
+        Tree&          tree,
+        Builder&       builder,
+        Root           root,
+        I              first,
+        I              /*last*/,
+        int            max_leaf_size,
+        int            subtree_size,
+        Pool&          pool,
+        std::true_type /*is_index_bvh*/
+        )
+{
+    build_top_down_parallel_nodes(
+            tree.nodes(),
+            tree.indices(),
+            builder,
+            root,
+            first,
+            max_leaf_size,
+            subtree_size,
+            pool
+            );
+}
+
+template <typename Tree, typename Builder, typename Root, typename I, typename Pool>
+inline void build_top_down_parallel_work(
+        Tree&           tree,
+        Builder&        builder,
+        Root            root,
+        I               first,
+        I               /*last*/,
+        int             max_leaf_size,
+        int             subtree_size,
+        Pool&           pool,
+        std::false_type /*is_index_bvh*/
+        )
+{
+    aligned_vector<unsigned> indices;
+
+    auto uss = builder.use_spatial_splits;
+
+    builder.use_spatial_splits = false;
+
+    build_top_down_parallel_nodes(
+            tree.nodes(),
+            indices,
+            builder,
+            root,
+            first,
+            max_leaf_size,
+            subtree_size,
+            pool
+            );
+
+    builder.use_spatial_splits = uss;
+
+    assign_primitives(tree, indices);
+}
+
+template <typename Tree, typename Builder, typename I, typename Pool>
+inline void build_top_down_parallel(
+        Tree&    tree,
+        Builder& builder,
+        I        first,
+        I        last,
+        int      max_leaf_size,
+        Pool&    pool
+        )
+{
+    if (max_leaf_size <= 0)
+    {
+        max_leaf_size = 4;
+    }
+
+    // Precompute primitive data needed by the builder
+
+    auto root = builder.init(first, last, pool);
+
+    // Preallocate memory
+    // Guess number of nodes...
+
+    auto count = std::distance(first, last);
+
+    tree.clear(2 * (count / max_leaf_size));
+
+    // Defer subtrees once there are enough of them to keep all threads busy
+
+    int num_threads = static_cast<int>(pool.num_threads);
+    int subtree_size = std::max(static_cast<int>(count / (8 * std::max(num_threads, 1))), 1024);
+
+    // Build the tree
+
+    // Create root node
+    tree.nodes().emplace_back();
+
+    build_top_down_parallel_work(
+            tree,
+            builder,
+            root,
+            first,
+            last,
+            max_leaf_size,
+            subtree_size,
+            pool,
+            is_index_bvh<Tree>()
+            );
+}
+
 } // detail
 } // visionaray
 
@@ -0,0 +1,224 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_COLLAPSE_H
+#define VSNRAY_DETAIL_BVH_COLLAPSE_H 1
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "../../math/aabb.h"
+#include "../../aligned_vector.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Traversal stack of wide BVHs
+//
+// Each visited node pops one entry and pushes up to N inner children, so trees with at
+// most MaxDepth levels of inner nodes need (N - 1) * MaxDepth + 1 entries. Collapsing
+// never makes a tree deeper, and the binary traversal stack has 32 entries, too.
+//
+
+template <unsigned N>
+struct wide_traversal_stack
+{
+    enum { MaxDepth = 32, Size = (N - 1) * MaxDepth + 1 };
+};
+
+// Most entries the traversal stack holds for the given wide nodes, in any traversal
+// order. Parents must precede their children in the node array.
+template <typename Nodes>
+inline unsigned max_traversal_stack_size(Nodes const& nodes)
+{
+    if (nodes.size() == 0)
+    {
+        return 0;
+    }
+
+    // Stack size when the node is popped, including the node itself
+    std::vector<unsigned> size_at(nodes.size(), 0);
+    size_at[0] = 1;
+
+    unsigned result = 1;
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        auto const& n = nodes[i];
+
+        unsigned num_inner = 0;
+
+        for (unsigned c = 0; c < n.get_num_children(); ++c)
+        {
+            num_inner += n.is_inner(c) ? 1 : 0;
+        }
+
+        unsigned size = size_at[i] - 1 + num_inner;
+        result = std::max(result, size);
+
+        for (unsigned c = 0; c < n.get_num_children(); ++c)
+        {
+            if (n.is_inner(c))
+            {
+                assert(n.get_child(c) > i);
+                size_at[n.get_child(c)] = size;
+            }
+        }
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Collapse the nodes of a binary BVH into N-wide nodes
+//
+// Starting with the children of a binary node, the inner child with the largest surface
+// area is repeatedly replaced by its own two children until N children were gathered or
+// only leaves are left. Wide nodes are emitted in breadth-first order. Leaves and thus
+// primitive (index) ranges are retained.
+//
+
+template <unsigned N, typename Nodes>
+inline aligned_vector<bvh_wide_node<N>, 32> collapse_nodes(Nodes const& nodes)
+{
+    static_assert(N >= 2, "Invalid node width");
+
+    aligned_vector<bvh_wide_node<N>, 32> result;
+
+    if (nodes.size() == 0)
+    {
+        return result;
+    }
+
+    // Pairs of (wide node index, binary node index)
+    std::vector<std::pair<size_t, size_t>> queue;
+
+    result.emplace_back();
+    queue.emplace_back(0, 0);
+
+    for (size_t q = 0; q < queue.size(); ++q)
+    {
+        size_t wide_index = queue[q].first;
+        auto const& n = nodes[queue[q].second];
+
+        size_t children[N];
+        unsigned num_children = 0;
+
+        if (is_leaf(n))
+        {
+            // Root is a leaf
+            children[num_children++] = queue[q].second;
+        }
+        else
+        {
+            children[num_children++] = n.get_child(0);
+            children[num_children++] = n.get_child(1);
+        }
+
+        while (num_children < N)
+        {
+            int best = -1;
+            float best_area = -1.0f;
+
+            for (unsigned i = 0; i < num_children; ++i)
+            {
+                auto const& c = nodes[children[i]];
+
+                if (is_inner(c) && surface_area(c.get_bounds()) > best_area)
+                {
+                    best = static_cast<int>(i);
+                    best_area = surface_area(c.get_bounds());
+                }
+            }
+
+            if (best < 0)
+            {
+                break;
+            }
+
+            auto const& c = nodes[children[best]];
+            children[best] = c.get_child(0);
+            children[num_children++] = c.get_child(1);
+        }
+
+        for (unsigned i = 0; i < N; ++i)
+        {
+            if (i >= num_children)
+            {
+                result[wide_index].set_empty(i);
+                continue;
+            }
+
+            auto const& c = nodes[children[i]];
+
+            if (is_leaf(c))
+            {
+                result[wide_index].set_leaf(
+                        i,
+                        c.get_bounds(),
+                        c.get_first_primitive(),
+                        c.get_num_primitives()
+                        );
+            }
+            else
+            {
+                unsigned child_index = static_cast<unsigned>(result.size());
+
+                result.emplace_back();
+                queue.emplace_back(child_index, children[i]);
+
+                result[wide_index].set_inner(i, c.get_bounds(), child_index);
+            }
+        }
+    }
+
+    assert(max_traversal_stack_size(result) <= wide_traversal_stack<N>::Size);
+
+    return result;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Convert a binary [index_]bvh into a BVH with N-wide nodes
+//
+// Primitives (and primitive indices) are copied, the wide BVH does not refer
+// to the binary BVH after construction.
+//
+
+template <unsigned N, typename PV, typename NV>
+inline bvh_t<PV, aligned_vector<bvh_wide_node<N>, 32>> collapse(bvh_t<PV, NV> const& tree)
+{
+    bvh_t<PV, aligned_vector<bvh_wide_node<N>, 32>> result;
+
+    result.primitives() = tree.primitives();
+    result.nodes() = detail::collapse_nodes<N>(tree.nodes());
+
+    return result;
+}
+
+template <unsigned N, typename PV, typename NV, typename IV>
+inline index_bvh_t<PV, aligned_vector<bvh_wide_node<N>, 32>, IV> collapse(index_bvh_t<PV, NV, IV> const& tree)
+{
+    index_bvh_t<PV, aligned_vector<bvh_wide_node<N>, 32>, IV> result;
+
+    result.primitives() = tree.primitives();
+    result.nodes() = detail::collapse_nodes<N>(tree.nodes());
+    result.indices() = tree.indices();
+
+    return result;
+}
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_COLLAPSE_H
@@ -31,7 +31,7 @@ inline aabb get_bounds(BVH const& bvh)
 template <
     typename BVH,
     typename = typename std::enable_if<is_any_bvh<BVH>::value>::type,
-    typename = typename std::enable_if<is_any_bvh_inst<BVH>::value>::type,
+    typename = typename std::enable_if<is_any_bvh_inst<BVH>::value && !is_motion_bvh_inst<BVH>::value>::type,
     typename = void
     >
 VSNRAY_FUNC
@@ -56,4 +56,43 @@ inline aabb get_bounds(BVH const& bvh)
     return result;
 }
 
+// Overload for motion instances, bounds at keyframe k
+template <typename R, unsigned K>
+VSNRAY_FUNC
+inline aabb get_bounds(bvh_motion_inst_t<R, K> const& inst, unsigned k)
+{
+    mat3 affine = inst.affine(k);
+    vec3 trans = inst.trans(k);
+
+    aabb bbox = get_bounds(inst.get_ref());
+
+    aabb result;
+    result.invalidate();
+
+    auto vertices = compute_vertices(bbox);
+
+    for (vec3 v : vertices)
+    {
+        v = affine * v + trans;
+        result.insert(v);
+    }
+
+    return result;
+}
+
+// Overload for motion instances, bounds over the whole shutter interval
+template <typename R, unsigned K>
+VSNRAY_FUNC
+inline aabb get_bounds(bvh_motion_inst_t<R, K> const& inst)
+{
+    aabb result = get_bounds(inst, 0);
+
+    for (unsigned k = 1; k < K; ++k)
+    {
+        result = combine(result, get_bounds(inst, k));
+    }
+
+    return result;
+}
+
 } // visionaray
@@ -107,6 +107,74 @@ void update_if(
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Instance path
+//
+// Indices into the primitive lists of all BVHs along the path from the top-level BVH to
+// the primitive that was hit. With (nested) instances, the first index refers to the
+// instance in the top-level BVH, the last index to the primitive in the bottom-level BVH
+//
+
+template <typename HR>
+struct instance_path_length : std::integral_constant<size_t, 0> {};
+
+template <typename R, typename Base>
+struct instance_path_length<hit_record_bvh<R, Base>>
+    : std::integral_constant<size_t, 1 + instance_path_length<Base>::value>
+{
+};
+
+template <typename R, typename Base>
+struct instance_path_length<hit_record_bvh_inst<R, Base>>
+    : std::integral_constant<size_t, 1 + instance_path_length<Base>::value>
+{
+};
+
+namespace detail
+{
+
+template <typename HR, typename I>
+VSNRAY_FUNC
+inline void write_instance_path(HR const& /* */, I* /* */)
+{
+}
+
+template <typename R, typename Base, typename I>
+VSNRAY_FUNC
+inline void write_instance_path(hit_record_bvh<R, Base> const& hr, I* path);
+
+template <typename R, typename Base, typename I>
+VSNRAY_FUNC
+inline void write_instance_path(hit_record_bvh_inst<R, Base> const& hr, I* path);
+
+template <typename R, typename Base, typename I>
+VSNRAY_FUNC
+inline void write_instance_path(hit_record_bvh<R, Base> const& hr, I* path)
+{
+    path[0] = hr.primitive_list_index;
+    write_instance_path(static_cast<Base const&>(hr), path + 1);
+}
+
+template <typename R, typename Base, typename I>
+VSNRAY_FUNC
+inline void write_instance_path(hit_record_bvh_inst<R, Base> const& hr, I* path)
+{
+    path[0] = hr.primitive_list_index_inst;
+    write_instance_path(static_cast<Base const&>(hr), path + 1);
+}
+
+} // detail
+
+template <typename HR>
+VSNRAY_FUNC
+inline array<typename HR::int_type, instance_path_length<HR>::value> get_instance_path(HR const& hr)
+{
+    array<typename HR::int_type, instance_path_length<HR>::value> result;
+    detail::write_instance_path(hr, result.data());
+    return result;
+}
+
+
 namespace simd
 {
 
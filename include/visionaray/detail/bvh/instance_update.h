@@ -0,0 +1,552 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_INSTANCE_UPDATE_H
+#define VSNRAY_DETAIL_BVH_INSTANCE_UPDATE_H 1
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "../../math/aabb.h"
+#include "../../math/matrix.h"
+#include "../../aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// bvh_instance_updater
+//
+// Updates a top-level index_bvh after some of its instances have moved, without
+// rebuilding it. Moved instances are removed from their leaves and re-inserted where
+// they increase the summed surface area the least (branch and bound search, cf. Bittner
+// et al. (2013): Fast Insertion-Based Optimization of Bounding Volume Hierarchies).
+// Leaves with a single instance are moved as a whole, instances that share a leaf with
+// others get a leaf of their own, the tree then grows by two nodes. Only the bounds
+// along the paths to the root are refitted, so an update costs O(k log n) for k moved
+// instances.
+//
+// The SAH cost of the tree is tracked incrementally. When it exceeds rebuild_threshold()
+// times the cost right after the last full build, the tree is rebuilt with the builder
+// that is passed to update().
+//
+// Instances are identified by their index in the array that was passed to the builder,
+// which index BVHs preserve (also across rebuilds). Works with any primitive type, the
+// overload of update() that takes transforms requires [index_]bvh_inst_t primitives.
+//
+
+struct bvh_update_result
+{
+    // Number of instance references that were re-inserted
+    size_t num_reinserted = 0;
+
+    // SAH cost after the update and cost right after the last full build
+    float sah = 0.0f;
+    float sah_build = 0.0f;
+
+    // True if the tree was rebuilt, nodes and indices were replaced
+    bool rebuilt = false;
+};
+
+class bvh_instance_updater
+{
+public:
+
+    explicit bvh_instance_updater(float rebuild_threshold = 1.5f, int max_leaf_size = -1)
+        : rebuild_threshold_(rebuild_threshold)
+        , max_leaf_size_(max_leaf_size)
+    {
+    }
+
+    // Rebuild when the SAH cost grows by more than this factor, 0 never rebuilds
+    void set_rebuild_threshold(float threshold)
+    {
+        rebuild_threshold_ = threshold;
+    }
+
+    float rebuild_threshold() const
+    {
+        return rebuild_threshold_;
+    }
+
+    // Set the transforms of instances tree.primitives()[indices[i]] to transforms[i]
+    // and update the tree. pool is passed on to the builder when the tree is rebuilt
+    template <typename Tree, typename Builder, typename ...Pool>
+    bvh_update_result update(
+            Tree&           tree,
+            Builder&        builder,
+            unsigned const* indices,
+            mat4x3 const*   transforms,
+            size_t          count,
+            Pool&...        pool
+            )
+    {
+        using instance_type = typename Tree::primitive_type;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto& inst = tree.primitives()[indices[i]];
+            inst = instance_type(inst.get_ref(), transforms[i]);
+        }
+
+        return update(tree, builder, indices, count, pool...);
+    }
+
+    // The caller changed instances tree.primitives()[indices[i]], update the tree
+    template <typename Tree, typename Builder, typename ...Pool>
+    bvh_update_result update(
+            Tree&           tree,
+            Builder&        builder,
+            unsigned const* indices,
+            size_t          count,
+            Pool&...        pool
+            )
+    {
+        bvh_update_result result;
+
+        if (!prepare(tree))
+        {
+            return result;
+        }
+
+        std::vector<unsigned> moved(indices, indices + count);
+        std::sort(moved.begin(), moved.end());
+        moved.erase(std::unique(moved.begin(), moved.end()), moved.end());
+
+        for (unsigned prim : moved)
+        {
+            assert(prim < tree.num_primitives());
+
+            for (unsigned j = offsets_[prim]; j != offsets_[prim + 1]; ++j)
+            {
+                unsigned leaf = leaf_of_index_[positions_[j]];
+                unsigned pair = 0;
+
+                if (tree.node(leaf).get_num_primitives() > 1)
+                {
+                    pair = split(tree, leaf, positions_[j]);
+                }
+                else
+                {
+                    update_leaf_bounds(tree, leaf);
+
+                    if (leaf == 0)
+                    {
+                        // Root is the only leaf
+                        continue;
+                    }
+
+                    pair = remove(tree, leaf);
+                }
+
+                insert(tree, pair);
+
+                ++result.num_reinserted;
+            }
+        }
+
+        result.sah = cost(tree);
+        result.sah_build = sah_build_;
+
+        if (rebuild_threshold_ > 0.0f && result.sah > sah_build_ * rebuild_threshold_)
+        {
+            tree = builder.build(Tree{}, tree.primitives().data(), tree.num_primitives(), max_leaf_size_, pool...);
+
+            reset();
+            prepare(tree);
+
+            result.sah = sah_build_;
+            result.sah_build = sah_build_;
+            result.rebuilt = true;
+        }
+
+        return result;
+    }
+
+    // Discard the bookkeeping, the next update() considers the tree freshly built
+    void reset()
+    {
+        nodes_ = nullptr;
+        num_nodes_ = 0;
+        parents_.clear();
+        leaf_of_index_.clear();
+        offsets_.clear();
+        positions_.clear();
+        area_inner_ = 0.0f;
+        area_leaves_ = 0.0f;
+        sah_build_ = 0.0f;
+    }
+
+private:
+
+    enum { Root = -1, Unreachable = -2 };
+
+    // Same constants as sah_cost()
+    static constexpr float Ci = 1.2f;
+
+    float rebuild_threshold_ = 1.5f;
+    int max_leaf_size_ = -1;
+
+    // Identifies the tree that the bookkeeping refers to
+    void const* nodes_ = nullptr;
+    size_t num_nodes_ = 0;
+
+    // Parent node index, Root or Unreachable
+    aligned_vector<int> parents_;
+
+    // Leaf node that refers to each entry of tree.indices()
+    aligned_vector<unsigned> leaf_of_index_;
+
+    // Entries of tree.indices() that refer to primitive i are
+    // positions_[offsets_[i]] to positions_[offsets_[i + 1]]
+    aligned_vector<unsigned> offsets_;
+    aligned_vector<unsigned> positions_;
+
+    // Summed surface area of inner nodes and of leaves times #primitives
+    float area_inner_ = 0.0f;
+    float area_leaves_ = 0.0f;
+
+    // SAH cost after the last full build
+    float sah_build_ = 0.0f;
+
+    // Build the bookkeeping if necessary, returns false for empty trees
+    template <typename Tree>
+    bool prepare(Tree const& tree)
+    {
+        static_assert(is_index_bvh<Tree>::value, "Type mismatch");
+        static_assert(!is_wide_bvh<Tree>::value, "Type mismatch");
+
+        if (tree.num_nodes() == 0)
+        {
+            return false;
+        }
+
+        if (nodes_ == tree.nodes().data() && num_nodes_ == tree.num_nodes())
+        {
+            return true;
+        }
+
+        reset();
+
+        nodes_ = tree.nodes().data();
+        num_nodes_ = tree.num_nodes();
+
+        parents_.resize(num_nodes_, Unreachable);
+        parents_[0] = Root;
+        leaf_of_index_.resize(tree.num_indices());
+
+        // Depth-first from the root, so that nodes not referenced by the tree are ignored
+        std::vector<unsigned> st;
+        st.push_back(0);
+
+        while (!st.empty())
+        {
+            unsigned index = st.back();
+            st.pop_back();
+
+            auto const& node = tree.node(index);
+
+            if (node.is_inner())
+            {
+                for (unsigned i = 0; i < 2; ++i)
+                {
+                    unsigned child = node.get_child(i);
+                    parents_[child] = static_cast<int>(index);
+                    st.push_back(child);
+                }
+            }
+            else
+            {
+                set_leaf_of_index(node, index);
+            }
+
+            add_cost(node, 1.0f);
+        }
+
+        // Primitives may be referenced more than once, e.g. after spatial splits
+        offsets_.resize(tree.num_primitives() + 1, 0);
+
+        for (size_t i = 0; i < tree.num_indices(); ++i)
+        {
+            ++offsets_[tree.indices()[i] + 1];
+        }
+
+        for (size_t i = 0; i < tree.num_primitives(); ++i)
+        {
+            offsets_[i + 1] += offsets_[i];
+        }
+
+        positions_.resize(tree.num_indices());
+
+        std::vector<unsigned> next(offsets_.begin(), offsets_.end() - 1);
+
+        for (size_t i = 0; i < tree.num_indices(); ++i)
+        {
+            positions_[next[tree.indices()[i]]++] = static_cast<unsigned>(i);
+        }
+
+        sah_build_ = cost(tree);
+
+        return true;
+    }
+
+    // Add (sign = 1) or subtract (sign = -1) the contribution of a node to the SAH cost
+    template <typename Node>
+    void add_cost(Node const& node, float sign)
+    {
+        float area = surface_area(node.get_bounds());
+
+        if (node.is_inner())
+        {
+            area_inner_ += sign * area;
+        }
+        else
+        {
+            area_leaves_ += sign * area * static_cast<float>(node.get_num_primitives());
+        }
+    }
+
+    template <typename Tree>
+    float cost(Tree const& tree) const
+    {
+        float area_root = surface_area(tree.node(0).get_bounds());
+
+        return (Ci * area_inner_ + area_leaves_) / area_root;
+    }
+
+    template <typename Node>
+    void set_leaf_of_index(Node const& leaf, unsigned index)
+    {
+        auto indices = leaf.get_indices();
+
+        for (unsigned i = indices.first; i != indices.last; ++i)
+        {
+            leaf_of_index_[i] = index;
+        }
+    }
+
+    // Copy a node to another position, its children or indices now refer to that position
+    template <typename Tree>
+    void move_node(Tree& tree, unsigned from, unsigned to)
+    {
+        tree.nodes()[to] = tree.node(from);
+
+        auto const& node = tree.node(to);
+
+        if (node.is_inner())
+        {
+            parents_[node.get_child(0)] = static_cast<int>(to);
+            parents_[node.get_child(1)] = static_cast<int>(to);
+        }
+        else
+        {
+            set_leaf_of_index(node, to);
+        }
+    }
+
+    // Recompute leaf bounds from the primitives that have moved
+    template <typename Tree>
+    void update_leaf_bounds(Tree& tree, unsigned leaf)
+    {
+        auto const& node = tree.node(leaf);
+
+        aabb bbox;
+        bbox.invalidate();
+
+        auto indices = node.get_indices();
+
+        for (unsigned i = indices.first; i != indices.last; ++i)
+        {
+            bbox.insert(get_bounds(tree.primitive(i)));
+        }
+
+        add_cost(node, -1.0f);
+        tree.nodes()[leaf].set_leaf(bbox, node.get_first_primitive(), node.get_num_primitives());
+        add_cost(tree.node(leaf), 1.0f);
+    }
+
+    // Recompute inner node bounds from index up to the root, stops early
+    // when the bounds of a node did not change
+    template <typename Tree>
+    void refit_upwards(Tree& tree, int index)
+    {
+        while (index >= 0)
+        {
+            auto const& node = tree.node(index);
+
+            aabb bounds = combine(
+                    tree.node(node.get_child(0)).get_bounds(),
+                    tree.node(node.get_child(1)).get_bounds()
+                    );
+
+            if (bounds.min == node.get_bounds().min && bounds.max == node.get_bounds().max)
+            {
+                return;
+            }
+
+            add_cost(node, -1.0f);
+            tree.nodes()[index].set_inner(bounds, node.get_child(0));
+            add_cost(tree.node(index), 1.0f);
+
+            index = parents_[index];
+        }
+    }
+
+    // Remove a leaf from the tree, its sibling replaces their parent. The leaf stays at its
+    // position, returns the position of the first node of the pair that is no longer
+    // referenced (the leaf and its former sibling)
+    template <typename Tree>
+    unsigned remove(Tree& tree, unsigned leaf)
+    {
+        unsigned parent = static_cast<unsigned>(parents_[leaf]);
+        unsigned pair = tree.node(parent).get_child(0);
+        unsigned sibling = leaf == pair ? pair + 1 : pair;
+
+        add_cost(tree.node(parent), -1.0f);
+        move_node(tree, sibling, parent);
+
+        refit_upwards(tree, parents_[parent]);
+
+        // Keep the leaf at the first position of the pair
+        if (leaf != pair)
+        {
+            move_node(tree, leaf, pair);
+        }
+
+        return pair;
+    }
+
+    // Move the primitive at index position from a leaf with several primitives to a new
+    // leaf at the end of the node array, followed by an unused node. Returns the position
+    // of the new leaf
+    template <typename Tree>
+    unsigned split(Tree& tree, unsigned leaf, unsigned position)
+    {
+        auto const& node = tree.node(leaf);
+
+        unsigned first = node.get_first_primitive();
+        unsigned last = first + node.get_num_primitives() - 1;
+
+        // Swap the primitive with the last one of the leaf
+        if (position != last)
+        {
+            auto& indices = tree.indices();
+
+            replace_position(indices[position], position, last);
+            replace_position(indices[last], last, position);
+
+            std::swap(indices[position], indices[last]);
+        }
+
+        add_cost(node, -1.0f);
+        tree.nodes()[leaf].set_leaf(node.get_bounds(), first, last - first);
+        add_cost(tree.node(leaf), 1.0f);
+
+        update_leaf_bounds(tree, leaf);
+
+        refit_upwards(tree, parents_[leaf]);
+
+        unsigned pair = static_cast<unsigned>(tree.num_nodes());
+
+        tree.nodes().resize(pair + 2);
+        tree.nodes()[pair].set_leaf(get_bounds(tree.primitive(last)), last, 1);
+        add_cost(tree.node(pair), 1.0f);
+
+        leaf_of_index_[last] = pair;
+
+        parents_.resize(pair + 2, Unreachable);
+
+        nodes_ = tree.nodes().data();
+        num_nodes_ = tree.num_nodes();
+
+        return pair;
+    }
+
+    void replace_position(unsigned prim, unsigned from, unsigned to)
+    {
+        for (unsigned j = offsets_[prim]; j != offsets_[prim + 1]; ++j)
+        {
+            if (positions_[j] == from)
+            {
+                positions_[j] = to;
+                return;
+            }
+        }
+    }
+
+    // Insert the leaf at position pair where it increases the summed surface area the
+    // least. The leaf becomes the sibling of the node that was found, both are placed at
+    // pair and pair + 1, the new parent takes the position of the node
+    template <typename Tree>
+    void insert(Tree& tree, unsigned pair)
+    {
+        aabb leaf_bounds = tree.node(pair).get_bounds();
+        float leaf_area = surface_area(leaf_bounds);
+
+        // Candidates ordered by the surface area induced in their ancestors
+        using candidate = std::pair<float, unsigned>;
+        std::priority_queue<candidate, std::vector<candidate>, std::greater<candidate>> queue;
+        queue.push({ 0.0f, 0U });
+
+        float best_cost = std::numeric_limits<float>::max();
+        unsigned best = 0;
+
+        while (!queue.empty())
+        {
+            candidate c = queue.top();
+            queue.pop();
+
+            // Lower bound for the cost of inserting into this subtree
+            if (c.first + leaf_area >= best_cost)
+            {
+                break;
+            }
+
+            auto const& node = tree.node(c.second);
+
+            float direct = surface_area(combine(node.get_bounds(), leaf_bounds));
+            float total = c.first + direct;
+
+            if (total < best_cost)
+            {
+                best_cost = total;
+                best = c.second;
+            }
+
+            if (node.is_inner())
+            {
+                float induced = total - surface_area(node.get_bounds());
+
+                if (induced + leaf_area < best_cost)
+                {
+                    queue.push({ induced, node.get_child(0) });
+                    queue.push({ induced, node.get_child(1) });
+                }
+            }
+        }
+
+        move_node(tree, pair, pair + 1);
+        move_node(tree, best, pair);
+
+        parents_[pair] = static_cast<int>(best);
+        parents_[pair + 1] = static_cast<int>(best);
+
+        aabb bounds = combine(tree.node(pair).get_bounds(), leaf_bounds);
+        tree.nodes()[best].set_inner(bounds, pair);
+        add_cost(tree.node(best), 1.0f);
+
+        refit_upwards(tree, parents_[best]);
+    }
+};
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_INSTANCE_UPDATE_H
@@ -23,6 +23,30 @@
 
 namespace visionaray
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Bounds of a node to test a ray against. Motion nodes are interpolated for the time
+// sample of the ray.
+//
+
+template <typename R>
+VSNRAY_FUNC
+inline aabb const& node_bounds(bvh_node const& node, R const& /* */)
+{
+    return node.get_bounds();
+}
+
+template <unsigned K, typename R>
+VSNRAY_FUNC
+inline basic_aabb<typename R::scalar_type> node_bounds(bvh_motion_node<K> const& node, R const& ray)
+{
+    return node.get_bounds_at(get_time(ray));
+}
+
+} // detail
+
 
 //-------------------------------------------------------------------------------------------------
 // Ray / BVH intersection
@@ -34,7 +58,7 @@ template <
     typename R,
     typename BVH,
     typename = typename std::enable_if<is_any_bvh<BVH>::value>::type,
-    typename = typename std::enable_if<!is_any_bvh_inst<BVH>::value>::type,
+    typename = typename std::enable_if<!is_any_bvh_inst<BVH>::value && !is_wide_bvh<BVH>::value>::type,
     typename Intersector,
     typename T = typename R::scalar_type,
     typename Cond = is_closer_t
@@ -51,6 +75,11 @@ inline auto intersect(
             decltype( isect(ray, std::declval<typename BVH::primitive_type>()) )
             >, Traversal, MultiHitMax>::type
 {
+    static_assert(
+            Traversal != detail::MultiHit || !is_multi_triangle<typename BVH::primitive_type>::value,
+            "Multi triangles only report their closest hit and don't support multi-hit traversal"
+            );
+
 #if VSNRAY_FULL_STACK_TRAVERSAL_
     using namespace detail;
     using HR = hit_record_bvh<R, decltype(isect(ray, std::declval<typename BVH::primitive_type>()))>;
@@ -77,8 +106,8 @@ next:
         {
             auto children = &b.node(node.get_child(0));
 
-            auto hr1 = isect(ray, children[0].get_bounds(), inv_dir);
-            auto hr2 = isect(ray, children[1].get_bounds(), inv_dir);
+            auto hr1 = isect(ray, node_bounds(children[0], ray), inv_dir);
+            auto hr2 = isect(ray, node_bounds(children[1], ray), inv_dir);
 
             auto b1 = any(is_closer(hr1, result, ray.tmin, ray.tmax));
             auto b2 = any(is_closer(hr2, result, ray.tmin, ray.tmax));
@@ -142,7 +171,7 @@ next:
 
     auto inv_dir = T(1.0) / ray.dir;
 
-    bvh_node node = b.node(0);
+    typename BVH::node_type node = b.node(0);
 
     uint64_t level = 0x8000000000000000ULL;
 
@@ -221,8 +250,8 @@ next:
         {
             auto children = &b.node(node.get_child(0));
 
-            auto hr1 = isect(ray, children[0].get_bounds(), inv_dir);
-            auto hr2 = isect(ray, children[1].get_bounds(), inv_dir);
+            auto hr1 = isect(ray, node_bounds(children[0], ray), inv_dir);
+            auto hr2 = isect(ray, node_bounds(children[1], ray), inv_dir);
 
             auto b1 = any(is_closer(hr1, result, ray.tmin, ray.tmax));
             auto b2 = any(is_closer(hr2, result, ray.tmin, ray.tmax));
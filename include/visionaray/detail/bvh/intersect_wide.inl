@@ -0,0 +1,412 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "../../math/simd/simd.h"
+#include "../../math/aabb.h"
+#include "../../math/intersect.h"
+#include "../../math/limits.h"
+#include "../../math/vector.h"
+#include "../../intersector.h"
+#include "../../update_if.h"
+
+#include "../exit_traversal.h"
+#include "../stack.h"
+#include "../tags.h"
+#include "../traversal_result.h"
+#include "collapse.h"
+#include "hit_record.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// SIMD type to test the child boxes of a wide node with
+//
+
+template <unsigned N>
+struct wide_node_float;
+
+template <>
+struct wide_node_float<4>
+{
+    using type = simd::float4;
+};
+
+template <>
+struct wide_node_float<8>
+{
+    using type = simd::float8;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Load unsigned 8-bit values and convert them to float
+//
+
+VSNRAY_CPU_FUNC
+inline void load_quantized(unsigned char const* q, simd::float4& result)
+{
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE4_1)
+    int bits;
+    std::memcpy(&bits, q, sizeof(bits));
+    result = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bits)));
+#else
+    VSNRAY_ALIGN(16) float f[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        f[i] = static_cast<float>(q[i]);
+    }
+
+    result = simd::float4(f);
+#endif
+}
+
+VSNRAY_CPU_FUNC
+inline void load_quantized(unsigned char const* q, simd::float8& result)
+{
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
+    result = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(q))));
+#else
+    VSNRAY_ALIGN(32) float f[8];
+
+    for (int i = 0; i < 8; ++i)
+    {
+        f[i] = static_cast<float>(q[i]);
+    }
+
+    result = simd::float8(f);
+#endif
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Distances along a single ray to the child box planes of a wide node, in N-wide SIMD vectors
+//
+
+template <unsigned N, typename F>
+VSNRAY_CPU_FUNC
+inline void child_plane_distances(
+        bvh_wide_node<N> const& node,
+        vec3 const&             ori,
+        vec3 const&             inv_dir,
+        F*                      t1,
+        F*                      t2
+        )
+{
+    t1[0] = (F(node.min_x) - F(ori.x)) * F(inv_dir.x);
+    t1[1] = (F(node.min_y) - F(ori.y)) * F(inv_dir.y);
+    t1[2] = (F(node.min_z) - F(ori.z)) * F(inv_dir.z);
+    t2[0] = (F(node.max_x) - F(ori.x)) * F(inv_dir.x);
+    t2[1] = (F(node.max_y) - F(ori.y)) * F(inv_dir.y);
+    t2[2] = (F(node.max_z) - F(ori.z)) * F(inv_dir.z);
+}
+
+// Quantized nodes: the plane at origin + q * scale is at (q * scale + origin - ori) / dir.
+// Decoding the plane before dividing by the direction keeps q = 0 planes from yielding
+// 0 * inf = NaN for axis-parallel rays.
+
+template <unsigned N, typename F>
+VSNRAY_CPU_FUNC
+inline void child_plane_distances(
+        bvh_quantized_node<N> const& node,
+        vec3 const&                  ori,
+        vec3 const&                  inv_dir,
+        F*                           t1,
+        F*                           t2
+        )
+{
+    unsigned char const* qmin[] = { node.qmin_x, node.qmin_y, node.qmin_z };
+    unsigned char const* qmax[] = { node.qmax_x, node.qmax_y, node.qmax_z };
+
+    vec3 scale = node.get_scale();
+
+    for (int a = 0; a < 3; ++a)
+    {
+        F s(scale[a]);
+        F o(node.origin[a] - ori[a]);
+        F id(inv_dir[a]);
+
+        F lo;
+        F hi;
+        load_quantized(qmin[a], lo);
+        load_quantized(qmax[a], hi);
+
+        t1[a] = (lo * s + o) * id;
+        t2[a] = (hi * s + o) * id;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Intersect ray with the child boxes of a wide node
+//
+// Writes the slots of the children that need to be visited to order[] and their entry
+// distances to tnear[] and returns the number of children to visit. Children are sorted
+// near to far for single rays and stay in slot order for ray packets.
+//
+
+// Single rays: test all child boxes at once with one N-wide slab test
+
+template <typename Intersector, typename Node, typename RT>
+VSNRAY_CPU_FUNC
+inline unsigned intersect_children(
+        basic_ray<float> const& ray,
+        vec3 const&             inv_dir,
+        Node const&             node,
+        Intersector&            isect,
+        RT const&               result,
+        unsigned*               order,
+        float*                  tnear
+        )
+{
+    VSNRAY_UNUSED(isect);
+
+    enum { N = Node::Width };
+
+    using F = typename wide_node_float<N>::type;
+
+    F t1[3];
+    F t2[3];
+    child_plane_distances(node, ray.ori, inv_dir, t1, t2);
+
+    F t1x = t1[0];
+    F t1y = t1[1];
+    F t1z = t1[2];
+    F t2x = t2[0];
+    F t2y = t2[1];
+    F t2z = t2[2];
+
+    F tn = max( max(min(t1x, t2x), min(t1y, t2y)), min(t1z, t2z) );
+    F tf = min( min(max(t1x, t2x), max(t1y, t2y)), max(t1z, t2z) );
+
+    auto hit = tf >= tn && tf >= F(ray.tmin) && tn <= F(ray.tmax);
+
+    if (!any(hit))
+    {
+        return 0;
+    }
+
+    VSNRAY_ALIGN(32) float tfar[N];
+
+    store(tnear, select(hit, tn, F(numeric_limits<float>::max())));
+    store(tfar, tf);
+
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < N && !node.is_empty(i); ++i)
+    {
+        if (tnear[i] == numeric_limits<float>::max())
+        {
+            continue;
+        }
+
+        hit_record<basic_ray<float>, aabb> hr;
+        hr.hit   = true;
+        hr.tnear = tnear[i];
+        hr.tfar  = tfar[i];
+
+        if (!any(is_closer(hr, result, ray.tmin, ray.tmax)))
+        {
+            continue;
+        }
+
+        // Insertion sort by distance
+        unsigned j = count++;
+
+        while (j > 0 && tnear[order[j - 1]] > tnear[i])
+        {
+            order[j] = order[j - 1];
+            --j;
+        }
+
+        order[j] = i;
+    }
+
+    return count;
+}
+
+// Ray packets: test the child boxes one after another
+
+template <typename Intersector, typename R, typename Node, typename RT>
+VSNRAY_CPU_FUNC
+inline unsigned intersect_children(
+        R const&                                   ray,
+        vector<3, typename R::scalar_type> const&  inv_dir,
+        Node const&                                node,
+        Intersector&                               isect,
+        RT const&                                  result,
+        unsigned*                                  order,
+        typename R::scalar_type*                   tnear
+        )
+{
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < Node::Width && !node.is_empty(i); ++i)
+    {
+        auto hr = isect(ray, node.get_bounds(i), inv_dir);
+
+        if (any(is_closer(hr, result, ray.tmin, ray.tmax)))
+        {
+            order[count++] = i;
+            tnear[i] = hr.tnear;
+        }
+    }
+
+    return count;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Ray / wide BVH intersection
+//
+// Leaf children are intersected as soon as they are encountered, nearest first, inner
+// children are pushed onto the traversal stack so that the nearest one is visited next.
+// Popped nodes are skipped if a closer hit was found after they were pushed.
+// Single rays test the child boxes of a node with a built-in SIMD slab test, so custom
+// box intersectors only apply to ray packets. Quantized nodes are decoded on the fly.
+//
+
+template <
+    detail::traversal_type Traversal,
+    size_t MultiHitMax = 1,             // Max hits for multi-hit traversal
+    typename R,
+    typename BVH,
+    typename = typename std::enable_if<
+            is_any_bvh<BVH>::value && !is_any_bvh_inst<BVH>::value && is_wide_bvh<BVH>::value
+            >::type,
+    typename Intersector,
+    typename T = typename R::scalar_type,
+    typename Cond = is_closer_t
+    >
+VSNRAY_CPU_FUNC
+inline auto intersect(
+        R const&     ray,
+        BVH const&   b,
+        Intersector& isect,
+        Cond         update_cond = Cond()
+        )
+    -> typename detail::traversal_result< hit_record_bvh<
+            R,
+            decltype( isect(ray, std::declval<typename BVH::primitive_type>()) )
+            >, Traversal, MultiHitMax>::type
+{
+    static_assert(
+            Traversal != detail::MultiHit || !is_multi_triangle<typename BVH::primitive_type>::value,
+            "Multi triangles only report their closest hit and don't support multi-hit traversal"
+            );
+
+    using namespace detail;
+    using HR = hit_record_bvh<R, decltype(isect(ray, std::declval<typename BVH::primitive_type>()))>;
+
+    using RT = typename detail::traversal_result<HR, Traversal, MultiHitMax>::type;
+
+    using node_type = typename std::remove_cv<
+            typename std::remove_reference<decltype(b.node(0))>::type
+            >::type;
+
+    enum { Width = node_type::Width };
+
+    RT result;
+
+    if (b.num_nodes() == 0)
+    {
+        return result;
+    }
+
+    // Node addresses and entry distances
+    enum { StackSize = wide_traversal_stack<Width>::Size };
+
+    stack<StackSize> st;
+    stack<StackSize, T> st_tnear;
+
+    st.push(0); // address of root node
+    st_tnear.push(T(-numeric_limits<float>::max()));
+
+    auto inv_dir = T(1.0) / ray.dir;
+
+    while (!st.empty())
+    {
+        auto const& node = b.node(st.pop());
+
+        // Skip nodes that are farther away than the closest hit found since they were pushed
+        hit_record<basic_ray<T>, aabb> node_hr;
+        node_hr.hit   = true;
+        node_hr.tnear = st_tnear.pop();
+        node_hr.tfar  = numeric_limits<T>::max();
+
+        if (!any(is_closer(node_hr, result, ray.tmin, ray.tmax)))
+        {
+            continue;
+        }
+
+        unsigned order[Width];
+        VSNRAY_ALIGN(32) T tnear[Width];
+
+        unsigned count = intersect_children(ray, inv_dir, node, isect, result, order, tnear);
+
+        unsigned inner[Width];
+        unsigned num_inner = 0;
+
+        for (unsigned c = 0; c < count; ++c)
+        {
+            unsigned slot = order[c];
+
+            if (node.is_inner(slot))
+            {
+                inner[num_inner++] = slot;
+                continue;
+            }
+
+
+            // perform ray-primitive intersection tests
+
+            auto indices = node.get_indices(slot);
+
+            for (auto i = indices.first; i != indices.last; ++i)
+            {
+                auto prim = b.primitive(i);
+
+                auto hr = HR(isect(ray, prim), i);
+                auto closer = update_cond(hr, result, ray.tmin, ray.tmax);
+
+                if (!any(closer))
+                {
+                    continue;
+                }
+
+                update_if(result, hr, closer);
+
+                exit_traversal<Traversal> early_exit;
+                if (early_exit.check(result))
+                {
+                    return result;
+                }
+            }
+        }
+
+        // Push far to near so that the nearest child is visited next
+        assert(st.size() + num_inner <= StackSize);
+
+        while (num_inner > 0)
+        {
+            unsigned slot = inner[--num_inner];
+            st.push(node.get_child(slot));
+            st_tnear.push(tnear[slot]);
+        }
+    }
+
+    return result;
+}
+
+} // visionaray
@@ -8,20 +8,33 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 #ifdef __CUDACC__
 #include <thrust/device_vector.h>
 #include <thrust/sort.h>
 #endif
 
+#include "../../math/detail/math.h"
 #include "../../aligned_vector.h"
 #include "../../morton.h"
+#include "../algorithm.h"
+#include "../parallel_algorithm.h"
+#include "../parallel_for.h"
+#include "../range.h"
 
 #ifdef _WIN32
 #include <intrin.h>
 #endif
 
 #include "build_top_down.h"
+#include "motion.h"
+#include "pack_triangles.h"
+#include "presplit.h"
 
 namespace visionaray
 {
@@ -174,6 +187,160 @@ inline vec2i determine_range(prim_ref* refs, int num_prims, int i, int& split)
         return vec2i(j, i);
 }
 
+//-------------------------------------------------------------------------------------------------
+// Quantize a centroid relative to the centroid bounds and map it to a morton code
+//
+
+VSNRAY_FUNC
+inline unsigned morton_code(vec3 centroid, aabb const& centroid_bounds)
+{
+    // Express centroid in [0..1] relative to bounding box
+    centroid -= centroid_bounds.center();
+    centroid = (centroid + centroid_bounds.size() * 0.5f) / centroid_bounds.size();
+
+    // Quantize centroid to 10-bit
+    centroid = min(max(centroid * 1024.0f, vec3(0.0f)), vec3(1023.0f));
+
+    return morton_encode3D(
+            static_cast<int>(centroid.x),
+            static_cast<int>(centroid.y),
+            static_cast<int>(centroid.z)
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Inner node data structure used for construction on the CPU. Inner nodes are indexed by
+// their split position in the sorted list of primitive references, children with indices
+// >= num_inner are leaves. [first..last] is the (inclusive!) range of sorted primitive
+// references below the node.
+//
+
+struct host_node
+{
+    aabb bbox;
+    int left;
+    int right;
+    int first;
+    int last;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Build the binary radix tree and compute node bounds in a single bottom-up pass
+//
+// cf. Apetrei (2014): Fast and Simple Agglomerative LBVH Construction
+//
+// Produces the same hierarchy as Karras' algorithm, but without the binary searches for
+// the node ranges. Each task starts at a leaf and proceeds upwards. The parent is the node
+// whose split is at the range's boundary with the longer common prefix. The first task to
+// arrive at a parent (tracked by an atomic exchange) terminates, the second one computes the
+// union of the children's bounds and proceeds. Returns the index of the root node.
+//
+
+template <typename Pool>
+inline int build_hierarchy(
+        host_node*      inner,       // OUT: all inner nodes with children and bounds assigned
+        aabb const*     prim_bounds, // IN:  all primitive bounding boxes
+        prim_ref const* prim_refs,   // IN:  prim refs, sorted by morton codes
+        int             num_prims,   // IN:  number of primitives
+        Pool&           pool         // IN:  thread pool
+        )
+{
+    int num_inner = num_prims - 1;
+
+    // Distance between the keys at i and i+1. Duplicate morton codes
+    // are disambiguated by augmenting the keys with their index
+    auto delta = [&](int i)
+    {
+        uint64_t a = (static_cast<uint64_t>(prim_refs[i].morton_code) << 32) | static_cast<uint64_t>(i);
+        uint64_t b = (static_cast<uint64_t>(prim_refs[i + 1].morton_code) << 32) | static_cast<uint64_t>(i + 1);
+        return a ^ b;
+    };
+
+    std::unique_ptr<std::atomic<int>[]> other_bounds(new std::atomic<int>[num_inner]);
+
+    for (int i = 0; i < num_inner; ++i)
+    {
+        other_bounds[i].store(-1, std::memory_order_relaxed);
+    }
+
+    std::atomic<int> root(-1);
+
+    parallel_for(
+        pool,
+        tiled_range1d<int>(0, num_prims, 4096),
+        [&](range1d<int> const& r)
+        {
+            for (int index = r.begin(); index != r.end(); ++index)
+            {
+                int first = index;
+                int last = index;
+                int current = num_inner + index;
+                aabb bbox = prim_bounds[prim_refs[index].id];
+
+                for (;;)
+                {
+                    int parent = -1;
+                    int previous = -1;
+
+                    if (first == 0 || (last != num_inner && delta(last) < delta(first - 1)))
+                    {
+                        // Parent's split is at our right boundary, we're its left child
+                        parent = last;
+                        inner[parent].left = current;
+                        inner[parent].first = first;
+                        previous = other_bounds[parent].exchange(first, std::memory_order_acq_rel);
+
+                        if (previous == -1)
+                        {
+                            break;
+                        }
+
+                        last = previous;
+                    }
+                    else
+                    {
+                        // Parent's split is at our left boundary, we're its right child
+                        parent = first - 1;
+                        inner[parent].right = current;
+                        inner[parent].last = last;
+                        previous = other_bounds[parent].exchange(last, std::memory_order_acq_rel);
+
+                        if (previous == -1)
+                        {
+                            break;
+                        }
+
+                        first = previous;
+                    }
+
+                    // Sibling subtree is finished
+                    int sibling = inner[parent].left == current ? inner[parent].right : inner[parent].left;
+
+                    bbox = combine(
+                            bbox,
+                            sibling >= num_inner ? prim_bounds[prim_refs[sibling - num_inner].id] : inner[sibling].bbox
+                            );
+
+                    inner[parent].bbox = bbox;
+                    inner[parent].first = first;
+                    inner[parent].last = last;
+
+                    current = parent;
+
+                    if (first == 0 && last == num_inner)
+                    {
+                        root.store(parent);
+                        break;
+                    }
+                }
+            }
+        });
+
+    return root.load();
+}
+
 #ifdef __CUDACC__
 
 //-------------------------------------------------------------------------------------------------
@@ -449,6 +616,18 @@ struct lbvh_builder
     aligned_vector<prim_ref> prim_refs;
     aligned_vector<aabb> prim_bounds;
 
+    // Whether to split large primitives before computing morton codes
+    bool use_presplits = false;
+    // Computes the primitive references if use_presplits is set
+    bvh_presplitter presplitter;
+
+    // Start with the references computed by presplitter instead of one reference
+    // per primitive. Primitives of a bvh are then duplicated
+    void enable_presplits(bool enable)
+    {
+        use_presplits = enable;
+    }
+
     VSNRAY_FUNC
     int find_split(prim_ref const* refs, int first, int last) const
     {
@@ -484,7 +663,63 @@ struct lbvh_builder
         return result;
     }
 
-    template <typename Tree, typename P>
+    // Build over triangles and pack the leaves into multi triangles when Tree stores
+    // basic_multi_triangle. Leaves hold up to N triangles unless max_leaf_size is given.
+    template <
+        typename Tree,
+        typename P,
+        typename = typename std::enable_if<is_multi_triangle_bvh<Tree>::value>::type,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
+    {
+        return detail::build_multi_triangle_bvh<Tree>(*this, primitives, num_prims, max_leaf_size);
+    }
+
+    // Build over keyframed primitives when Tree has bvh_motion_nodes. The nodes store
+    // the bounds at each keyframe.
+    template <
+        typename Tree,
+        typename P,
+        typename = typename std::enable_if<is_motion_bvh<Tree>::value>::type,
+        typename = void,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
+    {
+        return detail::build_motion_bvh<Tree>(*this, primitives, num_prims, max_leaf_size);
+    }
+
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<is_multi_triangle_bvh<Tree>::value>::type,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        return detail::build_multi_triangle_bvh<Tree>(*this, primitives, num_prims, max_leaf_size, pool);
+    }
+
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<is_motion_bvh<Tree>::value>::type,
+        typename = void,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        return detail::build_motion_bvh<Tree>(*this, primitives, num_prims, max_leaf_size, pool);
+    }
+
+    template <
+        typename Tree,
+        typename P,
+        typename = typename std::enable_if<!is_multi_triangle_bvh<Tree>::value && !is_motion_bvh<Tree>::value>::type
+        >
     Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
     {
         Tree tree(primitives, num_prims);
@@ -494,6 +729,222 @@ struct lbvh_builder
         return tree;
     }
 
+    //-------------------------------------------------------------------------
+    // Parallel CPU builder. Builds the same radix tree as Karras, Maximizing
+    // parallelism in the construction of BVHs octrees and k-d trees (2012).
+    //
+    // Computes bounds and morton codes in parallel, sorts the primitive
+    // references with a parallel radix sort and emits the hierarchy and the
+    // node bounds in one parallel bottom-up pass. Subtrees with no more than
+    // max_leaf_size primitives are collapsed into leaves.
+    //
+
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<!is_multi_triangle_bvh<Tree>::value && !is_motion_bvh<Tree>::value>::type
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        using namespace detail::lbvh;
+
+        if (max_leaf_size <= 0)
+        {
+            max_leaf_size = 4;
+        }
+
+        Tree tree(primitives, num_prims);
+
+        int n = static_cast<int>(num_prims);
+
+        if (n == 0)
+        {
+            tree.clear();
+            return tree;
+        }
+
+        // Compute primitive bounding boxes, centroids and centroid bounds
+        // (or those of the primitive references)
+
+        static const int TileSize = 16384;
+
+        if (use_presplits)
+        {
+            presplitter.split(primitives, num_prims, pool);
+            n = static_cast<int>(presplitter.size());
+        }
+
+        int num_tiles = div_up(n, TileSize);
+
+        prim_bounds.resize(n);
+        aligned_vector<vec3> centroids(n);
+        std::vector<aabb> tile_bounds(num_tiles);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                aabb cb;
+                cb.invalidate();
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    prim_bounds[i] = use_presplits ? presplitter.bounds()[i] : get_bounds(primitives[i]);
+                    centroids[i] = prim_bounds[i].center();
+                    cb.insert(centroids[i]);
+                }
+
+                tile_bounds[r.begin() / TileSize] = cb;
+            });
+
+        aabb centroid_bounds;
+        centroid_bounds.invalidate();
+
+        for (auto const& cb : tile_bounds)
+        {
+            centroid_bounds.insert(cb);
+        }
+
+        // Compute morton codes for centroids
+
+        aligned_vector<detail::lbvh::prim_ref> refs(n);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    refs[i].id = i;
+                    refs[i].morton_code = morton_code(centroids[i], centroid_bounds);
+                }
+            });
+
+        // Sort prim refs by morton codes (30 bits)
+
+        {
+            aligned_vector<detail::lbvh::prim_ref> temp(n);
+
+            paralgo::radix_sort(
+                    pool,
+                    refs.begin(),
+                    refs.end(),
+                    temp.begin(),
+                    30,
+                    [](detail::lbvh::prim_ref const& ref) { return ref.morton_code; }
+                    );
+        }
+
+        // Assign 0,1,2,3,.. indices in morton order
+
+        aligned_vector<unsigned> indices(n);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    indices[i] = use_presplits
+                            ? presplitter.indices()[refs[i].id]
+                            : static_cast<unsigned>(refs[i].id);
+                }
+            });
+
+        if (n <= max_leaf_size)
+        {
+            aabb bounds;
+            bounds.invalidate();
+
+            for (int i = 0; i < n; ++i)
+            {
+                bounds.insert(prim_bounds[i]);
+            }
+
+            tree.nodes().resize(1);
+            tree.nodes()[0].set_leaf(bounds, 0, static_cast<unsigned>(n));
+
+            assign_indices(tree, primitives, indices, pool);
+
+            return tree;
+        }
+
+        // Build the radix tree hierarchy bottom-up
+
+        int num_inner = n - 1;
+
+        std::vector<host_node> inner(num_inner);
+
+        int root = build_hierarchy(inner.data(), prim_bounds.data(), refs.data(), n, pool);
+
+        // Inner nodes covering more than max_leaf_size primitives are kept, the
+        // others are collapsed into leaves. The children of the k-th kept node are
+        // stored at 1+2k and 2+2k in the Visionaray node array.
+
+        std::vector<int> ranks(num_inner);
+
+        int num_kept = 0;
+
+        for (int i = 0; i < num_inner; ++i)
+        {
+            bool keep = inner[i].last - inner[i].first + 1 > max_leaf_size;
+            ranks[i] = keep ? num_kept++ : -1;
+        }
+
+        tree.nodes().resize(1 + 2 * num_kept);
+
+        tree.nodes()[0].set_inner(inner[root].bbox, 1 + 2 * ranks[root]);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, num_inner, 4096),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    if (ranks[i] < 0)
+                    {
+                        continue;
+                    }
+
+                    int children[] = { inner[i].left, inner[i].right };
+
+                    for (int c = 0; c < 2; ++c)
+                    {
+                        auto& node = tree.nodes()[1 + 2 * ranks[i] + c];
+
+                        int child = children[c];
+
+                        if (child >= num_inner)
+                        {
+                            int prim = child - num_inner;
+                            node.set_leaf(prim_bounds[refs[prim].id], prim, 1);
+                        }
+                        else if (ranks[child] >= 0)
+                        {
+                            node.set_inner(inner[child].bbox, 1 + 2 * ranks[child]);
+                        }
+                        else
+                        {
+                            node.set_leaf(
+                                    inner[child].bbox,
+                                    inner[child].first,
+                                    inner[child].last - inner[child].first + 1
+                                    );
+                        }
+                    }
+                }
+            });
+
+        assign_indices(tree, primitives, indices, pool);
+
+        return tree;
+    }
+
     template <typename I>
     leaf_info init(I first, I last)
     {
@@ -509,13 +960,28 @@ struct lbvh_builder
         centroid_bounds.invalidate();
 
 
-        prim_bounds.resize(last - first);
-        aligned_vector<vec3> centroids(last - first);
+        if (use_presplits)
+        {
+            presplitter.split(&*first, last - first);
+            prim_bounds = presplitter.bounds();
+        }
+        else
+        {
+            prim_bounds.resize(last - first);
+
+            int i = 0;
+            for (auto it = first; it != last; ++it, ++i)
+            {
+                prim_bounds[i] = get_bounds(*it);
+            }
+        }
+
+        int n = static_cast<int>(prim_bounds.size());
+
+        aligned_vector<vec3> centroids(n);
 
-        int i = 0;
-        for (auto it = first; it != last; ++it, ++i)
+        for (int i = 0; i < n; ++i)
         {
-            prim_bounds[i] = get_bounds(*it);
             scene_bounds.insert(prim_bounds[i]);
 
             centroids[i] = prim_bounds[i].center();
@@ -525,30 +991,17 @@ struct lbvh_builder
 
         // Calculate morton codes for centroids
 
-        prim_refs.resize(last - first);
+        prim_refs.resize(n);
 
-        for (int i = 0; i < last - first; ++i)
+        for (int i = 0; i < n; ++i)
         {
-            vec3 centroid = centroids[i];
-
-            // Express centroid in [0..1] relative to bounding box
-            centroid -= centroid_bounds.center();
-            centroid = (centroid + centroid_bounds.size() * 0.5f) / centroid_bounds.size();
-
-            // Quantize centroid to 10-bit
-            centroid = min(max(centroid * 1024.0f, vec3(0.0f)), vec3(1023.0f));
-
             prim_refs[i].id = i;
-            prim_refs[i].morton_code = morton_encode3D(
-                    static_cast<int>(centroid.x),
-                    static_cast<int>(centroid.y),
-                    static_cast<int>(centroid.z)
-                    );
+            prim_refs[i].morton_code = detail::lbvh::morton_code(centroids[i], centroid_bounds);
         }
 
         std::stable_sort(prim_refs.begin(), prim_refs.end());
 
-        return { 0, static_cast<int>(last - first), scene_bounds };
+        return { 0, n, scene_bounds };
     }
 
     // Inserts primitive indices into INDICES.
@@ -557,7 +1010,7 @@ struct lbvh_builder
     {
         for (int i = leaf.first; i < leaf.last; ++i)
         {
-            indices.push_back(prim_refs[i].id);
+            indices.push_back(use_presplits ? presplitter.indices()[prim_refs[i].id] : prim_refs[i].id);
         }
 
         return leaf.last - leaf.first;
@@ -601,6 +1054,40 @@ struct lbvh_builder
         return true;
     }
 
+    // Store the morton ordered indices (index_bvh)
+    template <typename Tree, typename P, typename Pool>
+    void assign_indices(Tree& tree, P* /* */, aligned_vector<unsigned>& indices, Pool& /* */, std::true_type)
+    {
+        tree.indices().assign(indices.begin(), indices.end());
+    }
+
+    // Reorder the primitives according to the indices (bvh)
+    template <typename Tree, typename P, typename Pool>
+    void assign_indices(Tree& tree, P* primitives, aligned_vector<unsigned>& indices, Pool& pool, std::false_type)
+    {
+        int n = static_cast<int>(indices.size());
+
+        // Primitives may be referenced more than once (pre-splitting)
+        tree.primitives().resize(n);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, 16384),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    tree.primitives()[i] = primitives[indices[i]];
+                }
+            });
+    }
+
+    template <typename Tree, typename P, typename Pool>
+    void assign_indices(Tree& tree, P* primitives, aligned_vector<unsigned>& indices, Pool& pool)
+    {
+        assign_indices(tree, primitives, indices, pool, is_index_bvh<Tree>());
+    }
+
 
 #ifdef __CUDACC__
 
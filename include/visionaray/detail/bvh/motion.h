@@ -0,0 +1,151 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_MOTION_H
+#define VSNRAY_DETAIL_BVH_MOTION_H 1
+
+#include <cstddef>
+#include <utility>
+
+#include "../../math/aabb.h"
+#include "../../aligned_vector.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Binary [index_]bvh with the same primitives as the motion BVH Tree
+//
+
+template <typename Tree>
+struct static_bvh;
+
+template <typename PV, unsigned K>
+struct static_bvh<bvh_t<PV, aligned_vector<bvh_motion_node<K>, 32>>>
+{
+    using type = bvh_t<PV, aligned_vector<bvh_node, 32>>;
+};
+
+template <typename PV, unsigned K, typename IV>
+struct static_bvh<index_bvh_t<PV, aligned_vector<bvh_motion_node<K>, 32>, IV>>
+{
+    using type = index_bvh_t<PV, aligned_vector<bvh_node, 32>, IV>;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Compute the keyframe bounds of the subtree at node index, bottom-up
+//
+// Leaves merge get_bounds(prim, k) of their primitives, inner nodes merge the bounds of
+// their children.
+//
+
+template <unsigned K, typename Tree, typename Nodes>
+inline void set_keyframe_bounds(Tree const& tree, Nodes& nodes, unsigned index)
+{
+    auto const& n = tree.node(index);
+
+    aabb bounds[K];
+
+    if (is_leaf(n))
+    {
+        for (unsigned k = 0; k < K; ++k)
+        {
+            bounds[k].invalidate();
+
+            for (unsigned i = n.get_indices().first; i != n.get_indices().last; ++i)
+            {
+                bounds[k] = combine(bounds[k], aabb(get_bounds(tree.primitive(i), k)));
+            }
+        }
+
+        nodes[index].set_leaf(bounds, n.get_first_primitive(), n.get_num_primitives());
+    }
+    else
+    {
+        set_keyframe_bounds<K>(tree, nodes, n.get_child(0));
+        set_keyframe_bounds<K>(tree, nodes, n.get_child(1));
+
+        for (unsigned k = 0; k < K; ++k)
+        {
+            bounds[k] = combine(
+                    nodes[n.get_child(0)].get_bounds(k),
+                    nodes[n.get_child(1)].get_bounds(k)
+                    );
+        }
+
+        nodes[index].set_inner(bounds, n.get_child(0));
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Move the primitives (and indices) of a BVH to a BVH with a different node type
+//
+
+template <typename PV, typename NV1, typename NV2>
+inline void move_primitives(bvh_t<PV, NV1>& dst, bvh_t<PV, NV2>& src)
+{
+    dst.primitives() = std::move(src.primitives());
+}
+
+template <typename PV, typename NV1, typename NV2, typename IV>
+inline void move_primitives(index_bvh_t<PV, NV1, IV>& dst, index_bvh_t<PV, NV2, IV>& src)
+{
+    dst.primitives() = std::move(src.primitives());
+    dst.indices() = std::move(src.indices());
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Build a motion BVH over keyframed primitives
+//
+// Used by the builders when Tree has bvh_motion_nodes. The topology is built with
+// builder over the primitive bounds for the whole shutter interval, the nodes then
+// store the bounds at each of the K keyframes. Primitives must provide
+// get_bounds(prim, k) for keyframes k = 0..K-1.
+//
+
+template <typename Tree, typename Builder, typename P, typename ...Pool>
+inline Tree build_motion_bvh(
+        Builder&    builder,
+        P*          primitives,
+        size_t      num_prims,
+        int         max_leaf_size,
+        Pool&...    pool
+        )
+{
+    enum { K = Tree::node_type::Keyframes };
+
+    static_assert(static_cast<unsigned>(P::Keyframes) == static_cast<unsigned>(K), "Primitives and nodes must have the same number of keyframes");
+
+    auto tree = builder.build(
+            typename static_bvh<Tree>::type{},
+            primitives,
+            num_prims,
+            max_leaf_size,
+            pool...
+            );
+
+    Tree result;
+
+    result.nodes().resize(tree.num_nodes());
+
+    if (tree.num_nodes() > 0)
+    {
+        set_keyframe_bounds<K>(tree, result.nodes(), 0);
+    }
+
+    move_primitives(result, tree);
+
+    return result;
+}
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_MOTION_H
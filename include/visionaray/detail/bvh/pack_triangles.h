@@ -0,0 +1,163 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_PACK_TRIANGLES_H
+#define VSNRAY_DETAIL_BVH_PACK_TRIANGLES_H 1
+
+#include <cstddef>
+
+#include "../../math/multi_triangle.h"
+#include "../../math/triangle.h"
+#include "../../aligned_vector.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Pack the triangles of each leaf into N-wide multi triangles
+//
+// Nodes keep their positions in the node array. Leaves with more than N triangles are
+// assigned several multi triangles, leaf primitive ranges then refer to multi triangles.
+//
+
+template <size_t N, typename Tree, typename Multis, typename Nodes>
+inline void pack_leaf_triangles(Tree const& tree, Multis& multis, Nodes& nodes)
+{
+    using triangle_type = typename Tree::primitive_type;
+
+    nodes = tree.nodes();
+
+    multis.clear();
+    multis.reserve((tree.num_primitives() + N - 1) / N);
+
+    for (auto& n : nodes)
+    {
+        if (!is_leaf(n))
+        {
+            continue;
+        }
+
+        unsigned first = n.get_first_primitive();
+        unsigned count = n.get_num_primitives();
+        unsigned multi_first = static_cast<unsigned>(multis.size());
+
+        for (unsigned i = 0; i < count; i += N)
+        {
+            triangle_type triangles[N];
+            size_t num_triangles = count - i < N ? count - i : N;
+
+            for (size_t j = 0; j < num_triangles; ++j)
+            {
+                triangles[j] = tree.primitive(first + i + j);
+            }
+
+            multis.emplace_back(triangles, num_triangles);
+        }
+
+        n.set_leaf(n.get_bounds(), multi_first, static_cast<unsigned>(multis.size()) - multi_first);
+    }
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Convert a binary [index_]bvh over triangles into a BVH with N-wide multi triangle leaves
+//
+// Primitives are copied, the resulting BVH does not refer to the source BVH after
+// construction. Index BVHs index the multi triangles in order.
+//
+
+template <size_t N, typename T, typename P, typename NV>
+inline bvh_t<aligned_vector<basic_multi_triangle<N, T, P>>, NV> pack_triangles(
+        bvh_t<aligned_vector<basic_triangle<3, T, P>>, NV> const& tree
+        )
+{
+    bvh_t<aligned_vector<basic_multi_triangle<N, T, P>>, NV> result;
+
+    detail::pack_leaf_triangles<N>(tree, result.primitives(), result.nodes());
+
+    return result;
+}
+
+template <size_t N, typename T, typename P, typename NV, typename IV>
+inline index_bvh_t<aligned_vector<basic_multi_triangle<N, T, P>>, NV, IV> pack_triangles(
+        index_bvh_t<aligned_vector<basic_triangle<3, T, P>>, NV, IV> const& tree
+        )
+{
+    index_bvh_t<aligned_vector<basic_multi_triangle<N, T, P>>, NV, IV> result;
+
+    detail::pack_leaf_triangles<N>(tree, result.primitives(), result.nodes());
+
+    result.indices().resize(result.primitives().size());
+
+    for (size_t i = 0; i < result.indices().size(); ++i)
+    {
+        result.indices()[i] = static_cast<unsigned>(i);
+    }
+
+    return result;
+}
+
+
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Binary [index_]bvh with the triangle type that Tree's multi triangles are made up of
+//
+
+template <typename Tree>
+struct unpacked_bvh;
+
+template <size_t N, typename T, typename P, typename NV>
+struct unpacked_bvh<bvh_t<aligned_vector<basic_multi_triangle<N, T, P>>, NV>>
+{
+    using type = bvh_t<aligned_vector<basic_triangle<3, T, P>>, NV>;
+};
+
+template <size_t N, typename T, typename P, typename NV, typename IV>
+struct unpacked_bvh<index_bvh_t<aligned_vector<basic_multi_triangle<N, T, P>>, NV, IV>>
+{
+    using type = index_bvh_t<aligned_vector<basic_triangle<3, T, P>>, NV, IV>;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Build a BVH over triangles with builder and pack its leaves into multi triangles
+//
+// Used by the builders when Tree stores multi triangles. Leaves hold up to N triangles
+// by default so that each leaf is intersected in a single SIMD test.
+//
+
+template <typename Tree, typename Builder, typename P, typename ...Pool>
+inline Tree build_multi_triangle_bvh(
+        Builder&    builder,
+        P*          primitives,
+        size_t      num_prims,
+        int         max_leaf_size,
+        Pool&...    pool
+        )
+{
+    enum { N = Tree::primitive_type::Width };
+
+    auto tree = builder.build(
+            typename unpacked_bvh<Tree>::type{},
+            primitives,
+            num_prims,
+            max_leaf_size < 0 ? static_cast<int>(N) : max_leaf_size,
+            pool...
+            );
+
+    return pack_triangles<N>(tree);
+}
+
+} // detail
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_PACK_TRIANGLES_H
@@ -0,0 +1,558 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_PLOC_H
+#define VSNRAY_DETAIL_BVH_PLOC_H 1
+
+#include <cfloat>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../../math/detail/math.h"
+#include "../../math/aabb.h"
+#include "../../aligned_vector.h"
+#include "../parallel_algorithm.h"
+#include "../parallel_for.h"
+#include "../range.h"
+#include "../thread_pool.h"
+#include "lbvh.h"
+#include "motion.h"
+#include "pack_triangles.h"
+
+namespace visionaray
+{
+namespace detail
+{
+namespace ploc
+{
+
+//-------------------------------------------------------------------------------------------------
+// Node data structure used for construction. Nodes [0..num_prims) are the primitives in
+// morton order, the other ones are created by merging two clusters.
+//
+
+struct cluster_node
+{
+    aabb bbox;
+    int left;
+    int right;
+
+    // Number of primitives below the node
+    int count;
+
+    // SAH cost of the subtree, not normalized by the root surface area
+    float cost;
+
+    // Number of inner nodes that are kept in the subtree
+    int num_inner;
+
+    // Subtree becomes a leaf
+    bool collapsed;
+};
+
+} // ploc
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// ploc_builder
+//
+// Parallel locally-ordered clustering
+//
+// cf. Meister, Bittner (2018): Parallel Locally-Ordered Clustering for Bounding Volume
+// Hierarchy Construction
+//
+// Builds the hierarchy bottom-up. Primitives are sorted by the morton codes of their
+// centroids and start as one cluster each. In each iteration, every cluster finds the
+// cluster within search_radius() positions in the sorted list that minimizes the surface
+// area of their union. Mutual nearest neighbors are merged, and the merged clusters are
+// compacted, keeping the morton order. Subtrees are collapsed into leaves with no more
+// than max_leaf_size primitives where that reduces the SAH cost.
+//
+
+class ploc_builder
+{
+public:
+
+    // Number of neighbors searched in each direction
+    void set_search_radius(int radius)
+    {
+        search_radius_ = radius;
+    }
+
+    int search_radius() const
+    {
+        return search_radius_;
+    }
+
+    // Runs on the calling thread
+    template <typename Tree, typename P>
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
+    {
+        thread_pool pool(0);
+        return build(Tree{}, primitives, num_prims, max_leaf_size, pool);
+    }
+
+    // Build over triangles and pack the leaves into multi triangles when Tree stores
+    // basic_multi_triangle. Leaves hold up to N triangles unless max_leaf_size is given.
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<is_multi_triangle_bvh<Tree>::value>::type,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        return detail::build_multi_triangle_bvh<Tree>(*this, primitives, num_prims, max_leaf_size, pool);
+    }
+
+    // Build over keyframed primitives when Tree has bvh_motion_nodes. The nodes store
+    // the bounds at each keyframe.
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<is_motion_bvh<Tree>::value>::type,
+        typename = void,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        return detail::build_motion_bvh<Tree>(*this, primitives, num_prims, max_leaf_size, pool);
+    }
+
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<!is_multi_triangle_bvh<Tree>::value && !is_motion_bvh<Tree>::value>::type
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        using namespace detail::ploc;
+        using detail::lbvh::prim_ref;
+
+        if (max_leaf_size <= 0)
+        {
+            max_leaf_size = 4;
+        }
+
+        Tree tree(primitives, num_prims);
+
+        int n = static_cast<int>(num_prims);
+
+        if (n == 0)
+        {
+            tree.clear();
+            return tree;
+        }
+
+        // Compute primitive bounding boxes, centroids and centroid bounds
+
+        static const int TileSize = 4096;
+
+        int num_tiles = div_up(n, TileSize);
+
+        aligned_vector<aabb> prim_bounds(n);
+        aligned_vector<vec3> centroids(n);
+        std::vector<aabb> tile_bounds(num_tiles);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                aabb cb;
+                cb.invalidate();
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    prim_bounds[i] = get_bounds(primitives[i]);
+                    centroids[i] = prim_bounds[i].center();
+                    cb.insert(centroids[i]);
+                }
+
+                tile_bounds[r.begin() / TileSize] = cb;
+            });
+
+        aabb centroid_bounds;
+        centroid_bounds.invalidate();
+
+        for (auto const& cb : tile_bounds)
+        {
+            centroid_bounds.insert(cb);
+        }
+
+        // Sort prim refs by morton codes (30 bits)
+
+        aligned_vector<prim_ref> refs(n);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    refs[i].id = i;
+                    refs[i].morton_code = detail::lbvh::morton_code(centroids[i], centroid_bounds);
+                }
+            });
+
+        {
+            aligned_vector<prim_ref> temp(n);
+
+            paralgo::radix_sort(
+                    pool,
+                    refs.begin(),
+                    refs.end(),
+                    temp.begin(),
+                    30,
+                    [](prim_ref const& ref) { return ref.morton_code; }
+                    );
+        }
+
+        // One cluster per primitive
+
+        std::vector<cluster_node> nodes(2 * n - 1);
+
+        aligned_vector<int> clusters(n);
+        aligned_vector<aabb> cluster_bounds(n);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    aabb const& bbox = prim_bounds[refs[i].id];
+                    nodes[i] = { bbox, -1, -1, 1, Cp * surface_area(bbox), 0, true };
+
+                    clusters[i] = i;
+                    cluster_bounds[i] = bbox;
+                }
+            });
+
+        // Merge clusters until only the root is left
+
+        int num_clusters = n;
+        int num_nodes = n;
+
+        aligned_vector<int> neighbors(n);
+        aligned_vector<int> next_clusters(n);
+        aligned_vector<aabb> next_bounds(n);
+        std::vector<int> tile_counts(num_tiles + 1);
+
+        while (num_clusters > 1)
+        {
+            int num = num_clusters;
+            int tiles = div_up(num, TileSize);
+
+            // Nearest neighbor search. On ties the neighbor with the lower index is
+            // chosen, so that there's always at least one mutual pair
+            parallel_for(
+                pool,
+                tiled_range1d<int>(0, num, TileSize),
+                [&](range1d<int> const& r)
+                {
+                    for (int i = r.begin(); i != r.end(); ++i)
+                    {
+                        int first = max(0, i - search_radius_);
+                        int last = min(num, i + search_radius_ + 1);
+
+                        float best_area = FLT_MAX;
+                        int best = -1;
+
+                        for (int j = first; j != last; ++j)
+                        {
+                            if (j == i)
+                            {
+                                continue;
+                            }
+
+                            float area = surface_area(combine(cluster_bounds[i], cluster_bounds[j]));
+
+                            if (area < best_area)
+                            {
+                                best_area = area;
+                                best = j;
+                            }
+                        }
+
+                        neighbors[i] = best;
+                    }
+                });
+
+            // Count merges per tile and compute the offsets of the new nodes
+            parallel_for(
+                pool,
+                tiled_range1d<int>(0, num, TileSize),
+                [&](range1d<int> const& r)
+                {
+                    int count = 0;
+
+                    for (int i = r.begin(); i != r.end(); ++i)
+                    {
+                        int j = neighbors[i];
+                        count += neighbors[j] == i && i < j ? 1 : 0;
+                    }
+
+                    tile_counts[r.begin() / TileSize] = count;
+                });
+
+            exclusive_scan(tile_counts, tiles);
+
+            int num_merges = tile_counts[tiles];
+
+            // Merge mutual nearest neighbors, the merged cluster takes the lower position
+            parallel_for(
+                pool,
+                tiled_range1d<int>(0, num, TileSize),
+                [&](range1d<int> const& r)
+                {
+                    int index = num_nodes + tile_counts[r.begin() / TileSize];
+
+                    for (int i = r.begin(); i != r.end(); ++i)
+                    {
+                        int j = neighbors[i];
+
+                        if (neighbors[j] != i || i > j)
+                        {
+                            continue;
+                        }
+
+                        nodes[index] = merge(nodes, clusters[i], clusters[j], max_leaf_size);
+
+                        clusters[i] = index;
+                        cluster_bounds[i] = nodes[index].bbox;
+
+                        ++index;
+                    }
+                });
+
+            num_nodes += num_merges;
+
+            // Compact, keeping the order. Clusters merged into a cluster
+            // at a lower position are dropped
+            auto keep = [&](int i)
+            {
+                int j = neighbors[i];
+                return neighbors[j] != i || i < j;
+            };
+
+            parallel_for(
+                pool,
+                tiled_range1d<int>(0, num, TileSize),
+                [&](range1d<int> const& r)
+                {
+                    int count = 0;
+
+                    for (int i = r.begin(); i != r.end(); ++i)
+                    {
+                        count += keep(i) ? 1 : 0;
+                    }
+
+                    tile_counts[r.begin() / TileSize] = count;
+                });
+
+            exclusive_scan(tile_counts, tiles);
+
+            parallel_for(
+                pool,
+                tiled_range1d<int>(0, num, TileSize),
+                [&](range1d<int> const& r)
+                {
+                    int index = tile_counts[r.begin() / TileSize];
+
+                    for (int i = r.begin(); i != r.end(); ++i)
+                    {
+                        if (keep(i))
+                        {
+                            next_clusters[index] = clusters[i];
+                            next_bounds[index] = cluster_bounds[i];
+                            ++index;
+                        }
+                    }
+                });
+
+            num_clusters = tile_counts[tiles];
+
+            std::swap(clusters, next_clusters);
+            std::swap(cluster_bounds, next_bounds);
+        }
+
+        // Emit Visionaray nodes. Children are stored in pairs, primitives of a leaf
+        // are contiguous in the index list (in the order the subtree is traversed)
+
+        int root = clusters[0];
+
+        tree.nodes().resize(1 + 2 * nodes[root].num_inner);
+
+        struct leaf_ref
+        {
+            int node;
+            int first_prim;
+        };
+
+        std::vector<leaf_ref> leaves;
+
+        {
+            struct entry
+            {
+                int node;
+                unsigned index;
+                int first_prim;
+            };
+
+            std::vector<entry> st;
+            st.push_back({ root, 0, 0 });
+
+            unsigned next_pair = 1;
+
+            while (!st.empty())
+            {
+                entry e = st.back();
+                st.pop_back();
+
+                auto const& node = nodes[e.node];
+
+                if (node.collapsed)
+                {
+                    tree.nodes()[e.index].set_leaf(node.bbox, e.first_prim, node.count);
+                    leaves.push_back({ e.node, e.first_prim });
+                }
+                else
+                {
+                    tree.nodes()[e.index].set_inner(node.bbox, next_pair);
+                    st.push_back({ node.right, next_pair + 1, e.first_prim + nodes[node.left].count });
+                    st.push_back({ node.left, next_pair, e.first_prim });
+                    next_pair += 2;
+                }
+            }
+        }
+
+        // Gather the primitives of each leaf
+
+        aligned_vector<unsigned> indices(n);
+
+        parallel_for(
+            pool,
+            tiled_range1d<size_t>(0, leaves.size(), 256),
+            [&](range1d<size_t> const& r)
+            {
+                std::vector<int> st;
+
+                for (size_t i = r.begin(); i != r.end(); ++i)
+                {
+                    int index = leaves[i].first_prim;
+
+                    st.push_back(leaves[i].node);
+
+                    while (!st.empty())
+                    {
+                        int node = st.back();
+                        st.pop_back();
+
+                        if (node < n)
+                        {
+                            indices[index++] = static_cast<unsigned>(refs[node].id);
+                        }
+                        else
+                        {
+                            st.push_back(nodes[node].right);
+                            st.push_back(nodes[node].left);
+                        }
+                    }
+                }
+            });
+
+        assign_indices(tree, primitives, indices, pool, is_index_bvh<Tree>());
+
+        return tree;
+    }
+
+private:
+
+    // SAH costs to traverse an inner node and to intersect a primitive, cf. sah_cost()
+    static constexpr float Ci = 1.2f;
+    static constexpr float Cp = 1.0f;
+
+    int search_radius_ = 16;
+
+    static detail::ploc::cluster_node merge(
+            std::vector<detail::ploc::cluster_node> const& nodes,
+            int left,
+            int right,
+            int max_leaf_size
+            )
+    {
+        auto const& l = nodes[left];
+        auto const& r = nodes[right];
+
+        detail::ploc::cluster_node result;
+        result.bbox = combine(l.bbox, r.bbox);
+        result.left = left;
+        result.right = right;
+        result.count = l.count + r.count;
+
+        float area = surface_area(result.bbox);
+        float inner_cost = Ci * area + l.cost + r.cost;
+        float leaf_cost = Cp * area * static_cast<float>(result.count);
+
+        result.collapsed = result.count <= max_leaf_size && leaf_cost <= inner_cost;
+        result.cost = result.collapsed ? leaf_cost : inner_cost;
+        result.num_inner = result.collapsed ? 0 : 1 + l.num_inner + r.num_inner;
+
+        return result;
+    }
+
+    // counts[0..n) becomes the exclusive prefix sum, counts[n] the total
+    static void exclusive_scan(std::vector<int>& counts, int n)
+    {
+        int sum = 0;
+
+        for (int i = 0; i < n; ++i)
+        {
+            int c = counts[i];
+            counts[i] = sum;
+            sum += c;
+        }
+
+        counts[n] = sum;
+    }
+
+    // Store the indices (index_bvh)
+    template <typename Tree, typename P, typename Pool>
+    void assign_indices(Tree& tree, P* /* */, aligned_vector<unsigned>& indices, Pool& /* */, std::true_type)
+    {
+        tree.indices().assign(indices.begin(), indices.end());
+    }
+
+    // Reorder the primitives according to the indices (bvh)
+    template <typename Tree, typename P, typename Pool>
+    void assign_indices(Tree& tree, P* primitives, aligned_vector<unsigned>& indices, Pool& pool, std::false_type)
+    {
+        int n = static_cast<int>(indices.size());
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, 16384),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    tree.primitives()[i] = primitives[indices[i]];
+                }
+            });
+    }
+};
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_PLOC_H
@@ -0,0 +1,504 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_PRESPLIT_H
+#define VSNRAY_DETAIL_BVH_PRESPLIT_H 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "../../math/detail/math.h"
+#include "../../math/aabb.h"
+#include "../../math/triangle.h"
+#include "../../aligned_vector.h"
+
+#include "../parallel_for.h"
+#include "../range.h"
+#include "../thread_pool.h"
+
+namespace visionaray
+{
+namespace detail
+{
+namespace presplit
+{
+
+//-------------------------------------------------------------------------------------------------
+// Primitives that can be split, cf. split_primitive() in sah.h
+//
+
+template <typename P>
+struct is_splittable : std::false_type {};
+
+template <size_t Dim, typename T, typename P>
+struct is_splittable<basic_triangle<Dim, T, P>> : std::true_type {};
+
+
+//-------------------------------------------------------------------------------------------------
+// Lower bound for the summed surface areas of the bounds of a primitive's fragments
+//
+
+template <size_t Dim, typename T, typename P>
+inline float ideal_area(basic_triangle<Dim, T, P> const& prim)
+{
+    return length(cross(prim.e1, prim.e2));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Planes of a uniform grid with 2^Levels cells per axis over the scene bounds. The plane
+// in the middle has level 0, the two planes at the quarters have level 1, and so on.
+// Splitting at low-level planes first produces fragments that align with the upper
+// levels of the hierarchy.
+//
+
+struct grid
+{
+    enum { Levels = 20 };
+
+    aabb bounds;
+
+    // Lowest-level plane strictly inside [lo..hi] along axis, returns false if there is none
+    bool find_plane(float lo, float hi, int axis, float& plane, int& level) const
+    {
+        float size = bounds.max[axis] - bounds.min[axis];
+
+        if (!(size > 0.0f))
+        {
+            return false;
+        }
+
+        float scale = static_cast<float>(1 << Levels) / size;
+
+        auto cell = [&](float x)
+        {
+            float c = (x - bounds.min[axis]) * scale;
+            return static_cast<unsigned>(std::min(std::max(c, 0.0f), static_cast<float>((1 << Levels) - 1)));
+        };
+
+        unsigned a = cell(lo);
+        unsigned b = cell(hi);
+
+        if (a == b)
+        {
+            return false;
+        }
+
+        // Highest bit in which the cells differ
+        int bit = Levels - 1;
+
+        while (((a ^ b) & (1U << bit)) == 0)
+        {
+            --bit;
+        }
+
+        unsigned p = (b >> bit) << bit;
+
+        plane = bounds.min[axis] + static_cast<float>(p) / scale;
+        level = Levels - 1 - bit;
+
+        return plane > lo && plane < hi;
+    }
+
+    // Lowest level of any plane crossing box, Levels if there is none
+    int min_level(aabb const& box) const
+    {
+        int result = Levels;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float plane = 0.0f;
+            int level = Levels;
+
+            if (find_plane(box.min[axis], box.max[axis], axis, plane, level))
+            {
+                result = std::min(result, level);
+            }
+        }
+
+        return result;
+    }
+};
+
+} // presplit
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// bvh_presplitter
+//
+// Splits the bounds of large primitives into several tighter primitive references before
+// the hierarchy is built, so that builders without spatial splits can separate long and
+// thin primitives from their neighbors.
+//
+// cf. Karras, Aila (2013): Fast Parallel Construction of High-Quality Bounding Volume
+// Hierarchies (Section 4.3)
+//
+// Primitives whose bounds have a surface area of more than threshold() times the ideal
+// surface area (twice the area of a triangle) are considered for splitting. They are
+// assigned a priority that grows with the surface area they waste and with the importance
+// of the grid planes that cross their bounds. The budget() of additional references
+// (relative to the number of primitives) is distributed according to the priorities.
+// Bounds are split recursively at the most important grid plane along the axis with the
+// largest extent.
+//
+// Only triangles are split, other primitives get a single reference.
+//
+
+class bvh_presplitter
+{
+public:
+
+    // Split primitives whose surface area exceeds the ideal surface area by this factor
+    void set_threshold(float threshold)
+    {
+        threshold_ = threshold;
+    }
+
+    float threshold() const
+    {
+        return threshold_;
+    }
+
+    // Maximum number of additional references, relative to the number of primitives
+    void set_budget(float budget)
+    {
+        budget_ = budget;
+    }
+
+    float budget() const
+    {
+        return budget_;
+    }
+
+    // Compute primitive references
+    template <typename P, typename Pool>
+    void split(P const* primitives, size_t num_prims, Pool& pool)
+    {
+        split(primitives, num_prims, pool, detail::presplit::is_splittable<P>{});
+    }
+
+    // Serial version, runs on the calling thread
+    template <typename P>
+    void split(P const* primitives, size_t num_prims)
+    {
+        thread_pool pool(0);
+        split(primitives, num_prims, pool);
+    }
+
+    // Number of primitive references
+    size_t size() const
+    {
+        return bounds_.size();
+    }
+
+    // Reference bounds
+    aligned_vector<aabb> const& bounds() const
+    {
+        return bounds_;
+    }
+
+    // Primitive index of each reference
+    aligned_vector<unsigned> const& indices() const
+    {
+        return indices_;
+    }
+
+private:
+
+    float threshold_ = 2.0f;
+    float budget_ = 0.3f;
+
+    aligned_vector<aabb> bounds_;
+    aligned_vector<unsigned> indices_;
+
+    // One reference per primitive
+    template <typename P, typename Pool>
+    void split(P const* primitives, size_t num_prims, Pool& pool, std::false_type)
+    {
+        int n = static_cast<int>(num_prims);
+
+        bounds_.resize(n);
+        indices_.resize(n);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, 16384),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    bounds_[i] = get_bounds(primitives[i]);
+                    indices_[i] = static_cast<unsigned>(i);
+                }
+            });
+    }
+
+    template <typename P, typename Pool>
+    void split(P const* primitives, size_t num_prims, Pool& pool, std::true_type)
+    {
+        static const int TileSize = 16384;
+
+        int n = static_cast<int>(num_prims);
+        int num_tiles = div_up(n, TileSize);
+
+        bounds_.clear();
+        indices_.clear();
+
+        if (n == 0)
+        {
+            return;
+        }
+
+        // Primitive bounds and scene bounds ----------------------
+
+        aligned_vector<aabb> prim_bounds(n);
+        std::vector<aabb> tile_bounds(num_tiles);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                aabb tb;
+                tb.invalidate();
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    prim_bounds[i] = get_bounds(primitives[i]);
+                    tb.insert(prim_bounds[i]);
+                }
+
+                tile_bounds[r.begin() / TileSize] = tb;
+            });
+
+        detail::presplit::grid g;
+        g.bounds.invalidate();
+
+        for (auto const& tb : tile_bounds)
+        {
+            g.bounds.insert(tb);
+        }
+
+        // Priorities ---------------------------------------------
+
+        aligned_vector<float> priorities(n);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    float area = surface_area(prim_bounds[i]);
+                    float ideal = detail::presplit::ideal_area(primitives[i]);
+
+                    if (!(area > threshold_ * ideal))
+                    {
+                        priorities[i] = 0.0f;
+                        continue;
+                    }
+
+                    int level = g.min_level(prim_bounds[i]);
+                    float importance = std::ldexp(1.0f, -level);
+
+                    priorities[i] = std::cbrt(importance * (area - ideal));
+                }
+            });
+
+        // Scale the priorities so that the number of splits fits the budget
+
+        double max_splits = static_cast<double>(budget_) * n;
+
+        auto count_splits = [&](double scale)
+        {
+            double result = 0.0;
+
+            for (int i = 0; i < n; ++i)
+            {
+                result += std::floor(scale * priorities[i]);
+            }
+
+            return result;
+        };
+
+        double sum = 0.0;
+
+        for (int i = 0; i < n; ++i)
+        {
+            sum += priorities[i];
+        }
+
+        // floor(x) <= x, so the lower bound is within budget
+        double lo = sum > 0.0 ? max_splits / sum : 0.0;
+        double hi = lo;
+
+        if (lo > 0.0)
+        {
+            while (count_splits(hi * 2.0) <= max_splits && hi < 1e30)
+            {
+                hi *= 2.0;
+            }
+
+            hi *= 2.0;
+
+            for (int i = 0; i < 16; ++i)
+            {
+                double mid = 0.5 * (lo + hi);
+
+                if (count_splits(mid) <= max_splits)
+                {
+                    lo = mid;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+        }
+
+        // Split, each tile writes to its own list ------------------
+
+        std::vector<aligned_vector<aabb>> tile_refs(num_tiles);
+        std::vector<aligned_vector<unsigned>> tile_indices(num_tiles);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, n, TileSize),
+            [&](range1d<int> const& r)
+            {
+                int tile = r.begin() / TileSize;
+
+                auto& refs = tile_refs[tile];
+                auto& indices = tile_indices[tile];
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    int count = 1 + static_cast<int>(std::floor(lo * priorities[i]));
+
+                    split_primitive_bounds(primitives[i], prim_bounds[i], count, g, refs);
+                    indices.resize(refs.size(), static_cast<unsigned>(i));
+                }
+            });
+
+        // Concatenate ----------------------------------------------
+
+        std::vector<size_t> offsets(num_tiles + 1, 0);
+
+        for (int t = 0; t < num_tiles; ++t)
+        {
+            offsets[t + 1] = offsets[t] + tile_refs[t].size();
+        }
+
+        bounds_.resize(offsets[num_tiles]);
+        indices_.resize(offsets[num_tiles]);
+
+        parallel_for(
+            pool,
+            range1d<int>(0, num_tiles),
+            [&](int t)
+            {
+                std::copy(tile_refs[t].begin(), tile_refs[t].end(), bounds_.begin() + offsets[t]);
+                std::copy(tile_indices[t].begin(), tile_indices[t].end(), indices_.begin() + offsets[t]);
+            });
+    }
+
+    // Split the bounds of a primitive into at most count references
+    template <typename P>
+    static void split_primitive_bounds(
+            P const&                        prim,
+            aabb const&                     bounds,
+            int                             count,
+            detail::presplit::grid const&   g,
+            aligned_vector<aabb>&           refs
+            )
+    {
+        struct entry
+        {
+            aabb bounds;
+            int count;
+        };
+
+        std::vector<entry> st;
+        st.push_back({ bounds, count });
+
+        while (!st.empty())
+        {
+            entry e = st.back();
+            st.pop_back();
+
+            if (e.count <= 1)
+            {
+                refs.push_back(e.bounds);
+                continue;
+            }
+
+            // Most important plane, along the largest axis for planes of the same level
+            int axis = -1;
+            int best_level = detail::presplit::grid::Levels;
+            float best_extent = 0.0f;
+            float plane = 0.0f;
+
+            for (int a = 0; a < 3; ++a)
+            {
+                float p = 0.0f;
+                int level = 0;
+                float extent = e.bounds.max[a] - e.bounds.min[a];
+
+                if (!g.find_plane(e.bounds.min[a], e.bounds.max[a], a, p, level))
+                {
+                    continue;
+                }
+
+                if (level < best_level || (level == best_level && extent > best_extent))
+                {
+                    axis = a;
+                    best_level = level;
+                    best_extent = extent;
+                    plane = p;
+                }
+            }
+
+            if (axis < 0)
+            {
+                refs.push_back(e.bounds);
+                continue;
+            }
+
+            aabb L;
+            aabb R;
+            split_primitive(L, R, plane, axis, prim);
+
+            L = intersect(L, e.bounds);
+            R = intersect(R, e.bounds);
+
+            // Bounds may be flat, but not inverted
+            if (!L.valid() || !R.valid())
+            {
+                refs.push_back(e.bounds);
+                continue;
+            }
+
+            // Distribute the references according to surface area
+            float sa_l = surface_area(L);
+            float sa_r = surface_area(R);
+            float ratio = sa_l + sa_r > 0.0f ? sa_l / (sa_l + sa_r) : 0.5f;
+
+            int count_l = static_cast<int>(e.count * ratio + 0.5f);
+            count_l = std::min(std::max(count_l, 1), e.count - 1);
+
+            st.push_back({ R, e.count - count_l });
+            st.push_back({ L, count_l });
+        }
+    }
+};
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_PRESPLIT_H
@@ -0,0 +1,98 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_QUANTIZE_H
+#define VSNRAY_DETAIL_BVH_QUANTIZE_H 1
+
+#include <cstddef>
+
+#include "../../math/aabb.h"
+#include "../../aligned_vector.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Quantize the child bounds of N-wide nodes
+//
+// Nodes keep their positions in the node array, so child indices and primitive (index)
+// ranges are retained. Each node's grid spans the union of its child bounds.
+//
+
+template <unsigned N, typename Nodes>
+inline aligned_vector<bvh_quantized_node<N>, 32> quantize_nodes(Nodes const& nodes)
+{
+    aligned_vector<bvh_quantized_node<N>, 32> result(nodes.size());
+
+    for (size_t n = 0; n < nodes.size(); ++n)
+    {
+        auto const& src = nodes[n];
+        auto& dst = result[n];
+
+        dst.set_grid(src.get_bounds());
+
+        for (unsigned i = 0; i < N; ++i)
+        {
+            if (src.is_empty(i))
+            {
+                dst.set_empty(i);
+            }
+            else if (src.is_leaf(i))
+            {
+                auto indices = src.get_indices(i);
+                dst.set_leaf(i, src.get_bounds(i), indices.first, indices.last - indices.first);
+            }
+            else
+            {
+                dst.set_inner(i, src.get_bounds(i), src.get_child(i));
+            }
+        }
+    }
+
+    return result;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Convert an N-wide [index_]bvh into a BVH with quantized N-wide nodes
+//
+// Binary BVHs are first converted with collapse<N>(). Primitives (and primitive indices)
+// are copied, the quantized BVH does not refer to the wide BVH after construction.
+//
+
+template <typename PV, unsigned N>
+inline bvh_t<PV, aligned_vector<bvh_quantized_node<N>, 32>> quantize(
+        bvh_t<PV, aligned_vector<bvh_wide_node<N>, 32>> const& tree
+        )
+{
+    bvh_t<PV, aligned_vector<bvh_quantized_node<N>, 32>> result;
+
+    result.primitives() = tree.primitives();
+    result.nodes() = detail::quantize_nodes<N>(tree.nodes());
+
+    return result;
+}
+
+template <typename PV, unsigned N, typename IV>
+inline index_bvh_t<PV, aligned_vector<bvh_quantized_node<N>, 32>, IV> quantize(
+        index_bvh_t<PV, aligned_vector<bvh_wide_node<N>, 32>, IV> const& tree
+        )
+{
+    index_bvh_t<PV, aligned_vector<bvh_quantized_node<N>, 32>, IV> result;
+
+    result.primitives() = tree.primitives();
+    result.nodes() = detail::quantize_nodes<N>(tree.nodes());
+    result.indices() = tree.indices();
+
+    return result;
+}
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_QUANTIZE_H
@@ -7,107 +7,433 @@
 #define VSNRAY_DETAIL_BVH_REFIT_H 1
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
 #include <cstddef>
-#include <cstdint>
-#include <mutex>
-#include <thread>
+#include <utility>
+#include <vector>
 
 #include "../../aligned_vector.h"
 
 #include "../parallel_for.h"
 #include "../range.h"
-#include "../stack.h"
 #include "../thread_pool.h"
+#include "statistics.h"
 
 namespace visionaray
 {
 
-struct bvh_refitter
+//-------------------------------------------------------------------------------------------------
+// bvh_refitter
+//
+// Recomputes the node bounds of a binary [index_]bvh after the primitives have moved,
+// keeping the topology. Runs in O(n): each leaf computes its bounds and then walks up
+// towards the root. An atomic counter per inner node makes sure that only the last
+// child to arrive computes the union of the child bounds and continues upwards.
+//
+// Parent links are built on the first call and reused as long as the refitter is
+// called with the same tree. Call reset() when the tree was rebuilt in place.
+//
+// optimize() can run after refit() and applies local tree rotations (cf. Kopta et al.
+// (2012): Fast, Effective BVH Updates for Animated Scenes) to reduce the SAH cost that
+// refitting alone increases with large deformations.
+//
+
+struct bvh_optimize_result
+{
+    // SAH cost before and after optimize()
+    float sah_before = 0.0f;
+    float sah_after = 0.0f;
+
+    // Number of inner nodes visited and number of rotations applied
+    size_t num_visited = 0;
+    size_t num_rotations = 0;
+};
+
+class bvh_refitter
 {
+public:
+
+    // Copy primitives to the tree and refit. For index_bvh, primitives are in the order
+    // they were passed to the builder, for bvh, in the order of tree.primitives()
     template <typename Tree, typename P>
     void refit(Tree& tree, P* primitives, size_t num_prims, thread_pool& pool)
     {
-        static_assert(is_index_bvh<Tree>::value, "Type mismatch");
-
-        std::copy(primitives, primitives + num_prims, tree.primitives().data());
+        copy_primitives(tree, primitives, num_prims);
+        refit(tree, pool);
+    }
 
-        // Generate primitive bounds
-        aligned_vector<aabb> prim_bounds(num_prims);
+    // Refit from the primitives currently stored in the tree
+    template <typename Tree>
+    void refit(Tree& tree, thread_pool& pool)
+    {
+        if (!prepare(tree))
+        {
+            return;
+        }
 
         parallel_for(
             pool,
-            tiled_range1d<size_t>(0, num_prims, 16),
+            tiled_range1d<size_t>(0, num_nodes_, 64),
             [&](range1d<size_t> const& r)
             {
                 for (size_t i = r.begin(); i < r.end(); ++i)
                 {
-                    prim_bounds[i] = get_bounds(primitives[i]);
+                    if (parents_[i] != Unreachable && leaf_flags_[i])
+                    {
+                        propagate(tree, static_cast<unsigned>(i));
+                    }
                 }
             });
+    }
+
+    // Serial versions, run on the calling thread
+    template <typename Tree, typename P>
+    void refit(Tree& tree, P* primitives, size_t num_prims)
+    {
+        copy_primitives(tree, primitives, num_prims);
+        refit(tree);
+    }
 
-        // Reassign node bounding boxes
-        std::mutex mtx;
+    template <typename Tree>
+    void refit(Tree& tree)
+    {
+        if (!prepare(tree))
+        {
+            return;
+        }
 
-        parallel_for(
-            pool,
-            tiled_range1d<size_t>(0, tree.num_nodes(), 16),
-            [&](range1d<size_t> const& r)
+        for (size_t i = 0; i < num_nodes_; ++i)
+        {
+            if (parents_[i] != Unreachable && leaf_flags_[i])
             {
-                for (size_t i = r.begin(); i < r.end(); ++i)
-                {
-                    detail::stack<64> st;
+                propagate(tree, static_cast<unsigned>(i));
+            }
+        }
+    }
 
-                    aabb bbox;
-                    bbox.invalidate();
+    // Apply tree rotations to a refitted tree. Visits inner nodes until time_budget (in
+    // milliseconds) is exceeded, the next call continues where the previous one stopped.
+    // A budget of 0 visits every inner node once. Node bounds stay valid, so the tree can
+    // be traversed or refitted at any time
+    template <typename Tree>
+    bvh_optimize_result optimize(Tree& tree, float time_budget = 0.0f)
+    {
+        bvh_optimize_result result;
 
-                    unsigned addr = static_cast<unsigned>(i);
+        if (!prepare(tree))
+        {
+            return result;
+        }
 
-                    st.push(addr);
+        result.sah_before = sah_cost(tree);
 
-                    while (!st.empty())
-                    {
-                        auto node = tree.node(addr);
-
-                        if (node.is_inner())
-                        {
-                            addr = node.get_child(0);
-                            st.push(node.get_child(1));
-                        }
-                        else
-                        {
-                            auto indices = node.get_indices();
-
-                            for (unsigned j = indices.first; j != indices.last; ++j)
-                            {
-                                bbox.insert(prim_bounds[tree.indices()[j]]);
-                            }
-
-                            addr = st.pop();
-                        }
-                    }
+        using clock = std::chrono::steady_clock;
+        auto start = clock::now();
+        auto budget = std::chrono::duration<float, std::milli>(time_budget);
 
-                    bvh_node n = tree.node(i);
+        for (size_t n = 0; n < num_nodes_; ++n)
+        {
+            // Check the clock every few nodes only
+            if (time_budget > 0.0f && n % 64 == 63 && clock::now() - start > budget)
+            {
+                break;
+            }
 
-                    if (n.is_inner())
-                    {
-                        tree.nodes()[i].set_inner(bbox, n.get_child(0));
-                    }
-                    else
-                    {
-                        tree.nodes()[i].set_leaf(bbox, n.get_first_primitive(), n.get_num_primitives());
-                    }
-                }
-            });
+            unsigned index = static_cast<unsigned>(cursor_);
+            cursor_ = (cursor_ + 1) % num_nodes_;
+
+            if (parents_[index] == Unreachable || !tree.node(index).is_inner())
+            {
+                continue;
+            }
+
+            ++result.num_visited;
+
+            if (rotate(tree, index))
+            {
+                ++result.num_rotations;
+            }
+        }
+
+        result.sah_after = sah_cost(tree);
+
+        return result;
     }
 
+    // Discard parent links
+    void reset()
+    {
+        nodes_ = nullptr;
+        num_nodes_ = 0;
+        cursor_ = 0;
+        parents_.clear();
+        leaf_flags_.clear();
+        counters_.clear();
+    }
+
+private:
+
+    enum { Root = -1, Unreachable = -2 };
+
+    // Identifies the tree that parent links were built for
+    void const* nodes_ = nullptr;
+    size_t num_nodes_ = 0;
+
+    // Next node to be visited by optimize()
+    size_t cursor_ = 0;
+
+    // Parent node index, Root or Unreachable
+    aligned_vector<int> parents_;
+
+    // 1 for leaves, so that refit() does not read nodes that other threads write to
+    aligned_vector<unsigned char> leaf_flags_;
+
+    // Number of children that have arrived at an inner node, reset to 0
+    // by the last one, so that counters are valid again after each refit
+    std::vector<std::atomic<unsigned>> counters_;
+
     template <typename Tree, typename P>
-    void refit(Tree& tree, P* primitives, size_t num_prims)
+    void copy_primitives(Tree& tree, P* primitives, size_t num_prims)
+    {
+        assert(num_prims == tree.num_primitives());
+
+        if (primitives != tree.primitives().data())
+        {
+            std::copy(primitives, primitives + num_prims, tree.primitives().data());
+        }
+    }
+
+    // Build parent links if necessary, returns false for empty trees
+    template <typename Tree>
+    bool prepare(Tree const& tree)
+    {
+        static_assert(is_any_bvh<Tree>::value, "Type mismatch");
+        static_assert(!is_wide_bvh<Tree>::value, "Type mismatch");
+
+        if (tree.num_nodes() == 0)
+        {
+            return false;
+        }
+
+        if (nodes_ == tree.nodes().data() && num_nodes_ == tree.num_nodes())
+        {
+            return true;
+        }
+
+        reset();
+
+        nodes_ = tree.nodes().data();
+        num_nodes_ = tree.num_nodes();
+
+        parents_.resize(num_nodes_, Unreachable);
+        parents_[0] = Root;
+        leaf_flags_.resize(num_nodes_, 0);
+        counters_ = std::vector<std::atomic<unsigned>>(num_nodes_);
+
+        for (auto& c : counters_)
+        {
+            c.store(0, std::memory_order_relaxed);
+        }
+
+        // Depth-first from the root, so that nodes not referenced by the tree are ignored
+        std::vector<unsigned> st;
+        st.push_back(0);
+
+        while (!st.empty())
+        {
+            unsigned index = st.back();
+            st.pop_back();
+
+            auto const& node = tree.node(index);
+
+            if (node.is_inner())
+            {
+                for (unsigned i = 0; i < 2; ++i)
+                {
+                    unsigned child = node.get_child(i);
+                    parents_[child] = static_cast<int>(index);
+                    st.push_back(child);
+                }
+            }
+            else
+            {
+                leaf_flags_[index] = 1;
+            }
+        }
+
+        return true;
+    }
+
+    // Compute the bounds of a leaf and propagate them towards the root
+    template <typename Tree>
+    void propagate(Tree& tree, unsigned leaf)
+    {
+        auto const& node = tree.node(leaf);
+
+        aabb bbox;
+        bbox.invalidate();
+
+        auto indices = node.get_indices();
+
+        for (unsigned i = indices.first; i != indices.last; ++i)
+        {
+            bbox.insert(get_bounds(tree.primitive(i)));
+        }
+
+        tree.nodes()[leaf].set_leaf(bbox, node.get_first_primitive(), node.get_num_primitives());
+
+        int parent = parents_[leaf];
+
+        while (parent >= 0)
+        {
+            // The first child to arrive stops, the second one sees both child boxes
+            if (counters_[parent].fetch_add(1, std::memory_order_acq_rel) == 0)
+            {
+                return;
+            }
+
+            counters_[parent].store(0, std::memory_order_relaxed);
+
+            auto const& inner = tree.node(parent);
+
+            aabb bounds = combine(
+                    tree.node(inner.get_child(0)).get_bounds(),
+                    tree.node(inner.get_child(1)).get_bounds()
+                    );
+
+            tree.nodes()[parent].set_inner(bounds, inner.get_child(0));
+
+            parent = parents_[parent];
+        }
+    }
+
+    // Swap the subtrees rooted at nodes a and b and update the parent links of their children
+    template <typename Tree>
+    void swap_subtrees(Tree& tree, unsigned a, unsigned b)
     {
-        // TODO: this freezes when the pool is not static
-        // and the function is called repeatedly
-        static thread_pool pool(std::thread::hardware_concurrency());
+        std::swap(tree.nodes()[a], tree.nodes()[b]);
+        std::swap(leaf_flags_[a], leaf_flags_[b]);
+
+        for (unsigned index : { a, b })
+        {
+            auto const& node = tree.node(index);
+
+            if (node.is_inner())
+            {
+                parents_[node.get_child(0)] = static_cast<int>(index);
+                parents_[node.get_child(1)] = static_cast<int>(index);
+            }
+        }
+    }
+
+    // Recompute the bounds of an inner node from its children
+    template <typename Tree>
+    void update_bounds(Tree& tree, unsigned index)
+    {
+        auto const& node = tree.node(index);
+
+        aabb bounds = combine(
+                tree.node(node.get_child(0)).get_bounds(),
+                tree.node(node.get_child(1)).get_bounds()
+                );
+
+        tree.nodes()[index].set_inner(bounds, node.get_child(0));
+    }
+
+    // Apply the rotation below an inner node that reduces the summed surface area of its
+    // children the most. Only the children's bounds change, so the gain in SAH cost is
+    // proportional to the reduction in surface area. Returns true if a rotation was applied
+    template <typename Tree>
+    bool rotate(Tree& tree, unsigned index)
+    {
+        auto const& node = tree.node(index);
+
+        unsigned l = node.get_child(0);
+        unsigned r = node.get_child(1);
+
+        auto const& L = tree.node(l);
+        auto const& R = tree.node(r);
+
+        // Candidates: swap nodes a and b, then update the bounds of
+        // the changed child (or children, for grandchild swaps)
+        struct candidate
+        {
+            float gain;
+            unsigned a;
+            unsigned b;
+        };
+
+        candidate best = { 0.0f, 0, 0 };
+
+        auto consider = [&](float gain, unsigned a, unsigned b)
+        {
+            if (gain > best.gain)
+            {
+                best = { gain, a, b };
+            }
+        };
+
+        float sa_l = surface_area(L.get_bounds());
+        float sa_r = surface_area(R.get_bounds());
+
+        if (R.is_inner())
+        {
+            auto const& rl = tree.node(R.get_child(0)).get_bounds();
+            auto const& rr = tree.node(R.get_child(1)).get_bounds();
+
+            consider(sa_r - surface_area(combine(L.get_bounds(), rr)), l, R.get_child(0));
+            consider(sa_r - surface_area(combine(rl, L.get_bounds())), l, R.get_child(1));
+        }
+
+        if (L.is_inner())
+        {
+            auto const& ll = tree.node(L.get_child(0)).get_bounds();
+            auto const& lr = tree.node(L.get_child(1)).get_bounds();
+
+            consider(sa_l - surface_area(combine(R.get_bounds(), lr)), r, L.get_child(0));
+            consider(sa_l - surface_area(combine(ll, R.get_bounds())), r, L.get_child(1));
+        }
+
+        if (L.is_inner() && R.is_inner())
+        {
+            auto const& ll = tree.node(L.get_child(0)).get_bounds();
+            auto const& lr = tree.node(L.get_child(1)).get_bounds();
+            auto const& rl = tree.node(R.get_child(0)).get_bounds();
+            auto const& rr = tree.node(R.get_child(1)).get_bounds();
+
+            consider(
+                    sa_l + sa_r - surface_area(combine(rl, lr)) - surface_area(combine(ll, rr)),
+                    L.get_child(0),
+                    R.get_child(0)
+                    );
+
+            consider(
+                    sa_l + sa_r - surface_area(combine(rr, lr)) - surface_area(combine(rl, ll)),
+                    L.get_child(0),
+                    R.get_child(1)
+                    );
+        }
+
+        // Ignore tiny gains, those are mostly due to rounding
+        if (best.gain <= surface_area(node.get_bounds()) * 1e-5f)
+        {
+            return false;
+        }
+
+        swap_subtrees(tree, best.a, best.b);
+
+        // Parents of a and b, each is l, r, or index
+        for (unsigned p : { l, r })
+        {
+            if (p == static_cast<unsigned>(parents_[best.a]) || p == static_cast<unsigned>(parents_[best.b]))
+            {
+                update_bounds(tree, p);
+            }
+        }
 
-        refit(tree, primitives, num_prims, pool);
+        return true;
     }
 };
 
@@ -0,0 +1,329 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_REORDER_H
+#define VSNRAY_DETAIL_BVH_REORDER_H 1
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../../math/aabb.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Memory layouts for reorder_nodes()
+//
+// The two children of an inner node are always stored next to each other, so both
+// layouts arrange child pairs. Parents are always stored before their children.
+//
+// DepthFirstOrder
+//      Child pairs in depth-first order, the subtree of the child with the larger surface
+//      area (the one more likely to be hit) directly follows the pair.
+//
+// VanEmdeBoasOrder
+//      Cache-oblivious layout: the tree of child pairs is split at half its height, the
+//      top half is laid out first, followed by each of the bottom subtrees, recursively.
+//
+
+enum bvh_node_order
+{
+    DepthFirstOrder,
+    VanEmdeBoasOrder
+};
+
+namespace detail
+{
+namespace reorder
+{
+
+// Nodes of a child pair, the one with the larger surface area first ----
+
+template <typename Nodes>
+inline std::pair<unsigned, unsigned> sort_by_area(Nodes const& nodes, unsigned pair)
+{
+    float a0 = surface_area(nodes[pair].get_bounds());
+    float a1 = surface_area(nodes[pair + 1].get_bounds());
+
+    return a0 >= a1 ? std::make_pair(pair, pair + 1) : std::make_pair(pair + 1, pair);
+}
+
+// Child pairs (identified by the old index of their first node) in depth-first order ----
+
+template <typename Nodes>
+inline void depth_first_pairs(Nodes const& nodes, std::vector<unsigned>& pairs)
+{
+    // Inner nodes whose child pair was not emitted yet
+    std::vector<unsigned> st;
+
+    if (nodes[0].is_inner())
+    {
+        st.push_back(0);
+    }
+
+    while (!st.empty())
+    {
+        unsigned index = st.back();
+        st.pop_back();
+
+        unsigned pair = nodes[index].get_child(0);
+        pairs.push_back(pair);
+
+        auto children = sort_by_area(nodes, pair);
+
+        if (nodes[children.second].is_inner())
+        {
+            st.push_back(children.second);
+        }
+
+        if (nodes[children.first].is_inner())
+        {
+            st.push_back(children.first);
+        }
+    }
+}
+
+// Van Emde Boas order of the pairs in the subtree of pair, up to depth height ----
+
+template <typename Nodes>
+inline void van_emde_boas_pairs(
+        Nodes const&           nodes,
+        unsigned               pair,
+        int                    height,
+        std::vector<unsigned>& pairs
+        )
+{
+    if (height == 1)
+    {
+        pairs.push_back(pair);
+        return;
+    }
+
+    int top_height = height / 2;
+    int bottom_height = height - top_height;
+
+    van_emde_boas_pairs(nodes, pair, top_height, pairs);
+
+    // Roots of the bottom subtrees, i.e. pairs at depth top_height
+    std::vector<std::pair<unsigned, int>> st;
+    st.emplace_back(pair, 0);
+
+    while (!st.empty())
+    {
+        unsigned p = st.back().first;
+        int depth = st.back().second;
+        st.pop_back();
+
+        if (depth == top_height)
+        {
+            van_emde_boas_pairs(nodes, p, bottom_height, pairs);
+            continue;
+        }
+
+        // Child pairs of p, the one below the larger node is popped first
+        auto children = sort_by_area(nodes, p);
+
+        if (nodes[children.second].is_inner())
+        {
+            st.emplace_back(nodes[children.second].get_child(0), depth + 1);
+        }
+
+        if (nodes[children.first].is_inner())
+        {
+            st.emplace_back(nodes[children.first].get_child(0), depth + 1);
+        }
+    }
+}
+
+template <typename Nodes>
+inline void van_emde_boas_pairs(Nodes const& nodes, std::vector<unsigned>& pairs)
+{
+    if (!nodes[0].is_inner())
+    {
+        return;
+    }
+
+    // Height of the tree of pairs, parents precede their children in depth-first order
+    std::vector<unsigned> dfs;
+    depth_first_pairs(nodes, dfs);
+
+    std::vector<int> heights(nodes.size(), 0);
+
+    for (auto it = dfs.rbegin(); it != dfs.rend(); ++it)
+    {
+        unsigned p = *it;
+
+        int h = 0;
+
+        for (unsigned c = p; c != p + 2; ++c)
+        {
+            if (nodes[c].is_inner())
+            {
+                h = std::max(h, heights[nodes[c].get_child(0)]);
+            }
+        }
+
+        heights[p] = h + 1;
+    }
+
+    unsigned root_pair = nodes[0].get_child(0);
+
+    van_emde_boas_pairs(nodes, root_pair, heights[root_pair], pairs);
+}
+
+// Copy the primitive references of a leaf ------------------
+
+template <typename Tree>
+inline void copy_leaf_primitives(
+        Tree const&           tree,
+        Tree&                 result,
+        bvh_node::index_range range,
+        unsigned              first,
+        std::true_type        /* is_index_bvh */
+        )
+{
+    auto dst = result.indices().begin() + first;
+
+    std::copy(
+            tree.indices().begin() + range.first,
+            tree.indices().begin() + range.last,
+            dst
+            );
+
+    // Ascending primitive indices, so that primitive(i) is accessed sequentially
+    std::sort(dst, dst + (range.last - range.first));
+}
+
+template <typename Tree>
+inline void copy_leaf_primitives(
+        Tree const&           tree,
+        Tree&                 result,
+        bvh_node::index_range range,
+        unsigned              first,
+        std::false_type       /* is_index_bvh */
+        )
+{
+    std::copy(
+            tree.primitives().begin() + range.first,
+            tree.primitives().begin() + range.last,
+            result.primitives().begin() + first
+            );
+}
+
+template <typename Tree>
+inline void resize_primitives(Tree const& tree, Tree& result, std::true_type /* is_index_bvh */)
+{
+    result.primitives() = tree.primitives();
+    result.indices().resize(tree.indices().size());
+}
+
+template <typename Tree>
+inline void resize_primitives(Tree const& tree, Tree& result, std::false_type /* is_index_bvh */)
+{
+    result.primitives().resize(tree.primitives().size());
+}
+
+} // reorder
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Reorder the nodes of a binary [index_]bvh for better memory locality during traversal
+//
+// Post-build pass for trees from any builder. Nodes are rearranged according to order,
+// nodes that are not referenced by the tree are dropped. Leaves are then assigned
+// consecutive primitive ranges in node order: bvh primitives are moved accordingly,
+// index_bvh indices are rewritten and sorted in ascending order within each leaf.
+// Primitives of an index_bvh keep their order. Node bounds and the tree topology, and
+// thus the SAH cost, do not change.
+//
+// Node and primitive storage is replaced, so parent links cached by bvh_refitter are
+// invalidated.
+//
+
+template <typename Tree>
+inline void reorder_nodes(Tree& tree, bvh_node_order order = DepthFirstOrder)
+{
+    static_assert(is_any_bvh<Tree>::value, "Type mismatch");
+    static_assert(!is_wide_bvh<Tree>::value, "Type mismatch");
+
+    auto const& nodes = tree.nodes();
+
+    if (nodes.size() == 0)
+    {
+        return;
+    }
+
+    std::vector<unsigned> pairs;
+    pairs.reserve(nodes.size() / 2);
+
+    if (order == VanEmdeBoasOrder)
+    {
+        detail::reorder::van_emde_boas_pairs(nodes, pairs);
+    }
+    else
+    {
+        detail::reorder::depth_first_pairs(nodes, pairs);
+    }
+
+    // Old node index to new node index
+    std::vector<unsigned> new_index(nodes.size(), 0);
+
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        new_index[pairs[i]]     = static_cast<unsigned>(2 * i + 1);
+        new_index[pairs[i] + 1] = static_cast<unsigned>(2 * i + 2);
+    }
+
+    // Old index of each new node
+    std::vector<unsigned> old_index(1 + 2 * pairs.size());
+    old_index[0] = 0;
+
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        old_index[2 * i + 1] = pairs[i];
+        old_index[2 * i + 2] = pairs[i] + 1;
+    }
+
+    Tree result;
+    result.nodes().resize(old_index.size());
+    detail::reorder::resize_primitives(tree, result, is_index_bvh<Tree>{});
+
+    unsigned num_prims = 0;
+
+    for (size_t i = 0; i < old_index.size(); ++i)
+    {
+        auto const& node = nodes[old_index[i]];
+
+        if (node.is_inner())
+        {
+            result.nodes()[i].set_inner(node.get_bounds(), new_index[node.get_child(0)]);
+        }
+        else
+        {
+            detail::reorder::copy_leaf_primitives(
+                    tree,
+                    result,
+                    node.get_indices(),
+                    num_prims,
+                    is_index_bvh<Tree>{}
+                    );
+
+            result.nodes()[i].set_leaf(node.get_bounds(), num_prims, node.get_num_primitives());
+
+            num_prims += node.get_num_primitives();
+        }
+    }
+
+    tree = std::move(result);
+}
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_REORDER_H
@@ -7,15 +7,23 @@
 #define VSNRAY_DETAIL_BVH_SAH_H 1
 
 #include <cassert>
+#include <algorithm>
 #include <array>
 #include <type_traits>
 #include <vector>
 
+#include "../../math/detail/math.h"
 #include "../../math/aabb.h"
+#include "../../math/motion_triangle.h"
 #include "../../math/sphere.h"
 #include "../../math/triangle.h"
 
+#include "../parallel_for.h"
+#include "../range.h"
 #include "build_top_down.h"
+#include "motion.h"
+#include "pack_triangles.h"
+#include "presplit.h"
 
 namespace visionaray
 {
@@ -65,6 +73,25 @@ void split_primitive(aabb& L, aabb& R, float plane, int axis, basic_triangle<Dim
     detail::split_edge(L, R, v2, v0, plane, axis);
 }
 
+// Motion triangles are split at each keyframe. Motion BVH nodes store the bounds of the
+// unsplit keyframes, so splits only guide the topology.
+template <size_t K, typename T, typename P>
+void split_primitive(aabb& L, aabb& R, float plane, int axis, basic_motion_triangle<K, T, P> const& prim)
+{
+    L.invalidate();
+    R.invalidate();
+
+    for (size_t k = 0; k < K; ++k)
+    {
+        aabb l;
+        aabb r;
+        split_primitive(l, r, plane, axis, get_keyframe(prim, k));
+
+        L = combine(L, l);
+        R = combine(R, r);
+    }
+}
+
 template <typename T, typename P>
 void split_primitive(aabb& L, aabb& R, float plane, int axis, basic_sphere<T, P> const& prim)
 {
@@ -186,7 +213,38 @@ struct binned_sah_builder
 
     using prim_refs = aligned_vector<prim_ref>;
 
-    template <typename Tree, typename P>
+    // Build over triangles and pack the leaves into multi triangles when Tree stores
+    // basic_multi_triangle. Leaves hold up to N triangles unless max_leaf_size is given.
+    template <
+        typename Tree,
+        typename P,
+        typename = typename std::enable_if<is_multi_triangle_bvh<Tree>::value>::type,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
+    {
+        return detail::build_multi_triangle_bvh<Tree>(*this, primitives, num_prims, max_leaf_size);
+    }
+
+    // Build over keyframed primitives when Tree has bvh_motion_nodes. The nodes store
+    // the bounds at each keyframe.
+    template <
+        typename Tree,
+        typename P,
+        typename = typename std::enable_if<is_motion_bvh<Tree>::value>::type,
+        typename = void,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
+    {
+        return detail::build_motion_bvh<Tree>(*this, primitives, num_prims, max_leaf_size);
+    }
+
+    template <
+        typename Tree,
+        typename P,
+        typename = typename std::enable_if<!is_multi_triangle_bvh<Tree>::value && !is_motion_bvh<Tree>::value>::type
+        >
     Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
     {
         Tree tree(primitives, num_prims);
@@ -196,6 +254,50 @@ struct binned_sah_builder
         return tree;
     }
 
+    // Parallel build. Splits the upper levels with parallel binning and partitioning
+    // and builds the remaining subtrees as independent tasks on the thread pool.
+    // Produces the same splits as the serial build. POOL must be a thread_pool,
+    // parallel_for() and task_group have no TBB implementation.
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<is_multi_triangle_bvh<Tree>::value>::type,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        return detail::build_multi_triangle_bvh<Tree>(*this, primitives, num_prims, max_leaf_size, pool);
+    }
+
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<is_motion_bvh<Tree>::value>::type,
+        typename = void,
+        typename = void
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        return detail::build_motion_bvh<Tree>(*this, primitives, num_prims, max_leaf_size, pool);
+    }
+
+    template <
+        typename Tree,
+        typename P,
+        typename Pool,
+        typename = typename std::enable_if<!is_multi_triangle_bvh<Tree>::value && !is_motion_bvh<Tree>::value>::type
+        >
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size, Pool& pool)
+    {
+        Tree tree(primitives, num_prims);
+
+        detail::build_top_down_parallel(tree, *this, primitives, primitives + num_prims, max_leaf_size, pool);
+
+        return tree;
+    }
+
     template <typename I>
     static void init(prim_refs& refs, aabb& prim_bounds, aabb& cent_bounds, I first, I last)
     {
@@ -213,11 +315,67 @@ struct binned_sah_builder
         }
     }
 
+    template <typename I, typename Pool>
+    static void init(prim_refs& refs, aabb& prim_bounds, aabb& cent_bounds, I first, I last, Pool& pool)
+    {
+        int count = static_cast<int>(last - first);
+        int num_tiles = div_up(count, static_cast<int>(ParallelTileSize));
+
+        refs.resize(count);
+
+        std::vector<aabb> tile_prim_bounds(num_tiles);
+        std::vector<aabb> tile_cent_bounds(num_tiles);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, count, ParallelTileSize),
+            [&](range1d<int> const& r)
+            {
+                int tile = r.begin() / ParallelTileSize;
+
+                aabb pb;
+                aabb cb;
+
+                pb.invalidate();
+                cb.invalidate();
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    refs[i].assign(first[i], i);
+
+                    pb.insert(refs[i].bounds);
+                    cb.insert(refs[i].bounds.center());
+                }
+
+                tile_prim_bounds[tile] = pb;
+                tile_cent_bounds[tile] = cb;
+            });
+
+        prim_bounds.invalidate();
+        cent_bounds.invalidate();
+
+        for (int i = 0; i < num_tiles; ++i)
+        {
+            prim_bounds.insert(tile_prim_bounds[i]);
+            cent_bounds.insert(tile_cent_bounds[i]);
+        }
+    }
+
     enum
     {
         NumBins = 16
     };
 
+    enum
+    {
+        // Number of primitive references processed by a single task
+        // when binning or partitioning in parallel
+        ParallelTileSize = 16384,
+
+        // Nodes with less primitive references are split on a single thread
+        ParallelSplitThreshold = 4 * ParallelTileSize
+    };
+
     struct bin
     {
         // TODO:
@@ -394,6 +552,133 @@ struct binned_sah_builder
         return sr;
     }
 
+    //--------------------------------------------------------------------------
+    // parallel binning and partitioning
+    //
+
+    // Bins the primitive references in [first..last) with FUNC(bins, ref).
+    // Each task fills its own list of bins, the lists are merged afterwards.
+    template <typename Pool, typename Func>
+    static bin_list parallel_bin(prim_refs const& refs, int first, int last, Pool& pool, Func func)
+    {
+        int num_tiles = div_up(last - first, static_cast<int>(ParallelTileSize));
+
+        std::vector<bin_list> tile_bins(num_tiles);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(first, last, ParallelTileSize),
+            [&](range1d<int> const& r)
+            {
+                auto& bins = tile_bins[(r.begin() - first) / ParallelTileSize];
+
+                for (auto& b : bins)
+                {
+                    b.clear();
+                }
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    func(bins, refs[i]);
+                }
+            });
+
+        bin_list bins = tile_bins[0];
+
+        for (int t = 1; t < num_tiles; ++t)
+        {
+            for (int i = 0; i < NumBins; ++i)
+            {
+                bins[i] = merge(bins[i], tile_bins[t][i]);
+            }
+        }
+
+        return bins;
+    }
+
+    // Partitions the primitive references in [first..last) so that all references
+    // for which PRED is true precede the other ones. Returns the partition point.
+    template <typename Pool, typename Pred>
+    static int parallel_partition(prim_refs& refs, int first, int last, Pool& pool, Pred pred)
+    {
+        int num_tiles = div_up(last - first, static_cast<int>(ParallelTileSize));
+
+        // Count the references that go to the left in each tile
+
+        std::vector<int> counts(num_tiles);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(first, last, ParallelTileSize),
+            [&](range1d<int> const& r)
+            {
+                int count = 0;
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    count += pred(refs[i]) ? 1 : 0;
+                }
+
+                counts[(r.begin() - first) / ParallelTileSize] = count;
+            });
+
+        // Exclusive prefix sums yield the output offsets of each tile
+
+        std::vector<int> left_offsets(num_tiles);
+        std::vector<int> right_offsets(num_tiles);
+
+        int num_left = 0;
+
+        for (int t = 0; t < num_tiles; ++t)
+        {
+            left_offsets[t] = num_left;
+            num_left += counts[t];
+        }
+
+        for (int t = 0; t < num_tiles; ++t)
+        {
+            int tile_first = t * ParallelTileSize;
+            right_offsets[t] = num_left + tile_first - left_offsets[t];
+        }
+
+        // Scatter into temporary storage and copy back
+
+        prim_refs temp(last - first);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(first, last, ParallelTileSize),
+            [&](range1d<int> const& r)
+            {
+                int tile = (r.begin() - first) / ParallelTileSize;
+
+                int l = left_offsets[tile];
+                int rr = right_offsets[tile];
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    if (pred(refs[i]))
+                    {
+                        temp[l++] = refs[i];
+                    }
+                    else
+                    {
+                        temp[rr++] = refs[i];
+                    }
+                }
+            });
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(first, last, ParallelTileSize),
+            [&](range1d<int> const& r)
+            {
+                std::copy(temp.begin() + (r.begin() - first), temp.begin() + (r.end() - first), refs.begin() + r.begin());
+            });
+
+        return first + num_left;
+    }
+
     //--------------------------------------------------------------------------
     // object partition
     //
@@ -451,6 +736,49 @@ struct binned_sah_builder
         childs[1].first = static_cast<int>(pivot - refs.begin());
     }
 
+    // Find the best object split, bin in parallel.
+    template <typename Pool>
+    static split_result find_object_split(prim_refs& refs, leaf_info const& leaf, projection pr, Pool& pool)
+    {
+        auto bins = parallel_bin(
+                refs,
+                leaf.first,
+                static_cast<int>(refs.size()),
+                pool,
+                [pr](bin_list& bins, prim_ref const& ref)
+                {
+                    project_object(bins, ref, pr);
+                }
+                );
+
+        return find_split(bins, leaf.prim_bounds);
+    }
+
+    // Partition the given list of objects in parallel
+    template <typename Pool>
+    static void perform_object_partition(
+        leaf_infos& childs, split_result const& sr, prim_refs& refs, leaf_info const& leaf, projection pr, Pool& pool)
+    {
+        childs[0].prim_bounds = sr.prim_bounds[0];
+        childs[0].cent_bounds = sr.cent_bounds[0];
+        childs[1].prim_bounds = sr.prim_bounds[1];
+        childs[1].cent_bounds = sr.cent_bounds[1];
+
+        auto pivot = parallel_partition(
+            refs,
+            leaf.first,
+            static_cast<int>(refs.size()),
+            pool,
+            [&](prim_ref const& x)
+            {
+                return pr.project_unsafe(x.bounds.center()) < sr.index;
+            }
+        );
+
+        childs[0].first = leaf.first;
+        childs[1].first = pivot;
+    }
+
     //--------------------------------------------------------------------------
     // spatial split
     //
@@ -527,6 +855,24 @@ struct binned_sah_builder
         return find_split(bins, leaf.prim_bounds);
     }
 
+    template <typename Data, typename Pool>
+    static split_result
+    find_spatial_split(prim_refs const& refs, leaf_info const& leaf, projection pr, Data const& data, Pool& pool)
+    {
+        auto bins = parallel_bin(
+                refs,
+                leaf.first,
+                static_cast<int>(refs.size()),
+                pool,
+                [pr, &data](bin_list& bins, prim_ref const& ref)
+                {
+                    split_object(bins, ref, pr, data);
+                }
+                );
+
+        return find_split(bins, leaf.prim_bounds);
+    }
+
     template <typename Data>
     static void perform_spatial_split(
             leaf_infos&         childs,
@@ -642,6 +988,160 @@ struct binned_sah_builder
         childs[1].first = pivot;
     }
 
+    // Perform the spatial split in parallel. References that straddle the plane
+    // are split into a left and a right half, so the list grows by their number.
+    // Each task counts and then scatters its tile of references, the left ones
+    // precede the right ones in the result.
+    template <typename Data, typename Pool>
+    static void perform_spatial_split(
+            leaf_infos&         childs,
+            split_result const& sr,
+            prim_refs&          refs,
+            leaf_info const&    leaf,
+            projection          pr,
+            Data const&         data,
+            Pool&               pool
+            )
+    {
+        auto plane = pr.unproject(sr.index);
+
+        int first = leaf.first;
+        int last = static_cast<int>(refs.size());
+        int num_tiles = div_up(last - first, static_cast<int>(ParallelTileSize));
+
+        struct tile_info
+        {
+            int num_left;
+            int num_right;
+            aabb prim_bounds[2];
+            aabb cent_bounds[2];
+        };
+
+        std::vector<tile_info> tiles(num_tiles);
+
+        // Count the references that go to either side in each tile
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(first, last, ParallelTileSize),
+            [&](range1d<int> const& r)
+            {
+                auto& ti = tiles[(r.begin() - first) / ParallelTileSize];
+
+                ti.num_left = 0;
+                ti.num_right = 0;
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    auto pmin = refs[i].bounds.min[pr.axis];
+                    auto pmax = refs[i].bounds.max[pr.axis];
+
+                    ti.num_left += pmin < plane || pmax <= plane ? 1 : 0;
+                    ti.num_right += pmax > plane ? 1 : 0;
+                }
+            });
+
+        // Exclusive prefix sums yield the output offsets of each tile
+
+        std::vector<int> left_offsets(num_tiles);
+        std::vector<int> right_offsets(num_tiles);
+
+        int num_left = 0;
+        int num_right = 0;
+
+        for (int t = 0; t < num_tiles; ++t)
+        {
+            left_offsets[t] = num_left;
+            num_left += tiles[t].num_left;
+        }
+
+        for (int t = 0; t < num_tiles; ++t)
+        {
+            right_offsets[t] = num_left + num_right;
+            num_right += tiles[t].num_right;
+        }
+
+        // Scatter into temporary storage, splitting straddling references
+
+        prim_refs temp(num_left + num_right);
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(first, last, ParallelTileSize),
+            [&](range1d<int> const& r)
+            {
+                int tile = (r.begin() - first) / ParallelTileSize;
+                auto& ti = tiles[tile];
+
+                for (int k = 0; k < 2; ++k)
+                {
+                    ti.prim_bounds[k].invalidate();
+                    ti.cent_bounds[k].invalidate();
+                }
+
+                int l = left_offsets[tile];
+                int rr = right_offsets[tile];
+
+                for (int i = r.begin(); i != r.end(); ++i)
+                {
+                    auto pmin = refs[i].bounds.min[pr.axis];
+                    auto pmax = refs[i].bounds.max[pr.axis];
+
+                    if (pmax <= plane)
+                    {
+                        temp[l++] = refs[i];
+                    }
+                    else if (pmin >= plane)
+                    {
+                        temp[rr++] = refs[i];
+                    }
+                    else
+                    {
+                        split_reference(temp[l++], temp[rr++], refs[i], plane, pr.axis, data);
+                    }
+                }
+
+                for (int i = left_offsets[tile]; i != l; ++i)
+                {
+                    ti.prim_bounds[0].insert(temp[i].bounds);
+                    ti.cent_bounds[0].insert(temp[i].bounds.center());
+                }
+
+                for (int i = right_offsets[tile]; i != rr; ++i)
+                {
+                    ti.prim_bounds[1].insert(temp[i].bounds);
+                    ti.cent_bounds[1].insert(temp[i].bounds.center());
+                }
+            });
+
+        for (int k = 0; k < 2; ++k)
+        {
+            childs[k].prim_bounds = tiles[0].prim_bounds[k];
+            childs[k].cent_bounds = tiles[0].cent_bounds[k];
+
+            for (int t = 1; t < num_tiles; ++t)
+            {
+                childs[k].prim_bounds = combine(childs[k].prim_bounds, tiles[t].prim_bounds[k]);
+                childs[k].cent_bounds = combine(childs[k].cent_bounds, tiles[t].cent_bounds[k]);
+            }
+        }
+
+        // Copy back
+
+        refs.resize(first + temp.size());
+
+        parallel_for(
+            pool,
+            tiled_range1d<int>(0, static_cast<int>(temp.size()), ParallelTileSize),
+            [&](range1d<int> const& r)
+            {
+                std::copy(temp.begin() + r.begin(), temp.begin() + r.end(), refs.begin() + first + r.begin());
+            });
+
+        childs[0].first = first;
+        childs[1].first = first + num_left;
+    }
+
     //--------------------------------------------------------------------------
     // split
     //
@@ -657,6 +1157,10 @@ struct binned_sah_builder
     float alpha = 1.0e-5f;
     // Whether to use spatial splits
     bool use_spatial_splits = false;
+    // Whether to split large primitives before binning
+    bool use_presplits = false;
+    // Computes the primitive references if use_presplits is set
+    bvh_presplitter presplitter;
 
     void set_alpha(float value)
     {
@@ -668,19 +1172,96 @@ struct binned_sah_builder
         use_spatial_splits = enable;
     }
 
+    // Start with the references computed by presplitter instead of one reference per
+    // primitive. Unlike spatial splits, this also works with bvh (primitives are then
+    // duplicated) and does not increase the cost of binning
+    void enable_presplits(bool enable)
+    {
+        use_presplits = enable;
+    }
+
+    // Primitive references from the presplitter
+    void init_presplit(aabb& prim_bounds, aabb& cent_bounds)
+    {
+        refs.resize(presplitter.size());
+
+        prim_bounds.invalidate();
+        cent_bounds.invalidate();
+
+        for (size_t i = 0; i < refs.size(); ++i)
+        {
+            refs[i].bounds = presplitter.bounds()[i];
+            refs[i].index = static_cast<int>(presplitter.indices()[i]);
+
+            prim_bounds.insert(refs[i].bounds);
+            cent_bounds.insert(refs[i].bounds.center());
+        }
+    }
+
     template <typename I>
     leaf_info init(I first, I last)
     {
         aabb prim_bounds;
         aabb cent_bounds;
 
-        init(refs, prim_bounds, cent_bounds, first, last);
+        if (use_presplits)
+        {
+            presplitter.split(&*first, last - first);
+            init_presplit(prim_bounds, cent_bounds);
+        }
+        else
+        {
+            init(refs, prim_bounds, cent_bounds, first, last);
+        }
+
+        sa_threshold = alpha * safe_surface_area(prim_bounds);
+
+        return { prim_bounds, cent_bounds, 0 };
+    }
+
+    template <typename I, typename Pool>
+    leaf_info init(I first, I last, Pool& pool)
+    {
+        aabb prim_bounds;
+        aabb cent_bounds;
+
+        if (use_presplits)
+        {
+            presplitter.split(&*first, last - first, pool);
+            init_presplit(prim_bounds, cent_bounds);
+        }
+        else
+        {
+            init(refs, prim_bounds, cent_bounds, first, last, pool);
+        }
 
         sa_threshold = alpha * safe_surface_area(prim_bounds);
 
         return { prim_bounds, cent_bounds, 0 };
     }
 
+    // Returns the number of primitive references in the given leaf.
+    int leaf_size(leaf_info const& leaf) const
+    {
+        return static_cast<int>(refs.size() - leaf.first);
+    }
+
+    // Moves the primitive references of LEAF to the builder SUB, which can then
+    // build the subtree independently. Removes the references from the current list.
+    void detach(binned_sah_builder& sub, leaf_info& sub_leaf, leaf_info const& leaf)
+    {
+        sub.sa_threshold = sa_threshold;
+        sub.alpha = alpha;
+        sub.use_spatial_splits = use_spatial_splits;
+
+        sub.refs.assign(refs.begin() + leaf.first, refs.end());
+
+        sub_leaf = leaf;
+        sub_leaf.first = 0;
+
+        refs.resize(leaf.first);
+    }
+
     // Inserts primitive indices into INDICES and removes them from the current list.
     template <typename Indices>
     int insert_indices(Indices& indices, leaf_info const& leaf)
@@ -704,6 +1285,21 @@ struct binned_sah_builder
     // method returns true. If the leaf should not be split, returns false.
     template <typename Data>
     bool split(leaf_infos& childs, leaf_info const& leaf, Data const& data, int max_leaf_size)
+    {
+        return split_impl(childs, leaf, data, max_leaf_size, static_cast<thread_pool*>(nullptr));
+    }
+
+    // Same as above, large leaves are binned and partitioned in parallel.
+    template <typename Data, typename Pool>
+    bool split(leaf_infos& childs, leaf_info const& leaf, Data const& data, int max_leaf_size, Pool& pool)
+    {
+        return split_impl(childs, leaf, data, max_leaf_size, &pool);
+    }
+
+private:
+
+    template <typename Data, typename Pool>
+    bool split_impl(leaf_infos& childs, leaf_info const& leaf, Data const& data, int max_leaf_size, Pool* pool)
     {
         // FIXME:
         // Create a leaf if max_depth is reached...
@@ -716,6 +1312,8 @@ struct binned_sah_builder
             return false;
         }
 
+        bool parallel = pool != nullptr && leaf_size >= ParallelSplitThreshold;
+
         // Find the split axis (TODO: Test all axes...)
 
         // Using centroid bounds for object partitioning...
@@ -731,7 +1329,7 @@ struct binned_sah_builder
 
         projection pr(leaf.cent_bounds, static_cast<int>(axis));
 
-        auto sr = find_object_split(refs, leaf, pr);
+        auto sr = parallel ? find_object_split(refs, leaf, pr, *pool) : find_object_split(refs, leaf, pr);
 
         // Spatial split -------------------------------------------------------
 
@@ -754,7 +1352,9 @@ struct binned_sah_builder
 
                 projection pr2(leaf.prim_bounds, static_cast<int>(axis));
 
-                auto sr2 = find_spatial_split(refs, leaf, pr2, data);
+                auto sr2 = parallel
+                        ? find_spatial_split(refs, leaf, pr2, data, *pool)
+                        : find_spatial_split(refs, leaf, pr2, data);
 
                 if (sr2.cost < sr.cost /* && (sr2.count[0] + sr2.count[1] < 1.5 * leaf_size) */)
                 {
@@ -777,10 +1377,18 @@ struct binned_sah_builder
         // Found a new split point.
         // Sort primitive references.
 
-        if (do_spatial_split)
+        if (do_spatial_split && parallel)
+        {
+            perform_spatial_split(childs, sr, refs, leaf, pr, data, *pool);
+        }
+        else if (do_spatial_split)
         {
             perform_spatial_split(childs, sr, refs, leaf, pr, data);
         }
+        else if (parallel)
+        {
+            perform_object_partition(childs, sr, refs, leaf, pr, *pool);
+        }
         else
         {
             perform_object_partition(childs, sr, refs, leaf, pr);
@@ -0,0 +1,445 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_TREELET_H
+#define VSNRAY_DETAIL_BVH_TREELET_H 1
+
+#include <atomic>
+#include <cassert>
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+
+#include "../../math/aabb.h"
+#include "../../aligned_vector.h"
+
+#include "../parallel_for.h"
+#include "../range.h"
+#include "../thread_pool.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// bvh_treelet_optimizer
+//
+// Post-optimization pass for binary [index_]bvhs from any builder, reduces the SAH cost by
+// restructuring small treelets
+//
+// cf. Karras, Aila (2013): Fast Parallel Construction of High-Quality Bounding Volume Hierarchies
+//
+// A treelet is formed at each inner node by repeatedly expanding the treelet leaf with the
+// largest surface area, until the treelet has treelet_size() leaves. The topology with the
+// least SAH cost over those leaves is found by dynamic programming over all subsets of
+// leaves, and replaces the treelet if it is cheaper. Nodes are processed bottom-up, the
+// last child to arrive at a node (tracked with an atomic counter) processes the parent.
+// Treelets processed at the same time are disjoint, so the pass runs in parallel.
+//
+// Treelets are rearranged in place: the treelet's inner nodes are reused and the subtrees
+// below the treelet leaves are moved by copying their root nodes. Node bounds stay valid,
+// primitives and leaves are not changed.
+//
+
+class bvh_treelet_optimizer
+{
+public:
+
+    // Maximum number of treelet leaves, the dynamic program has cost O(3^n)
+    enum { MaxTreeletSize = 8 };
+
+    // Number of leaves per treelet, in [3..MaxTreeletSize]
+    void set_treelet_size(int size)
+    {
+        assert(size >= 3 && size <= MaxTreeletSize);
+        treelet_size_ = size;
+    }
+
+    int treelet_size() const
+    {
+        return treelet_size_;
+    }
+
+    // Number of bottom-up passes over the tree
+    void set_num_rounds(int rounds)
+    {
+        num_rounds_ = rounds;
+    }
+
+    int num_rounds() const
+    {
+        return num_rounds_;
+    }
+
+    // SAH costs to traverse an inner node and to intersect a primitive, cf. sah_cost()
+    void set_costs(float ci, float cp)
+    {
+        ci_ = ci;
+        cp_ = cp;
+    }
+
+    template <typename Tree>
+    void optimize(Tree& tree, thread_pool& pool)
+    {
+        if (!prepare(tree))
+        {
+            return;
+        }
+
+        for (int round = 0; round < num_rounds_; ++round)
+        {
+            collect_leaves();
+
+            parallel_for(
+                pool,
+                tiled_range1d<size_t>(0, leaves_.size(), 16),
+                [&](range1d<size_t> const& r)
+                {
+                    for (size_t i = r.begin(); i < r.end(); ++i)
+                    {
+                        propagate(tree, leaves_[i]);
+                    }
+                });
+        }
+    }
+
+    // Serial version, runs on the calling thread
+    template <typename Tree>
+    void optimize(Tree& tree)
+    {
+        if (!prepare(tree))
+        {
+            return;
+        }
+
+        for (int round = 0; round < num_rounds_; ++round)
+        {
+            collect_leaves();
+
+            for (unsigned leaf : leaves_)
+            {
+                propagate(tree, leaf);
+            }
+        }
+    }
+
+private:
+
+    enum { Root = -1, Unreachable = -2 };
+
+    int treelet_size_ = 7;
+    int num_rounds_ = 3;
+
+    float ci_ = 1.2f;
+    float cp_ = 1.0f;
+
+    // Parent node index, Root or Unreachable
+    aligned_vector<int> parents_;
+
+    // 1 for leaves
+    aligned_vector<unsigned char> leaf_flags_;
+
+    // SAH cost of the subtree below each node, not normalized by the root surface area
+    aligned_vector<float> costs_;
+
+    // Leaves to start the bottom-up pass from
+    aligned_vector<unsigned> leaves_;
+
+    // Number of children that have arrived at an inner node, reset by the last one
+    std::vector<std::atomic<unsigned>> counters_;
+
+    // Build parent links, returns false if there is nothing to optimize
+    template <typename Tree>
+    bool prepare(Tree const& tree)
+    {
+        static_assert(is_any_bvh<Tree>::value, "Type mismatch");
+        static_assert(!is_wide_bvh<Tree>::value, "Type mismatch");
+
+        size_t num_nodes = tree.num_nodes();
+
+        if (num_nodes < 5)
+        {
+            return false;
+        }
+
+        parents_.assign(num_nodes, Unreachable);
+        parents_[0] = Root;
+        leaf_flags_.assign(num_nodes, 0);
+        costs_.assign(num_nodes, 0.0f);
+        counters_ = std::vector<std::atomic<unsigned>>(num_nodes);
+
+        for (auto& c : counters_)
+        {
+            c.store(0, std::memory_order_relaxed);
+        }
+
+        std::vector<unsigned> st;
+        st.push_back(0);
+
+        while (!st.empty())
+        {
+            unsigned index = st.back();
+            st.pop_back();
+
+            auto const& node = tree.node(index);
+
+            if (node.is_inner())
+            {
+                for (unsigned i = 0; i < 2; ++i)
+                {
+                    unsigned child = node.get_child(i);
+                    parents_[child] = static_cast<int>(index);
+                    st.push_back(child);
+                }
+            }
+            else
+            {
+                leaf_flags_[index] = 1;
+            }
+        }
+
+        return true;
+    }
+
+    // Leaves move around when treelets are restructured
+    void collect_leaves()
+    {
+        leaves_.clear();
+
+        for (size_t i = 0; i < leaf_flags_.size(); ++i)
+        {
+            if (leaf_flags_[i] && parents_[i] != Unreachable)
+            {
+                leaves_.push_back(static_cast<unsigned>(i));
+            }
+        }
+    }
+
+    // Compute the cost of a leaf and process its ancestors
+    template <typename Tree>
+    void propagate(Tree& tree, unsigned leaf)
+    {
+        auto const& node = tree.node(leaf);
+        costs_[leaf] = cp_ * surface_area(node.get_bounds()) * static_cast<float>(node.get_num_primitives());
+
+        int parent = parents_[leaf];
+
+        while (parent >= 0)
+        {
+            if (counters_[parent].fetch_add(1, std::memory_order_acq_rel) == 0)
+            {
+                return;
+            }
+
+            counters_[parent].store(0, std::memory_order_relaxed);
+
+            restructure(tree, static_cast<unsigned>(parent));
+
+            parent = parents_[parent];
+        }
+    }
+
+    // Form the treelet below an inner node and replace it with the optimal topology
+    template <typename Tree>
+    void restructure(Tree& tree, unsigned root)
+    {
+        using node_type = typename Tree::node_type;
+
+        auto const& root_node = tree.node(root);
+
+        float current_cost = ci_ * surface_area(root_node.get_bounds())
+                           + costs_[root_node.get_child(0)]
+                           + costs_[root_node.get_child(1)];
+
+        // Form the treelet ---------------------------------------
+
+        unsigned leaves[MaxTreeletSize];
+        unsigned inner[MaxTreeletSize - 1];
+
+        int num_leaves = 2;
+        int num_inner = 1;
+
+        leaves[0] = root_node.get_child(0);
+        leaves[1] = root_node.get_child(1);
+        inner[0] = root;
+
+        while (num_leaves < treelet_size_)
+        {
+            int best = -1;
+            float best_area = -1.0f;
+
+            for (int i = 0; i < num_leaves; ++i)
+            {
+                if (!leaf_flags_[leaves[i]])
+                {
+                    float area = surface_area(tree.node(leaves[i]).get_bounds());
+
+                    if (area > best_area)
+                    {
+                        best = i;
+                        best_area = area;
+                    }
+                }
+            }
+
+            if (best < 0)
+            {
+                break;
+            }
+
+            auto const& expand = tree.node(leaves[best]);
+            inner[num_inner++] = leaves[best];
+            leaves[best] = expand.get_child(0);
+            leaves[num_leaves++] = expand.get_child(1);
+        }
+
+        if (num_leaves < 3)
+        {
+            costs_[root] = current_cost;
+            return;
+        }
+
+        // Optimal topology over all subsets of treelet leaves -----
+
+        unsigned num_subsets = 1U << num_leaves;
+
+        aabb bounds[1 << MaxTreeletSize];
+        float copt[1 << MaxTreeletSize];
+        unsigned partition[1 << MaxTreeletSize];
+
+        for (unsigned s = 1; s < num_subsets; ++s)
+        {
+            unsigned lowest = s & (~s + 1);
+
+            if (s == lowest)
+            {
+                int i = 0;
+                while ((1U << i) != s)
+                {
+                    ++i;
+                }
+
+                bounds[s] = tree.node(leaves[i]).get_bounds();
+                copt[s] = costs_[leaves[i]];
+                partition[s] = 0;
+                continue;
+            }
+
+            bounds[s] = combine(bounds[lowest], bounds[s ^ lowest]);
+
+            // Partitions {p, s \ p}, p contains the lowest bit so that each is visited once
+            float best_cost = FLT_MAX;
+            unsigned best_p = lowest;
+
+            for (unsigned p = (s - 1) & s; p != 0; p = (p - 1) & s)
+            {
+                if ((p & lowest) == 0)
+                {
+                    continue;
+                }
+
+                float c = copt[p] + copt[s ^ p];
+
+                if (c < best_cost)
+                {
+                    best_cost = c;
+                    best_p = p;
+                }
+            }
+
+            copt[s] = ci_ * surface_area(bounds[s]) + best_cost;
+            partition[s] = best_p;
+        }
+
+        unsigned all = num_subsets - 1;
+
+        if (!(copt[all] < current_cost * (1.0f - 1e-6f)))
+        {
+            costs_[root] = current_cost;
+            return;
+        }
+
+        // Rearrange the treelet -----------------------------------
+
+        // Leaf records and costs are overwritten below, copy them first
+        node_type leaf_nodes[MaxTreeletSize];
+        float leaf_costs[MaxTreeletSize];
+        unsigned char leaf_is_leaf[MaxTreeletSize];
+
+        for (int i = 0; i < num_leaves; ++i)
+        {
+            leaf_nodes[i] = tree.node(leaves[i]);
+            leaf_costs[i] = costs_[leaves[i]];
+            leaf_is_leaf[i] = leaf_flags_[leaves[i]];
+        }
+
+        // Child pairs of the treelet's inner nodes, reused for the new inner nodes
+        unsigned pairs[MaxTreeletSize - 1];
+
+        for (int i = 0; i < num_inner; ++i)
+        {
+            pairs[i] = tree.node(inner[i]).get_child(0);
+        }
+
+        int next_pair = 0;
+
+        // Explicit stack of (subset, node index)
+        struct entry
+        {
+            unsigned subset;
+            unsigned index;
+        };
+
+        entry st[2 * MaxTreeletSize];
+        int sp = 0;
+
+        st[sp++] = { all, root };
+
+        while (sp > 0)
+        {
+            entry e = st[--sp];
+
+            if ((e.subset & (e.subset - 1)) == 0)
+            {
+                // Treelet leaf
+                int i = 0;
+                while ((1U << i) != e.subset)
+                {
+                    ++i;
+                }
+
+                tree.nodes()[e.index] = leaf_nodes[i];
+                costs_[e.index] = leaf_costs[i];
+                leaf_flags_[e.index] = leaf_is_leaf[i];
+
+                if (!leaf_is_leaf[i])
+                {
+                    parents_[leaf_nodes[i].get_child(0)] = static_cast<int>(e.index);
+                    parents_[leaf_nodes[i].get_child(1)] = static_cast<int>(e.index);
+                }
+            }
+            else
+            {
+                unsigned first_child = pairs[next_pair++];
+
+                tree.nodes()[e.index].set_inner(bounds[e.subset], first_child);
+                costs_[e.index] = copt[e.subset];
+                leaf_flags_[e.index] = 0;
+
+                parents_[first_child] = static_cast<int>(e.index);
+                parents_[first_child + 1] = static_cast<int>(e.index);
+
+                unsigned p = partition[e.subset];
+                st[sp++] = { p, first_child };
+                st[sp++] = { e.subset ^ p, first_child + 1 };
+            }
+        }
+
+        assert(next_pair == num_inner);
+    }
+};
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_TREELET_H
@@ -41,7 +41,6 @@ __global__ void render(
         )
 {
     using S = typename R::scalar_type;
-    using I = typename simd::int_type<S>::type;
 
     auto x = blockIdx.x * blockDim.x + threadIdx.x;
     auto y = blockIdx.y * blockDim.y + threadIdx.y;
@@ -52,13 +51,15 @@ __global__ void render(
     }
 
     expand_pixel<S> ep;
-    auto seed = make_random_seed(
-        convert_to_int(ep.y(y)) * rt_ref.width() + convert_to_int(ep.x(x)),
-        I(frame_id)
+    auto gen = make_pixel_generator(
+        S{},
+        sample_params,
+        convert_to_int(ep.x(x)),
+        convert_to_int(ep.y(y)),
+        rt_ref.width(),
+        frame_id
         );
 
-    auto gen = make_generator(S{}, sample_params, seed);
-
     sample_pixel(
             kernel,
             sample_params,
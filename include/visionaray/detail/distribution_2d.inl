@@ -0,0 +1,242 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <type_traits>
+
+#include "../math/simd/gather.h"
+#include "../math/simd/type_traits.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Index of the bin [cdf[i]..cdf[i+1]) that contains u, cdf has n + 1 entries.
+// Bins with zero width are never returned for u in [0..1)
+VSNRAY_FUNC
+inline int find_interval(float const* cdf, int n, float u)
+{
+    int first = 0;
+    int count = n;
+
+    // Largest i in [0..n) with cdf[i] <= u
+    while (count > 0)
+    {
+        int step = count / 2;
+        int i = first + step;
+
+        if (cdf[i + 1] <= u)
+        {
+            first = i + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first < n ? first : n - 1;
+}
+
+VSNRAY_FUNC
+inline float fetch(float const* data, int index)
+{
+    return data[index];
+}
+
+template <
+    typename I,
+    typename = typename std::enable_if<simd::is_simd_vector<I>::value>::type
+    >
+inline simd::float_type_t<I> fetch(float const* data, I const& index)
+{
+    return simd::gather(data, index);
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// distribution_2d_ref
+//
+
+VSNRAY_FUNC
+inline distribution_2d_ref::distribution_2d_ref(
+        float const* func,
+        float const* conditional_cdf,
+        float const* marginal_cdf,
+        float        integral,
+        int          width,
+        int          height
+        )
+    : func_(func)
+    , conditional_cdf_(conditional_cdf)
+    , marginal_cdf_(marginal_cdf)
+    , integral_(integral)
+    , width_(width)
+    , height_(height)
+{
+}
+
+VSNRAY_FUNC
+inline vector<2, float> distribution_2d_ref::sample(float u1, float u2, float& pdf) const
+{
+    int y = detail::find_interval(marginal_cdf_, height_, u1);
+
+    float const* cdf = conditional_cdf_ + y * (width_ + 1);
+    int x = detail::find_interval(cdf, width_, u2);
+
+    // Position inside the bins
+    float dy = marginal_cdf_[y + 1] - marginal_cdf_[y];
+    float dx = cdf[x + 1] - cdf[x];
+
+    float oy = dy > 0.0f ? (u1 - marginal_cdf_[y]) / dy : 0.5f;
+    float ox = dx > 0.0f ? (u2 - cdf[x]) / dx : 0.5f;
+
+    pdf = func_[y * width_ + x] / integral_;
+
+    return vector<2, float>(
+            min((x + ox) / width_, 0.99999994f),
+            min((y + oy) / height_, 0.99999994f)
+            );
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T distribution_2d_ref::pdf(vector<2, T> const& uv) const
+{
+    using I = simd::int_type_t<T>;
+
+    I x = convert_to_int(uv.x * T(static_cast<float>(width_)));
+    I y = convert_to_int(uv.y * T(static_cast<float>(height_)));
+
+    x = max(I(0), min(x, I(width_ - 1)));
+    y = max(I(0), min(y, I(height_ - 1)));
+
+    return detail::fetch(func_, y * I(width_) + x) / T(integral_);
+}
+
+VSNRAY_FUNC
+inline int distribution_2d_ref::width() const
+{
+    return width_;
+}
+
+VSNRAY_FUNC
+inline int distribution_2d_ref::height() const
+{
+    return height_;
+}
+
+VSNRAY_FUNC
+inline distribution_2d_ref::operator bool() const
+{
+    return func_ != nullptr;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// distribution_2d
+//
+
+inline distribution_2d::distribution_2d(float const* func, int width, int height)
+{
+    reset(func, width, height);
+}
+
+inline void distribution_2d::reset(float const* func, int width, int height)
+{
+    width_ = width;
+    height_ = height;
+
+    size_t w = static_cast<size_t>(width);
+    size_t h = static_cast<size_t>(height);
+
+    func_.resize(w * h);
+    conditional_cdf_.resize(h * (w + 1));
+    marginal_cdf_.resize(h + 1);
+
+    double total = 0.0;
+
+    for (size_t i = 0; i < w * h; ++i)
+    {
+        func_[i] = func[i] > 0.0f ? func[i] : 0.0f;
+        total += func_[i];
+    }
+
+    // Sample uniformly if the function is zero everywhere
+    if (total <= 0.0)
+    {
+        for (auto& f : func_)
+        {
+            f = 1.0f;
+        }
+
+        total = static_cast<double>(w * h);
+    }
+
+    integral_ = static_cast<float>(total / (w * h));
+
+    // Accumulate in double precision, normalize and force the last entries to 1
+    auto build_cdf = [](float const* f, size_t n, float* cdf)
+    {
+        double sum = 0.0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            sum += f[i];
+        }
+
+        double partial = 0.0;
+        cdf[0] = 0.0f;
+
+        for (size_t i = 1; i <= n; ++i)
+        {
+            partial += f[i - 1];
+            cdf[i] = sum > 0.0 ? static_cast<float>(partial / sum) : static_cast<float>(i) / n;
+        }
+
+        cdf[n] = 1.0f;
+
+        return sum;
+    };
+
+    aligned_vector<float> row_sums(h);
+
+    for (size_t y = 0; y < h; ++y)
+    {
+        row_sums[y] = static_cast<float>(build_cdf(func_.data() + y * w, w, conditional_cdf_.data() + y * (w + 1)));
+    }
+
+    build_cdf(row_sums.data(), h, marginal_cdf_.data());
+}
+
+inline distribution_2d::ref_type distribution_2d::ref() const
+{
+    return ref_type(
+            func_.data(),
+            conditional_cdf_.data(),
+            marginal_cdf_.data(),
+            integral_,
+            width_,
+            height_
+            );
+}
+
+inline int distribution_2d::width() const
+{
+    return width_;
+}
+
+inline int distribution_2d::height() const
+{
+    return height_;
+}
+
+} // visionaray
@@ -1,6 +1,13 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <cstddef>
+#include <vector>
+
+#include "../math/constants.h"
+#include "../sampling.h"
+#include "color_conversion.h"
+
 namespace visionaray
 {
 
@@ -22,6 +29,133 @@ VSNRAY_FUNC vector<3, U> environment_light<T, Texture>::intensity(vector<3, U> c
     return tex2D(texture_, tc).xyz() * vector<3, U>(to_rgb(scale_));
 }
 
+template <typename T, typename Texture>
+template <typename Generator, typename U>
+VSNRAY_FUNC
+inline light_sample<U> environment_light<T, Texture>::sample(Generator& gen) const
+{
+    return sample_from(vector<3, U>(0.0), gen);
+}
+
+template <typename T, typename Texture>
+template <typename Generator, typename U>
+VSNRAY_FUNC
+inline light_sample<U> environment_light<T, Texture>::sample_from(
+        vector<3, U> const& ref_pos,
+        Generator&          gen
+        ) const
+{
+    U u1 = gen.next();
+    U u2 = gen.next();
+
+    vector<3, U> d;
+    U pdf(0.0);
+
+    if (distribution_)
+    {
+        float p = 0.0f;
+        auto uv = distribution_.sample(u1, u2, p);
+
+        // Inverse of the mapping in intensity()
+        U phi = U(uv.x) * constants::two_pi<U>();
+        U theta = U(uv.y) * constants::pi<U>();
+
+        U sin_theta = sin(theta);
+
+        d = vector<3, U>(sin_theta * sin(phi), cos(theta), sin_theta * cos(phi));
+
+        // Change of variables from [0..1)^2 to solid angle
+        pdf = sin_theta > U(0.0) ? U(p) / (U(2.0) * constants::pi<U>() * constants::pi<U>() * sin_theta) : U(0.0);
+    }
+    else
+    {
+        d = uniform_sample_sphere(u1, u2);
+        pdf = U(0.25) * constants::inv_pi<U>();
+    }
+
+    vector<3, U> dir = normalize((matrix<4, 4, U>(light_to_world_transform_) * vector<4, U>(d, U(0.0))).xyz());
+
+    U dist = U(sample_distance());
+
+    light_sample<U> result;
+
+    result.pos = ref_pos + dir * dist;
+    result.normal = -dir;
+    result.delta_light = false;
+
+    // Choose the area so that the density w.r.t. solid angle
+    // dist^2 / (area * cos) as seen from ref_pos equals pdf
+    if (pdf > U(0.0))
+    {
+        result.intensity = intensity(dir);
+        result.area = dist * dist / pdf;
+    }
+    else
+    {
+        result.intensity = vector<3, U>(0.0);
+        result.area = dist * dist;
+    }
+
+    return result;
+}
+
+template <typename T, typename Texture>
+template <typename U>
+VSNRAY_FUNC
+inline U environment_light<T, Texture>::pdf(vector<3, U> const& dir) const
+{
+    if (!distribution_)
+    {
+        return U(0.25) * constants::inv_pi<U>();
+    }
+
+    vector<3, U> d = normalize((matrix<4, 4, U>(world_to_light_transform_) * vector<4, U>(dir, U(0.0))).xyz());
+
+    auto x = atan2(d.x, d.z);
+    x = select(x < U(0.0), x + constants::two_pi<U>(), x);
+    auto y = acos(clamp(d.y, U(-1.0), U(1.0)));
+
+    U sin_theta = sin(y);
+
+    vector<2, U> uv(x / constants::two_pi<U>(), y * constants::inv_pi<U>());
+
+    U p = distribution_.pdf(uv);
+
+    return select(
+            sin_theta > U(0.0),
+            p / (U(2.0) * constants::pi<U>() * constants::pi<U>() * sin_theta),
+            U(0.0)
+            );
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline vector<3, T> environment_light<T, Texture>::position() const
+{
+    return vector<3, T>(0.0);
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline T environment_light<T, Texture>::sample_distance()
+{
+    return T(1e6);
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline void environment_light<T, Texture>::set_distribution(distribution_2d_ref const& distribution)
+{
+    distribution_ = distribution;
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline distribution_2d_ref const& environment_light<T, Texture>::distribution() const
+{
+    return distribution_;
+}
+
 template <typename T, typename Texture>
 VSNRAY_FUNC
 Texture& environment_light<T, Texture>::texture()
@@ -79,4 +213,33 @@ environment_light<T, Texture>::operator bool() const
     return static_cast<bool>(texture_);
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Importance sampling distribution
+//
+
+template <typename Texture>
+inline distribution_2d make_environment_light_distribution(Texture const& tex)
+{
+    int width = static_cast<int>(tex.width());
+    int height = static_cast<int>(tex.height());
+
+    std::vector<float> func(static_cast<size_t>(width) * height);
+
+    for (int y = 0; y < height; ++y)
+    {
+        // Row y covers theta in [y..y+1) * pi / height
+        float sin_theta = std::sin((y + 0.5f) * constants::pi<float>() / height);
+
+        for (int x = 0; x < width; ++x)
+        {
+            size_t index = static_cast<size_t>(y) * width + x;
+            vec4 texel(tex.data()[index]);
+            func[index] = rgb_to_luminance(texel.xyz()) * sin_theta;
+        }
+    }
+
+    return distribution_2d(func.data(), width, height);
+}
+
 } // visionaray
@@ -0,0 +1,635 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "../math/constants.h"
+#include "../math/triangle.h"
+#include "color_conversion.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Light properties used to build the light samplers
+//
+
+template <typename Light>
+inline float light_power(Light const& l)
+{
+    auto pos = l.position();
+    float lum = rgb_to_luminance(vec3(l.intensity(pos)));
+    return std::max(0.0f, lum * static_cast<float>(area(l.geometry())));
+}
+
+template <typename Light>
+inline int light_prim_id(Light const& l)
+{
+    return static_cast<int>(l.geometry().prim_id);
+}
+
+// Bounding cone of the light normals: triangles have a single normal,
+// other geometry emits in all directions
+template <size_t Dim, typename T, typename P>
+inline void light_normal_bounds(basic_triangle<Dim, T, P> const& t, vec3& axis, float& theta_o)
+{
+    vec3 n = cross(vec3(t.e1), vec3(t.e2));
+    float len = length(n);
+
+    if (len > 0.0f)
+    {
+        axis = n / len;
+        theta_o = 0.0f;
+    }
+    else
+    {
+        axis = vec3(0.0f, 0.0f, 1.0f);
+        theta_o = constants::pi<float>();
+    }
+}
+
+template <typename Geometry>
+inline void light_normal_bounds(Geometry const& geom, vec3& axis, float& theta_o)
+{
+    VSNRAY_UNUSED(geom);
+
+    axis = vec3(0.0f, 0.0f, 1.0f);
+    theta_o = constants::pi<float>();
+}
+
+// Light index per primitive id, -1 for primitives that are not lights
+template <typename Lights>
+inline void build_prim_to_light(Lights begin, Lights end, aligned_vector<int>& prim_to_light)
+{
+    int max_prim_id = -1;
+
+    for (auto it = begin; it != end; ++it)
+    {
+        max_prim_id = std::max(max_prim_id, light_prim_id(*it));
+    }
+
+    prim_to_light.assign(static_cast<size_t>(max_prim_id + 1), -1);
+
+    int index = 0;
+    for (auto it = begin; it != end; ++it, ++index)
+    {
+        int prim_id = light_prim_id(*it);
+
+        if (prim_id >= 0)
+        {
+            prim_to_light[prim_id] = index;
+        }
+    }
+}
+
+VSNRAY_FUNC
+inline int lookup_light(int const* prim_to_light, int num_prims, int prim_id)
+{
+    return prim_id >= 0 && prim_id < num_prims ? prim_to_light[prim_id] : -1;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// uniform_light_sampler
+//
+
+template <typename T>
+VSNRAY_FUNC
+inline int uniform_light_sampler::select(
+        int                 num_lights,
+        vector<3, T> const& pos,
+        vector<3, T> const& n,
+        T                   u,
+        T&                  pdf
+        ) const
+{
+    VSNRAY_UNUSED(pos);
+    VSNRAY_UNUSED(n);
+
+    pdf = T(1.0) / T(num_lights);
+
+    int light_id = static_cast<int>(u * T(num_lights));
+    return light_id < num_lights ? light_id : num_lights - 1;
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T uniform_light_sampler::pdf(
+        int                 num_lights,
+        int                 prim_id,
+        vector<3, T> const& pos,
+        vector<3, T> const& n
+        ) const
+{
+    VSNRAY_UNUSED(prim_id);
+    VSNRAY_UNUSED(pos);
+    VSNRAY_UNUSED(n);
+
+    return T(1.0) / T(num_lights);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// power_light_sampler_ref
+//
+
+VSNRAY_FUNC
+inline power_light_sampler_ref::power_light_sampler_ref(
+        detail::alias_table_entry const* table,
+        float const*                     pdfs,
+        int const*                       prim_to_light,
+        int                              num_lights,
+        int                              num_prims
+        )
+    : table_(table)
+    , pdfs_(pdfs)
+    , prim_to_light_(prim_to_light)
+    , num_lights_(num_lights)
+    , num_prims_(num_prims)
+{
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline int power_light_sampler_ref::select(
+        int                 num_lights,
+        vector<3, T> const& pos,
+        vector<3, T> const& n,
+        T                   u,
+        T&                  pdf
+        ) const
+{
+    VSNRAY_UNUSED(num_lights);
+    VSNRAY_UNUSED(pos);
+    VSNRAY_UNUSED(n);
+
+    // Select bin with the integer part of u * num_lights,
+    // reuse the fractional part to decide between bin and alias
+    T x = u * T(num_lights_);
+    int bin = static_cast<int>(x);
+    bin = bin < num_lights_ ? bin : num_lights_ - 1;
+
+    T v = x - T(bin);
+
+    int light_id = v < T(table_[bin].prob) ? bin : table_[bin].alias;
+
+    pdf = T(pdfs_[light_id]);
+    return light_id;
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T power_light_sampler_ref::pdf(
+        int                 num_lights,
+        int                 prim_id,
+        vector<3, T> const& pos,
+        vector<3, T> const& n
+        ) const
+{
+    VSNRAY_UNUSED(num_lights);
+    VSNRAY_UNUSED(pos);
+    VSNRAY_UNUSED(n);
+
+    int light_id = detail::lookup_light(prim_to_light_, num_prims_, prim_id);
+    return light_id >= 0 ? T(pdfs_[light_id]) : T(0.0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// power_light_sampler
+//
+
+template <typename Lights>
+inline power_light_sampler::power_light_sampler(Lights begin, Lights end)
+{
+    reset(begin, end);
+}
+
+template <typename Lights>
+inline void power_light_sampler::reset(Lights begin, Lights end)
+{
+    size_t num_lights = static_cast<size_t>(end - begin);
+
+    pdfs_.resize(num_lights);
+    table_.resize(num_lights);
+
+    detail::build_prim_to_light(begin, end, prim_to_light_);
+
+    if (num_lights == 0)
+    {
+        return;
+    }
+
+    double total = 0.0;
+
+    size_t i = 0;
+    for (auto it = begin; it != end; ++it, ++i)
+    {
+        pdfs_[i] = detail::light_power(*it);
+        total += pdfs_[i];
+    }
+
+    // Fall back to uniform selection if no light emits
+    for (size_t i = 0; i < num_lights; ++i)
+    {
+        pdfs_[i] = total > 0.0 ? static_cast<float>(pdfs_[i] / total) : 1.0f / num_lights;
+    }
+
+
+    // Vose's alias method
+
+    std::vector<double> scaled(num_lights);
+    std::vector<int> small;
+    std::vector<int> large;
+
+    for (size_t i = 0; i < num_lights; ++i)
+    {
+        scaled[i] = static_cast<double>(pdfs_[i]) * num_lights;
+
+        if (scaled[i] < 1.0)
+        {
+            small.push_back(static_cast<int>(i));
+        }
+        else
+        {
+            large.push_back(static_cast<int>(i));
+        }
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        int s = small.back();
+        small.pop_back();
+
+        int l = large.back();
+
+        table_[s].prob = static_cast<float>(scaled[s]);
+        table_[s].alias = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+
+        if (scaled[l] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Remaining bins are full (up to rounding errors)
+    for (int l : large)
+    {
+        table_[l].prob = 1.0f;
+        table_[l].alias = l;
+    }
+
+    for (int s : small)
+    {
+        table_[s].prob = 1.0f;
+        table_[s].alias = s;
+    }
+}
+
+inline power_light_sampler::ref_type power_light_sampler::ref() const
+{
+    return ref_type(
+            table_.data(),
+            pdfs_.data(),
+            prim_to_light_.data(),
+            static_cast<int>(table_.size()),
+            static_cast<int>(prim_to_light_.size())
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// light_bvh_ref
+//
+
+VSNRAY_FUNC
+inline light_bvh_ref::light_bvh_ref(
+        light_bvh_node const* nodes,
+        int const*            light_to_node,
+        int const*            prim_to_light,
+        int                   num_prims
+        )
+    : nodes_(nodes)
+    , light_to_node_(light_to_node)
+    , prim_to_light_(prim_to_light)
+    , num_prims_(num_prims)
+{
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline int light_bvh_ref::select(
+        int                 num_lights,
+        vector<3, T> const& pos,
+        vector<3, T> const& n,
+        T                   u,
+        T&                  pdf
+        ) const
+{
+    VSNRAY_UNUSED(num_lights);
+
+    vec3 p(pos);
+    vec3 nn(n);
+    float uu(u);
+
+    float result_pdf = 1.0f;
+    int index = 0;
+
+    while (!nodes_[index].is_leaf)
+    {
+        int first = nodes_[index].index;
+        float p_first = first_child_prob(nodes_[index], p, nn);
+
+        // Rescale u to [0..1) to reuse it on the next level
+        if (uu < p_first)
+        {
+            uu = min(uu / p_first, 0.99999994f);
+            result_pdf *= p_first;
+            index = first;
+        }
+        else
+        {
+            uu = min((uu - p_first) / (1.0f - p_first), 0.99999994f);
+            result_pdf *= 1.0f - p_first;
+            index = first + 1;
+        }
+    }
+
+    pdf = T(result_pdf);
+    return nodes_[index].index;
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T light_bvh_ref::pdf(
+        int                 num_lights,
+        int                 prim_id,
+        vector<3, T> const& pos,
+        vector<3, T> const& n
+        ) const
+{
+    VSNRAY_UNUSED(num_lights);
+
+    int light_id = detail::lookup_light(prim_to_light_, num_prims_, prim_id);
+
+    if (light_id < 0)
+    {
+        return T(0.0);
+    }
+
+    vec3 p(pos);
+    vec3 nn(n);
+
+    float result_pdf = 1.0f;
+    int index = light_to_node_[light_id];
+
+    while (nodes_[index].parent >= 0)
+    {
+        auto const& parent = nodes_[nodes_[index].parent];
+        float p_first = first_child_prob(parent, p, nn);
+        result_pdf *= index == parent.index ? p_first : 1.0f - p_first;
+        index = nodes_[index].parent;
+    }
+
+    return T(result_pdf);
+}
+
+VSNRAY_FUNC
+inline float light_bvh_ref::first_child_prob(light_bvh_node const& node, vec3 const& pos, vec3 const& n) const
+{
+    auto importance = [&](light_bvh_node const& c)
+    {
+        if (c.power <= 0.0f)
+        {
+            return 0.0f;
+        }
+
+        vec3 center = c.bbox.center();
+        vec3 half_diag = (c.bbox.max - c.bbox.min) * 0.5f;
+
+        vec3 d = center - pos;
+        float dist2 = dot(d, d);
+        float r2 = dot(half_diag, half_diag);
+
+        // Inside the bounds, all directions are possible
+        if (dist2 <= r2)
+        {
+            return c.power / max(r2, FLT_MIN);
+        }
+
+        float dist = sqrt(dist2);
+        vec3 wi = d / dist;
+
+        // Angle subtended by the bounding sphere
+        float theta_u = asin(min(sqrt(r2 / dist2), 1.0f));
+
+        // Receiver cosine bound, the normal is ignored at volumetric or degenerate points
+        float cos_r = 1.0f;
+        if (dot(n, n) > 0.0f)
+        {
+            float theta_r = acos(clamp(dot(n, wi), -1.0f, 1.0f));
+            float theta = max(0.0f, theta_r - theta_u);
+            cos_r = theta < constants::pi_over_two<float>() ? cos(theta) : 0.0f;
+        }
+
+        // Emitter cosine bound, two-sided
+        float theta_e = acos(clamp(dot(c.axis, -wi), -1.0f, 1.0f));
+        theta_e = min(theta_e, constants::pi<float>() - theta_e);
+        float theta = max(0.0f, theta_e - c.theta_o - theta_u);
+        float cos_e = theta < constants::pi_over_two<float>() ? cos(theta) : 0.0f;
+
+        return c.power * cos_r * cos_e / dist2;
+    };
+
+    float i1 = importance(nodes_[node.index]);
+    float i2 = importance(nodes_[node.index + 1]);
+
+    return i1 + i2 > 0.0f ? i1 / (i1 + i2) : 0.5f;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// light_bvh
+//
+
+template <typename Lights>
+inline light_bvh::light_bvh(Lights begin, Lights end)
+{
+    reset(begin, end);
+}
+
+template <typename Lights>
+inline void light_bvh::reset(Lights begin, Lights end)
+{
+    size_t num_lights = static_cast<size_t>(end - begin);
+
+    nodes_.clear();
+    light_to_node_.resize(num_lights);
+
+    detail::build_prim_to_light(begin, end, prim_to_light_);
+
+    if (num_lights == 0)
+    {
+        return;
+    }
+
+    std::vector<build_light> lights(num_lights);
+
+    size_t i = 0;
+    for (auto it = begin; it != end; ++it, ++i)
+    {
+        auto& bl = lights[i];
+        bl.bbox = aabb(get_bounds(it->geometry()));
+        bl.centroid = bl.bbox.center();
+        detail::light_normal_bounds(it->geometry(), bl.axis, bl.theta_o);
+        bl.power = detail::light_power(*it);
+        bl.index = static_cast<int>(i);
+    }
+
+    // Binary tree with one light per leaf
+    nodes_.resize(2 * num_lights - 1);
+
+    int next = 1;
+    build_node(0, -1, lights.data(), lights.data() + num_lights, next);
+
+    assert(next == static_cast<int>(nodes_.size()));
+}
+
+inline light_bvh::ref_type light_bvh::ref() const
+{
+    return ref_type(
+            nodes_.data(),
+            light_to_node_.data(),
+            prim_to_light_.data(),
+            static_cast<int>(prim_to_light_.size())
+            );
+}
+
+inline aligned_vector<light_bvh_node> const& light_bvh::nodes() const
+{
+    return nodes_;
+}
+
+inline void light_bvh::build_node(
+        int          node_index,
+        int          parent,
+        build_light* first,
+        build_light* last,
+        int&         next
+        )
+{
+    auto& node = nodes_[node_index];
+    node.parent = parent;
+
+    if (last - first == 1)
+    {
+        node.bbox = first->bbox;
+        node.axis = first->axis;
+        node.theta_o = first->theta_o;
+        node.power = first->power;
+        node.index = first->index;
+        node.is_leaf = 1;
+
+        light_to_node_[first->index] = node_index;
+        return;
+    }
+
+    // Median split along the largest extent of the centroids
+    aabb centroid_bounds;
+    centroid_bounds.invalidate();
+
+    for (auto it = first; it != last; ++it)
+    {
+        centroid_bounds.insert(it->centroid);
+    }
+
+    vec3 size = centroid_bounds.max - centroid_bounds.min;
+    int axis = size.x >= size.y && size.x >= size.z ? 0 : size.y >= size.z ? 1 : 2;
+
+    auto middle = first + (last - first) / 2;
+
+    std::nth_element(
+            first,
+            middle,
+            last,
+            [axis](build_light const& a, build_light const& b)
+            {
+                return a.centroid[axis] < b.centroid[axis];
+            }
+            );
+
+    int child = next;
+    next += 2;
+
+    node.index = child;
+    node.is_leaf = 0;
+
+    build_node(child,     node_index, first,  middle, next);
+    build_node(child + 1, node_index, middle, last,   next);
+
+    // nodes_ is not resized during the build, references stay valid
+    auto const& c1 = nodes_[child];
+    auto const& c2 = nodes_[child + 1];
+
+    node.bbox = combine(c1.bbox, c2.bbox);
+    node.power = c1.power + c2.power;
+
+
+    // Merge normal bounds, lights are two-sided, so the axes may be flipped
+
+    vec3 axis1 = c1.axis;
+    vec3 axis2 = dot(c1.axis, c2.axis) < 0.0f ? -c2.axis : c2.axis;
+
+    float theta_d = std::acos(clamp(dot(axis1, axis2), -1.0f, 1.0f));
+
+    if (std::min(theta_d + c2.theta_o, constants::pi<float>()) <= c1.theta_o)
+    {
+        // Cone 1 contains cone 2
+        node.axis = axis1;
+        node.theta_o = c1.theta_o;
+    }
+    else if (std::min(theta_d + c1.theta_o, constants::pi<float>()) <= c2.theta_o)
+    {
+        // Cone 2 contains cone 1
+        node.axis = axis2;
+        node.theta_o = c2.theta_o;
+    }
+    else
+    {
+        float theta_o = (c1.theta_o + theta_d + c2.theta_o) * 0.5f;
+
+        if (theta_o >= constants::pi<float>())
+        {
+            node.axis = axis1;
+            node.theta_o = constants::pi<float>();
+        }
+        else
+        {
+            // Rotate axis1 towards axis2 by the angle between axis1 and the new axis
+            float theta_r = theta_o - c1.theta_o;
+            vec3 w = axis2 - axis1 * dot(axis1, axis2);
+            float len = length(w);
+
+            node.axis = len > 0.0f
+                ? axis1 * std::cos(theta_r) + (w / len) * std::sin(theta_r)
+                : axis1
+                ;
+            node.theta_o = theta_o;
+        }
+    }
+}
+
+} // visionaray
@@ -0,0 +1,162 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_LOW_DISCREPANCY_H
+#define VSNRAY_DETAIL_LOW_DISCREPANCY_H 1
+
+#include "../math/simd/type_traits.h"
+#include "../array.h"
+#include "macros.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Helpers for low-discrepancy generators
+//
+// Scrambling uses hash-based permutations after B. Burley: Practical Hash-based Owen
+// Scrambling (JCGT 2020)
+//
+
+// 32-bit integer hash (C. Wellons' lowbias32)
+VSNRAY_FUNC
+inline unsigned ld_hash(unsigned x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+VSNRAY_FUNC
+inline unsigned ld_hash_combine(unsigned seed, unsigned v)
+{
+    return seed ^ (v + (seed << 6) + (seed >> 2));
+}
+
+VSNRAY_FUNC
+inline unsigned reverse_bits(unsigned x)
+{
+#if VSNRAY_GPU_MODE
+    return __brev(x);
+#else
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+#endif
+}
+
+// Permutation where each bit only depends on less significant bits
+VSNRAY_FUNC
+inline unsigned laine_karras_permutation(unsigned x, unsigned seed)
+{
+    x += seed;
+    x ^= x * 0x6C50B47Cu;
+    x ^= x * 0xB82F1E52u;
+    x ^= x * 0xC7AFE638u;
+    x ^= x * 0x8D22F6E6u;
+    return x;
+}
+
+// Owen scrambling of a 32-bit fixed point number in [0..1)
+VSNRAY_FUNC
+inline unsigned nested_uniform_scramble(unsigned x, unsigned seed)
+{
+    x = reverse_bits(x);
+    x = laine_karras_permutation(x, seed);
+    x = reverse_bits(x);
+    return x;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// SIMD low-discrepancy generator, steps one scalar generator per lane
+//
+// The scalar generators (ScalarGen) are constructed from a seed, the pixel position and
+// the index of the first sample, their next_uint() returns 32-bit fixed point numbers.
+//
+
+template <typename T, typename ScalarGen>
+class simd_low_discrepancy_generator
+{
+public:
+
+    using value_type = T;
+    using int_type = simd::int_type_t<T>;
+
+    enum { Size = simd::num_elements<T>::value };
+
+public:
+
+    // Scalar generator that steps a single lane
+    typedef ScalarGen generator_type;
+
+    simd_low_discrepancy_generator() = default;
+
+    VSNRAY_FUNC simd_low_discrepancy_generator(
+            array<unsigned, Size> const& seed,
+            int_type const&              x,
+            int_type const&              y,
+            unsigned                     first_sample = 0
+            )
+    {
+        simd::aligned_array_t<int_type> xs;
+        simd::aligned_array_t<int_type> ys;
+
+        simd::store(xs, x);
+        simd::store(ys, y);
+
+        for (int i = 0; i < Size; ++i)
+        {
+            generators_[i] = generator_type(seed[i], xs[i], ys[i], first_sample);
+        }
+    }
+
+    VSNRAY_FUNC void begin_sample(unsigned sample)
+    {
+        for (int i = 0; i < Size; ++i)
+        {
+            generators_[i].begin_sample(sample);
+        }
+    }
+
+    VSNRAY_FUNC value_type next()
+    {
+        return convert_to_float((next_uint() >> 8) & int_type(0x00FFFFFF)) * value_type(1.0f / 16777216.0f);
+    }
+
+    VSNRAY_FUNC int_type next_uint()
+    {
+        simd::aligned_array_t<int_type> values;
+
+        for (int i = 0; i < Size; ++i)
+        {
+            values[i] = static_cast<int>(generators_[i].next_uint());
+        }
+
+        return int_type(values);
+    }
+
+    VSNRAY_FUNC generator_type& get_generator(unsigned i)
+    {
+        return generators_[i];
+    }
+
+private:
+
+    array<generator_type, Size> generators_;
+
+};
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_LOW_DISCREPANCY_H
@@ -9,23 +9,206 @@
 #include <visionaray/config.h>
 
 #include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <iterator>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #if VSNRAY_HAVE_TBB
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_reduce.h>
 #endif
 
+#include "../math/detail/math.h"
 #include "algorithm.h"
 #include "macros.h"
+#include "parallel_for.h"
+#include "range.h"
 
 namespace visionaray
 {
 namespace paralgo
 {
 
+//-------------------------------------------------------------------------------------------------
+// counting_sort
+//
+// Stable counting sort that distributes the work over a thread pool.
+// Sorts items based on integer keys in [0..k).
+//
+// [in] POOL
+//      Thread pool to run the counting and scattering passes on.
+//
+// [in] FIRST
+//      Start of the input sequence.
+//
+// [in] LAST
+//      End of the input sequence.
+//
+// [out] OUT
+//      Start of the output sequence.
+//
+// [in,out] COUNTS
+//      Modifiable counts sequence of size k. On exit, contains the
+//      start offset of each key in the output sequence.
+//
+// [in] KEY
+//      Sort key function object.
+//
+// Complexity: O(n/p + k*p) with p tiles
+//
+
+template <
+    typename Pool,
+    typename InputIt,
+    typename OutputIt,
+    typename Counts,
+    typename Key = visionaray::algo::detail::trivial_key
+    >
+void counting_sort(Pool& pool, InputIt first, InputIt last, OutputIt out, Counts& counts, Key key = Key())
+{
+    static_assert(
+            std::is_integral<decltype(key(*first))>::value,
+            "counting_sort requires integral key type"
+            );
+
+    static const size_t TileSize = 16384;
+
+    size_t len = last - first;
+    size_t k = counts.size();
+    size_t num_tiles = div_up(len, TileSize);
+
+    // Histogram for each tile
+
+    std::vector<size_t> tile_counts(num_tiles * k);
+
+    parallel_for(
+        pool,
+        tiled_range1d<size_t>(0, len, TileSize),
+        [&](range1d<size_t> const& r)
+        {
+            size_t* cnt = tile_counts.data() + (r.begin() / TileSize) * k;
+
+            for (size_t i = r.begin(); i != r.end(); ++i)
+            {
+                ++cnt[key(first[i])];
+            }
+        });
+
+    // Exclusive prefix sum in (key, tile) order yields the output offset of each
+    // (tile, key) pair. Tiles with lower indices come first, so the sort is stable
+
+    size_t offset = 0;
+
+    for (size_t m = 0; m < k; ++m)
+    {
+        counts[m] = static_cast<typename std::decay<decltype(counts[m])>::type>(offset);
+
+        for (size_t t = 0; t < num_tiles; ++t)
+        {
+            size_t c = tile_counts[t * k + m];
+            tile_counts[t * k + m] = offset;
+            offset += c;
+        }
+    }
+
+    // Scatter
+
+    parallel_for(
+        pool,
+        tiled_range1d<size_t>(0, len, TileSize),
+        [&](range1d<size_t> const& r)
+        {
+            size_t* offsets = tile_counts.data() + (r.begin() / TileSize) * k;
+
+            for (size_t i = r.begin(); i != r.end(); ++i)
+            {
+                out[offsets[key(first[i])]++] = first[i];
+            }
+        });
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// radix_sort
+//
+// Stable LSD radix sort based on paralgo::counting_sort. Sorts items based
+// on the NUM_BITS least significant bits of their unsigned integer keys.
+//
+// [in] POOL
+//      Thread pool to run the counting sort passes on.
+//
+// [in,out] FIRST
+//      Start of the sequence to be sorted.
+//
+// [in,out] LAST
+//      End of the sequence to be sorted.
+//
+// [in,out] TEMP
+//      Start of temporary storage for LAST-FIRST elements.
+//
+// [in] NUM_BITS
+//      Number of key bits to consider, must be <= 32.
+//
+// [in] KEY
+//      Sort key function object.
+//
+// Complexity: O(b/8 * (n/p + 256*p)) with p tiles and b bits
+//
+
+template <
+    typename Pool,
+    typename RandIt,
+    typename TempIt,
+    typename Key = visionaray::algo::detail::trivial_key
+    >
+void radix_sort(Pool& pool, RandIt first, RandIt last, TempIt temp, unsigned num_bits, Key key = Key())
+{
+    static const unsigned BitsPerPass = 8;
+    static const unsigned Radix = 1 << BitsPerPass;
+
+    std::vector<unsigned> counts(Radix);
+
+    auto temp_last = temp + (last - first);
+
+    bool swapped = false;
+
+    for (unsigned shift = 0; shift < num_bits; shift += BitsPerPass)
+    {
+        auto digit = [&](typename std::iterator_traits<RandIt>::value_type const& item)
+        {
+            return static_cast<unsigned>((key(item) >> shift) & (Radix - 1));
+        };
+
+        if (!swapped)
+        {
+            counting_sort(pool, first, last, temp, counts, digit);
+        }
+        else
+        {
+            counting_sort(pool, temp, temp_last, first, counts, digit);
+        }
+
+        swapped = !swapped;
+    }
+
+    // Result resides in temporary storage after an odd number of passes
+    if (swapped)
+    {
+        size_t len = last - first;
+
+        parallel_for(
+            pool,
+            tiled_range1d<size_t>(0, len, 16384),
+            [&](range1d<size_t> const& r)
+            {
+                std::copy(temp + r.begin(), temp + r.end(), first + r.begin());
+            });
+    }
+}
+
 #if VSNRAY_HAVE_TBB
 
 //-------------------------------------------------------------------------------------------------
@@ -4,6 +4,8 @@
 #include <visionaray/math/vector.h>
 #include <visionaray/get_area.h>
 #include <visionaray/get_surface.h>
+#include <visionaray/light_sample.h>
+#include <visionaray/light_sampler.h>
 #include <visionaray/result_record.h>
 #include <visionaray/sampling.h>
 #include <visionaray/spectrum.h>
@@ -14,6 +16,27 @@ namespace visionaray
 {
 namespace pathtracing
 {
+namespace detail
+{
+
+// Density of light samples in direction dir for environment lights that support
+// sampling, 0 otherwise
+template <typename Light, typename T>
+VSNRAY_FUNC
+inline auto environment_pdf(Light const& light, vector<3, T> const& dir, int)
+    -> decltype(light.pdf(dir))
+{
+    return light.pdf(dir);
+}
+
+template <typename Light, typename T>
+VSNRAY_FUNC
+inline T environment_pdf(Light const& /* */, vector<3, T> const& /* */, long)
+{
+    return T(0.0);
+}
+
+} // detail
 
 template <typename Params>
 struct kernel
@@ -21,6 +44,115 @@ struct kernel
 
     Params params;
 
+    // Next event estimation: contribution of light sample ls, whose light was selected
+    // with probability select_pdf, to the shading point that ray hit, provided that the
+    // light sample is visible. The shadow ray that tests for visibility is returned in
+    // shadow_ray, it has the same time sample as ray. MIS weights are computed with the
+    // power heuristic
+    template <
+        typename R,
+        typename Surface,
+        typename I,
+        typename S = typename R::scalar_type
+        >
+    VSNRAY_FUNC spectrum<S> unoccluded_light_contribution(
+            R const&                    ray,
+            Surface&                    surf,
+            I const&                    inter,
+            vector<3, S> const&         isect_pos,
+            vector<3, S> const&         n,
+            vector<3, S> const&         view_dir,
+            spectrum<S> const&          throughput,
+            light_sample<S> const&      ls,
+            S const&                    select_pdf,
+            R&                          shadow_ray
+            ) const
+    {
+        using C = spectrum<S>;
+
+        auto ld = length(ls.pos - isect_pos);
+        auto L = normalize(ls.pos - isect_pos);
+
+        auto ln = select(ls.delta_light, -L, ls.normal);
+#if 1
+        ln = faceforward( ln, -L, ln );
+#endif
+        auto ldotn = dot(L, n);
+        auto ldotln = abs(dot(-L, ln));
+
+        // The origin is offset by epsilon, so stop 2 * epsilon short of
+        // the light sample to not intersect emissive geometry itself
+        shadow_ray = R(
+            isect_pos + L * S(params.epsilon),  // origin
+            L,                                  // direction
+            S(params.epsilon),                  // tmin
+            ld - S(2.0f * params.epsilon)       // tmax
+            );
+        copy_ray_time(shadow_ray, ray);
+
+        auto brdf_pdf = surf.pdf(view_dir, L, inter);
+        auto prob = max_element(throughput.samples());
+        brdf_pdf *= prob;
+
+        // TODO: inv_pi / dot(n, wi) factor only valid for plastic and matte
+        auto src = surf.shade(view_dir, L, ls.intensity) * constants::inv_pi<S>() / ldotn;
+        auto solid_angle = (ldotln * ls.area);
+        solid_angle = select(!ls.delta_light, solid_angle / (ld * ld), solid_angle);
+        auto light_pdf = S(1.0) / solid_angle;
+
+        S mis_weight = power_heuristic(light_pdf * select_pdf, brdf_pdf);
+
+        return select(
+            ldotn > S(0.0) && ldotln > S(0.0) && select_pdf > S(0.0),
+            mis_weight * throughput * src * (ldotn / (light_pdf * select_pdf)),
+            C(0.0)
+            );
+    }
+
+    // Next event estimation: contribution of light sample ls, whose light was selected
+    // with probability select_pdf, to the shading point that ray hit
+    template <
+        typename R,
+        typename Intersector,
+        typename Surface,
+        typename I,
+        typename S = typename R::scalar_type
+        >
+    VSNRAY_FUNC spectrum<S> light_contribution(
+            Intersector&                isect,
+            R const&                    ray,
+            Surface&                    surf,
+            I const&                    inter,
+            vector<3, S> const&         isect_pos,
+            vector<3, S> const&         n,
+            vector<3, S> const&         view_dir,
+            spectrum<S> const&          throughput,
+            light_sample<S> const&      ls,
+            S const&                    select_pdf
+            ) const
+    {
+        using C = spectrum<S>;
+
+        R shadow_ray;
+
+        auto contribution = unoccluded_light_contribution<R>(
+                ray,
+                surf,
+                inter,
+                isect_pos,
+                n,
+                view_dir,
+                throughput,
+                ls,
+                select_pdf,
+                shadow_ray
+                );
+
+        auto lhr = any_hit(shadow_ray, params.prims.begin, params.prims.end, isect);
+
+        return select(!lhr.hit, contribution, C(0.0));
+    }
+
     template <typename Intersector, typename R, typename Generator>
     VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
             Intersector& isect,
@@ -33,9 +165,20 @@ struct kernel
         using V = vector<3, S>;
         using C = spectrum<S>;
 
+        // Environment lights that support sampling take part in next event estimation
+        using amb_light_type = decltype(params.amb_light);
+        constexpr bool sample_environment
+                = visionaray::detail::has_sample<amb_light_type, Generator>::value;
+
         simd::mask_type_t<S> active_rays = true;
         simd::mask_type_t<S> last_specular = true;
 
+        // Position, shading normal and BRDF sampling pdf of the previous vertex,
+        // the MIS weights for hit lights must be evaluated there
+        V last_pos(0.0);
+        V last_n(0.0);
+        S last_brdf_pdf(0.0);
+
         C intensity(0.0);
         C throughput(1.0);
 
@@ -50,9 +193,21 @@ struct kernel
             auto exited = active_rays & !hit_rec.hit;
 
             auto env = params.amb_light.intensity(ray.dir);
+
+            S env_weight(1.0);
+
+            if (sample_environment)
+            {
+                env_weight = select(
+                    bounce > 0 && !last_specular,
+                    power_heuristic(last_brdf_pdf, detail::environment_pdf(params.amb_light, ray.dir, 0)),
+                    S(1.0)
+                    );
+            }
+
             intensity += select(
                 exited,
-                from_rgb(env) * throughput,
+                env_weight * from_rgb(env) * throughput,
                 C(0.0)
                 );
 
@@ -93,27 +248,37 @@ struct kernel
             auto zero_pdf = brdf_pdf <= S(0.0);
 
             S light_pdf(0.0);
-            auto num_lights = params.lights.end - params.lights.begin;
+            auto num_lights = static_cast<int>(params.lights.end - params.lights.begin);
 
             if (num_lights > 0 && any(inter == surface_interaction::Emission))
             {
-                auto A = get_area(params.prims.begin, hit_rec);
+                auto A = get_area(params.prims.begin, hit_rec, isect);
                 auto ld = length(hit_rec.isect_pos - ray.ori);
                 auto L = normalize(hit_rec.isect_pos - ray.ori);
                 auto n = surf.geometric_normal;
                 auto ldotln = abs(dot(-L, n));
                 auto solid_angle = (ldotln * A) / (ld * ld);
 
+                // Probability that next event estimation at the previous vertex
+                // would have selected the light that was hit
+                auto select_pdf = light_select_pdf(
+                        params.light_sampler,
+                        num_lights,
+                        hit_rec.prim_id,
+                        last_pos,
+                        last_n
+                        );
+
                 light_pdf = select(
                     inter == surface_interaction::Emission,
-                    S(1.0) / solid_angle,
+                    select_pdf / solid_angle,
                     S(0.0)
                     );
             }
 
             S mis_weight = select(
                 bounce > 0 && num_lights > 0 && !last_specular,
-                power_heuristic(brdf_pdf, light_pdf / static_cast<float>(num_lights)),
+                power_heuristic(last_brdf_pdf, light_pdf),
                 S(1.0)
                 );
 
@@ -133,46 +298,47 @@ struct kernel
 
             if (num_lights > 0)
             {
-                auto ls = sample_random_light(params.lights.begin, params.lights.end, gen);
-
-                auto ld = length(ls.pos - hit_rec.isect_pos);
-                auto L = normalize(ls.pos - hit_rec.isect_pos);
+                S select_pdf(0.0);
+                auto ls = sample_light(
+                        params.lights.begin,
+                        params.lights.end,
+                        params.light_sampler,
+                        hit_rec.isect_pos,
+                        n,
+                        select_pdf,
+                        gen
+                        );
 
-                auto ln = select(ls.delta_light, -L, ls.normal);
-#if 1
-                ln = faceforward( ln, -L, ln );
-#endif
-                auto ldotn = dot(L, n);
-                auto ldotln = abs(dot(-L, ln));
-
-                R shadow_ray(
-                    hit_rec.isect_pos + L * S(params.epsilon), // origin
-                    L,                                         // direction
-                    S(params.epsilon),                         // tmin
-                    ld - S(params.epsilon)                     // tmax
+                intensity += select(
+                    active_rays,
+                    light_contribution<R>(isect, ray, surf, inter, hit_rec.isect_pos, n, view_dir, throughput, ls, select_pdf),
+                    C(0.0)
                     );
+            }
 
-                auto lhr = any_hit(shadow_ray, params.prims.begin, params.prims.end, isect);
-
-                auto brdf_pdf = surf.pdf(view_dir, L, inter);
-                auto prob = max_element(throughput.samples());
-                brdf_pdf *= prob;
-
-                // TODO: inv_pi / dot(n, wi) factor only valid for plastic and matte
-                auto src = surf.shade(view_dir, L, ls.intensity) * constants::inv_pi<S>() / ldotn;
-                auto solid_angle = (ldotln * ls.area);
-                solid_angle = select(!ls.delta_light, solid_angle / (ld * ld), solid_angle);
-                auto light_pdf = S(1.0) / solid_angle;
-
-                S mis_weight = power_heuristic(light_pdf / static_cast<float>(num_lights), brdf_pdf);
+            if (sample_environment)
+            {
+                S select_pdf(0.0);
+                auto ls = sample_light(
+                        &params.amb_light,
+                        &params.amb_light + 1,
+                        uniform_light_sampler{},
+                        hit_rec.isect_pos,
+                        n,
+                        select_pdf,
+                        gen
+                        );
 
                 intensity += select(
-                    active_rays && !lhr.hit && ldotn > S(0.0) && ldotln > S(0.0),
-                    mis_weight * throughput * src * (ldotn / light_pdf) * S(static_cast<float>(num_lights)),
+                    active_rays,
+                    light_contribution<R>(isect, ray, surf, inter, hit_rec.isect_pos, n, view_dir, throughput, ls, select_pdf),
                     C(0.0)
                     );
             }
 
+            // Same pdf that next event estimation uses in its MIS weight
+            last_brdf_pdf = brdf_pdf * max_element(throughput.samples());
+
             throughput *= src * (dot(n, refl_dir) / brdf_pdf);
             throughput = select(zero_pdf, C(0.0), throughput);
 
@@ -193,6 +359,9 @@ struct kernel
             ray.ori = hit_rec.isect_pos + refl_dir * S(params.epsilon);
             ray.dir = refl_dir;
 
+            last_pos = hit_rec.isect_pos;
+            last_n = n;
+
             last_specular = inter == surface_interaction::SpecularReflection ||
                             inter == surface_interaction::SpecularTransmission;
 
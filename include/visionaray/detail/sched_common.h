@@ -10,6 +10,7 @@
 
 #include <visionaray/math/forward.h>
 #include <visionaray/math/matrix.h>
+#include <visionaray/math/ray.h>
 #include <visionaray/math/vector.h>
 #include <visionaray/packet_traits.h>
 #include <visionaray/matrix_camera.h>
@@ -91,6 +92,29 @@ inline auto invoke_kernel(K kernel, R r, Generator& gen, int x, int y)
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Sample the time of a primary ray
+//
+// Motion rays get a time uniformly distributed over the shutter interval, other rays
+// are left untouched
+//
+
+template <typename R, typename Generator>
+VSNRAY_FUNC
+inline void sample_time(R& r, Generator& gen)
+{
+    VSNRAY_UNUSED(r);
+    VSNRAY_UNUSED(gen);
+}
+
+template <typename T, typename Generator>
+VSNRAY_FUNC
+inline void sample_time(basic_motion_ray<T>& r, Generator& gen)
+{
+    r.time = gen.next();
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Invoke cam::primary_ray()
 //
@@ -111,9 +135,9 @@ inline auto invoke_cam_primary_ray(
         )
     -> decltype(cam.primary_ray(R{}, x, y, width, height))
 {
-    VSNRAY_UNUSED(gen);
-
-    return cam.primary_ray(R{}, x, y, width, height);
+    auto r = cam.primary_ray(R{}, x, y, width, height);
+    sample_time(r, gen);
+    return r;
 }
 
 template <typename R, typename Camera, typename Generator, typename T, typename = void>
@@ -129,7 +153,33 @@ inline auto invoke_cam_primary_ray(
         )
     -> decltype(cam.primary_ray(R{}, gen, x, y, width, height))
 {
-    return cam.primary_ray(R{}, gen, x, y, width, height);
+    auto r = cam.primary_ray(R{}, gen, x, y, width, height);
+    sample_time(r, gen);
+    return r;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Invoke gen.begin_sample()
+//
+// Generators that are indexed by sample number (e.g. low-discrepancy generators) are
+// notified when a new pixel sample starts, other generators are left untouched
+//
+
+template <typename Generator>
+VSNRAY_FUNC
+inline auto invoke_begin_sample(Generator& gen, unsigned sample, int /* prefer */)
+    -> decltype(gen.begin_sample(sample))
+{
+    gen.begin_sample(sample);
+}
+
+template <typename Generator>
+VSNRAY_FUNC
+inline void invoke_begin_sample(Generator& gen, unsigned sample, long /* */)
+{
+    VSNRAY_UNUSED(gen);
+    VSNRAY_UNUSED(sample);
 }
 
 
@@ -351,6 +401,8 @@ inline void sample_pixel_impl(
 //-------------------------------------------------------------------------------------------------
 // Jittered pixel sampler, result is blended on top of color buffer
 //
+// Also used for the low-discrepancy samplers, which derive from basic_jittered_blend_type
+//
 
 template <
     typename K,
@@ -381,6 +433,8 @@ inline void sample_pixel_impl(
 
     for (unsigned s = 0; s < ps.spp; ++s)
     {
+        invoke_begin_sample(gen, s, 0);
+
         auto r = make_primary_ray(
                 R{},
                 ps,
@@ -461,10 +515,12 @@ inline void sample_pixel_choose_intersector_impl(
         Args&&...               args
         )
 {
-    auto caller = [&kernel, &isect](Args&&...args)
-        -> decltype(kernel(isect, std::forward<Args>(args)...))
+    // Called by invoke_kernel() with the kernel arguments (ray, generator, ...), not
+    // with the arguments of this function
+    auto caller = [&kernel, &isect](auto&&... kargs)
+        -> decltype(kernel(isect, std::forward<decltype(kargs)>(kargs)...))
     {
-        return kernel(isect, std::forward<Args>(args)...);
+        return kernel(isect, std::forward<decltype(kargs)>(kargs)...);
     };
 
     detail::sample_pixel_impl(
@@ -19,7 +19,6 @@ template <typename K, typename SP>
 void simple_sched<R>::frame(K kernel, SP sched_params)
 {
     using S = typename R::scalar_type;
-    using I = typename simd::int_type<S>::type;
 
     sched_params.cam.begin_frame();
 
@@ -38,13 +37,15 @@ void simple_sched<R>::frame(K kernel, SP sched_params)
             }
 
             expand_pixel<S> ep;
-            auto seed = make_random_seed(
-                convert_to_int(ep.y(y)) * sched_params.rt.width() + convert_to_int(ep.x(x)),
-                I(frame_id_)
+            auto gen = make_pixel_generator(
+                S{},
+                typename SP::pixel_sampler_type{},
+                convert_to_int(ep.x(x)),
+                convert_to_int(ep.y(y)),
+                sched_params.rt.width(),
+                frame_id_
                 );
 
-            auto gen = make_generator(S{}, typename SP::pixel_sampler_type{}, seed);
-
             sample_pixel(
                     kernel,
                     typename SP::pixel_sampler_type{},
@@ -6,21 +6,32 @@
 #ifndef VSNRAY_DETAIL_THREAD_POOL_H
 #define VSNRAY_DETAIL_THREAD_POOL_H 1
 
+#include <algorithm>
 #include <atomic>
-#include <cassert>
 #include <condition_variable>
-#include <functional>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
 
-#include "semaphore.h"
-
 namespace visionaray
 {
 
+class task_group;
+
 //-------------------------------------------------------------------------------------------------
-// Thread pool
+// Work-stealing thread pool
+//
+// Each worker thread owns a task queue. Workers push tasks to the back of their own queue
+// and pop from there (LIFO), idle workers steal from the front of other workers' queues
+// (FIFO), so that thieves take the oldest and thus (with recursive splitting) largest
+// pieces of work. Threads that are not part of the pool submit to an additional, shared
+// queue.
+//
+// Threads that wait for work to complete (in run() or task_group::wait()) execute
+// pending tasks in the meantime, so run() and task groups may be used recursively from
+// within tasks. Workers without work spin for a short while and then go to sleep until
+// new tasks are submitted.
 //
 
 class thread_pool
@@ -29,8 +40,6 @@ public:
 
     explicit thread_pool(unsigned num_threads)
     {
-        sync_params.start_threads = false;
-        sync_params.join_threads = false;
         reset(num_threads);
     }
 
@@ -44,11 +53,12 @@ public:
         join_threads();
 
         threads.reset(new std::thread[num_threads]);
+        queues_.reset(new work_queue[num_threads + 1]);
         this->num_threads = num_threads;
 
         for (unsigned i = 0; i < num_threads; ++i)
         {
-            threads[i] = std::thread([this](){ thread_loop(); });
+            threads[i] = std::thread([this, i](){ thread_loop(i); });
         }
     }
 
@@ -59,9 +69,12 @@ public:
             return;
         }
 
-        sync_params.start_threads = true;
-        sync_params.join_threads = true;
-        sync_params.threads_start.notify_all();
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+
+        wakeup_.notify_all();
 
         for (unsigned i = 0; i < num_threads; ++i)
         {
@@ -71,31 +84,29 @@ public:
             }
         }
 
-        sync_params.start_threads = false;
-        sync_params.join_threads = false;
+        stop_ = false;
         threads.reset(nullptr);
+        num_threads = 0;
     }
 
+    // Call f(work_item) for all work items in [0..queue_length), return when done.
+    // The range is recursively split in halves, the calling thread participates
     template <typename Func>
     void run(Func f, long queue_length)
     {
-        // Set worker function
-        func = f;
+        if (queue_length <= 0)
+        {
+            return;
+        }
 
-        // Set counters
-        sync_params.num_work_items = queue_length;
-        sync_params.work_item_counter = 0;
-        sync_params.work_items_finished_counter = 0;
+        // Split into about 16 pieces per thread
+        long grain = std::max(queue_length / (16 * static_cast<long>(num_threads + 1)), 1L);
 
-        // Activate persistent threads
-        sync_params.start_threads = true;
-        sync_params.threads_start.notify_all();
+        loop_data<Func> data{ f, grain, { queue_length } };
 
-        // Wait for all threads to finish
-        sync_params.threads_ready.wait();
+        push({ &execute_loop<Func>, &data, 0, queue_length });
 
-        // Idle w/o work
-        sync_params.start_threads = false;
+        wait_until([&]() { return data.remaining.load() == 0; });
     }
 
     std::unique_ptr<std::thread[]> threads;
@@ -103,70 +114,292 @@ public:
 
 private:
 
-    using func_t = std::function<void(unsigned)>;
-    func_t func;
+    friend class task_group;
+
+    // Tasks are plain function pointers plus data so that they can be
+    // stored in the queues without allocations for the common case
+    struct task
+    {
+        void (*execute)(thread_pool& pool, task const& t);
+        void* data;
+        long first;
+        long last;
+    };
+
+    struct work_queue
+    {
+        std::mutex       mutex;
+        std::deque<task> tasks;
+    };
+
+    template <typename Func>
+    struct loop_data
+    {
+        Func              func;
+        long              grain;
+        std::atomic<long> remaining;
+    };
+
+    struct worker_info
+    {
+        thread_pool const* pool;
+        unsigned           index;
+    };
+
+    enum { SpinCount = 64 };
+
+    // num_threads worker queues + one queue for external threads
+    std::unique_ptr<work_queue[]> queues_;
+
+    // Number of tasks in all queues
+    std::atomic<long> num_queued_ = { 0 };
+
+    // Number of workers that are (about to go) asleep
+    std::atomic<unsigned> num_sleeping_ = { 0 };
+
+    std::mutex              sleep_mutex_;
+    std::condition_variable wakeup_;
+    std::atomic<bool>       stop_ = { false };
+
+    static worker_info& this_worker()
+    {
+        static thread_local worker_info info = { nullptr, 0 };
+        return info;
+    }
+
+    // Queue that the calling thread pushes to and pops from
+    unsigned queue_index() const
+    {
+        auto const& info = this_worker();
+        return info.pool == this ? info.index : num_threads;
+    }
+
+    void push(task const& t)
+    {
+        auto& q = queues_[queue_index()];
+
+        {
+            std::unique_lock<std::mutex> lock(q.mutex);
+            q.tasks.push_back(t);
+            ++num_queued_;
+        }
 
+        if (num_sleeping_ > 0)
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            wakeup_.notify_one();
+        }
+    }
 
-    struct
+    // Pop from the back of the own queue or steal from the front of another one
+    bool find_task(unsigned index, task& t)
     {
-        std::mutex              mutex;
-        std::condition_variable threads_start;
-        visionaray::semaphore   threads_ready;
+        if (num_queued_ == 0)
+        {
+            return false;
+        }
+
+        {
+            auto& q = queues_[index];
+            std::unique_lock<std::mutex> lock(q.mutex);
 
-        std::atomic<bool>       start_threads;
-        std::atomic<bool>       join_threads;
+            if (!q.tasks.empty())
+            {
+                t = q.tasks.back();
+                q.tasks.pop_back();
+                --num_queued_;
+                return true;
+            }
+        }
 
-        std::atomic<long>       num_work_items;
-        std::atomic<long>       work_item_counter;
-        std::atomic<long>       work_items_finished_counter;
-    } sync_params;
+        for (unsigned i = 1; i <= num_threads; ++i)
+        {
+            auto& q = queues_[(index + i) % (num_threads + 1)];
+            std::unique_lock<std::mutex> lock(q.mutex);
 
-    void thread_loop()
+            if (!q.tasks.empty())
+            {
+                t = q.tasks.front();
+                q.tasks.pop_front();
+                --num_queued_;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Execute pending tasks until cond() is true
+    template <typename Cond>
+    void wait_until(Cond cond)
     {
+        unsigned index = queue_index();
+
+        while (!cond())
+        {
+            task t;
+
+            if (find_task(index, t))
+            {
+                t.execute(*this, t);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    template <typename Func>
+    static void execute_loop(thread_pool& pool, task const& t)
+    {
+        auto data = static_cast<loop_data<Func>*>(t.data);
+
+        long first = t.first;
+        long last = t.last;
+
+        // Push the upper halves, these are what thieves get first
+        while (last - first > data->grain)
+        {
+            long mid = first + (last - first) / 2;
+            pool.push({ &execute_loop<Func>, data, mid, last });
+            last = mid;
+        }
+
+        for (long i = first; i != last; ++i)
+        {
+            data->func(i);
+        }
+
+        data->remaining -= last - first;
+    }
+
+    void thread_loop(unsigned index)
+    {
+        this_worker() = { this, index };
+
         for (;;)
         {
-            // Wait until activated
+            task t;
+
+            if (find_task(index, t))
             {
-                std::unique_lock<std::mutex> lock(sync_params.mutex);
-                sync_params.threads_start.wait(
-                        lock,
-                        [this]()
-                            -> std::atomic<bool> const&
-                        {
-                            return sync_params.start_threads;
-                        }
-                        );
+                t.execute(*this, t);
+                continue;
             }
 
-            // Exit?
-            if (sync_params.join_threads)
+            if (stop_)
             {
                 break;
             }
 
+            // Spin for a while before going to sleep
+            bool found = false;
 
-            // Perform work in queue
-            for (;;)
+            for (int i = 0; i < SpinCount && !found; ++i)
             {
-                auto work_item = sync_params.work_item_counter.fetch_add(1);
+                std::this_thread::yield();
+                found = num_queued_ > 0 || stop_;
+            }
 
-                if (work_item >= sync_params.num_work_items)
-                {
-                    break;
-                }
+            if (found)
+            {
+                continue;
+            }
 
-                func(work_item);
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
 
-                auto finished = sync_params.work_items_finished_counter.fetch_add(1);
+            ++num_sleeping_;
 
-                if (finished >= sync_params.num_work_items - 1)
-                {
-                    assert(finished == sync_params.num_work_items - 1);
-                    sync_params.threads_ready.notify();
-                    break;
-                }
-            }
+            wakeup_.wait(
+                    lock,
+                    [this]()
+                    {
+                        return num_queued_ > 0 || stop_;
+                    }
+                    );
+
+            --num_sleeping_;
         }
+
+        this_worker() = { nullptr, 0 };
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Task group for fork/join parallelism
+//
+// run() submits a task to the pool, wait() returns once all tasks submitted to the
+// group have finished, executing pending tasks in the meantime. Tasks may themselves
+// create task groups and wait for them.
+//
+// Example:
+//
+//   void build(node& n, thread_pool& pool)
+//   {
+//       task_group tg(pool);
+//       tg.run([&]() { build(n.left, pool); });
+//       build(n.right, pool);
+//       tg.wait();
+//   }
+//
+
+class task_group
+{
+public:
+
+    explicit task_group(thread_pool& pool)
+        : pool_(pool)
+    {
+    }
+
+   ~task_group()
+    {
+        wait();
+    }
+
+    task_group(task_group const&) = delete;
+    task_group& operator=(task_group const&) = delete;
+
+    template <typename Func>
+    void run(Func f)
+    {
+        ++pending_;
+
+        pool_.push({ &execute<Func>, new task_data<Func>{ f, this }, 0, 0 });
+    }
+
+    void wait()
+    {
+        pool_.wait_until([this]() { return pending_.load() == 0; });
+    }
+
+private:
+
+    template <typename Func>
+    struct task_data
+    {
+        Func        func;
+        task_group* group;
+    };
+
+    thread_pool& pool_;
+
+    std::atomic<long> pending_ = { 0 };
+
+    template <typename Func>
+    static void execute(thread_pool& /* */, thread_pool::task const& t)
+    {
+        auto data = static_cast<task_data<Func>*>(t.data);
+        auto group = data->group;
+
+        data->func();
+
+        // Destroy the functor before wait() may return
+        delete data;
+
+        --group->pending_;
     }
 };
 
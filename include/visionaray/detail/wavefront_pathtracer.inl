@@ -0,0 +1,600 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstddef>
+
+#include "../get_area.h"
+#include "../get_surface.h"
+#include "../light_sample.h"
+#include "../light_sampler.h"
+#include "../sampling.h"
+#include "../surface_interaction.h"
+#include "../traverse.h"
+
+namespace visionaray
+{
+namespace pathtracing
+{
+
+//-------------------------------------------------------------------------------------------------
+// Render a frame
+//
+
+template <typename Params, typename FloatT>
+template <typename Camera, typename RenderTarget, typename Intersector, typename Pool>
+void wavefront<Params, FloatT>::frame(
+        pixel_sampler::jittered_blend_type  ps,
+        Camera&                             cam,
+        RenderTarget&                       rt,
+        unsigned                            frame_id,
+        Intersector&                        isect,
+        Pool&                               pool
+        )
+{
+    cam.begin_frame();
+
+    rt.begin_frame();
+
+    int width = rt.width();
+    int height = rt.height();
+
+    generate(ps, cam, width, height, frame_id, pool);
+
+    for (unsigned bounce = 0; bounce < params_.num_bounces && !active_.empty(); ++bounce)
+    {
+        extend(isect, pool);
+
+        shade(isect, bounce, pool);
+
+        connect(isect, pool);
+
+        // Continue with the paths that were not terminated
+        next_active_.clear();
+
+        for (size_t q = 0; q < active_.size(); ++q)
+        {
+            if (continue_[q])
+            {
+                next_active_.push_back(active_[q]);
+            }
+        }
+
+        std::swap(active_, next_active_);
+    }
+
+    accumulate(ps, cam, rt.ref(), width, height, pool);
+
+    rt.end_frame();
+
+    cam.end_frame();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Generate primary rays, one path per pixel sample
+//
+
+template <typename Params, typename FloatT>
+template <typename Camera, typename Pool>
+void wavefront<Params, FloatT>::generate(
+        pixel_sampler::jittered_blend_type  ps,
+        Camera const&                       cam,
+        int                                 width,
+        int                                 height,
+        unsigned                            frame_id,
+        Pool&                               pool
+        )
+{
+    size_t spp = ps.spp;
+    size_t num_paths = static_cast<size_t>(width) * height * spp;
+
+    rays_.resize(num_paths);
+    primary_rays_.resize(num_paths);
+    throughput_.resize(num_paths);
+    intensity_.resize(num_paths);
+    last_pos_.resize(num_paths);
+    last_n_.resize(num_paths);
+    last_brdf_pdf_.resize(num_paths);
+    last_specular_.resize(num_paths);
+    hit_.resize(num_paths);
+    depth_.resize(num_paths);
+    background_.resize(num_paths);
+    gens_.resize(num_paths);
+    active_.resize(num_paths);
+
+    parallel_for(
+        pool,
+        tiled_range1d<size_t>(0, num_paths, TileSize),
+        [&](range1d<size_t> const& r)
+        {
+            for (size_t p = r.begin(); p != r.end(); ++p)
+            {
+                size_t pixel = p / spp;
+                unsigned s = static_cast<unsigned>(p % spp);
+
+                int x = static_cast<int>(pixel % width);
+                int y = static_cast<int>(pixel / width);
+
+                // Pseudo-random sequence per pixel sample and frame
+                gens_[p] = generator_type(make_random_seed(
+                        static_cast<int>(pixel),
+                        static_cast<int>(frame_id * ps.spp + s)
+                        ));
+
+                rays_[p] = visionaray::detail::make_primary_ray(
+                        R{},
+                        ps,
+                        gens_[p],
+                        x,
+                        y,
+                        width,
+                        height,
+                        cam
+                        );
+
+                primary_rays_[p]  = rays_[p];
+                throughput_[p]    = C(1.0);
+                intensity_[p]     = C(0.0);
+                last_pos_[p]      = V(0.0);
+                last_n_[p]        = V(0.0);
+                last_brdf_pdf_[p] = S(0.0);
+                last_specular_[p] = 1;
+                hit_[p]           = 0;
+                depth_[p]         = S(0.0);
+                background_[p]    = vec4(params_.background.intensity(rays_[p].dir), S(1.0));
+                active_[p]        = static_cast<unsigned>(p);
+            }
+        });
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Find closest hits for all active paths
+//
+
+template <typename Params, typename FloatT>
+template <typename Intersector, typename Pool>
+void wavefront<Params, FloatT>::extend(Intersector& isect, Pool& pool)
+{
+    size_t n = active_.size();
+
+    queue_rays_.resize(n);
+    hit_records_.resize(n);
+
+    parallel_for(
+        pool,
+        tiled_range1d<size_t>(0, n, TileSize),
+        [&](range1d<size_t> const& r)
+        {
+            for (size_t q = r.begin(); q != r.end(); ++q)
+            {
+                queue_rays_[q] = rays_[active_[q]];
+            }
+        });
+
+    stream_.closest_hit(
+            queue_rays_.data(),
+            n,
+            params_.prims.begin,
+            params_.prims.end,
+            hit_records_.data(),
+            isect,
+            pool
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Order the queue by material type, paths that exited come first
+//
+
+template <typename Params, typename FloatT>
+template <typename Pool>
+void wavefront<Params, FloatT>::sort_by_material(Pool& pool)
+{
+    size_t n = active_.size();
+
+    shade_order_.resize(n);
+    shade_temp_.resize(n);
+
+    for (size_t q = 0; q < n; ++q)
+    {
+        shade_temp_[q] = static_cast<unsigned>(q);
+    }
+
+    material_counts_.resize(1 + detail::num_material_types<typename Params::material_type>::value);
+
+    paralgo::counting_sort(
+            pool,
+            shade_temp_.begin(),
+            shade_temp_.end(),
+            shade_order_.begin(),
+            material_counts_,
+            [&](unsigned q)
+            {
+                auto const& hr = hit_records_[q];
+                return hr.hit ? 1 + detail::material_type_index(params_.materials[hr.geom_id]) : 0U;
+            }
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Shade all active paths
+//
+
+template <typename Params, typename FloatT>
+template <typename Intersector, typename Pool>
+void wavefront<Params, FloatT>::shade(Intersector& isect, unsigned bounce, Pool& pool)
+{
+    size_t n = active_.size();
+
+    sort_by_material(pool);
+
+    shadow_slots_.resize(2 * n);
+    shadow_contributions_.resize(2 * n);
+    continue_.resize(n);
+
+    kernel<Params> k{params_};
+
+    parallel_for(
+        pool,
+        tiled_range1d<size_t>(0, n, TileSize),
+        [&](range1d<size_t> const& r)
+        {
+            for (size_t i = r.begin(); i != r.end(); ++i)
+            {
+                shade_path(k, isect, shade_order_[i], bounce);
+            }
+        });
+}
+
+// Same as one iteration of the bounce loop of pathtracing::kernel, shadow rays are
+// deferred to the connect stage
+
+template <typename Params, typename FloatT>
+template <typename Intersector>
+void wavefront<Params, FloatT>::shade_path(kernel<Params> const& k, Intersector& isect, unsigned q, unsigned bounce)
+{
+    using I = int;
+
+    using amb_light_type = decltype(params_.amb_light);
+    constexpr bool sample_environment
+            = visionaray::detail::has_sample<amb_light_type, generator_type>::value;
+
+    unsigned p = active_[q];
+
+    auto hit_rec = hit_records_[q];
+    auto const& ray = queue_rays_[q];
+    auto& gen = gens_[p];
+    auto& throughput = throughput_[p];
+    auto& intensity = intensity_[p];
+
+    continue_[q] = 0;
+    shadow_contributions_[2 * q] = C(0.0);
+    shadow_contributions_[2 * q + 1] = C(0.0);
+
+    // Handle rays that just exited
+    if (!hit_rec.hit)
+    {
+        auto env = params_.amb_light.intensity(ray.dir);
+
+        S env_weight(1.0);
+
+        if (sample_environment && bounce > 0 && !last_specular_[p])
+        {
+            env_weight = power_heuristic(
+                    last_brdf_pdf_[p],
+                    detail::environment_pdf(params_.amb_light, ray.dir, 0)
+                    );
+        }
+
+        intensity += env_weight * from_rgb(env) * throughput;
+        return;
+    }
+
+    // Special handling for first bounce
+    if (bounce == 0)
+    {
+        hit_[p] = 1;
+        depth_[p] = hit_rec.t;
+    }
+
+    V refl_dir(0.0);
+    V view_dir = -ray.dir;
+
+    hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
+
+    auto surf = get_surface(hit_rec, params_);
+
+    S brdf_pdf(0.0);
+
+    I inter = 0;
+    auto src = surf.sample(view_dir, refl_dir, brdf_pdf, inter, gen);
+
+    bool zero_pdf = brdf_pdf <= S(0.0);
+
+    S light_pdf(0.0);
+    auto num_lights = static_cast<int>(params_.lights.end - params_.lights.begin);
+
+    if (num_lights > 0 && inter == surface_interaction::Emission)
+    {
+        auto A = get_area(params_.prims.begin, hit_rec, isect);
+        auto ld = length(hit_rec.isect_pos - ray.ori);
+        auto L = normalize(hit_rec.isect_pos - ray.ori);
+        auto n = surf.geometric_normal;
+        auto ldotln = abs(dot(-L, n));
+        auto solid_angle = (ldotln * A) / (ld * ld);
+
+        auto select_pdf = light_select_pdf(
+                params_.light_sampler,
+                num_lights,
+                hit_rec.prim_id,
+                last_pos_[p],
+                last_n_[p]
+                );
+
+        light_pdf = select_pdf / solid_angle;
+    }
+
+    if (inter == surface_interaction::Emission)
+    {
+        S mis_weight(1.0);
+
+        if (bounce > 0 && num_lights > 0 && !last_specular_[p])
+        {
+            mis_weight = power_heuristic(last_brdf_pdf_[p], light_pdf);
+        }
+
+        intensity += mis_weight * throughput * src;
+        return;
+    }
+
+    if (zero_pdf)
+    {
+        return;
+    }
+
+    auto n = surf.shading_normal;
+#if 1
+    n = faceforward( n, view_dir, surf.geometric_normal );
+#endif
+
+    if (num_lights > 0)
+    {
+        S select_pdf(0.0);
+        auto ls = sample_light(
+                params_.lights.begin,
+                params_.lights.end,
+                params_.light_sampler,
+                hit_rec.isect_pos,
+                n,
+                select_pdf,
+                gen
+                );
+
+        shadow_contributions_[2 * q] = k.template unoccluded_light_contribution<R>(
+                ray,
+                surf,
+                inter,
+                hit_rec.isect_pos,
+                n,
+                view_dir,
+                throughput,
+                ls,
+                select_pdf,
+                shadow_slots_[2 * q]
+                );
+    }
+
+    if (sample_environment)
+    {
+        S select_pdf(0.0);
+        auto ls = sample_light(
+                &params_.amb_light,
+                &params_.amb_light + 1,
+                uniform_light_sampler{},
+                hit_rec.isect_pos,
+                n,
+                select_pdf,
+                gen
+                );
+
+        shadow_contributions_[2 * q + 1] = k.template unoccluded_light_contribution<R>(
+                ray,
+                surf,
+                inter,
+                hit_rec.isect_pos,
+                n,
+                view_dir,
+                throughput,
+                ls,
+                select_pdf,
+                shadow_slots_[2 * q + 1]
+                );
+    }
+
+    // Same pdf that next event estimation uses in its MIS weight
+    last_brdf_pdf_[p] = brdf_pdf * max_element(throughput.samples());
+
+    throughput *= src * (dot(n, refl_dir) / brdf_pdf);
+
+    if (bounce >= 2)
+    {
+        // Russian roulette
+        auto prob = max_element(throughput.samples());
+
+        if (gen.next() > prob)
+        {
+            return;
+        }
+
+        throughput /= prob;
+    }
+
+    rays_[p].ori = hit_rec.isect_pos + refl_dir * S(params_.epsilon);
+    rays_[p].dir = refl_dir;
+
+    last_pos_[p] = hit_rec.isect_pos;
+    last_n_[p] = n;
+
+    last_specular_[p] = inter == surface_interaction::SpecularReflection ||
+                        inter == surface_interaction::SpecularTransmission;
+
+    continue_[q] = 1;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Trace the shadow rays of all paths, add the contributions of visible light samples
+//
+
+template <typename Params, typename FloatT>
+template <typename Intersector, typename Pool>
+void wavefront<Params, FloatT>::connect(Intersector& isect, Pool& pool)
+{
+    size_t num_slots = shadow_slots_.size();
+
+    shadow_rays_.clear();
+    shadow_slot_index_.clear();
+
+    // Only light samples that contribute need a shadow ray
+    for (size_t i = 0; i < num_slots; ++i)
+    {
+        C const& c = shadow_contributions_[i];
+
+        if (max_element(c.samples()) > S(0.0))
+        {
+            shadow_rays_.push_back(shadow_slots_[i]);
+            shadow_slot_index_.push_back(static_cast<unsigned>(i));
+        }
+    }
+
+    size_t n = shadow_rays_.size();
+
+    shadow_hit_records_.resize(n);
+
+    stream_.any_hit(
+            shadow_rays_.data(),
+            n,
+            params_.prims.begin,
+            params_.prims.end,
+            shadow_hit_records_.data(),
+            isect,
+            pool
+            );
+
+    parallel_for(
+        pool,
+        tiled_range1d<size_t>(0, n, TileSize),
+        [&](range1d<size_t> const& r)
+        {
+            for (size_t i = r.begin(); i != r.end(); ++i)
+            {
+                if (shadow_hit_records_[i].hit)
+                {
+                    shadow_contributions_[shadow_slot_index_[i]] = C(0.0);
+                }
+            }
+        });
+
+    size_t num_queued = num_slots / 2;
+
+    // Both slots of a path are added by the same thread
+    parallel_for(
+        pool,
+        tiled_range1d<size_t>(0, num_queued, TileSize),
+        [&](range1d<size_t> const& r)
+        {
+            for (size_t q = r.begin(); q != r.end(); ++q)
+            {
+                intensity_[active_[q]] += shadow_contributions_[2 * q] + shadow_contributions_[2 * q + 1];
+            }
+        });
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Average the samples of each pixel and blend with the render target
+//
+
+template <typename Params, typename FloatT>
+template <typename RenderTargetRef, typename Camera, typename Pool>
+void wavefront<Params, FloatT>::accumulate(
+        pixel_sampler::jittered_blend_type  ps,
+        Camera const&                       cam,
+        RenderTargetRef                     rt_ref,
+        int                                 width,
+        int                                 height,
+        Pool&                               pool
+        )
+{
+    size_t spp = ps.spp;
+    size_t num_pixels = static_cast<size_t>(width) * height;
+
+    parallel_for(
+        pool,
+        tiled_range1d<size_t>(0, num_pixels, TileSize),
+        [&](range1d<size_t> const& r)
+        {
+            for (size_t pixel = r.begin(); pixel != r.end(); ++pixel)
+            {
+                int x = static_cast<int>(pixel % width);
+                int y = static_cast<int>(pixel / width);
+
+                vec4 color(0.0);
+                S depth(0.0);
+                bool hit = false;
+
+                for (size_t s = 0; s < spp; ++s)
+                {
+                    size_t p = pixel * spp + s;
+
+                    color += hit_[p] ? to_rgba(intensity_[p]) : background_[p];
+
+                    if (RenderTargetRef::depth_format != PF_UNSPECIFIED)
+                    {
+                        depth += hit_[p]
+                            ? visionaray::detail::depth_transform(primary_rays_[p], depth_[p], cam)
+                            : S(1.0);
+                    }
+
+                    hit |= hit_[p] != 0;
+                }
+
+                color /= S(static_cast<float>(spp));
+                depth /= S(static_cast<float>(spp));
+
+                visionaray::detail::pixel_access::blend(
+                        pixel_format_constant<RenderTargetRef::color_format>{},
+                        pixel_format_constant<PF_RGBA32F>{},
+                        x,
+                        y,
+                        width,
+                        height,
+                        color,
+                        rt_ref.color(),
+                        ps.sfactor,
+                        ps.dfactor
+                        );
+
+                if (RenderTargetRef::depth_format != PF_UNSPECIFIED && hit)
+                {
+                    visionaray::detail::pixel_access::store(
+                            pixel_format_constant<RenderTargetRef::depth_format>{},
+                            pixel_format_constant<PF_DEPTH32F>{},
+                            x,
+                            y,
+                            width,
+                            height,
+                            depth,
+                            rt_ref.depth()
+                            );
+                }
+            }
+        });
+}
+
+} // pathtracing
+} // visionaray
@@ -272,6 +272,7 @@ struct kernel
                         S(0.0),                                            // tmin
                         length(hit_rec.isect_pos - V(it->position()))      // tmax
                         );
+                copy_ray_time(shadow_ray, ray);
 
                 // only cast a shadow if occluder between light source and hit pos
                 auto shadow_rec = any_hit(
@@ -295,10 +296,12 @@ struct kernel
             if (any(bounce.kr > S(0.0)))
             {
                 auto dir = bounce.reflected_dir;
-                ray = R(
+                R reflected(
                     hit_rec.isect_pos + dir * S(params.epsilon),
                     dir
                     );
+                copy_ray_time(reflected, ray);
+                ray = reflected;
                 hit_rec = closest_hit(ray, params.prims.begin, params.prims.end, isect);
             }
             throughput *= bounce.kr;
@@ -0,0 +1,112 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DISTRIBUTION_2D_H
+#define VSNRAY_DISTRIBUTION_2D_H 1
+
+#include "detail/macros.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Piecewise constant 2D distribution over [0..1)^2
+//
+// Built from width x height nonnegative function values. Sampling first selects a row from
+// the marginal distribution and then a column from the row's conditional distribution,
+// both by binary search over the respective CDF. Functions that are zero everywhere are
+// sampled uniformly.
+//
+// distribution_2d stores the tables on the host, ref() returns a distribution_2d_ref that
+// refers to them and that can be passed to kernels.
+//
+
+class distribution_2d_ref
+{
+public:
+
+    distribution_2d_ref() = default;
+
+    VSNRAY_FUNC distribution_2d_ref(
+            float const* func,
+            float const* conditional_cdf,
+            float const* marginal_cdf,
+            float        integral,
+            int          width,
+            int          height
+            );
+
+    // Sample a point in [0..1)^2 with random numbers u1 (row) and u2 (column),
+    // pdf is the density of the point w.r.t. area
+    VSNRAY_FUNC vector<2, float> sample(float u1, float u2, float& pdf) const;
+
+    // Density w.r.t. area at point uv
+    template <typename T>
+    VSNRAY_FUNC T pdf(vector<2, T> const& uv) const;
+
+    VSNRAY_FUNC int width() const;
+    VSNRAY_FUNC int height() const;
+
+    VSNRAY_FUNC explicit operator bool() const;
+
+private:
+
+    // width x height function values
+    float const* func_ = nullptr;
+
+    // height x (width + 1) conditional CDFs, one per row
+    float const* conditional_cdf_ = nullptr;
+
+    // (height + 1) values
+    float const* marginal_cdf_ = nullptr;
+
+    // Integral of the function over [0..1)^2
+    float integral_ = 0.0f;
+
+    int width_ = 0;
+    int height_ = 0;
+
+};
+
+class distribution_2d
+{
+public:
+
+    using ref_type = distribution_2d_ref;
+
+public:
+
+    distribution_2d() = default;
+
+    // func: width x height function values, row-major
+    distribution_2d(float const* func, int width, int height);
+
+    void reset(float const* func, int width, int height);
+
+    ref_type ref() const;
+
+    int width() const;
+    int height() const;
+
+private:
+
+    aligned_vector<float> func_;
+    aligned_vector<float> conditional_cdf_;
+    aligned_vector<float> marginal_cdf_;
+
+    float integral_ = 0.0f;
+
+    int width_ = 0;
+    int height_ = 0;
+
+};
+
+} // visionaray
+
+#include "detail/distribution_2d.inl"
+
+#endif // VSNRAY_DISTRIBUTION_2D_H
@@ -9,11 +9,22 @@
 #include "detail/macros.h"
 #include "math/matrix.h"
 #include "math/vector.h"
+#include "distribution_2d.h"
+#include "light_sample.h"
 #include "spectrum.h"
 
 namespace visionaray
 {
 
+//-------------------------------------------------------------------------------------------------
+// Environment light with a lat-long texture
+//
+// Supports importance sampling when a distribution (see make_environment_light_distribution())
+// is set, otherwise directions are sampled uniformly. Light samples are positions in the
+// sampled direction, at a large distance (sample_distance()) from the shading point passed
+// to sample_from(), so that the samples can be used like those of the other light types.
+//
+
 template <typename T, typename Texture>
 class environment_light
 {
@@ -24,9 +35,31 @@ public:
 
 public:
 
+    // Evaluate the light intensity in direction dir.
     template <typename U>
     VSNRAY_FUNC vector<3, U> intensity(vector<3, U> const& dir) const;
 
+    // Sample a position as seen from the origin
+    template <typename Generator, typename U = typename Generator::value_type>
+    VSNRAY_FUNC light_sample<U> sample(Generator& gen) const;
+
+    // Sample a position as seen from the shading point ref_pos
+    template <typename Generator, typename U = typename Generator::value_type>
+    VSNRAY_FUNC light_sample<U> sample_from(vector<3, U> const& ref_pos, Generator& gen) const;
+
+    // Density w.r.t. solid angle of sampling direction dir
+    template <typename U>
+    VSNRAY_FUNC U pdf(vector<3, U> const& dir) const;
+
+    // Return the origin, the light has no position
+    VSNRAY_FUNC vector<3, T> position() const;
+
+    // Distance of the sampled positions from the reference point
+    VSNRAY_FUNC static T sample_distance();
+
+    VSNRAY_FUNC void set_distribution(distribution_2d_ref const& distribution);
+    VSNRAY_FUNC distribution_2d_ref const& distribution() const;
+
     VSNRAY_FUNC Texture& texture();
     VSNRAY_FUNC Texture const& texture() const;
 
@@ -48,8 +81,20 @@ private:
 
     matrix<4, 4, T> light_to_world_transform_;
     matrix<4, 4, T> world_to_light_transform_;
+
+    distribution_2d_ref distribution_;
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// Build the importance sampling distribution for a lat-long texture: luminance weighted by
+// sin(theta) to account for the distortion of the mapping. Requires host access to the
+// texels
+//
+
+template <typename Texture>
+distribution_2d make_environment_light_distribution(Texture const& tex);
+
 } // visionaray
 
 #include "detail/environment_light.inl"
@@ -14,6 +14,8 @@
 #include "detail/macros.h"
 #include "math/simd/type_traits.h"
 #include "bvh.h"
+#include "get_primitive.h"
+#include "intersector.h"
 
 namespace visionaray
 {
@@ -33,32 +35,77 @@ inline vector<3, U> sample_surface(P, Generator&)
 }
 #endif
 
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Area of a single primitive
+//
+// Indexed triangles don't store their vertices, they are taken from the intersector the
+// primitives were traversed with (see indexed_triangle_intersector)
+//
+
+template <typename P, typename Intersector>
+VSNRAY_FUNC
+inline auto primitive_area(P const& prim, Intersector const& /* */)
+    -> decltype(area(prim))
+{
+    return area(prim);
+}
+
+template <typename T, typename P, typename Intersector>
+VSNRAY_FUNC
+inline auto primitive_area(basic_indexed_triangle<T, P> const& tri, Intersector const& isect)
+    -> decltype(area(tri, isect.vertices))
+{
+    return area(tri, isect.vertices);
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Get area of the primitive that was hit
+//
+// The intersector is only needed for primitives that don't store their vertices
+//
+
 // No BVH, no SIMD
 template <
     typename Primitives,
     typename HR,
+    typename Intersector = default_intersector,
     typename Primitive = typename std::iterator_traits<Primitives>::value_type,
     typename = typename std::enable_if<!is_any_bvh<Primitive>::value>::type,
     typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
     >
 VSNRAY_FUNC
-inline auto get_area(Primitives const& prims, HR const& hr)
-    -> decltype(area(std::declval<Primitive>()))
+inline auto get_area(
+        Primitives const&   prims,
+        HR const&           hr,
+        Intersector const&  isect = Intersector{}
+        )
+    -> decltype(detail::primitive_area(std::declval<Primitive>(), isect))
 {
-    return area(prims[hr.prim_id]);
+    return detail::primitive_area(prims[hr.prim_id], isect);
 }
 
 // No BVH, SIMD
 template <
     typename Primitives,
     typename HR,
+    typename Intersector = default_intersector,
     typename Primitive = typename std::iterator_traits<Primitives>::value_type,
     typename = typename std::enable_if<!is_any_bvh<Primitive>::value>::type,
     typename = typename std::enable_if<simd::is_simd_vector<typename HR::scalar_type>::value>::type,
     typename = void
     >
 VSNRAY_FUNC
-inline auto get_area(Primitives const& prims, HR const& hr)
+inline auto get_area(
+        Primitives const&   prims,
+        HR const&           hr,
+        Intersector const&  isect = Intersector{}
+        )
     -> typename HR::scalar_type
 {
     using T = typename HR::scalar_type;
@@ -72,7 +119,7 @@ inline auto get_area(Primitives const& prims, HR const& hr)
 
     for (unsigned i = 0; i < simd::num_elements<T>::value; ++i)
     {
-        result[i] = area(prims[prim_id[i]]);
+        result[i] = detail::primitive_area(prims[prim_id[i]], isect);
     }
 
     return T(result);
@@ -82,6 +129,7 @@ inline auto get_area(Primitives const& prims, HR const& hr)
 template <
     typename Primitives,
     typename HR,
+    typename Intersector = default_intersector,
     typename Primitive = typename std::iterator_traits<Primitives>::value_type,
     typename = typename std::enable_if<is_any_bvh<Primitive>::value>::type,
     typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type,
@@ -89,8 +137,12 @@ template <
     typename = void
     >
 VSNRAY_FUNC
-inline auto get_area(Primitives const& prims, HR const& hr)
-    -> decltype(area(std::declval<typename Primitive::primitive_type>()))
+inline auto get_area(
+        Primitives const&   prims,
+        HR const&           hr,
+        Intersector const&  isect = Intersector{}
+        )
+    -> decltype(detail::primitive_area(std::declval<typename Primitive::primitive_type>(), isect))
 {
     // Find the BVH that contains prim_id
     size_t num_primitives_total = 0;
@@ -101,19 +153,24 @@ inline auto get_area(Primitives const& prims, HR const& hr)
         num_primitives_total += prims[i++].num_primitives();
     }
 
-    return area(prims[i].primitive(hr.primitive_list_index));
+    return detail::primitive_area(prims[i].primitive(hr.primitive_list_index), isect);
 }
 
 // BVH, SIMD
 template <
     typename Primitives,
     typename HR,
+    typename Intersector = default_intersector,
     typename Primitive = typename std::iterator_traits<Primitives>::value_type,
     typename = typename std::enable_if<is_any_bvh<Primitive>::value && !is_any_bvh_inst<typename Primitive::primitive_type>::value>::type,
     typename = typename std::enable_if<simd::is_simd_vector<typename HR::scalar_type>::value>::type
     >
 VSNRAY_FUNC
-inline auto get_area(Primitives const& prims, HR const& hr)
+inline auto get_area(
+        Primitives const&   prims,
+        HR const&           hr,
+        Intersector const&  isect = Intersector{}
+        )
     -> typename HR::scalar_type
 {
     using T = typename HR::scalar_type;
@@ -138,7 +195,7 @@ inline auto get_area(Primitives const& prims, HR const& hr)
         {
             num_primitives_total += prims[j++].num_primitives();
         }
-        result[i] = area(prims[j].primitive(primitive_list_index[i]));
+        result[i] = detail::primitive_area(prims[j].primitive(primitive_list_index[i]), isect);
     }
 
     return T(result);
@@ -148,56 +205,58 @@ inline auto get_area(Primitives const& prims, HR const& hr)
 template <
     typename Primitives,
     typename HR,
+    typename Intersector = default_intersector,
     typename Primitive = typename std::iterator_traits<Primitives>::value_type,
     typename = typename std::enable_if<is_any_bvh<Primitive>::value && is_any_bvh_inst<typename Primitive::primitive_type>::value>::type,
     typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
     >
 VSNRAY_FUNC
-inline auto get_area(Primitives const& prims, HR const& hr, void* = nullptr)
+inline auto get_area(
+        Primitives const&   prims,
+        HR const&           hr,
+        Intersector const&  isect = Intersector{},
+        void*               = nullptr
+        )
     -> typename HR::scalar_type
 {
-    auto& b = prims[0]; // TODO: currently only two levels supported (i.e. one top-level BVH)
+    auto& b = prims[0]; // TODO: currently only one top-level BVH supported
 
-    auto& inst = b.primitive(hr.primitive_list_index);
-
-    return area(inst.primitive(hr.primitive_list_index_inst));
+    return detail::primitive_area(detail::get_instanced_primitive(b.primitive(hr.primitive_list_index), hr), isect);
 }
 
 // BVH instance, SIMD
 template <
     typename Primitives,
     typename HR,
+    typename Intersector = default_intersector,
     typename Primitive = typename std::iterator_traits<Primitives>::value_type,
     typename = typename std::enable_if<is_any_bvh<Primitive>::value && is_any_bvh_inst<typename Primitive::primitive_type>::value>::type,
     typename = typename std::enable_if<simd::is_simd_vector<typename HR::scalar_type>::value>::type,
     typename = void
     >
 VSNRAY_FUNC
-inline auto get_area(Primitives const& prims, HR const& hr, void* = nullptr)
+inline auto get_area(
+        Primitives const&   prims,
+        HR const&           hr,
+        Intersector const&  isect = Intersector{},
+        void*               = nullptr
+        )
     -> typename HR::scalar_type
 {
     using T = typename HR::scalar_type;
     using float_array = simd::aligned_array_t<T>;
-    using int_array = simd::aligned_array_t<simd::int_type_t<T>>;
 
-    int_array prim_id;
-    store(prim_id, hr.prim_id);
-
-    int_array primitive_list_index_inst;
-    store(primitive_list_index_inst, hr.primitive_list_index_inst);
-
-    int_array primitive_list_index;
-    store(primitive_list_index, hr.primitive_list_index);
+    auto hrs = simd::unpack(hr);
 
     float_array result = {};
 
     for (unsigned i = 0; i < simd::num_elements<T>::value; ++i)
     {
-        auto& b = prims[0]; // TODO: currently only two levels supported (i.e. one top-level BVH)
+        auto& b = prims[0]; // TODO: currently only one top-level BVH supported
 
-        auto& inst = b.primitive(primitive_list_index[i]);
+        auto& inst = b.primitive(hrs[i].primitive_list_index);
 
-        result[i] = area(inst.primitive(primitive_list_index_inst[i]));
+        result[i] = detail::primitive_area(detail::get_instanced_primitive(inst, hrs[i]), isect);
     }
 
     return T(result);
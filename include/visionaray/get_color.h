@@ -11,6 +11,8 @@
 
 #include "detail/macros.h"
 #include "math/simd/type_traits.h"
+#include "math/indexed_triangle.h"
+#include "math/multi_triangle.h"
 #include "math/triangle.h"
 #include "math/vector.h"
 #include "array.h"
@@ -95,6 +97,59 @@ inline auto get_color(
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Get indexed triangle vertex color from array
+//
+
+template <
+    typename Colors,
+    typename HR,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
+    >
+VSNRAY_FUNC
+inline auto get_color(
+        Colors                              colors,
+        HR const&                           hr,
+        basic_indexed_triangle<T> const&    tri,
+        colors_per_vertex_binding           /* */
+        )
+    -> typename std::iterator_traits<Colors>::value_type
+{
+    return lerp(
+            colors[tri.i1],
+            colors[tri.i2],
+            colors[tri.i3],
+            hr.u,
+            hr.v
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Get multi triangle vertex color from array, colors are stored per triangle
+//
+
+template <
+    typename Colors,
+    typename HR,
+    size_t N,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
+    >
+VSNRAY_FUNC
+inline auto get_color(
+        Colors                                  colors,
+        HR const&                               hr,
+        basic_multi_triangle<N, T> const&       /* */,
+        colors_per_vertex_binding               /* */
+        )
+    -> typename std::iterator_traits<Colors>::value_type
+{
+    return get_color(colors, hr, basic_triangle<3, T>{}, colors_per_vertex_binding{});
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Gather N face colors for SIMD ray
 //
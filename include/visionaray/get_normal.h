@@ -11,6 +11,8 @@
 
 #include "detail/macros.h"
 #include "math/simd/type_traits.h"
+#include "math/indexed_triangle.h"
+#include "math/multi_triangle.h"
 #include "math/plane.h"
 #include "math/sphere.h"
 #include "math/triangle.h"
@@ -57,6 +59,49 @@ inline auto get_normal(
     return normals[hr.prim_id];
 }
 
+//-------------------------------------------------------------------------------------------------
+// Get face normal of indexed triangle from array
+//
+
+template <
+    typename Normals,
+    typename HR,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
+    >
+VSNRAY_FUNC
+inline auto get_normal(
+        Normals                             normals,
+        HR const&                           hr,
+        basic_indexed_triangle<T> const&    /* */
+        )
+    -> typename std::iterator_traits<Normals>::value_type
+{
+    return normals[hr.prim_id];
+}
+
+//-------------------------------------------------------------------------------------------------
+// Get face normal of multi triangle from array
+//
+
+template <
+    typename Normals,
+    typename HR,
+    size_t N,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
+    >
+VSNRAY_FUNC
+inline auto get_normal(
+        Normals                                 normals,
+        HR const&                               hr,
+        basic_multi_triangle<N, T> const&       /* */
+        )
+    -> typename std::iterator_traits<Normals>::value_type
+{
+    return normals[hr.prim_id];
+}
+
 //-------------------------------------------------------------------------------------------------
 // Gather N face normals for SIMD ray
 //
@@ -115,6 +160,25 @@ inline vector<3, T> get_normal(HR const& hr, basic_triangle<3, T> const& triangl
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Get normal from multi triangle primitive, the triangle that was hit is found by prim_id
+//
+
+template <typename HR, size_t N, typename T>
+VSNRAY_FUNC
+inline vector<3, T> get_normal(HR const& hr, basic_multi_triangle<N, T> const& triangle)
+{
+    size_t i = 0;
+
+    while (i < N - 1 && triangle.prim_id[i] != static_cast<unsigned>(hr.prim_id))
+    {
+        ++i;
+    }
+
+    return get_normal(hr, get_triangle(triangle, i));
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Get normal from plane primitive
 //
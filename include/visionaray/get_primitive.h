@@ -13,6 +13,59 @@
 
 namespace visionaray
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Primitive type stored by the bottom-level BVH of (nested) instances
+//
+
+template <typename P, typename = void>
+struct instanced_primitive
+{
+    using type = P;
+};
+
+template <typename P>
+struct instanced_primitive<P, typename std::enable_if<is_any_bvh_inst<P>::value>::type>
+{
+    using type = typename instanced_primitive<typename P::primitive_type>::type;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Follow the instance path of the hit record down to the primitive that was hit
+//
+
+template <
+    typename Inst,
+    typename HR,
+    typename = typename std::enable_if<!is_any_bvh_inst<typename Inst::primitive_type>::value>::type
+    >
+VSNRAY_FUNC
+inline typename Inst::primitive_type const& get_instanced_primitive(Inst const& inst, HR const& hr)
+{
+    return inst.primitive(hr.primitive_list_index_inst);
+}
+
+template <
+    typename Inst,
+    typename R,
+    typename Base,
+    typename = typename std::enable_if<is_any_bvh_inst<typename Inst::primitive_type>::value>::type,
+    typename = void
+    >
+VSNRAY_FUNC
+inline typename instanced_primitive<Inst>::type const& get_instanced_primitive(
+        Inst const&                         inst,
+        hit_record_bvh_inst<R, Base> const& hr
+        )
+{
+    return get_instanced_primitive(inst.primitive(hr.primitive_list_index_inst), static_cast<Base const&>(hr));
+}
+
+} // detail
+
 
 //-------------------------------------------------------------------------------------------------
 // Get primitive from params
@@ -63,10 +116,10 @@ template <
     >
 VSNRAY_FUNC
 inline auto get_primitive(Params const& params, HR const& hr)
-    -> typename P::primitive_type::primitive_type const&
+    -> typename detail::instanced_primitive<typename P::primitive_type>::type const&
 {
     // Assume we only have one top-level BVH (TODO?)
-    return params.prims.begin[0].primitive(hr.primitive_list_index).primitive(hr.primitive_list_index_inst);
+    return detail::get_instanced_primitive(params.prims.begin[0].primitive(hr.primitive_list_index), hr);
 }
 
 } // visionaray
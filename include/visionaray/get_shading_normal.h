@@ -12,6 +12,8 @@
 #include "detail/macros.h"
 #include "math/detail/math.h"
 #include "math/simd/type_traits.h"
+#include "math/indexed_triangle.h"
+#include "math/multi_triangle.h"
 #include "math/triangle.h"
 #include "get_normal.h"
 #include "prim_traits.h"
@@ -106,6 +108,69 @@ inline auto get_shading_normal(
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// get_shading_normal for indexed triangles with normals_per_vertex_binding
+//
+// Normals are stored per vertex, vertices of meshes w/o shading normals store the zero
+// vector. The triangle can't compute its geometric normal, so the zero vector is returned
+// and get_surface() uses the geometric normal instead
+//
+
+template <
+    typename Normals,
+    typename HR,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
+    >
+VSNRAY_FUNC
+inline auto get_shading_normal(
+        Normals                             normals,
+        HR const&                           hr,
+        basic_indexed_triangle<T> const&    tri,
+        normals_per_vertex_binding          /* */
+        )
+    -> typename std::iterator_traits<Normals>::value_type
+{
+    auto n = lerp(
+            normals[tri.i1],
+            normals[tri.i2],
+            normals[tri.i3],
+            hr.u,
+            hr.v
+            );
+
+    auto len = length(n);
+
+    return len > T(0.0) ? n / len : n;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// get_shading_normal for multi triangles with normals_per_vertex_binding
+//
+// Normals are stored per triangle like with basic_triangle
+//
+
+template <
+    typename Normals,
+    typename HR,
+    size_t N,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
+    >
+VSNRAY_FUNC
+inline auto get_shading_normal(
+        Normals                                 normals,
+        HR const&                               hr,
+        basic_multi_triangle<N, T> const&       /* */,
+        normals_per_vertex_binding              /* */
+        )
+    -> typename std::iterator_traits<Normals>::value_type
+{
+    return get_shading_normal(normals, hr, basic_triangle<3, T>{}, normals_per_vertex_binding{});
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // get_shading_normal for triangles with normals_per_vertex_binding for SIMD ray
 //
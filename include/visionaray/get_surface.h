@@ -121,6 +121,61 @@ inline typename Params::color_type get_tex_color(
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Normals
+//
+// Primitives that only refer to their vertices by index (indexed triangles) can't compute
+// their geometric normal, it is then looked up per face, and replaces per vertex shading
+// normals of zero length
+//
+
+template <typename Normals, typename HR, typename Primitive>
+VSNRAY_FUNC
+inline auto geometric_normal_impl(Normals const& normals, HR const& hr, Primitive const& prim, int)
+    -> decltype(get_normal(hr, prim))
+{
+    return normals ? get_normal(normals, hr, prim) : get_normal(hr, prim);
+}
+
+template <typename Normals, typename HR, typename Primitive>
+VSNRAY_FUNC
+inline auto geometric_normal_impl(Normals const& normals, HR const& hr, Primitive const& prim, long)
+    -> decltype(get_normal(normals, hr, prim))
+{
+    return get_normal(normals, hr, prim);
+}
+
+template <typename Normals, typename HR, typename Primitive, typename NormalBinding, typename N>
+VSNRAY_FUNC
+inline auto shading_normal_impl(
+        Normals const&          normals,
+        HR const&               hr,
+        Primitive const&        prim,
+        NormalBinding           binding,
+        N const&                /* gn */,
+        int
+        )
+    -> decltype(get_normal(hr, prim), get_shading_normal(normals, hr, prim, binding))
+{
+    return get_shading_normal(normals, hr, prim, binding);
+}
+
+template <typename Normals, typename HR, typename Primitive, typename NormalBinding, typename N>
+VSNRAY_FUNC
+inline N shading_normal_impl(
+        Normals const&          normals,
+        HR const&               hr,
+        Primitive const&        prim,
+        NormalBinding           binding,
+        N const&                gn,
+        long
+        )
+{
+    N sn = get_shading_normal(normals, hr, prim, binding);
+    return length(sn) > typename HR::scalar_type(0.0) ? sn : gn;
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // No SIMD
 //
@@ -145,8 +200,8 @@ inline auto get_surface_impl(HR const& hr, Params const& params)
     auto const& gns = params.geometric_normals;
     auto const& sns = params.shading_normals;
 
-    auto gn    = gns ? get_normal(gns, hr, prim) : get_normal(hr, prim);
-    auto sn    = sns ? get_shading_normal(sns, hr, prim, typename Params::normal_binding{}) : gn;
+    auto gn    = geometric_normal_impl(gns, hr, prim, 0);
+    auto sn    = sns ? shading_normal_impl(sns, hr, prim, typename Params::normal_binding{}, gn, 0) : gn;
     auto color = params.colors ? get_color(params.colors, hr, prim, typename Params::color_binding{}) : C(1.0);
     auto tc    = params.tex_coords && params.textures ? get_tex_color(
                         hr,
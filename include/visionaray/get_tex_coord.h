@@ -13,6 +13,8 @@
 #include "math/detail/math.h"
 #include "math/simd/type_traits.h"
 #include "math/constants.h"
+#include "math/indexed_triangle.h"
+#include "math/multi_triangle.h"
 #include "math/sphere.h"
 #include "math/triangle.h"
 #include "math/vector.h"
@@ -61,6 +63,49 @@ inline auto get_tex_coord(TexCoords tex_coords, HR const& hr, basic_triangle<3,
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Indexed triangle, texture coordinates are stored per vertex
+//
+
+template <
+    typename TexCoords,
+    typename HR,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
+    >
+VSNRAY_FUNC
+inline auto get_tex_coord(TexCoords tex_coords, HR const& hr, basic_indexed_triangle<T> const& tri)
+    -> typename std::iterator_traits<TexCoords>::value_type
+{
+    return lerp(
+            tex_coords[tri.i1],
+            tex_coords[tri.i2],
+            tex_coords[tri.i3],
+            hr.u,
+            hr.v
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Multi triangle, texture coordinates are stored per triangle like with basic_triangle
+//
+
+template <
+    typename TexCoords,
+    typename HR,
+    size_t N,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type
+    >
+VSNRAY_FUNC
+inline auto get_tex_coord(TexCoords tex_coords, HR const& hr, basic_multi_triangle<N, T> const& /* */)
+    -> typename std::iterator_traits<TexCoords>::value_type
+{
+    return get_tex_coord(tex_coords, hr, basic_triangle<3, T>{});
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // SIMD triangle
 //
@@ -0,0 +1,132 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_HALTON_GENERATOR_H
+#define VSNRAY_HALTON_GENERATOR_H 1
+
+#include <type_traits>
+
+#include "detail/low_discrepancy.h"
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Halton sequence with per pixel random shifts (Cranley-Patterson rotation)
+//
+// next() returns the successive dimensions of the current sample, begin_sample() starts
+// a new sample and resets the dimension. Dimension d uses the d-th prime as base, after
+// the first 32 dimensions the bases are reused, with different random shifts.
+//
+
+namespace detail
+{
+
+VSNRAY_FUNC
+inline unsigned halton_base(unsigned dim)
+{
+    static const unsigned primes[32] = {
+          2,   3,   5,   7,  11,  13,  17,  19,
+         23,  29,  31,  37,  41,  43,  47,  53,
+         59,  61,  67,  71,  73,  79,  83,  89,
+         97, 101, 103, 107, 109, 113, 127, 131
+    };
+
+    return primes[dim % 32];
+}
+
+// Radical inverse of index to arbitrary base, as 32-bit fixed point number
+VSNRAY_FUNC
+inline unsigned radical_inverse_fixed(unsigned base, unsigned index)
+{
+    double inv_base = 1.0 / base;
+    double inv_bi = inv_base;
+    double result = 0.0;
+
+    while (index > 0)
+    {
+        result += (index % base) * inv_bi;
+        index /= base;
+        inv_bi *= inv_base;
+    }
+
+    // result < 1, rounding may produce 1.0 though
+    double fixed = result * 4294967296.0;
+    return fixed < 4294967295.0 ? static_cast<unsigned>(fixed) : 0xFFFFFFFFu;
+}
+
+} // detail
+
+
+template <typename T, typename = void>
+class halton_generator
+{
+public:
+
+    using value_type = T;
+
+public:
+
+    halton_generator() = default;
+
+    VSNRAY_FUNC explicit halton_generator(unsigned seed, unsigned first_sample = 0)
+        : seed_(detail::ld_hash(seed))
+        , first_sample_(first_sample)
+        , index_(first_sample)
+    {
+    }
+
+    // Pixel sampler interface, the pixel position is not used
+    VSNRAY_FUNC halton_generator(unsigned seed, int x, int y, unsigned first_sample)
+        : halton_generator(seed, first_sample)
+    {
+        VSNRAY_UNUSED(x);
+        VSNRAY_UNUSED(y);
+    }
+
+    VSNRAY_FUNC void begin_sample(unsigned sample)
+    {
+        index_ = first_sample_ + sample;
+        dim_ = 0;
+    }
+
+    VSNRAY_FUNC T next()
+    {
+        return T(next_uint() >> 8) * T(1.0f / 16777216.0f);
+    }
+
+    VSNRAY_FUNC unsigned next_uint()
+    {
+        unsigned dim = dim_++;
+
+        // Fixed point addition wraps around, i.e. computes the shift modulo 1
+        unsigned shift = detail::ld_hash(detail::ld_hash_combine(seed_, dim));
+        return detail::radical_inverse_fixed(detail::halton_base(dim), index_) + shift;
+    }
+
+private:
+
+    unsigned seed_ = 0;
+    unsigned first_sample_ = 0;
+    unsigned index_ = 0;
+    unsigned dim_ = 0;
+
+};
+
+template <typename T>
+class halton_generator<T, typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+    : public detail::simd_low_discrepancy_generator<T, halton_generator<float>>
+{
+public:
+
+    using detail::simd_low_discrepancy_generator<T, halton_generator<float>>::simd_low_discrepancy_generator;
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_HALTON_GENERATOR_H
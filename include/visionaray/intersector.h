@@ -12,6 +12,7 @@
 
 #include "detail/macros.h"
 #include "detail/tags.h"
+#include "math/intersect.h"
 #include "bvh.h"
 
 namespace visionaray
@@ -124,6 +125,32 @@ struct default_intersector : basic_intersector<default_intersector>
 {
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// Intersector for indexed triangles, holds the vertex array that the triangles refer to
+//
+
+template <typename T>
+struct indexed_triangle_intersector : basic_intersector<indexed_triangle_intersector<T>>
+{
+    using basic_intersector<indexed_triangle_intersector<T>>::operator();
+
+    VSNRAY_FUNC explicit indexed_triangle_intersector(vector<3, T> const* v = nullptr)
+        : vertices(v)
+    {
+    }
+
+    template <typename R, typename P>
+    VSNRAY_FUNC
+    auto operator()(R const& ray, basic_indexed_triangle<T, P> const& tri)
+        -> decltype( intersect(ray, tri, std::declval<vector<3, T> const*>()) )
+    {
+        return intersect(ray, tri, vertices);
+    }
+
+    vector<3, T> const* vertices;
+};
+
 } // visionaray
 
 #endif // VSNRAY_INTERSECTOR_H
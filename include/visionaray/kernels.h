@@ -14,6 +14,7 @@
 #include "math/vector.h"
 #include "prim_traits.h"
 #include "ambient_light.h"
+#include "light_sampler.h"
 #include "tags.h"
 
 namespace visionaray
@@ -34,7 +35,8 @@ template <
     typename Textures,
     typename Lights,
     typename BackgroundLight,
-    typename AmbientLight
+    typename AmbientLight,
+    typename LightSampler = uniform_light_sampler
     >
 struct kernel_params
 {
@@ -47,6 +49,7 @@ struct kernel_params
     using color_type        = typename std::iterator_traits<Colors>::value_type;
     using texture_type      = typename std::iterator_traits<Textures>::value_type;
     using light_type        = typename std::iterator_traits<Lights>::value_type;
+    using light_sampler_type = LightSampler;
 
     struct
     {
@@ -72,6 +75,9 @@ struct kernel_params
 
     BackgroundLight background;
     AmbientLight amb_light;
+
+    // Selects lights for next event estimation
+    LightSampler light_sampler;
 };
 
 
@@ -128,7 +134,8 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bl,
-        al
+        al,
+        {}
         };
 }
 
@@ -185,7 +192,8 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bl,
-        al
+        al,
+        {}
         };
 }
 
@@ -248,7 +256,8 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bl,
-        al
+        al,
+        {}
         };
 }
 
@@ -315,7 +324,8 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bl,
-        al
+        al,
+        {}
         };
 }
 
@@ -387,7 +397,8 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bl,
-        al
+        al,
+        {}
         };
 }
 
@@ -451,9 +462,83 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         background,
-        amb_light
+        amb_light,
+        {}
         };
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Replace the light sampler of a param struct, e.g.
+//
+//   power_light_sampler sampler(lights.begin(), lights.end());
+//   auto kparams = with_light_sampler(make_kernel_params(...), sampler.ref());
+//
+
+template <
+    typename NormalBinding,
+    typename ColorBinding,
+    typename Primitives,
+    typename Normals,
+    typename TexCoords,
+    typename Materials,
+    typename Colors,
+    typename Textures,
+    typename Lights,
+    typename BackgroundLight,
+    typename AmbientLight,
+    typename OldLightSampler,
+    typename LightSampler
+    >
+auto with_light_sampler(
+        kernel_params<
+            NormalBinding,
+            ColorBinding,
+            Primitives,
+            Normals,
+            TexCoords,
+            Materials,
+            Colors,
+            Textures,
+            Lights,
+            BackgroundLight,
+            AmbientLight,
+            OldLightSampler
+            > const&                params,
+        LightSampler const&         light_sampler
+        )
+    -> kernel_params<
+        NormalBinding,
+        ColorBinding,
+        Primitives,
+        Normals,
+        TexCoords,
+        Materials,
+        Colors,
+        Textures,
+        Lights,
+        BackgroundLight,
+        AmbientLight,
+        LightSampler
+        >
+{
+    return {
+        { params.prims.begin, params.prims.end },
+        params.geometric_normals,
+        params.shading_normals,
+        params.tex_coords,
+        params.materials,
+        params.colors,
+        params.textures,
+        { params.lights.begin, params.lights.end },
+        params.num_bounces,
+        params.epsilon,
+        params.background,
+        params.amb_light,
+        light_sampler
+        };
+}
+
 } // visionaray
 
 #include "detail/pathtracing.inl"
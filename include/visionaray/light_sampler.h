@@ -0,0 +1,269 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_LIGHT_SAMPLER_H
+#define VSNRAY_LIGHT_SAMPLER_H 1
+
+#include "detail/macros.h"
+#include "math/aabb.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Light samplers
+//
+// Select one out of num_lights lights for a shading point, e.g. for next event estimation
+// in the path tracer. Light samplers implement:
+//
+//   // Select a light for shading point pos with normal n, u is a random number in [0..1).
+//   // Returns the light index, pdf is the probability of selecting that light
+//   template <typename T>
+//   int select(int num_lights, vector<3, T> const& pos, vector<3, T> const& n, T u, T& pdf) const;
+//
+//   // Probability that select() chooses the light that emits from primitive prim_id.
+//   // Required for MIS when a light is hit by a BRDF sample
+//   template <typename T>
+//   T pdf(int num_lights, int prim_id, vector<3, T> const& pos, vector<3, T> const& n) const;
+//
+// Samplers are lightweight and passed to kernels by value. Samplers with precomputed data
+// (power_light_sampler and light_bvh) store that in host containers, their ref() functions
+// return samplers that refer to the data.
+//
+// power_light_sampler and light_bvh support area lights, primitive ids are obtained from
+// the light geometry.
+//
+
+
+//-------------------------------------------------------------------------------------------------
+// Select lights with uniform probability
+//
+
+struct uniform_light_sampler
+{
+    template <typename T>
+    VSNRAY_FUNC int select(
+            int                 num_lights,
+            vector<3, T> const& pos,
+            vector<3, T> const& n,
+            T                   u,
+            T&                  pdf
+            ) const;
+
+    template <typename T>
+    VSNRAY_FUNC T pdf(
+            int                 num_lights,
+            int                 prim_id,
+            vector<3, T> const& pos,
+            vector<3, T> const& n
+            ) const;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Select lights with probability proportional to their power, using an alias table
+// (M. D. Vose: A linear algorithm for generating random numbers with a given
+// distribution, 1991)
+//
+
+namespace detail
+{
+
+struct alias_table_entry
+{
+    // Probability to keep the bin, otherwise select alias
+    float prob;
+    int   alias;
+};
+
+} // detail
+
+class power_light_sampler_ref
+{
+public:
+
+    power_light_sampler_ref() = default;
+
+    VSNRAY_FUNC power_light_sampler_ref(
+            detail::alias_table_entry const* table,
+            float const*                     pdfs,
+            int const*                       prim_to_light,
+            int                              num_lights,
+            int                              num_prims
+            );
+
+    template <typename T>
+    VSNRAY_FUNC int select(
+            int                 num_lights,
+            vector<3, T> const& pos,
+            vector<3, T> const& n,
+            T                   u,
+            T&                  pdf
+            ) const;
+
+    template <typename T>
+    VSNRAY_FUNC T pdf(
+            int                 num_lights,
+            int                 prim_id,
+            vector<3, T> const& pos,
+            vector<3, T> const& n
+            ) const;
+
+private:
+
+    detail::alias_table_entry const* table_ = nullptr;
+    float const* pdfs_ = nullptr;
+    int const* prim_to_light_ = nullptr;
+    int num_lights_ = 0;
+    int num_prims_ = 0;
+
+};
+
+class power_light_sampler
+{
+public:
+
+    using ref_type = power_light_sampler_ref;
+
+public:
+
+    power_light_sampler() = default;
+
+    template <typename Lights>
+    power_light_sampler(Lights begin, Lights end);
+
+    template <typename Lights>
+    void reset(Lights begin, Lights end);
+
+    ref_type ref() const;
+
+private:
+
+    aligned_vector<detail::alias_table_entry> table_;
+    aligned_vector<float> pdfs_;
+
+    // Light index per primitive id, -1 for primitives that are not lights
+    aligned_vector<int> prim_to_light_;
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Light BVH, selects lights by their estimated contribution to the shading point
+//
+// Binary hierarchy over the lights (one light per leaf). Nodes store the bounds, the total
+// power and a bounding cone of the normals of the lights in the subtree. Traversal picks
+// a child with probability proportional to an importance estimate that is based on power,
+// distance and bounds on the emitter and receiver cosines (C. Conty Estevez and C. Kulla:
+// Importance Sampling of Many Lights with Adaptive Tree Splitting, 2018). Lights are
+// considered two-sided.
+//
+
+struct light_bvh_node
+{
+    aabb  bbox;
+
+    // Normal bounds: cone axis and half-angle
+    vec3  axis;
+    float theta_o;
+
+    float power;
+
+    // Inner nodes: index of the first child, the second child is stored next to it.
+    // Leaves: light index
+    int   index;
+    int   parent;
+    int   is_leaf;
+};
+
+class light_bvh_ref
+{
+public:
+
+    light_bvh_ref() = default;
+
+    VSNRAY_FUNC light_bvh_ref(
+            light_bvh_node const* nodes,
+            int const*            light_to_node,
+            int const*            prim_to_light,
+            int                   num_prims
+            );
+
+    template <typename T>
+    VSNRAY_FUNC int select(
+            int                 num_lights,
+            vector<3, T> const& pos,
+            vector<3, T> const& n,
+            T                   u,
+            T&                  pdf
+            ) const;
+
+    template <typename T>
+    VSNRAY_FUNC T pdf(
+            int                 num_lights,
+            int                 prim_id,
+            vector<3, T> const& pos,
+            vector<3, T> const& n
+            ) const;
+
+private:
+
+    light_bvh_node const* nodes_ = nullptr;
+    int const* light_to_node_ = nullptr;
+    int const* prim_to_light_ = nullptr;
+    int num_prims_ = 0;
+
+    // Probability of selecting the first child of node
+    VSNRAY_FUNC float first_child_prob(light_bvh_node const& node, vec3 const& pos, vec3 const& n) const;
+
+};
+
+class light_bvh
+{
+public:
+
+    using ref_type = light_bvh_ref;
+
+public:
+
+    light_bvh() = default;
+
+    template <typename Lights>
+    light_bvh(Lights begin, Lights end);
+
+    template <typename Lights>
+    void reset(Lights begin, Lights end);
+
+    ref_type ref() const;
+
+    aligned_vector<light_bvh_node> const& nodes() const;
+
+private:
+
+    aligned_vector<light_bvh_node> nodes_;
+    aligned_vector<int> light_to_node_;
+    aligned_vector<int> prim_to_light_;
+
+    struct build_light
+    {
+        aabb  bbox;
+        vec3  centroid;
+        vec3  axis;
+        float theta_o;
+        float power;
+        int   index;
+    };
+
+    void build_node(int node_index, int parent, build_light* first, build_light* last, int& next);
+
+};
+
+} // visionaray
+
+#include "detail/light_sampler.inl"
+
+#endif // VSNRAY_LIGHT_SAMPLER_H
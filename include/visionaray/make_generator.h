@@ -6,18 +6,24 @@
 #ifndef VSNRAY_MAKE_GENERATOR_H
 #define VSNRAY_MAKE_GENERATOR_H 1
 
+#include <type_traits>
 #include <utility>
 
 #include "detail/macros.h"
+#include "blue_noise_generator.h"
+#include "halton_generator.h"
+#include "make_random_seed.h"
+#include "pcg_generator.h"
 #include "pixel_sampler_types.h"
 #include "random_generator.h"
+#include "sobol_generator.h"
 
 namespace visionaray
 {
 namespace detail
 {
 
-template <typename T, typename U>
+template <typename T, typename U, template <typename...> class Generator = random_generator>
 struct make_generator_impl
 {
     struct void_t
@@ -33,17 +39,41 @@ struct make_generator_impl
     using generator_type = void_t;
 };
 
-template <typename T, typename U>
-struct make_generator_impl<T, pixel_sampler::basic_jittered_blend_type<U>>
+template <typename T, typename U, template <typename...> class Generator>
+struct make_generator_impl<T, pixel_sampler::basic_jittered_blend_type<U>, Generator>
 {
-    using generator_type = random_generator<T>;
+    using generator_type = Generator<T>;
+};
+
+// Low-discrepancy samplers determine the generator type
+
+template <typename T, typename U, template <typename...> class Generator>
+struct make_generator_impl<T, pixel_sampler::basic_sobol_blend_type<U>, Generator>
+{
+    using generator_type = sobol_generator<T>;
+};
+
+template <typename T, typename U, template <typename...> class Generator>
+struct make_generator_impl<T, pixel_sampler::basic_halton_blend_type<U>, Generator>
+{
+    using generator_type = halton_generator<T>;
+};
+
+template <typename T, typename U, template <typename...> class Generator>
+struct make_generator_impl<T, pixel_sampler::basic_blue_noise_blend_type<U>, Generator>
+{
+    using generator_type = blue_noise_generator<T>;
 };
 
 } // detail
 
 
 //-------------------------------------------------------------------------------------------------
-// Factory function for number generators
+// Factory functions for number generators
+//
+// The generator type can be selected explicitly, e.g.:
+//   auto gen = make_generator<pcg_generator>(S{}, sample_params, seed);
+// The default is random_generator<T>.
 //
 
 template <typename T, typename PixelSampler, typename ...Args>
@@ -56,6 +86,91 @@ auto make_generator(T /* */, PixelSampler /* */, Args&&... args)
             );
 }
 
+template <
+    template <typename...> class Generator,
+    typename T,
+    typename PixelSampler,
+    typename ...Args
+    >
+VSNRAY_FUNC
+auto make_generator(T /* */, PixelSampler /* */, Args&&... args)
+    -> typename detail::make_generator_impl<T, PixelSampler, Generator>::generator_type
+{
+    return typename detail::make_generator_impl<T, PixelSampler, Generator>::generator_type(
+            std::forward<Args>(args)...
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Make the generator for a pixel (or a packet of pixels) in a given frame
+//
+// Used by the schedulers. Pseudo-random generators are seeded with a hash over pixel
+// index and frame_id. Low-discrepancy generators are seeded with a hash over the pixel
+// index only, the frame_id instead selects the first sample of the sequence, so that
+// successive frames continue the same sequence.
+//
+
+namespace detail
+{
+
+template <typename T, typename PixelSampler, typename I>
+VSNRAY_FUNC
+inline auto make_pixel_generator(
+        T                   /* */,
+        PixelSampler const& ps,
+        I const&            x,
+        I const&            y,
+        int                 width,
+        unsigned            frame_id,
+        std::false_type     /* low discrepancy */
+        )
+    -> typename make_generator_impl<T, PixelSampler>::generator_type
+{
+    return make_generator(T{}, ps, make_random_seed(y * width + x, I(frame_id)));
+}
+
+template <typename T, typename PixelSampler, typename I>
+VSNRAY_FUNC
+inline auto make_pixel_generator(
+        T                   /* */,
+        PixelSampler const& ps,
+        I const&            x,
+        I const&            y,
+        int                 width,
+        unsigned            frame_id,
+        std::true_type      /* low discrepancy */
+        )
+    -> typename make_generator_impl<T, PixelSampler>::generator_type
+{
+    return make_generator(T{}, ps, make_random_seed(y * width + x, I(0)), x, y, frame_id * ps.spp);
+}
+
+} // detail
+
+template <typename T, typename PixelSampler, typename I>
+VSNRAY_FUNC
+inline auto make_pixel_generator(
+        T                   /* */,
+        PixelSampler const& ps,
+        I const&            x,
+        I const&            y,
+        int                 width,
+        unsigned            frame_id
+        )
+    -> typename detail::make_generator_impl<T, PixelSampler>::generator_type
+{
+    return detail::make_pixel_generator(
+            T{},
+            ps,
+            x,
+            y,
+            width,
+            frame_id,
+            typename pixel_sampler::is_low_discrepancy<PixelSampler>::type{}
+            );
+}
+
 } // visionaray
 
 #endif // VSNRAY_MAKE_GENERATOR_H
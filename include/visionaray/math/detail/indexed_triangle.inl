@@ -0,0 +1,77 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include "../aabb.h"
+
+namespace MATH_NAMESPACE
+{
+
+//-------------------------------------------------------------------------------------------------
+// Indexed triangle members
+//
+
+template <typename T, typename P>
+MATH_FUNC
+basic_indexed_triangle<T, P>::basic_indexed_triangle(unsigned i1, unsigned i2, unsigned i3)
+    : i1(i1)
+    , i2(i2)
+    , i3(i3)
+{
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Geometric functions
+//
+
+template <typename T, typename P>
+MATH_FUNC
+inline T area(basic_indexed_triangle<T, P> const& t, vector<3, T> const* vertices)
+{
+    vector<3, T> v1 = vertices[t.i1];
+    vector<3, T> v2 = vertices[t.i2];
+    vector<3, T> v3 = vertices[t.i3];
+
+    return T(0.5) * length(cross(v2 - v1, v3 - v1));
+}
+
+template <typename T, typename P>
+MATH_FUNC
+inline basic_aabb<T> get_bounds(basic_indexed_triangle<T, P> const& t, vector<3, T> const* vertices)
+{
+    basic_aabb<T> bounds;
+
+    bounds.invalidate();
+    bounds.insert(vertices[t.i1]);
+    bounds.insert(vertices[t.i2]);
+    bounds.insert(vertices[t.i3]);
+
+    return bounds;
+}
+
+template <typename T, typename P, typename Generator, typename U = typename Generator::value_type>
+MATH_FUNC
+inline vector<3, U> sample_surface(
+        basic_indexed_triangle<T, P> const& t,
+        vector<3, T> const*                 vertices,
+        Generator&                          gen
+        )
+{
+    U u1 = gen.next();
+    U u2 = gen.next();
+
+    vector<3, U> v1(vertices[t.i1]);
+    vector<3, U> v2(vertices[t.i2]);
+    vector<3, U> v3(vertices[t.i3]);
+
+    return v1 * (U(1.0) - sqrt(u1)) + v2 * sqrt(u1) * (U(1.0) - u2) + v3 * sqrt(u1) * u2;
+}
+
+template <typename T, typename P>
+MATH_FUNC
+inline array<vector<3, T>, 3> compute_vertices(basic_indexed_triangle<T, P> const& t, vector<3, T> const* vertices)
+{
+    return {{ vertices[t.i1], vertices[t.i2], vertices[t.i3] }};
+}
+
+} // MATH_NAMESPACE
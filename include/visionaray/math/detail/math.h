@@ -527,6 +527,28 @@ inline T lerp(T const& a, T const& b, T const& c, S const& u, S const& v)
     return s1 + s2 + s3;
 }
 
+// Interpolate between K keyframes that are evenly spaced over [0,1]. key(k) returns the
+// k-th keyframe, V is the type of the result. Each SIMD lane of x interpolates between
+// its own pair of keyframes.
+template <size_t K, typename V, typename S, typename Key>
+MATH_FUNC
+inline V lerp_keyframes(Key key, S const& x)
+{
+    static_assert(K >= 2, "At least two keyframes required");
+
+    S t = clamp(x, S(0.0), S(1.0)) * S(K - 1);
+
+    V result = lerp(V(key(0)), V(key(1)), t);
+
+    for (size_t k = 1; k < K - 1; ++k)
+    {
+        S f = t - S(k);
+        result = select(f >= S(0.0), lerp(V(key(k)), V(key(k + 1)), f), result);
+    }
+
+    return result;
+}
+
 template <typename T>
 MATH_FUNC
 inline T step(T const& edge, T const& x)
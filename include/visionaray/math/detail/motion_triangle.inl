@@ -0,0 +1,93 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include "../aabb.h"
+
+namespace MATH_NAMESPACE
+{
+
+//-------------------------------------------------------------------------------------------------
+// Motion triangle members
+//
+
+template <size_t K, typename T, typename P>
+MATH_FUNC
+basic_motion_triangle<K, T, P>::basic_motion_triangle(basic_triangle<3, T, P> const* keyframes)
+{
+    for (size_t k = 0; k < K; ++k)
+    {
+        v1[k] = keyframes[k].v1;
+        e1[k] = keyframes[k].e1;
+        e2[k] = keyframes[k].e2;
+    }
+
+    this->prim_id = keyframes[0].prim_id;
+    this->geom_id = keyframes[0].geom_id;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Get the triangle at keyframe k, or interpolated for time
+//
+
+template <size_t K, typename T, typename P>
+MATH_FUNC
+inline basic_triangle<3, T, P> get_keyframe(basic_motion_triangle<K, T, P> const& t, size_t k)
+{
+    basic_triangle<3, T, P> result(t.v1[k], t.e1[k], t.e2[k]);
+
+    result.prim_id = t.prim_id;
+    result.geom_id = t.geom_id;
+
+    return result;
+}
+
+template <size_t K, typename T, typename P>
+MATH_FUNC
+inline basic_triangle<3, T, P> get_triangle(basic_motion_triangle<K, T, P> const& t, T const& time)
+{
+    using V = vector<3, T>;
+
+    basic_triangle<3, T, P> result(
+            lerp_keyframes<K, V>([&](size_t k) { return t.v1[k]; }, time),
+            lerp_keyframes<K, V>([&](size_t k) { return t.e1[k]; }, time),
+            lerp_keyframes<K, V>([&](size_t k) { return t.e2[k]; }, time)
+            );
+
+    result.prim_id = t.prim_id;
+    result.geom_id = t.geom_id;
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Geometric functions
+//
+
+// Bounds over the whole shutter interval
+template <size_t K, typename T, typename P>
+MATH_FUNC
+inline basic_aabb<T> get_bounds(basic_motion_triangle<K, T, P> const& t)
+{
+    basic_aabb<T> bounds;
+
+    bounds.invalidate();
+
+    for (size_t k = 0; k < K; ++k)
+    {
+        bounds.insert(get_bounds(get_keyframe(t, k)));
+    }
+
+    return bounds;
+}
+
+// Bounds at keyframe k
+template <size_t K, typename T, typename P>
+MATH_FUNC
+inline basic_aabb<T> get_bounds(basic_motion_triangle<K, T, P> const& t, size_t k)
+{
+    return get_bounds(get_keyframe(t, k));
+}
+
+} // MATH_NAMESPACE
@@ -0,0 +1,75 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include "../aabb.h"
+
+namespace MATH_NAMESPACE
+{
+
+//-------------------------------------------------------------------------------------------------
+// Multi-triangle members
+//
+
+template <size_t N, typename T, typename P>
+MATH_FUNC
+basic_multi_triangle<N, T, P>::basic_multi_triangle(basic_triangle<3, T, P> const* triangles, size_t count)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        auto const& t = triangles[i < count ? i : count - 1];
+
+        for (int a = 0; a < 3; ++a)
+        {
+            v1[a][i] = t.v1[a];
+            e1[a][i] = t.e1[a];
+            e2[a][i] = t.e2[a];
+        }
+
+        prim_id[i] = t.prim_id;
+        geom_id[i] = t.geom_id;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Get the i-th triangle
+//
+
+template <size_t N, typename T, typename P>
+MATH_FUNC
+inline basic_triangle<3, T, P> get_triangle(basic_multi_triangle<N, T, P> const& t, size_t i)
+{
+    basic_triangle<3, T, P> result(
+            vector<3, T>(t.v1[0][i], t.v1[1][i], t.v1[2][i]),
+            vector<3, T>(t.e1[0][i], t.e1[1][i], t.e1[2][i]),
+            vector<3, T>(t.e2[0][i], t.e2[1][i], t.e2[2][i])
+            );
+
+    result.prim_id = t.prim_id[i];
+    result.geom_id = t.geom_id[i];
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Geometric functions
+//
+
+template <size_t N, typename T, typename P>
+MATH_FUNC
+inline basic_aabb<T> get_bounds(basic_multi_triangle<N, T, P> const& t)
+{
+    basic_aabb<T> bounds;
+
+    bounds.invalidate();
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        bounds.insert(get_bounds(get_triangle(t, i)));
+    }
+
+    return bounds;
+}
+
+} // MATH_NAMESPACE
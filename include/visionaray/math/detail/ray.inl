@@ -39,6 +39,62 @@ inline basic_ray<T>::basic_ray(
 {
 }
 
+template <typename T>
+MATH_FUNC
+inline basic_motion_ray<T>::basic_motion_ray(vector<3, T> const& o, vector<3, T> const& d)
+    : basic_ray<T>(o, d)
+    , time(T(0.0))
+{
+}
+
+template <typename T>
+MATH_FUNC
+inline basic_motion_ray<T>::basic_motion_ray(
+        vector<3, T> const& o,
+        vector<3, T> const& d,
+        T const& tmin,
+        T const& tmax,
+        T const& time
+        )
+    : basic_ray<T>(o, d, tmin, tmax)
+    , time(time)
+{
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Time sample of a ray
+//
+
+template <typename T>
+MATH_FUNC
+inline T get_time(basic_ray<T> const& /* */)
+{
+    return T(0.0);
+}
+
+template <typename T>
+MATH_FUNC
+inline T get_time(basic_motion_ray<T> const& ray)
+{
+    return ray.time;
+}
+
+// Copy the time sample of src to dst, e.g. to secondary rays, no-op for rays without time
+
+template <typename T>
+MATH_FUNC
+inline void copy_ray_time(basic_ray<T>& /* dst */, basic_ray<T> const& /* src */)
+{
+}
+
+template <typename T>
+MATH_FUNC
+inline void copy_ray_time(basic_motion_ray<T>& dst, basic_motion_ray<T> const& src)
+{
+    dst.time = src.time;
+}
+
 
 namespace simd
 {
@@ -49,12 +49,24 @@ class basic_aabb;
 template <typename T>
 class basic_ray;
 
+template <typename T>
+class basic_motion_ray;
+
 template <typename T, typename P = unsigned>
 class basic_sphere;
 
 template <size_t Dim, typename T, typename P = unsigned>
 class basic_triangle;
 
+template <typename T, typename P = unsigned>
+class basic_indexed_triangle;
+
+template <size_t N, typename T, typename P = unsigned>
+class basic_multi_triangle;
+
+template <size_t K, typename T, typename P = unsigned>
+class basic_motion_triangle;
+
 template <typename Layout, typename T>
 class rectangle;
 
@@ -134,6 +146,11 @@ typedef basic_aabb<float>                      aabb;
 
 
 typedef basic_ray<float>                       ray;
+typedef basic_motion_ray<float>                motion_ray;
+
+
+typedef basic_multi_triangle<4, float>         triangle4;
+typedef basic_multi_triangle<8, float>         triangle8;
 
 
 typedef rectangle<xywh_layout<int>, int>       recti;
@@ -0,0 +1,46 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_MATH_INDEXED_TRIANGLE_H
+#define VSNRAY_MATH_INDEXED_TRIANGLE_H 1
+
+#include "primitive.h"
+#include "vector.h"
+
+namespace MATH_NAMESPACE
+{
+
+//-------------------------------------------------------------------------------------------------
+// Triangle that references its vertices in a vertex array shared with other triangles
+//
+// The three 32-bit indices also address per-vertex attributes (shading normals, texture
+// coordinates, colors) in arrays that are laid out parallel to the vertex array. The
+// triangle does not store the vertex array, functions that need the vertex positions
+// take it as an argument. BVH traversal gets it from indexed_triangle_intersector.
+//
+
+template <typename T, typename P>
+class basic_indexed_triangle : public primitive<P>
+{
+public:
+
+    using scalar_type =  T;
+    using vec_type    =  vector<3, T>;
+
+public:
+
+    basic_indexed_triangle() = default;
+    MATH_FUNC basic_indexed_triangle(unsigned i1, unsigned i2, unsigned i3);
+
+    unsigned i1;
+    unsigned i2;
+    unsigned i3;
+};
+
+} // MATH_NAMESPACE
+
+#include "detail/indexed_triangle.inl"
+
+#endif // VSNRAY_MATH_INDEXED_TRIANGLE_H
@@ -11,7 +11,10 @@
 #include "simd/type_traits.h"
 #include "aabb.h"
 #include "config.h"
+#include "indexed_triangle.h"
 #include "limits.h"
+#include "motion_triangle.h"
+#include "multi_triangle.h"
 #include "plane.h"
 #include "ray.h"
 #include "sphere.h"
@@ -156,6 +159,204 @@ inline hit_record<R, primitive<unsigned>> intersect(R const& ray, basic_triangle
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// ray / indexed triangle
+//
+
+template <typename R, typename U>
+MATH_FUNC
+inline hit_record<R, primitive<unsigned>> intersect(
+        R const&                                    ray,
+        basic_indexed_triangle<U, unsigned> const&  tri,
+        vector<3, U> const*                         vertices
+        )
+{
+    vector<3, U> v1 = vertices[tri.i1];
+    vector<3, U> v2 = vertices[tri.i2];
+    vector<3, U> v3 = vertices[tri.i3];
+
+    basic_triangle<3, U, unsigned> t(v1, v2 - v1, v3 - v1);
+    t.prim_id = tri.prim_id;
+    t.geom_id = tri.geom_id;
+
+    return intersect(ray, t);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// ray / multi triangle
+//
+// Returns the closest hit with tmin <= t <= tmax over all N triangles. SIMD rays and
+// double precision rays test the triangles one after another, single precision rays
+// test them in one N-wide SIMD test. Only the closest hit is reported, so BVH traversal
+// rejects multi-hit queries on multi triangles at compile time. Multi triangles in
+// arrays are not necessarily aligned to the SIMD width, the lanes are loaded unaligned
+//
+
+namespace detail
+{
+
+template <typename R, size_t N, typename U>
+MATH_FUNC
+inline hit_record<R, primitive<unsigned>> intersect_lanes(
+        R const&                                    ray,
+        basic_multi_triangle<N, U, unsigned> const& tri
+        )
+{
+    using T = typename R::scalar_type;
+
+    hit_record<R, primitive<unsigned>> result;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        auto hr = intersect(ray, get_triangle(tri, i));
+
+        auto closer = hr.hit && hr.t >= ray.tmin && hr.t <= ray.tmax && hr.t < result.t;
+
+        result.hit    |= closer;
+        result.t       = select( closer, hr.t, result.t );
+        result.prim_id = select( closer, hr.prim_id, result.prim_id );
+        result.geom_id = select( closer, hr.geom_id, result.geom_id );
+        result.u       = select( closer, hr.u, result.u );
+        result.v       = select( closer, hr.v, result.v );
+    }
+
+    result.t = select( result.hit, result.t, T(-1.0) );
+
+    return result;
+}
+
+} // detail
+
+template <typename R, size_t N, typename U>
+MATH_FUNC
+inline hit_record<R, primitive<unsigned>> intersect(R const& ray, basic_multi_triangle<N, U, unsigned> const& tri)
+{
+    return detail::intersect_lanes(ray, tri);
+}
+
+template <size_t N>
+MATH_FUNC
+inline hit_record<basic_ray<float>, primitive<unsigned>> intersect(
+        basic_ray<float> const&                         ray,
+        basic_multi_triangle<N, float, unsigned> const& tri
+        )
+{
+#ifdef __CUDA_ARCH__
+    return detail::intersect_lanes(ray, tri);
+#else
+    using F = simd::float_from_simd_width_t<N>;
+    using M = simd::mask_type_t<F>;
+    using vec_type = vector<3, F>;
+
+    hit_record<basic_ray<float>, primitive<unsigned>> result;
+    result.t = -1.0f;
+
+    vec_type v1(
+            simd::load_unaligned<F>(tri.v1[0]),
+            simd::load_unaligned<F>(tri.v1[1]),
+            simd::load_unaligned<F>(tri.v1[2])
+            );
+
+    vec_type e1(
+            simd::load_unaligned<F>(tri.e1[0]),
+            simd::load_unaligned<F>(tri.e1[1]),
+            simd::load_unaligned<F>(tri.e1[2])
+            );
+
+    vec_type e2(
+            simd::load_unaligned<F>(tri.e2[0]),
+            simd::load_unaligned<F>(tri.e2[1]),
+            simd::load_unaligned<F>(tri.e2[2])
+            );
+
+    vec_type ori(ray.ori);
+    vec_type dir(ray.dir);
+
+    vec_type s1 = cross(dir, e2);
+    F div = dot(s1, e1);
+
+    M hit = ( div != F(0.0) );
+
+    F inv_div = F(1.0) / div;
+
+    vec_type d = ori - v1;
+    F b1 = dot(d, s1) * inv_div;
+
+    hit &= ( b1 >= F(0.0) && b1 <= F(1.0) );
+
+    vec_type s2 = cross(d, e1);
+    F b2 = dot(dir, s2) * inv_div;
+
+    hit &= ( b2 >= F(0.0) && b1 + b2 <= F(1.0) );
+
+    F t = dot(e2, s2) * inv_div;
+
+    hit &= ( t >= F(ray.tmin) && t <= F(ray.tmax) );
+
+    if ( !any(hit) )
+    {
+        return result;
+    }
+
+    // Horizontal min over the lanes that were hit
+    simd::aligned_array_t<F> ts;
+    simd::aligned_array_t<F> us;
+    simd::aligned_array_t<F> vs;
+
+    store(ts, select(hit, t, F(numeric_limits<float>::max())));
+    store(us, b1);
+    store(vs, b2);
+
+    size_t closest = 0;
+
+    for (size_t i = 1; i < N; ++i)
+    {
+        if (ts[i] < ts[closest])
+        {
+            closest = i;
+        }
+    }
+
+    result.hit = true;
+    result.prim_id = tri.prim_id[closest];
+    result.geom_id = tri.geom_id[closest];
+    result.t = ts[closest];
+    result.u = us[closest];
+    result.v = vs[closest];
+    return result;
+#endif
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// ray / motion triangle
+//
+// The triangle is interpolated for the time sample of the ray, rays without a time
+// sample are intersected with the first keyframe
+//
+
+template <typename R, size_t K, typename U>
+MATH_FUNC
+inline hit_record<R, primitive<unsigned>> intersect(R const& ray, basic_motion_triangle<K, U, unsigned> const& tri)
+{
+    using T = typename R::scalar_type;
+    using V = vector<3, T>;
+
+    T time = get_time(ray);
+
+    basic_triangle<3, T, unsigned> t(
+            lerp_keyframes<K, V>([&](size_t k) { return tri.v1[k]; }, time),
+            lerp_keyframes<K, V>([&](size_t k) { return tri.e1[k]; }, time),
+            lerp_keyframes<K, V>([&](size_t k) { return tri.e2[k]; }, time)
+            );
+    t.prim_id = tri.prim_id;
+    t.geom_id = tri.geom_id;
+
+    return intersect(ray, t);
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // ray / sphere
 //
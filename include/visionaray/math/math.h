@@ -14,10 +14,13 @@
 #include "constants.h"
 #include "coordinates.h"
 #include "fixed.h"
+#include "indexed_triangle.h"
 #include "intersect.h"
 #include "io.h"
 #include "limits.h"
 #include "matrix.h"
+#include "motion_triangle.h"
+#include "multi_triangle.h"
 #include "norm.h"
 #include "plane.h"
 #include "primitive.h"
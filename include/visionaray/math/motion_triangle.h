@@ -0,0 +1,50 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_MATH_MOTION_TRIANGLE_H
+#define VSNRAY_MATH_MOTION_TRIANGLE_H 1
+
+#include <cstddef>
+
+#include "config.h"
+#include "triangle.h"
+#include "vector.h"
+
+namespace MATH_NAMESPACE
+{
+
+//-------------------------------------------------------------------------------------------------
+// Triangle with K keyframes that are evenly spaced over the shutter interval
+//
+// Vertices move linearly between keyframes. Rays are intersected with the triangle
+// interpolated for their time sample (see basic_motion_ray).
+//
+
+template <size_t K, typename T, typename P>
+class basic_motion_triangle : public primitive<P>
+{
+public:
+
+    using scalar_type = T;
+
+    enum { Keyframes = K };
+
+public:
+
+    basic_motion_triangle() = default;
+
+    // Triangle from K keyframes, ids are taken from the first keyframe
+    MATH_FUNC explicit basic_motion_triangle(basic_triangle<3, T, P> const* keyframes);
+
+    vector<3, T> v1[K];
+    vector<3, T> e1[K];
+    vector<3, T> e2[K];
+};
+
+} // MATH_NAMESPACE
+
+#include "detail/motion_triangle.inl"
+
+#endif // VSNRAY_MATH_MOTION_TRIANGLE_H
@@ -0,0 +1,52 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_MATH_MULTI_TRIANGLE_H
+#define VSNRAY_MATH_MULTI_TRIANGLE_H 1
+
+#include <cstddef>
+
+#include "config.h"
+#include "triangle.h"
+
+namespace MATH_NAMESPACE
+{
+
+//-------------------------------------------------------------------------------------------------
+// N triangles in SoA layout, intersected with a single ray in one N-wide SIMD test
+//
+// Used as BVH leaf primitive. Triangles are stored as v1, e1 and e2 like basic_triangle,
+// with the N values of each component in a row. Unused slots repeat the last triangle.
+//
+
+template <size_t N, typename T, typename P>
+class basic_multi_triangle
+{
+public:
+
+    using scalar_type = T;
+
+    enum { Width = N };
+
+public:
+
+    basic_multi_triangle() = default;
+
+    // Pack count triangles, 1 <= count <= N
+    MATH_FUNC basic_multi_triangle(basic_triangle<3, T, P> const* triangles, size_t count);
+
+    T v1[3][N];
+    T e1[3][N];
+    T e2[3][N];
+
+    P prim_id[N];
+    P geom_id[N];
+};
+
+} // MATH_NAMESPACE
+
+#include "detail/multi_triangle.inl"
+
+#endif // VSNRAY_MATH_MULTI_TRIANGLE_H
@@ -44,6 +44,39 @@ public:
 
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// Ray with a time sample, used to render motion blur
+//
+// time is relative to the shutter interval: 0 is shutter open, 1 is shutter close.
+// Keyframed primitives, motion BVHs and motion instances interpolate their keyframes
+// for this time. Rays without a time sample see the scene at shutter open.
+//
+
+template <typename T>
+class basic_motion_ray : public basic_ray<T>
+{
+public:
+
+    T time;
+
+    basic_motion_ray() = default;
+
+    // Constructor with origin and direction, tmin is 0.0, tmax is
+    // numeric_limits::max<T>, and time is 0.0
+    MATH_FUNC basic_motion_ray(vector<3, T> const& o, vector<3, T> const& d);
+
+    // Constructor with origin, direction, tmin, tmax, and time
+    MATH_FUNC basic_motion_ray(
+            vector<3, T> const& o,
+            vector<3, T> const& d,
+            T const& tmin,
+            T const& tmax,
+            T const& time = T(0.0)
+            );
+
+};
+
 } // MATH_NAMESPACE
 
 #include "detail/ray.inl"
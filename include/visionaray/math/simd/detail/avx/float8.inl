@@ -2,6 +2,7 @@
 // See the LICENSE file for details.
 
 #include <cmath>
+#include <type_traits>
 
 namespace MATH_NAMESPACE
 {
@@ -86,6 +87,16 @@ VSNRAY_FORCE_INLINE float8 select(mask8 const& m, float8 const& a, float8 const&
 // Load / store
 //
 
+// Unaligned load, the vector type is passed as template argument, e.g.
+// load_unaligned<float8>(src). A float8 load(float const*) would clash with float4's
+template <typename F>
+VSNRAY_FORCE_INLINE typename std::enable_if<std::is_same<F, float8>::value, float8>::type load_unaligned(
+        float const src[8]
+        )
+{
+    return _mm256_loadu_ps(src);
+}
+
 VSNRAY_FORCE_INLINE void store(float dst[8], float8 const& v)
 {
     _mm256_store_ps(dst, v);
@@ -2,6 +2,7 @@
 // See the LICENSE file for details.
 
 #include <cmath>
+#include <type_traits>
 
 namespace MATH_NAMESPACE
 {
@@ -81,6 +82,15 @@ VSNRAY_FORCE_INLINE float16 select(mask16 const& m, float16 const& a, float16 co
 // Load / store
 //
 
+// Unaligned load, the vector type is passed as template argument
+template <typename F>
+VSNRAY_FORCE_INLINE typename std::enable_if<std::is_same<F, float16>::value, float16>::type load_unaligned(
+        float const src[16]
+        )
+{
+    return _mm512_loadu_ps(src);
+}
+
 VSNRAY_FORCE_INLINE void store(float dst[16], float16 const& v)
 {
     _mm512_store_ps(dst, v);
@@ -1,6 +1,8 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <type_traits>
+
 #include "../../../detail/math.h"
 
 namespace MATH_NAMESPACE
@@ -128,6 +130,16 @@ VSNRAY_FORCE_INLINE float16 select(mask16 const& m, float16 const& a, float16 co
 //        );
 //}
 
+// Unaligned load, the vector type is passed as template argument
+template <typename F>
+MATH_FUNC
+VSNRAY_FORCE_INLINE typename std::enable_if<std::is_same<F, float16>::value, float16>::type load_unaligned(
+        float const src[16]
+        )
+{
+    return float16(src);
+}
+
 MATH_FUNC
 VSNRAY_FORCE_INLINE void store(float dst[16], float16 const& v)
 {
@@ -1,6 +1,8 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <type_traits>
+
 #include "../../../detail/math.h"
 
 namespace MATH_NAMESPACE
@@ -84,6 +86,16 @@ VSNRAY_FORCE_INLINE float4 select(mask4 const& m, float4 const& a, float4 const&
 //    return float4(src[0], src[1], src[2], src[3]);
 //}
 
+// Unaligned load, the vector type is passed as template argument
+template <typename F>
+MATH_FUNC
+VSNRAY_FORCE_INLINE typename std::enable_if<std::is_same<F, float4>::value, float4>::type load_unaligned(
+        float const src[4]
+        )
+{
+    return float4(src);
+}
+
 MATH_FUNC
 VSNRAY_FORCE_INLINE void store(float dst[4], float4 const& v)
 {
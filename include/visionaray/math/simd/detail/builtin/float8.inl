@@ -1,6 +1,8 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <type_traits>
+
 #include "../../../detail/math.h"
 
 namespace MATH_NAMESPACE
@@ -101,6 +103,16 @@ VSNRAY_FORCE_INLINE float8 select(mask8 const& m, float8 const& a, float8 const&
 //    return float8(src[0], src[1], src[2], src[3], src[4], src[5], src[6], src[7]);
 //}
 
+// Unaligned load, the vector type is passed as template argument
+template <typename F>
+MATH_FUNC
+VSNRAY_FORCE_INLINE typename std::enable_if<std::is_same<F, float8>::value, float8>::type load_unaligned(
+        float const src[8]
+        )
+{
+    return float8(src);
+}
+
 MATH_FUNC
 VSNRAY_FORCE_INLINE void store(float dst[8], float8 const& v)
 {
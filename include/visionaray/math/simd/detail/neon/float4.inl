@@ -2,6 +2,7 @@
 // See the LICENSE file for details.
 
 #include <cmath>
+#include <type_traits>
 
 namespace MATH_NAMESPACE
 {
@@ -84,6 +85,15 @@ VSNRAY_FORCE_INLINE float4 load(float const src[4])
     return vld1q_f32(src);
 }
 
+// Unaligned load, the vector type is passed as template argument
+template <typename F>
+VSNRAY_FORCE_INLINE typename std::enable_if<std::is_same<F, float4>::value, float4>::type load_unaligned(
+        float const src[4]
+        )
+{
+    return vld1q_f32(src);
+}
+
 VSNRAY_FORCE_INLINE void store(float dst[4], float4 const& v)
 {
     vst1q_f32(dst, v);
@@ -2,6 +2,7 @@
 // See the LICENSE file for details.
 
 #include <cmath>
+#include <type_traits>
 
 namespace MATH_NAMESPACE
 {
@@ -91,6 +92,16 @@ VSNRAY_FORCE_INLINE float4 load_unaligned(float const src[4])
     return _mm_loadu_ps(src);
 }
 
+// Same as load_unaligned(), with the vector type as template argument so that generic
+// code can load vectors of any width, e.g. load_unaligned<F>(src)
+template <typename F>
+VSNRAY_FORCE_INLINE typename std::enable_if<std::is_same<F, float4>::value, float4>::type load_unaligned(
+        float const src[4]
+        )
+{
+    return _mm_loadu_ps(src);
+}
+
 VSNRAY_FORCE_INLINE void store(float dst[4], float4 const& v)
 {
     _mm_store_ps(dst, v);
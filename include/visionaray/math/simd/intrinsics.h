@@ -94,6 +94,11 @@
 #endif
 #endif
 
+// Use faster, less accurate approximations for trigonometric functions?
+#ifndef VSNRAY_SIMD_FAST_TRANS
+#define VSNRAY_SIMD_FAST_TRANS 0
+#endif
+
 //-------------------------------------------------------------------------------------------------
 // Macros to identify SIMD isa availability
 //
@@ -0,0 +1,148 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_PCG_GENERATOR_H
+#define VSNRAY_PCG_GENERATOR_H 1
+
+#include <type_traits>
+
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+#include "array.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Permuted congruential generator (M. E. O'Neill: PCG: A Family of Simple Fast
+// Space-Efficient Statistically Good Algorithms for Random Number Generation)
+//
+// 32-bit LCG state, the output permutation is a fixed-shift xorshift-multiply hash
+// (C. Wellons' lowbias32) instead of PCG's random shifts, so that all lanes of a SIMD
+// vector can be permuted with the same (constant) shift amounts. Generates floats in
+// [0..1) with 24 bits of randomness.
+//
+// The SIMD specialization steps all lanes at once, lane i produces the same sequence
+// as a scalar pcg_generator seeded with seed[i].
+//
+
+namespace detail
+{
+
+// LCG multiplier and increment (from PCG's 32-bit LCG)
+static const unsigned pcg_mult = 747796405u;
+static const unsigned pcg_inc  = 2891336453u;
+
+} // detail
+
+template <typename T, typename = void>
+class pcg_generator
+{
+public:
+
+    using value_type = T;
+
+public:
+
+    pcg_generator() = default;
+
+    VSNRAY_FUNC pcg_generator(unsigned seed)
+        : state_(seed)
+    {
+        // Decorrelate similar seeds
+        next_uint();
+    }
+
+    VSNRAY_FUNC T next()
+    {
+        return T(next_uint() >> 8) * T(1.0f / 16777216.0f);
+    }
+
+    VSNRAY_FUNC unsigned next_uint()
+    {
+        state_ = state_ * detail::pcg_mult + detail::pcg_inc;
+
+        unsigned x = state_;
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+private:
+
+    unsigned state_ = 0;
+
+};
+
+template <typename T>
+class pcg_generator<T, typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+{
+public:
+
+    using value_type = T;
+    using int_type = simd::int_type_t<T>;
+
+    enum { Size = simd::num_elements<T>::value };
+
+public:
+
+    // Scalar generator that steps a single lane
+    typedef pcg_generator<float> generator_type;
+
+    pcg_generator() = default;
+
+    VSNRAY_FUNC pcg_generator(array<unsigned, Size> const& seed)
+    {
+        for (int i = 0; i < Size; ++i)
+        {
+            generators_[i] = generator_type(seed[i]);
+        }
+    }
+
+    VSNRAY_FUNC value_type next()
+    {
+        return convert_to_float((next_uint() >> 8) & int_type(0x00FFFFFF)) * value_type(1.0f / 16777216.0f);
+    }
+
+    VSNRAY_FUNC int_type next_uint()
+    {
+        // The scalar generators only consist of their state, so
+        // the states of all lanes are contiguous in memory
+        static_assert(sizeof(generators_) == sizeof(int) * Size, "Size mismatch");
+
+        auto state_ptr = reinterpret_cast<int*>(generators_.data());
+
+        int_type state(state_ptr);
+        state = state * int_type(static_cast<int>(detail::pcg_mult)) + int_type(static_cast<int>(detail::pcg_inc));
+        store(state_ptr, state);
+
+        // Mask after right shifts, on some ISAs these are arithmetic shifts
+        int_type x = state;
+        x = x ^ ((x >> 16) & int_type(0x0000FFFF));
+        x = x * int_type(static_cast<int>(0x7FEB352Du));
+        x = x ^ ((x >> 15) & int_type(0x0001FFFF));
+        x = x * int_type(static_cast<int>(0x846CA68Bu));
+        x = x ^ ((x >> 16) & int_type(0x0000FFFF));
+        return x;
+    }
+
+    VSNRAY_FUNC generator_type& get_generator(unsigned i)
+    {
+        return generators_[i];
+    }
+
+private:
+
+    // Aligned so that all lanes can be loaded at once
+    VSNRAY_ALIGN(64) array<generator_type, Size> generators_;
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_PCG_GENERATOR_H
@@ -6,6 +6,8 @@
 #ifndef VSNRAY_PIXEL_SAMPLER_TYPES_H
 #define VSNRAY_PIXEL_SAMPLER_TYPES_H 1
 
+#include <type_traits>
+
 namespace visionaray
 {
 
@@ -41,6 +43,46 @@ struct basic_jittered_blend_type : base_type
 
 using jittered_blend_type = basic_jittered_blend_type<float>;
 
+// Low-discrepancy samplers with successive blending. Like jittered_blend_type,
+// but samples are drawn from sequences indexed by sample number and frame
+
+// Owen-scrambled Sobol sequence, scrambled per pixel
+template <typename T>
+struct basic_sobol_blend_type : basic_jittered_blend_type<T>
+{
+};
+
+// Halton sequence, randomly shifted per pixel
+template <typename T>
+struct basic_halton_blend_type : basic_jittered_blend_type<T>
+{
+};
+
+// Tiled blue-noise mask, shifted per frame
+template <typename T>
+struct basic_blue_noise_blend_type : basic_jittered_blend_type<T>
+{
+};
+
+using sobol_blend_type      = basic_sobol_blend_type<float>;
+using halton_blend_type     = basic_halton_blend_type<float>;
+using blue_noise_blend_type = basic_blue_noise_blend_type<float>;
+
+
+// Traits -------------------------------------------------
+
+template <typename T>
+struct is_low_discrepancy : std::false_type {};
+
+template <typename T>
+struct is_low_discrepancy<basic_sobol_blend_type<T>> : std::true_type {};
+
+template <typename T>
+struct is_low_discrepancy<basic_halton_blend_type<T>> : std::true_type {};
+
+template <typename T>
+struct is_low_discrepancy<basic_blue_noise_blend_type<T>> : std::true_type {};
+
 } // pixel_sampler
 } // visionaray
 
@@ -8,6 +8,9 @@
 
 #include <cstddef>
 
+#include "math/indexed_triangle.h"
+#include "math/motion_triangle.h"
+#include "math/multi_triangle.h"
 #include "math/plane.h"
 #include "math/sphere.h"
 #include "math/triangle.h"
@@ -75,6 +78,24 @@ struct scalar_type<basic_triangle<Dim, T, P>>
     using type = T;
 };
 
+template <typename T, typename P>
+struct scalar_type<basic_indexed_triangle<T, P>>
+{
+    using type = T;
+};
+
+template <size_t N, typename T, typename P>
+struct scalar_type<basic_multi_triangle<N, T, P>>
+{
+    using type = T;
+};
+
+template <size_t K, typename T, typename P>
+struct scalar_type<basic_motion_triangle<K, T, P>>
+{
+    using type = T;
+};
+
 //-------------------------------------------------------------------------------------------------
 // Number of vertices
 //
@@ -95,6 +116,12 @@ struct num_vertices<basic_triangle<Dim, T, P>>
     enum { value = 3 };
 };
 
+template <typename T, typename P>
+struct num_vertices<basic_indexed_triangle<T, P>>
+{
+    enum { value = 3 };
+};
+
 
 //-------------------------------------------------------------------------------------------------
 // Number of precalculated normals
@@ -122,6 +149,18 @@ struct num_normals<basic_triangle<Dim, T, P>, normals_per_vertex_binding>
     enum { value = 3 };
 };
 
+template <typename T, typename P>
+struct num_normals<basic_indexed_triangle<T, P>, normals_per_face_binding>
+{
+    enum { value = 1 };
+};
+
+template <typename T, typename P>
+struct num_normals<basic_indexed_triangle<T, P>, normals_per_vertex_binding>
+{
+    enum { value = 3 };
+};
+
 
 //-------------------------------------------------------------------------------------------------
 // Number of texture coordinates
@@ -143,6 +182,12 @@ struct num_tex_coords<basic_triangle<Dim, T, P>>
     enum { value = 3 };
 };
 
+template <typename T, typename P>
+struct num_tex_coords<basic_indexed_triangle<T, P>>
+{
+    enum { value = 3 };
+};
+
 } // visionaray
 
 #endif // VSNRAY_PRIM_TRAITS_H
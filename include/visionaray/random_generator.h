@@ -17,6 +17,7 @@
 #include "detail/macros.h"
 #include "math/simd/type_traits.h"
 #include "array.h"
+#include "pcg_generator.h"
 
 namespace visionaray
 {
@@ -62,46 +63,17 @@ private:
 
 };
 
+//-------------------------------------------------------------------------------------------------
+// SIMD random_generator, steps all lanes at once using a vectorized pcg_generator
+//
+
 template <typename T>
 class random_generator<T, typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+    : public pcg_generator<T>
 {
 public:
 
-    using value_type = T;
-
-public:
-
-    typedef random_generator<float> generator_type;
-
-    VSNRAY_FUNC random_generator(array<unsigned, simd::num_elements<value_type>::value> const& seed)
-    {
-        for (int i = 0; i < simd::num_elements<value_type>::value; ++i)
-        {
-            generators_[i] = generator_type(seed[i]);
-        }
-    }
-
-    VSNRAY_FUNC value_type next()
-    {
-        simd::aligned_array_t<value_type> arr;
-
-        for (int i = 0; i < simd::num_elements<value_type>::value; ++i)
-        {
-            arr[i] = generators_[i].next();
-        }
-
-        return value_type(arr);
-    }
-
-    // TODO: maybe don't have a random_generatorN at all?
-    VSNRAY_FUNC generator_type& get_generator(unsigned i)
-    {
-        return generators_[i];
-    }
-
-private:
-
-    array<generator_type, simd::num_elements<value_type>::value> generators_;
+    using pcg_generator<T>::pcg_generator;
 
 };
 
@@ -0,0 +1,341 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_RAY_STREAM_H
+#define VSNRAY_RAY_STREAM_H 1
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "detail/parallel_algorithm.h"
+#include "detail/parallel_for.h"
+#include "detail/range.h"
+#include "detail/thread_pool.h"
+#include "math/simd/simd.h"
+#include "math/aabb.h"
+#include "math/ray.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+#include "array.h"
+#include "intersector.h"
+#include "morton.h"
+#include "traverse.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Sort key of a ray in a stream
+//
+
+struct ray_stream_key
+{
+    unsigned key;
+    unsigned index;
+};
+
+// Direction octant in the three most significant bits, followed by the
+// 27 bit Morton code of the origin relative to the origin bounds
+inline unsigned ray_sort_key(basic_ray<float> const& r, aabb const& ori_bounds)
+{
+    unsigned octant = (r.dir.x < 0.0f ? 1U : 0U)
+                    | (r.dir.y < 0.0f ? 2U : 0U)
+                    | (r.dir.z < 0.0f ? 4U : 0U);
+
+    vec3 size = ori_bounds.max - ori_bounds.min;
+    vec3 p = r.ori - ori_bounds.min;
+
+    auto quantize = [](float x, float size)
+    {
+        float c = size > 0.0f ? x / size * 512.0f : 0.0f;
+        return static_cast<unsigned>(std::min(std::max(c, 0.0f), 511.0f));
+    };
+
+    unsigned code = morton_encode3D(
+            quantize(p.x, size.x),
+            quantize(p.y, size.y),
+            quantize(p.z, size.z)
+            );
+
+    return (octant << 27) | code;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// basic_ray_stream
+//
+// Traverses large batches of single rays, e.g. all rays of one bounce of a wavefront path
+// tracer, in fully populated SIMD packets. Rays are sorted by direction octant and by the
+// Morton code of their origin, consecutive rays of the sorted stream are then packed into
+// basic_ray<FloatT>. Only the rays passed to the stream are traced, so terminated paths
+// do not occupy SIMD lanes as they do with per-packet megakernels.
+//
+// Hit records are returned in the order of the input rays. Primitives are passed as
+// iterator ranges like with closest_hit(), so any primitive type or BVH type that
+// supports packet traversal may be used (e.g. index_bvh::bvh_ref).
+//
+// Streams keep their temporary storage, reusing a stream for all bounces of a frame
+// avoids reallocations. With a thread pool, packets are traversed in parallel and the
+// intersector is shared between the threads.
+//
+
+template <typename FloatT>
+class basic_ray_stream
+{
+public:
+
+    using scalar_ray_type = basic_ray<float>;
+    using packet_ray_type = basic_ray<FloatT>;
+
+    enum { PacketSize = simd::num_elements<FloatT>::value };
+
+public:
+
+    // Sort rays before packing them, otherwise packets are formed in input order
+    void enable_sorting(bool enable)
+    {
+        sorting_ = enable;
+    }
+
+    bool sorting_enabled() const
+    {
+        return sorting_;
+    }
+
+    // Closest hits of all rays, hit_records[i] belongs to rays[i]
+    template <typename Primitives, typename HR, typename Intersector, typename Pool>
+    void closest_hit(
+            scalar_ray_type const*  rays,
+            size_t                  num_rays,
+            Primitives              begin,
+            Primitives              end,
+            HR*                     hit_records,
+            Intersector&            isect,
+            Pool&                   pool
+            )
+    {
+        traverse_packets(rays, num_rays, hit_records, pool, [&](packet_ray_type const& r)
+        {
+            return visionaray::closest_hit(r, begin, end, isect);
+        });
+    }
+
+    template <typename Primitives, typename HR, typename Intersector>
+    void closest_hit(
+            scalar_ray_type const*  rays,
+            size_t                  num_rays,
+            Primitives              begin,
+            Primitives              end,
+            HR*                     hit_records,
+            Intersector&            isect
+            )
+    {
+        thread_pool pool(0);
+        closest_hit(rays, num_rays, begin, end, hit_records, isect, pool);
+    }
+
+    template <typename Primitives, typename HR>
+    void closest_hit(
+            scalar_ray_type const*  rays,
+            size_t                  num_rays,
+            Primitives              begin,
+            Primitives              end,
+            HR*                     hit_records
+            )
+    {
+        default_intersector isect;
+        closest_hit(rays, num_rays, begin, end, hit_records, isect);
+    }
+
+    // Any hits of all rays (e.g. shadow rays), hit_records[i] belongs to rays[i]
+    template <typename Primitives, typename HR, typename Intersector, typename Pool>
+    void any_hit(
+            scalar_ray_type const*  rays,
+            size_t                  num_rays,
+            Primitives              begin,
+            Primitives              end,
+            HR*                     hit_records,
+            Intersector&            isect,
+            Pool&                   pool
+            )
+    {
+        traverse_packets(rays, num_rays, hit_records, pool, [&](packet_ray_type const& r)
+        {
+            return visionaray::any_hit(r, begin, end, isect);
+        });
+    }
+
+    template <typename Primitives, typename HR, typename Intersector>
+    void any_hit(
+            scalar_ray_type const*  rays,
+            size_t                  num_rays,
+            Primitives              begin,
+            Primitives              end,
+            HR*                     hit_records,
+            Intersector&            isect
+            )
+    {
+        thread_pool pool(0);
+        any_hit(rays, num_rays, begin, end, hit_records, isect, pool);
+    }
+
+    template <typename Primitives, typename HR>
+    void any_hit(
+            scalar_ray_type const*  rays,
+            size_t                  num_rays,
+            Primitives              begin,
+            Primitives              end,
+            HR*                     hit_records
+            )
+    {
+        default_intersector isect;
+        any_hit(rays, num_rays, begin, end, hit_records, isect);
+    }
+
+    // Order of the rays of the last traversal, packet i holds the rays
+    // order()[i * PacketSize] to order()[(i + 1) * PacketSize - 1]
+    aligned_vector<unsigned> const& order() const
+    {
+        return order_;
+    }
+
+private:
+
+    bool sorting_ = true;
+
+    aligned_vector<detail::ray_stream_key> keys_;
+    aligned_vector<detail::ray_stream_key> temp_;
+    aligned_vector<unsigned> order_;
+
+    template <typename Pool>
+    void sort(scalar_ray_type const* rays, size_t num_rays, Pool& pool)
+    {
+        static const size_t TileSize = 16384;
+
+        order_.resize(num_rays);
+
+        if (!sorting_)
+        {
+            for (size_t i = 0; i < num_rays; ++i)
+            {
+                order_[i] = static_cast<unsigned>(i);
+            }
+
+            return;
+        }
+
+        // Origin bounds, reduced per tile
+
+        size_t num_tiles = div_up(num_rays, TileSize);
+        std::vector<aabb> tile_bounds(num_tiles);
+
+        parallel_for(
+            pool,
+            tiled_range1d<size_t>(0, num_rays, TileSize),
+            [&](range1d<size_t> const& r)
+            {
+                aabb tb;
+                tb.invalidate();
+
+                for (size_t i = r.begin(); i != r.end(); ++i)
+                {
+                    tb.insert(rays[i].ori);
+                }
+
+                tile_bounds[r.begin() / TileSize] = tb;
+            });
+
+        aabb ori_bounds;
+        ori_bounds.invalidate();
+
+        for (auto const& tb : tile_bounds)
+        {
+            ori_bounds.insert(tb);
+        }
+
+        // Sort by key
+
+        keys_.resize(num_rays);
+        temp_.resize(num_rays);
+
+        parallel_for(
+            pool,
+            tiled_range1d<size_t>(0, num_rays, TileSize),
+            [&](range1d<size_t> const& r)
+            {
+                for (size_t i = r.begin(); i != r.end(); ++i)
+                {
+                    keys_[i].key = detail::ray_sort_key(rays[i], ori_bounds);
+                    keys_[i].index = static_cast<unsigned>(i);
+                }
+            });
+
+        paralgo::radix_sort(
+                pool,
+                keys_.begin(),
+                keys_.end(),
+                temp_.begin(),
+                30,
+                [](detail::ray_stream_key const& k) { return k.key; }
+                );
+
+        for (size_t i = 0; i < num_rays; ++i)
+        {
+            order_[i] = keys_[i].index;
+        }
+    }
+
+    template <typename HR, typename Pool, typename Func>
+    void traverse_packets(scalar_ray_type const* rays, size_t num_rays, HR* hit_records, Pool& pool, Func func)
+    {
+        if (num_rays == 0)
+        {
+            return;
+        }
+
+        sort(rays, num_rays, pool);
+
+        size_t num_packets = div_up(num_rays, static_cast<size_t>(PacketSize));
+
+        parallel_for(
+            pool,
+            tiled_range1d<size_t>(0, num_packets, 64),
+            [&](range1d<size_t> const& r)
+            {
+                for (size_t p = r.begin(); p != r.end(); ++p)
+                {
+                    size_t first = p * PacketSize;
+                    size_t count = std::min(num_rays - first, static_cast<size_t>(PacketSize));
+
+                    // Unused lanes of the last packet repeat its first ray, so
+                    // that they do not visit any additional nodes
+                    array<scalar_ray_type, PacketSize> packet;
+
+                    for (size_t i = 0; i < PacketSize; ++i)
+                    {
+                        packet[i] = rays[order_[first + (i < count ? i : 0)]];
+                    }
+
+                    auto hrs = simd::unpack(func(simd::pack(packet)));
+
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        hit_records[order_[first + i]] = hrs[i];
+                    }
+                }
+            });
+    }
+};
+
+using ray_stream = basic_ray_stream<simd::float4>;
+
+} // visionaray
+
+#endif // VSNRAY_RAY_STREAM_H
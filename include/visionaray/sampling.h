@@ -161,6 +161,23 @@ struct has_sample : has_sample_impl<T, Generator>::type
 {
 };
 
+// Lights w/o a position (e.g. environment lights) sample relative to the shading point
+template <typename Light, typename T, typename Generator>
+VSNRAY_FUNC
+inline auto sample_light_from(Light const& light, vector<3, T> const& pos, Generator& gen, int)
+    -> decltype(light.sample_from(pos, gen))
+{
+    return light.sample_from(pos, gen);
+}
+
+template <typename Light, typename T, typename Generator>
+VSNRAY_FUNC
+inline auto sample_light_from(Light const& light, vector<3, T> const& /* pos */, Generator& gen, long)
+    -> decltype(light.sample(gen))
+{
+    return light.sample(gen);
+}
+
 } // detail
 
 // empty default
@@ -250,6 +267,198 @@ light_sample<T> sample_random_light(Lights begin, Lights end, Generator& gen, T
     return result;
 }
 
+
+
+//-------------------------------------------------------------------------------------------------
+// Sample a light that is selected by a light sampler (see light_sampler.h)
+//
+// select_pdf is the probability of having selected the light, pos and n are the
+// position and normal of the shading point that the light sampler may consider
+//
+
+// empty default
+template <
+    typename Lights,
+    typename LightSampler,
+    typename Generator,
+    typename T = typename Generator::value_type,
+    typename = typename std::enable_if<
+        !detail::has_sample<typename std::iterator_traits<Lights>::value_type, Generator>::value>::type
+    >
+VSNRAY_FUNC
+light_sample<T> sample_light(
+        Lights                  begin,
+        Lights                  end,
+        LightSampler const&     sampler,
+        vector<3, T> const&     pos,
+        vector<3, T> const&     n,
+        T&                      select_pdf,
+        Generator&              gen
+        )
+{
+    VSNRAY_UNUSED(begin);
+    VSNRAY_UNUSED(end);
+    VSNRAY_UNUSED(sampler);
+    VSNRAY_UNUSED(pos);
+    VSNRAY_UNUSED(n);
+    VSNRAY_UNUSED(gen);
+
+    select_pdf = T(0.0);
+
+    return {};
+}
+
+// non-simd
+template <
+    typename Lights,
+    typename LightSampler,
+    typename Generator,
+    typename T = typename Generator::value_type,
+    typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type,
+    typename = typename std::enable_if<
+        detail::has_sample<typename std::iterator_traits<Lights>::value_type, Generator>::value>::type
+    >
+VSNRAY_FUNC
+light_sample<T> sample_light(
+        Lights                  begin,
+        Lights                  end,
+        LightSampler const&     sampler,
+        vector<3, T> const&     pos,
+        vector<3, T> const&     n,
+        T&                      select_pdf,
+        Generator&              gen
+        )
+{
+    int num_lights = static_cast<int>(end - begin);
+
+    auto u = gen.next();
+
+    int light_id = sampler.select(num_lights, pos, n, u, select_pdf);
+
+    return detail::sample_light_from(begin[light_id], pos, gen, 0);
+}
+
+// simd
+template <
+    typename Lights,
+    typename LightSampler,
+    typename Generator,
+    typename T = typename Generator::value_type,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type,
+    typename = typename std::enable_if<
+        detail::has_sample<typename std::iterator_traits<Lights>::value_type, Generator>::value>::type
+    >
+light_sample<T> sample_light(
+        Lights                  begin,
+        Lights                  end,
+        LightSampler const&     sampler,
+        vector<3, T> const&     pos,
+        vector<3, T> const&     n,
+        T&                      select_pdf,
+        Generator&              gen,
+        T                       = T()
+        )
+{
+    using float_array = simd::aligned_array_t<T>;
+
+    int num_lights = static_cast<int>(end - begin);
+
+    auto u = gen.next();
+
+    float_array uf;
+    store(uf, u);
+
+    auto poss_in = simd::unpack(pos);
+    auto normals_in = simd::unpack(n);
+
+    light_sample<T> result;
+
+    array<vector<3, float>, simd::num_elements<T>::value> poss;
+    array<vector<3, float>, simd::num_elements<T>::value> intensities;
+    array<vector<3, float>, simd::num_elements<T>::value> normals;
+    float* area = reinterpret_cast<float*>(&result.area);
+    int* delta_light = reinterpret_cast<int*>(&result.delta_light);
+    float* pdf = reinterpret_cast<float*>(&select_pdf);
+
+    for (unsigned i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        int light_id = sampler.select(num_lights, poss_in[i], normals_in[i], uf[i], pdf[i]);
+
+        auto ls = detail::sample_light_from(begin[light_id], poss_in[i], gen.get_generator(i), 0);
+
+        poss[i] = ls.pos;
+        intensities[i] = ls.intensity;
+        normals[i] = ls.normal;
+        area[i] = ls.area;
+        delta_light[i] = ls.delta_light ? 0xFFFFFFFF : 0x00000000;
+    }
+
+    result.pos = simd::pack(poss);
+    result.intensity = simd::pack(intensities);
+    result.normal = simd::pack(normals);
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Probability that a light sampler selects the light that emits from primitive prim_id
+//
+
+// non-simd
+template <
+    typename LightSampler,
+    typename I,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type
+    >
+VSNRAY_FUNC
+T light_select_pdf(
+        LightSampler const&     sampler,
+        int                     num_lights,
+        I const&                prim_id,
+        vector<3, T> const&     pos,
+        vector<3, T> const&     n
+        )
+{
+    return sampler.pdf(num_lights, static_cast<int>(prim_id), pos, n);
+}
+
+// simd
+template <
+    typename LightSampler,
+    typename I,
+    typename T,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type,
+    typename = void
+    >
+T light_select_pdf(
+        LightSampler const&     sampler,
+        int                     num_lights,
+        I const&                prim_id,
+        vector<3, T> const&     pos,
+        vector<3, T> const&     n
+        )
+{
+    using int_array = simd::aligned_array_t<simd::int_type_t<T>>;
+    using float_array = simd::aligned_array_t<T>;
+
+    int_array ids;
+    store(ids, simd::int_type_t<T>(prim_id));
+
+    auto poss = simd::unpack(pos);
+    auto normals = simd::unpack(n);
+
+    float_array result;
+
+    for (unsigned i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        result[i] = sampler.pdf(num_lights, ids[i], poss[i], normals[i]);
+    }
+
+    return T(result);
+}
+
 } // visionaray
 
 #endif // VSNRAY_SAMPLING_H
@@ -0,0 +1,131 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_SOBOL_GENERATOR_H
+#define VSNRAY_SOBOL_GENERATOR_H 1
+
+#include <type_traits>
+
+#include "detail/low_discrepancy.h"
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Owen-scrambled Sobol sequence
+//
+// next() returns the successive dimensions of the current sample, begin_sample() starts
+// a new sample and resets the dimension. The seed selects the scrambling, so pixels
+// that are seeded differently obtain decorrelated sequences. Sample i is sample
+// first_sample + i of the sequence.
+//
+// Successive pairs of dimensions (0,1), (2,3), (4,5), ... are the first two Sobol
+// dimensions, which form a (0,2)-sequence, i.e. each pair is stratified in 2D. Each pair
+// uses a different scrambling and shuffling of the sample index, so that pairs are not
+// correlated (cf. B. Burley: Practical Hash-based Owen Scrambling, JCGT 2020).
+//
+
+namespace detail
+{
+
+// First two dimensions of the Sobol sequence, as 32-bit fixed point numbers with
+// reversed bit order
+VSNRAY_FUNC
+inline unsigned sobol_reversed(unsigned index, unsigned dim)
+{
+    if (dim == 1)
+    {
+        // The generator matrix of the second dimension is the Pascal matrix mod 2,
+        // i.e. bit i of the result is the xor of all index bits k where i is a subset
+        // of k. Compute this with a superset transform over the bit positions
+        index ^= (index >> 1) & 0x55555555u;
+        index ^= (index >> 2) & 0x33333333u;
+        index ^= (index >> 4) & 0x0F0F0F0Fu;
+        index ^= (index >> 8) & 0x00FF00FFu;
+        index ^= (index >> 16) & 0x0000FFFFu;
+    }
+
+    // The generator matrix of the first dimension is the identity (van der Corput)
+    return index;
+}
+
+} // detail
+
+
+template <typename T, typename = void>
+class sobol_generator
+{
+public:
+
+    using value_type = T;
+
+public:
+
+    sobol_generator() = default;
+
+    VSNRAY_FUNC explicit sobol_generator(unsigned seed, unsigned first_sample = 0)
+        : seed_(detail::ld_hash(seed))
+        , first_sample_(first_sample)
+        , index_(first_sample)
+    {
+    }
+
+    // Pixel sampler interface, the pixel position is not used
+    VSNRAY_FUNC sobol_generator(unsigned seed, int x, int y, unsigned first_sample)
+        : sobol_generator(seed, first_sample)
+    {
+        VSNRAY_UNUSED(x);
+        VSNRAY_UNUSED(y);
+    }
+
+    VSNRAY_FUNC void begin_sample(unsigned sample)
+    {
+        index_ = first_sample_ + sample;
+        dim_ = 0;
+    }
+
+    VSNRAY_FUNC T next()
+    {
+        return T(next_uint() >> 8) * T(1.0f / 16777216.0f);
+    }
+
+    VSNRAY_FUNC unsigned next_uint()
+    {
+        unsigned dim = dim_++;
+
+        unsigned pair_seed = detail::ld_hash_combine(seed_, detail::ld_hash(dim / 2));
+        unsigned dim_seed = detail::ld_hash_combine(pair_seed, detail::ld_hash(dim % 2 + 1));
+
+        unsigned index = detail::nested_uniform_scramble(index_, pair_seed);
+
+        // Owen scrambling, the bit order of the Sobol point is already reversed
+        unsigned x = detail::sobol_reversed(index, dim % 2);
+        return detail::reverse_bits(detail::laine_karras_permutation(x, dim_seed));
+    }
+
+private:
+
+    unsigned seed_ = 0;
+    unsigned first_sample_ = 0;
+    unsigned index_ = 0;
+    unsigned dim_ = 0;
+
+};
+
+template <typename T>
+class sobol_generator<T, typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+    : public detail::simd_low_discrepancy_generator<T, sobol_generator<float>>
+{
+public:
+
+    using detail::simd_low_discrepancy_generator<T, sobol_generator<float>>::simd_low_discrepancy_generator;
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_SOBOL_GENERATOR_H
@@ -144,6 +144,12 @@ public:
         return *this;
     }
 
+    // Zero-based index of the alternative that is currently stored
+    VSNRAY_FUNC unsigned which() const
+    {
+        return type_index_ - 1;
+    }
+
     template <typename T>
     VSNRAY_FUNC T* as()
     {
@@ -0,0 +1,229 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_WAVEFRONT_PATHTRACER_H
+#define VSNRAY_WAVEFRONT_PATHTRACER_H 1
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail/parallel_algorithm.h"
+#include "detail/parallel_for.h"
+#include "detail/pixel_access.h"
+#include "detail/range.h"
+#include "detail/sched_common.h"
+#include "math/ray.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+#include "generic_material.h"
+#include "intersector.h"
+#include "kernels.h"
+#include "make_random_seed.h"
+#include "pixel_format.h"
+#include "pixel_sampler_types.h"
+#include "random_generator.h"
+#include "ray_stream.h"
+#include "spectrum.h"
+
+namespace visionaray
+{
+namespace pathtracing
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Material types, shading is grouped by these
+//
+
+template <typename M>
+struct num_material_types : std::integral_constant<unsigned, 1>
+{
+};
+
+template <typename ...Ts>
+struct num_material_types<generic_material<Ts...>> : std::integral_constant<unsigned, sizeof...(Ts)>
+{
+};
+
+template <typename M>
+inline unsigned material_type_index(M const& /* */)
+{
+    return 0;
+}
+
+template <typename ...Ts>
+inline unsigned material_type_index(generic_material<Ts...> const& mat)
+{
+    return mat.which();
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Wavefront path tracer
+//
+// Computes the same estimate as pathtracing::kernel, but instead of tracing paths of one
+// ray packet at a time, all paths of a frame advance one bounce per iteration of a
+// pipeline of stages:
+//
+//   generate:    primary rays for all pixels and samples
+//   extend:      closest hits for the rays of all active paths
+//   shade:       emission, material sampling and light sampling. Paths are grouped by
+//                material type, so that generic_material dispatch is coherent
+//   connect:     occlusion tests for all shadow rays of the bounce
+//   accumulate:  average samples and blend the result on top of the render target
+//
+// Path state is kept in SoA buffers that are reused for subsequent frames. The extend and
+// connect stages trace their rays with ray streams, so the SIMD packets are fully populated
+// even when most paths have terminated. Shading is done per path (with float).
+//
+// CPU only. Rays are traced with basic_ray_stream<FloatT>.
+//
+
+template <typename Params, typename FloatT = simd::float4>
+class wavefront
+{
+public:
+
+    using params_type = Params;
+
+    wavefront() = default;
+
+    explicit wavefront(Params const& params)
+        : params_(params)
+    {
+    }
+
+    void set_params(Params const& params)
+    {
+        params_ = params;
+    }
+
+    Params const& params() const
+    {
+        return params_;
+    }
+
+    // Render one frame with spp samples per pixel, blend the result with the color buffer
+    // like pixel_sampler::jittered_blend_type does
+    template <typename Camera, typename RenderTarget, typename Intersector, typename Pool>
+    void frame(
+            pixel_sampler::jittered_blend_type  ps,
+            Camera&                             cam,
+            RenderTarget&                       rt,
+            unsigned                            frame_id,
+            Intersector&                        isect,
+            Pool&                               pool
+            );
+
+    template <typename Camera, typename RenderTarget, typename Pool>
+    void frame(
+            pixel_sampler::jittered_blend_type  ps,
+            Camera&                             cam,
+            RenderTarget&                       rt,
+            unsigned                            frame_id,
+            Pool&                               pool
+            )
+    {
+        default_intersector isect;
+        frame(ps, cam, rt, frame_id, isect, pool);
+    }
+
+private:
+
+    using S = float;
+    using V = vector<3, S>;
+    using C = spectrum<S>;
+    using R = basic_ray<S>;
+    using generator_type = random_generator<S>;
+    using primitive_iterator = decltype(std::declval<Params>().prims.begin);
+    // Hit records don't depend on the intersector. indexed_triangle_intersector handles
+    // the primitives default_intersector handles, and indexed triangles in addition
+    using hit_record_type = decltype(closest_hit(
+            R{},
+            std::declval<primitive_iterator>(),
+            std::declval<primitive_iterator>(),
+            std::declval<indexed_triangle_intersector<S>&>()
+            ));
+
+    enum { TileSize = 4096 };
+
+    Params params_;
+
+    basic_ray_stream<FloatT> stream_;
+
+    // Path state, one entry per pixel sample --------------
+
+    aligned_vector<R>                   rays_;
+    aligned_vector<R>                   primary_rays_;
+    aligned_vector<C>                   throughput_;
+    aligned_vector<C>                   intensity_;
+    aligned_vector<V>                   last_pos_;
+    aligned_vector<V>                   last_n_;
+    aligned_vector<S>                   last_brdf_pdf_;
+    aligned_vector<unsigned char>       last_specular_;
+    aligned_vector<unsigned char>       hit_;
+    aligned_vector<S>                   depth_;
+    aligned_vector<vec4>                background_;
+    std::vector<generator_type>         gens_;
+
+    // Queues -----------------------------------------------
+
+    // Paths that are still active
+    aligned_vector<unsigned>            active_;
+    aligned_vector<unsigned>            next_active_;
+
+    // Rays and hit records of the active paths
+    aligned_vector<R>                   queue_rays_;
+    aligned_vector<hit_record_type>     hit_records_;
+
+    // Queue entries in shading order
+    aligned_vector<unsigned>            shade_order_;
+    aligned_vector<unsigned>            shade_temp_;
+    std::vector<unsigned>               material_counts_;
+
+    // Two shadow ray slots per queue entry: light sources and environment light
+    aligned_vector<R>                   shadow_slots_;
+    aligned_vector<C>                   shadow_contributions_;
+    aligned_vector<unsigned char>       continue_;
+
+    // Shadow rays in the connect queue and the slots they belong to
+    aligned_vector<R>                   shadow_rays_;
+    aligned_vector<unsigned>            shadow_slot_index_;
+    aligned_vector<hit_record_type>     shadow_hit_records_;
+
+
+    template <typename Camera, typename Pool>
+    void generate(pixel_sampler::jittered_blend_type ps, Camera const& cam, int width, int height, unsigned frame_id, Pool& pool);
+
+    template <typename Intersector, typename Pool>
+    void extend(Intersector& isect, Pool& pool);
+
+    template <typename Pool>
+    void sort_by_material(Pool& pool);
+
+    template <typename Intersector, typename Pool>
+    void shade(Intersector& isect, unsigned bounce, Pool& pool);
+
+    template <typename Intersector>
+    void shade_path(kernel<Params> const& k, Intersector& isect, unsigned q, unsigned bounce);
+
+    template <typename Intersector, typename Pool>
+    void connect(Intersector& isect, Pool& pool);
+
+    template <typename RenderTargetRef, typename Camera, typename Pool>
+    void accumulate(pixel_sampler::jittered_blend_type ps, Camera const& cam, RenderTargetRef rt_ref, int width, int height, Pool& pool);
+};
+
+} // pathtracing
+} // visionaray
+
+#include "detail/wavefront_pathtracer.inl"
+
+#endif // VSNRAY_WAVEFRONT_PATHTRACER_H
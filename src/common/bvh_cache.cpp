@@ -0,0 +1,249 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "bvh_cache.h"
+
+namespace visionaray
+{
+
+static const char Magic[8] = { 'V', 'S', 'N', 'R', 'B', 'V', 'H', '\0' };
+
+// File sections are aligned so that mapped nodes satisfy their alignment requirements
+static const uint64_t SectionAlignment = 64;
+
+static uint64_t align_up(uint64_t offset)
+{
+    return (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// bvh_cache
+//
+
+bvh_cache::bvh_cache(std::string directory)
+    : directory_(std::move(directory))
+{
+}
+
+bvh_cache::~bvh_cache() = default;
+
+std::string bvh_cache::filename(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.vsnraybvh", static_cast<unsigned long long>(key));
+
+    return (boost::filesystem::path(directory_) / name).string();
+}
+
+uint64_t bvh_cache::hash(void const* data, size_t size, uint64_t seed)
+{
+    // FNV-1a, processes eight bytes at once
+
+    static const uint64_t Prime = 0x100000001B3ULL;
+
+    uint64_t h = seed ^ 0xCBF29CE484222325ULL;
+
+    auto bytes = static_cast<unsigned char const*>(data);
+
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+
+        h ^= word;
+        h *= Prime;
+    }
+
+    for (; i < size; ++i)
+    {
+        h ^= bytes[i];
+        h *= Prime;
+    }
+
+    return h;
+}
+
+bvh_cache::header bvh_cache::make_header(
+        uint64_t key,
+        size_t   primitive_size,
+        size_t   node_size,
+        size_t   index_size,
+        size_t   num_primitives,
+        size_t   num_nodes,
+        size_t   num_indices
+        )
+{
+    header hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+
+    std::memcpy(hdr.magic, Magic, sizeof(Magic));
+    hdr.version             = Version;
+    hdr.primitive_size      = static_cast<uint32_t>(primitive_size);
+    hdr.node_size           = static_cast<uint32_t>(node_size);
+    hdr.index_size          = static_cast<uint32_t>(index_size);
+    hdr.key                 = key;
+    hdr.num_primitives      = num_primitives;
+    hdr.num_nodes           = num_nodes;
+    hdr.num_indices         = num_indices;
+    hdr.primitives_offset   = align_up(sizeof(header));
+    hdr.nodes_offset        = align_up(hdr.primitives_offset + primitive_size * num_primitives);
+    hdr.indices_offset      = align_up(hdr.nodes_offset + node_size * num_nodes);
+    hdr.file_size           = hdr.indices_offset + index_size * num_indices;
+
+    return hdr;
+}
+
+bool bvh_cache::write(
+        header const& hdr,
+        void const*   primitives,
+        void const*   nodes,
+        void const*   indices
+        )
+{
+    try
+    {
+        boost::filesystem::create_directories(directory_);
+
+        // Write to a temporary file first so that concurrent
+        // viewer instances never map incomplete files
+        std::string fn = filename(hdr.key);
+        std::string tmp = fn + ".tmp";
+
+        std::ofstream file(tmp, std::ios::binary);
+
+        if (!file.good())
+        {
+            return false;
+        }
+
+        auto write_section = [&](uint64_t offset, void const* data, uint64_t size)
+        {
+            static const char zeros[SectionAlignment] = { 0 };
+
+            uint64_t pos = static_cast<uint64_t>(file.tellp());
+            file.write(zeros, static_cast<std::streamsize>(offset - pos));
+
+            if (size > 0)
+            {
+                file.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+            }
+        };
+
+        file.write(reinterpret_cast<char const*>(&hdr), sizeof(hdr));
+        write_section(hdr.primitives_offset, primitives, hdr.primitive_size * hdr.num_primitives);
+        write_section(hdr.nodes_offset, nodes, hdr.node_size * hdr.num_nodes);
+        write_section(hdr.indices_offset, indices, hdr.index_size * hdr.num_indices);
+
+        file.close();
+
+        if (!file.good())
+        {
+            boost::filesystem::remove(tmp);
+            return false;
+        }
+
+        boost::filesystem::rename(tmp, fn);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+char* bvh_cache::map(
+        uint64_t key,
+        size_t   primitive_size,
+        size_t   node_size,
+        size_t   index_size
+        )
+{
+    std::string fn = filename(key);
+
+    try
+    {
+        if (!boost::filesystem::exists(fn))
+        {
+            return nullptr;
+        }
+
+        std::unique_ptr<boost::iostreams::mapped_file> file(new boost::iostreams::mapped_file(
+                fn,
+                boost::iostreams::mapped_file::priv
+                ));
+
+        if (!file->is_open() || file->size() < sizeof(header))
+        {
+            return nullptr;
+        }
+
+        header hdr;
+        std::memcpy(&hdr, file->data(), sizeof(hdr));
+
+        if (std::memcmp(hdr.magic, Magic, sizeof(Magic)) != 0
+         || hdr.version != Version
+         || hdr.key != key
+         || hdr.primitive_size != primitive_size
+         || hdr.node_size != node_size
+         || hdr.index_size != index_size
+         || hdr.file_size != file->size())
+        {
+            return nullptr;
+        }
+
+        // Counts that don't fit into the file would overflow the section sizes below
+        if (hdr.num_primitives > file->size() / (primitive_size > 0 ? primitive_size : 1)
+         || hdr.num_nodes > file->size() / (node_size > 0 ? node_size : 1)
+         || hdr.num_indices > file->size() / (index_size > 0 ? index_size : 1))
+        {
+            return nullptr;
+        }
+
+        // The sections must be where store() puts them for the stored counts, so that
+        // the array_refs returned from load() stay inside the mapped file
+        header expected = make_header(
+                key,
+                primitive_size,
+                node_size,
+                index_size,
+                hdr.num_primitives,
+                hdr.num_nodes,
+                hdr.num_indices
+                );
+
+        if (hdr.primitives_offset != expected.primitives_offset
+         || hdr.nodes_offset != expected.nodes_offset
+         || hdr.indices_offset != expected.indices_offset
+         || hdr.file_size != expected.file_size)
+        {
+            return nullptr;
+        }
+
+        char* data = file->data();
+        mappings_.push_back(std::move(file));
+        return data;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return nullptr;
+    }
+}
+
+} // visionaray
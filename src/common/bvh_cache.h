@@ -0,0 +1,277 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_COMMON_BVH_CACHE_H
+#define VSNRAY_COMMON_BVH_CACHE_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <visionaray/array_ref.h>
+#include <visionaray/bvh.h>
+
+#include "export.h"
+
+namespace boost
+{
+namespace iostreams
+{
+class mapped_file;
+} // iostreams
+} // boost
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// On-disk cache for BVHs
+//
+// BVHs are stored as flat binary images (header, primitives, nodes, indices) in files named
+// after a 64-bit key. The key is a content hash over the input primitives and a string
+// describing the builder parameters, see make_key().
+//
+// Cached BVHs are loaded without copying: the file is memory mapped (privately, i.e.
+// copy-on-write), and the BVH returned from load() refers to the mapped pages through
+// array_refs. The mapping is kept alive until the cache object is destroyed.
+//
+
+class bvh_cache
+{
+public:
+
+    enum { Version = 1 };
+
+    struct header
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t primitive_size;
+        uint32_t node_size;
+        uint32_t index_size;
+        uint64_t key;
+        uint64_t num_primitives;
+        uint64_t num_nodes;
+        uint64_t num_indices;
+        uint64_t primitives_offset;
+        uint64_t nodes_offset;
+        uint64_t indices_offset;
+        uint64_t file_size;
+    };
+
+public:
+
+    VSNRAY_COMMON_EXPORT explicit bvh_cache(std::string directory);
+    VSNRAY_COMMON_EXPORT ~bvh_cache();
+
+    bvh_cache(bvh_cache const&) = delete;
+    bvh_cache& operator=(bvh_cache const&) = delete;
+
+    // Compute key from primitive data and builder parameters
+    template <typename P>
+    static uint64_t make_key(P const* primitives, size_t num_primitives, std::string const& params);
+
+    // Compute key from primitive data, data that the primitives refer to (e.g. the
+    // vertices of indexed triangles) and builder parameters
+    template <typename P, typename D>
+    static uint64_t make_key(
+            P const*           primitives,
+            size_t             num_primitives,
+            D const*           data,
+            size_t             data_size,
+            std::string const& params
+            );
+
+    // Store BVH under key, returns false if the file could not be written
+    template <typename BVH>
+    bool store(uint64_t key, BVH const& tree);
+
+    // Map the BVH stored under key into memory, BVH must be an array_ref-based
+    // [index_]bvh_t. Returns false if there is no (valid) BVH stored under key
+    template <typename BVH>
+    bool load(uint64_t key, BVH& tree);
+
+private:
+
+    std::string directory_;
+
+    // Mapped files, BVHs returned from load() point into these
+    std::vector<std::unique_ptr<boost::iostreams::mapped_file>> mappings_;
+
+    VSNRAY_COMMON_EXPORT std::string filename(uint64_t key) const;
+
+    VSNRAY_COMMON_EXPORT static uint64_t hash(void const* data, size_t size, uint64_t seed);
+
+    VSNRAY_COMMON_EXPORT static header make_header(
+            uint64_t key,
+            size_t   primitive_size,
+            size_t   node_size,
+            size_t   index_size,
+            size_t   num_primitives,
+            size_t   num_nodes,
+            size_t   num_indices
+            );
+
+    // Write header and data sections, returns false on failure
+    VSNRAY_COMMON_EXPORT bool write(
+            header const& hdr,
+            void const*   primitives,
+            void const*   nodes,
+            void const*   indices
+            );
+
+    // Map file and check header, returns nullptr on failure
+    VSNRAY_COMMON_EXPORT char* map(
+            uint64_t key,
+            size_t   primitive_size,
+            size_t   node_size,
+            size_t   index_size
+            );
+
+    template <typename BVH>
+    bool store_impl(uint64_t key, BVH const& tree, std::true_type /* index bvh */);
+
+    template <typename BVH>
+    bool store_impl(uint64_t key, BVH const& tree, std::false_type /* index bvh */);
+
+    template <typename BVH>
+    bool load_impl(uint64_t key, BVH& tree, std::true_type /* index bvh */);
+
+    template <typename BVH>
+    bool load_impl(uint64_t key, BVH& tree, std::false_type /* index bvh */);
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Implementation
+//
+
+template <typename P>
+inline uint64_t bvh_cache::make_key(P const* primitives, size_t num_primitives, std::string const& params)
+{
+    uint64_t key = hash(params.data(), params.size(), Version);
+    key = hash(&num_primitives, sizeof(num_primitives), key);
+    key = hash(primitives, sizeof(P) * num_primitives, key);
+    return key;
+}
+
+template <typename P, typename D>
+inline uint64_t bvh_cache::make_key(
+        P const*           primitives,
+        size_t             num_primitives,
+        D const*           data,
+        size_t             data_size,
+        std::string const& params
+        )
+{
+    uint64_t key = make_key(primitives, num_primitives, params);
+    key = hash(&data_size, sizeof(data_size), key);
+    key = hash(data, sizeof(D) * data_size, key);
+    return key;
+}
+
+template <typename BVH>
+inline bool bvh_cache::store(uint64_t key, BVH const& tree)
+{
+    return store_impl(key, tree, std::integral_constant<bool, is_index_bvh<BVH>::value>{});
+}
+
+template <typename BVH>
+inline bool bvh_cache::load(uint64_t key, BVH& tree)
+{
+    return load_impl(key, tree, std::integral_constant<bool, is_index_bvh<BVH>::value>{});
+}
+
+template <typename BVH>
+inline bool bvh_cache::store_impl(uint64_t key, BVH const& tree, std::true_type)
+{
+    using P = typename BVH::primitive_type;
+    using N = typename BVH::node_type;
+
+    header hdr = make_header(
+            key,
+            sizeof(P),
+            sizeof(N),
+            sizeof(unsigned),
+            tree.num_primitives(),
+            tree.num_nodes(),
+            tree.num_indices()
+            );
+
+    return write(hdr, tree.primitives().data(), tree.nodes().data(), tree.indices().data());
+}
+
+template <typename BVH>
+inline bool bvh_cache::store_impl(uint64_t key, BVH const& tree, std::false_type)
+{
+    using P = typename BVH::primitive_type;
+    using N = typename BVH::node_type;
+
+    header hdr = make_header(
+            key,
+            sizeof(P),
+            sizeof(N),
+            0,
+            tree.num_primitives(),
+            tree.num_nodes(),
+            0
+            );
+
+    return write(hdr, tree.primitives().data(), tree.nodes().data(), nullptr);
+}
+
+template <typename BVH>
+inline bool bvh_cache::load_impl(uint64_t key, BVH& tree, std::true_type)
+{
+    using P = typename BVH::primitive_type;
+    using N = typename BVH::node_type;
+
+    char* data = map(key, sizeof(P), sizeof(N), sizeof(unsigned));
+
+    if (data == nullptr)
+    {
+        return false;
+    }
+
+    header hdr;
+    std::memcpy(&hdr, data, sizeof(hdr));
+
+    tree.primitives() = array_ref<P>(reinterpret_cast<P*>(data + hdr.primitives_offset), hdr.num_primitives);
+    tree.nodes() = array_ref<N>(reinterpret_cast<N*>(data + hdr.nodes_offset), hdr.num_nodes);
+    tree.indices() = array_ref<unsigned>(reinterpret_cast<unsigned*>(data + hdr.indices_offset), hdr.num_indices);
+
+    return true;
+}
+
+template <typename BVH>
+inline bool bvh_cache::load_impl(uint64_t key, BVH& tree, std::false_type)
+{
+    using P = typename BVH::primitive_type;
+    using N = typename BVH::node_type;
+
+    char* data = map(key, sizeof(P), sizeof(N), 0);
+
+    if (data == nullptr)
+    {
+        return false;
+    }
+
+    header hdr;
+    std::memcpy(&hdr, data, sizeof(hdr));
+
+    tree.primitives() = array_ref<P>(reinterpret_cast<P*>(data + hdr.primitives_offset), hdr.num_primitives);
+    tree.nodes() = array_ref<N>(reinterpret_cast<N*>(data + hdr.nodes_offset), hdr.num_nodes);
+
+    return true;
+}
+
+} // visionaray
+
+#endif // VSNRAY_COMMON_BVH_CACHE_H
@@ -122,6 +122,7 @@ struct renderer : viewer_type
 
     aligned_vector<basic_sphere<float>>         primitives;
     index_bvh<basic_sphere<float>>              bvh;
+    bvh_refitter                                refitter;
     aligned_vector<generic_material<plastic<float>, mirror<float>>> materials;
     aligned_vector<procedural_texture>          textures;
 
@@ -611,8 +612,10 @@ void renderer::generate_frame(float t)
     }
     else
     {
-        bvh_refitter refitter;
         refitter.refit(bvh, primitives.data(), primitives.size(), pool);
+
+        // Keep the tree quality up with a few rotations per frame
+        refitter.optimize(bvh, 1.0f);
     }
 
     outlines.init(bvh);
@@ -0,0 +1,161 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/pixel_sampler_types.h>
+#include <visionaray/result_record.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Convergence benchmark for the stochastic pixel samplers
+//
+// Renders an image with a synthetic integrand with known solution, progressively blending
+// one sample per pixel and frame, like the viewer does. After each power of two frames,
+// the RMSE over all pixels is reported. The integrand is evaluated with dimensions 2-5 of
+// the pixel generators (dimensions 0 and 1 are used for the pixel jitter) and consists of
+//  - a discontinuous part (u2 + u3 < c), with c varying over the image width, and
+//  - a smooth part exp(-(u4^2 + u5^2)).
+//
+
+static const int Width  = 128;
+static const int Height = 128;
+static const int Frames = 1024;
+
+using ray_type = basic_ray<float>;
+using rt_type  = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+
+// Discontinuity for pixel column x
+static float edge(int x)
+{
+    return 2.0f * (x + 0.5f) / Width;
+}
+
+// Area of {(u,v) in [0,1)^2 | u + v < c}
+static double edge_integral(double c)
+{
+    return c <= 1.0 ? 0.5 * c * c : 1.0 - 0.5 * (2.0 - c) * (2.0 - c);
+}
+
+// Integral of exp(-(u^2 + v^2)) over [0,1)^2
+static double gauss_integral()
+{
+    double i = std::sqrt(constants::pi<double>()) * 0.5 * std::erf(1.0);
+    return i * i;
+}
+
+struct kernel
+{
+    template <typename Generator>
+    result_record<float> operator()(ray_type const& r, Generator& gen, int x, int y) const
+    {
+        VSNRAY_UNUSED(r);
+        VSNRAY_UNUSED(y);
+
+        float u2 = gen.next();
+        float u3 = gen.next();
+        float u4 = gen.next();
+        float u5 = gen.next();
+
+        float f = (u2 + u3 < edge(x) ? 1.0f : 0.0f) + std::exp(-(u4 * u4 + u5 * u5));
+
+        result_record<float> result;
+        result.hit = true;
+        result.color = vec4(f, f, f, 1.0f);
+        return result;
+    }
+};
+
+template <typename Sampler>
+static std::vector<double> measure(char const* name, tiled_sched<ray_type>& sched, pinhole_camera const& cam)
+{
+    rt_type rt;
+    rt.resize(Width, Height);
+    rt.clear_color_buffer();
+
+    std::vector<double> rmse;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 1; frame <= Frames; ++frame)
+    {
+        float alpha = 1.0f / frame;
+
+        Sampler sampler;
+        sampler.spp = 1;
+        sampler.sfactor = alpha;
+        sampler.dfactor = 1.0f - alpha;
+
+        sched.frame(kernel{}, make_sched_params(sampler, cam, rt));
+
+        if ((frame & (frame - 1)) == 0)
+        {
+            double sum = 0.0;
+
+            for (int y = 0; y < Height; ++y)
+            {
+                for (int x = 0; x < Width; ++x)
+                {
+                    double ref = edge_integral(edge(x)) + gauss_integral();
+                    double err = rt.color()[y * Width + x].x - ref;
+                    sum += err * err;
+                }
+            }
+
+            rmse.push_back(std::sqrt(sum / (Width * Height)));
+        }
+    }
+
+    auto stop = std::chrono::steady_clock::now();
+
+    std::printf(
+            "%-12s %8.1f ms\n",
+            name,
+            std::chrono::duration<double, std::milli>(stop - start).count()
+            );
+
+    return rmse;
+}
+
+int main()
+{
+    tiled_sched<ray_type> sched(std::thread::hardware_concurrency());
+
+    pinhole_camera cam;
+    cam.set_viewport(0, 0, Width, Height);
+    cam.perspective(45.0f * constants::degrees_to_radians<float>(), 1.0f, 0.001f, 1000.0f);
+
+    std::printf("Render time for %d frames (%dx%d pixels):\n", Frames, Width, Height);
+
+    std::vector<std::vector<double>> rmse;
+    rmse.push_back(measure<pixel_sampler::jittered_blend_type>("random", sched, cam));
+    rmse.push_back(measure<pixel_sampler::sobol_blend_type>("sobol", sched, cam));
+    rmse.push_back(measure<pixel_sampler::halton_blend_type>("halton", sched, cam));
+    rmse.push_back(measure<pixel_sampler::blue_noise_blend_type>("blue noise", sched, cam));
+
+    std::printf("\nRMSE:\n");
+    std::printf("%8s %12s %12s %12s %12s\n", "spp", "random", "sobol", "halton", "blue noise");
+
+    for (size_t i = 0; i < rmse[0].size(); ++i)
+    {
+        std::printf(
+                "%8d %12.6f %12.6f %12.6f %12.6f\n",
+                1 << i,
+                rmse[0][i],
+                rmse[1][i],
+                rmse[2][i],
+                rmse[3][i]
+                );
+    }
+}
@@ -16,10 +16,19 @@ namespace visionaray
 //-------------------------------------------------------------------------------------------------
 // Intersector to gather bvh costs
 //
+// Primitive intersections are passed on to the intersector the kernel was called with,
+// e.g. one that knows the vertices of indexed triangles
+//
 
-struct bvh_cost_intersector : basic_intersector<bvh_cost_intersector>
+template <typename Base>
+struct bvh_cost_intersector : basic_intersector<bvh_cost_intersector<Base>>
 {
-    using basic_intersector<bvh_cost_intersector>::operator();
+    using basic_intersector<bvh_cost_intersector<Base>>::operator();
+
+    VSNRAY_FUNC explicit bvh_cost_intersector(Base& b)
+        : base(b)
+    {
+    }
 
     template <typename R, typename S, typename ...Args>
     VSNRAY_FUNC
@@ -33,12 +42,23 @@ struct bvh_cost_intersector : basic_intersector<bvh_cost_intersector>
     template <typename R, typename S>
     VSNRAY_FUNC
     auto operator()(R const& ray, basic_triangle<3, S> const& tri)
-        -> decltype( intersect(ray, tri) )
+        -> decltype( std::declval<Base&>()(ray, tri) )
+    {
+        ++num_tris;
+        return base(ray, tri);
+    }
+
+    template <typename R, typename S>
+    VSNRAY_FUNC
+    auto operator()(R const& ray, basic_indexed_triangle<S> const& tri)
+        -> decltype( std::declval<Base&>()(ray, tri) )
     {
         ++num_tris;
-        return intersect(ray, tri);
+        return base(ray, tri);
     }
 
+    Base& base;
+
     unsigned num_boxes = 0;
     unsigned num_tris  = 0;
 };
@@ -56,8 +76,8 @@ struct bvh_costs_kernel
     {
     }
 
-    template <typename R>
-    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(R ray) const
+    template <typename Intersector, typename R>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(Intersector& isect, R ray) const
     {
         using S = typename R::scalar_type;
         using C = vector<4, S>;
@@ -69,7 +89,7 @@ struct bvh_costs_kernel
 
         result_record<S> result;
 
-        bvh_cost_intersector i;
+        bvh_cost_intersector<Intersector> i(isect);
 
         auto hit_rec = closest_hit(ray, params.prims.begin, params.prims.end, i);
 
@@ -82,6 +102,13 @@ struct bvh_costs_kernel
         return result;
     }
 
+    template <typename R>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(R ray) const
+    {
+        default_intersector ignore;
+        return (*this)(ignore, ray);
+    }
+
     Params params;
 };
 
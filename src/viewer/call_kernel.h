@@ -6,6 +6,7 @@
 #ifndef VSNRAY_VIEWER_CALL_KERNEL_H
 #define VSNRAY_VIEWER_CALL_KERNEL_H 1
 
+#include <memory>
 #include <utility>
 
 #include <visionaray/kernels.h>
@@ -15,6 +16,13 @@
 #include <visionaray/thin_lens_camera.h>
 #include <visionaray/variant.h>
 
+#if !defined(__CUDACC__) && !defined(__MINGW32__) && !defined(__MINGW64__)
+#define VSNRAY_VIEWER_HAVE_WAVEFRONT 1
+#include <thread>
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/wavefront_pathtracer.h>
+#endif
+
 #include "bvh_costs.h"
 
 namespace visionaray
@@ -31,22 +39,150 @@ namespace visionaray
 
 
 
-enum algorithm { Simple, Whitted, Pathtracing, Costs };
+enum algorithm { Simple, Whitted, Pathtracing, Costs, Wavefront };
+
+
+//-------------------------------------------------------------------------------------------------
+// Algorithms that accumulate samples over subsequent frames
+//
+
+inline bool is_progressive(algorithm algo)
+{
+    return algo == Pathtracing || algo == Wavefront;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// State of the wavefront path tracer
+//
+// Owned by the renderer, so that the thread pool and the path state buffers are created
+// and destroyed with it and are reused between frames. The path state depends on the
+// kernel params type and is recreated when a frame uses other kernel params
+//
+
+class wavefront_state
+{
+public:
+
+#ifdef VSNRAY_VIEWER_HAVE_WAVEFRONT
+    thread_pool& pool()
+    {
+        if (pool_ == nullptr)
+        {
+            pool_.reset(new pool_holder);
+        }
+
+        return static_cast<pool_holder&>(*pool_).pool;
+    }
+
+    template <typename KParams>
+    pathtracing::wavefront<KParams>& wavefront()
+    {
+        auto holder = dynamic_cast<wavefront_holder<KParams>*>(wavefront_.get());
+
+        if (holder == nullptr)
+        {
+            holder = new wavefront_holder<KParams>;
+            wavefront_.reset(holder);
+        }
+
+        return holder->wf;
+    }
+#endif
+
+private:
+
+    struct holder_base
+    {
+        virtual ~holder_base() = default;
+    };
+
+#ifdef VSNRAY_VIEWER_HAVE_WAVEFRONT
+    struct pool_holder : holder_base
+    {
+        pool_holder() : pool(std::thread::hardware_concurrency()) {}
+        thread_pool pool;
+    };
+
+    template <typename KParams>
+    struct wavefront_holder : holder_base
+    {
+        pathtracing::wavefront<KParams> wf;
+    };
+#endif
+
+    std::unique_ptr<holder_base> pool_;
+    std::unique_ptr<holder_base> wavefront_;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Wavefront path tracer
+//
+// Only available with tiled_sched and a wavefront state, otherwise falls back to
+// pathtracing::kernel
+//
+
+template <typename Sched, typename KParams, typename ...Args>
+inline void call_wavefront(
+        Sched&                              sched,
+        wavefront_state*                    /* */,
+        KParams const&                      kparams,
+        pixel_sampler::jittered_blend_type  jps,
+        unsigned                            /* */,
+        Args&&...                           args
+        )
+{
+    sched.frame(
+        pathtracing::kernel<KParams>({kparams}),
+        make_sched_params(jps, std::forward<Args>(args)...)
+        );
+}
+
+#ifdef VSNRAY_VIEWER_HAVE_WAVEFRONT
+template <typename R, typename KParams, typename Camera, typename RT, typename ...Intersector>
+inline void call_wavefront(
+        tiled_sched<R>&                     sched,
+        wavefront_state*                    state,
+        KParams const&                      kparams,
+        pixel_sampler::jittered_blend_type  jps,
+        unsigned                            frame_num,
+        Camera                              cam,
+        RT&                                 rt,
+        Intersector&...                     isect
+        )
+{
+    if (state == nullptr)
+    {
+        sched.frame(
+            pathtracing::kernel<KParams>({kparams}),
+            make_sched_params(jps, cam, rt, isect...)
+            );
+        return;
+    }
+
+    auto& wf = state->wavefront<KParams>();
+    wf.set_params(kparams);
+    wf.frame(jps, cam, rt, frame_num, isect..., state->pool());
+}
+#endif
 
 
 //-------------------------------------------------------------------------------------------------
 // Pinhole camera vs. thin lens camera
 //
 
-template <typename Sched, typename KParams, typename RT>
+template <typename Sched, typename KParams, typename RT, typename ...Intersector>
 inline void call_kernel(
         algorithm                                        algo,
         Sched&                                           sched,
+        wavefront_state*                                 wavefront,
         KParams const&                                   kparams,
         unsigned&                                        frame_num,
         unsigned                                         spp,
         variant<pinhole_camera, thin_lens_camera> const& cam,
-        RT&                                              rt
+        RT&                                              rt,
+        Intersector&...                                  isect
         )
 {
     if (cam.as<thin_lens_camera>())
@@ -54,11 +190,13 @@ inline void call_kernel(
         call_kernel(
                 algo,
                 sched,
+                wavefront,
                 kparams,
                 frame_num,
                 spp,
                 *cam.as<thin_lens_camera>(),
-                rt
+                rt,
+                isect...
                 );
     }
     else
@@ -66,11 +204,13 @@ inline void call_kernel(
         call_kernel(
                 algo,
                 sched,
+                wavefront,
                 kparams,
                 frame_num,
                 spp,
                 *cam.as<pinhole_camera>(),
-                rt
+                rt,
+                isect...
                 );
     }
 }
@@ -79,15 +219,20 @@ inline void call_kernel(
 //-------------------------------------------------------------------------------------------------
 // Call one of the built-in kernels
 //
+// wavefront may be nullptr, the wavefront path tracer then falls back to
+// pathtracing::kernel. args are the camera, the render target and optionally
+// an intersector
+//
 
 template <typename Sched, typename KParams, typename ...Args>
 void call_kernel(
-        algorithm       algo,
-        Sched&          sched,
-        KParams const&  kparams,
-        unsigned&       frame_num,
-        unsigned        spp,
-        Args&&...       args
+        algorithm           algo,
+        Sched&              sched,
+        wavefront_state*    wavefront,
+        KParams const&      kparams,
+        unsigned&           frame_num,
+        unsigned            spp,
+        Args&&...           args
         )
 {
     switch (algo)
@@ -126,6 +271,23 @@ void call_kernel(
             );
         break;
     }
+    case Wavefront:
+    {
+        float alpha = 1.0f / ++frame_num;
+        pixel_sampler::jittered_blend_type jps;
+        jps.spp = spp;
+        jps.sfactor = alpha;
+        jps.dfactor = 1.0f - alpha;
+        call_wavefront(
+            sched,
+            wavefront,
+            kparams,
+            jps,
+            frame_num,
+            std::forward<Args>(args)...
+            );
+        break;
+    }
     case Costs:
     {
         sched.frame(
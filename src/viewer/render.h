@@ -14,6 +14,7 @@
 
 #include <visionaray/math/simd/simd.h>
 #include <visionaray/math/forward.h>
+#include <visionaray/math/indexed_triangle.h>
 #include <visionaray/math/ray.h>
 //#include <visionaray/math/sphere.h>
 #include <visionaray/math/triangle.h>
@@ -24,6 +25,7 @@
 #include <visionaray/environment_light.h>
 #include <visionaray/generic_light.h>
 #include <visionaray/generic_material.h>
+#include <visionaray/light_sampler.h>
 #include <visionaray/material.h>
 #include <visionaray/pinhole_camera.h>
 #include <visionaray/point_light.h>
@@ -85,6 +87,21 @@ using cuda_texture_t = cuda_texture_ref<vector<4, unorm<8>>, 2>;
 using device_environment_light = environment_light<float, cuda_texture_ref<vec4, 2>>;
 #endif
 
+enum light_sampling_strategy
+{
+    UniformLightSampling = 0,   // Select lights with uniform probability
+    PowerLightSampling,         // Select lights proportional to their power
+    LightBVHSampling            // Select lights with a light BVH
+};
+
+// Light samplers for the area lights, only the one that the strategy refers to is built
+struct area_light_samplers
+{
+    light_sampling_strategy strategy = UniformLightSampling;
+    power_light_sampler     power;
+    light_bvh               bvh;
+};
+
 #if defined(__INTEL_COMPILER) || defined(__MINGW32__) || defined(__MINGW64__)
 template <typename R>
 using host_sched_t = tbb_sched<R>;
@@ -99,23 +116,24 @@ using host_sched_t = tiled_sched<R>;
 //
 
 void render_plastic_cpp(
-        index_bvh<basic_triangle<3, float>> const& bvh,
-        aligned_vector<vec3> const&                geometric_normals,
-        aligned_vector<vec3> const&                shading_normals,
-        aligned_vector<vec2> const&                tex_coords,
-        aligned_vector<plastic_t> const&           materials,
-        aligned_vector<texture_t> const&           textures,
-        aligned_vector<point_light<float>> const&  lights,
-        unsigned                                   bounces,
-        float                                      epsilon,
-        vec4                                       bgcolor,
-        vec4                                       ambient,
-        host_device_rt&                            rt,
-        host_sched_t<ray_type_cpu>&                sched,
-        camera_t const&                            cam,
-        unsigned&                                  frame_num,
-        algorithm                                  algo,
-        unsigned                                   ssaa_samples
+        index_bvh<basic_triangle<3, float>>::bvh_ref bvh,
+        aligned_vector<vec3> const&                 geometric_normals,
+        aligned_vector<vec3> const&                 shading_normals,
+        aligned_vector<vec2> const&                 tex_coords,
+        aligned_vector<plastic_t> const&            materials,
+        aligned_vector<texture_t> const&            textures,
+        aligned_vector<point_light<float>> const&   lights,
+        unsigned                                    bounces,
+        float                                       epsilon,
+        vec4                                        bgcolor,
+        vec4                                        ambient,
+        host_device_rt&                             rt,
+        host_sched_t<ray_type_cpu>&                 sched,
+        wavefront_state&                            wavefront,
+        camera_t const&                             cam,
+        unsigned&                                   frame_num,
+        algorithm                                   algo,
+        unsigned                                    ssaa_samples
         );
 
 #ifdef __CUDACC__
@@ -146,19 +164,21 @@ void render_plastic_cu(
 //
 
 void render_generic_material_cpp(
-        index_bvh<basic_triangle<3, float>> const&                         bvh,
+        index_bvh<basic_triangle<3, float>>::bvh_ref                       bvh,
         aligned_vector<vec3> const&                                        geometric_normals,
         aligned_vector<vec3> const&                                        shading_normals,
         aligned_vector<vec2> const&                                        tex_coords,
         aligned_vector<generic_material_t> const&                          materials,
         aligned_vector<texture_t> const&                                   textures,
         aligned_vector<area_light<float, basic_triangle<3, float>>> const& lights,
+        area_light_samplers const&                                         light_samplers,
         unsigned                                                           bounces,
         float                                                              epsilon,
         vec4                                                               bgcolor,
         vec4                                                               ambient,
         host_device_rt&                                                    rt,
         host_sched_t<ray_type_cpu>&                                        sched,
+        wavefront_state&                                                   wavefront,
         camera_t const&                                                    cam,
         unsigned&                                                          frame_num,
         algorithm                                                          algo,
@@ -193,73 +213,78 @@ void render_generic_material_cu(
 //
 
 void render_instances_cpp(
-        index_bvh<index_bvh<basic_triangle<3, float>>::bvh_inst>& bvh,
-        aligned_vector<vec3> const&                               /*geometric_normals*/,
-        aligned_vector<vec3> const&                               shading_normals,
-        aligned_vector<vec2> const&                               tex_coords,
-        aligned_vector<generic_material_t> const&                 materials,
-        aligned_vector<vec3> const&                               colors,
-        aligned_vector<texture_t> const&                          textures,
-        aligned_vector<generic_light_t> const&                    lights,
-        unsigned                                                  bounces,
-        float                                                     epsilon,
-        vec4                                                      bgcolor,
-        vec4                                                      ambient,
-        host_device_rt&                                           rt,
-        host_sched_t<ray_type_cpu>&                               sched,
-        camera_t const&                                           cam,
-        unsigned&                                                 frame_num,
-        algorithm                                                 algo,
-        unsigned                                                  ssaa_samples,
-        host_environment_light const&                             env_light
+        index_bvh<index_bvh<basic_indexed_triangle<float>>::bvh_inst>& bvh,
+        aligned_vector<vec3> const&                                    vertices,
+        aligned_vector<vec3> const&                                    /*geometric_normals*/,
+        aligned_vector<vec3> const&                                    shading_normals,
+        aligned_vector<vec2> const&                                    tex_coords,
+        aligned_vector<generic_material_t> const&                      materials,
+        aligned_vector<vec3> const&                                    colors,
+        aligned_vector<texture_t> const&                               textures,
+        aligned_vector<generic_light_t> const&                         lights,
+        unsigned                                                       bounces,
+        float                                                          epsilon,
+        vec4                                                           bgcolor,
+        vec4                                                           ambient,
+        host_device_rt&                                                rt,
+        host_sched_t<ray_type_cpu>&                                    sched,
+        wavefront_state&                                               wavefront,
+        camera_t const&                                                cam,
+        unsigned&                                                      frame_num,
+        algorithm                                                      algo,
+        unsigned                                                       ssaa_samples,
+        host_environment_light const&                                  env_light
         );
 
 #ifdef __CUDACC__
 void render_instances_cu(
-        cuda_index_bvh<cuda_index_bvh<basic_triangle<3, float>>::bvh_inst>& bvh,
-        thrust::device_vector<vec3> const&                                  geometric_normals,
-        thrust::device_vector<vec3> const&                                  shading_normals,
-        thrust::device_vector<vec2> const&                                  tex_coords,
-        thrust::device_vector<generic_material_t> const&                    materials,
-        thrust::device_vector<vec3> const&                                  colors,
-        thrust::device_vector<cuda_texture_t> const&                        textures,
-        aligned_vector<generic_light_t> const&                              lights,
-        unsigned                                                            bounces,
-        float                                                               epsilon,
-        vec4                                                                bgcolor,
-        vec4                                                                ambient,
-        host_device_rt&                                                     rt,
-        cuda_sched<ray_type_gpu>&                                           sched,
-        camera_t const&                                                     cam,
-        unsigned&                                                           frame_num,
-        algorithm                                                           algo,
-        unsigned                                                            ssaa_samples,
-        device_environment_light const&                                     env_light
+        cuda_index_bvh<cuda_index_bvh<basic_indexed_triangle<float>>::bvh_inst>& bvh,
+        thrust::device_vector<vec3> const&                                       vertices,
+        thrust::device_vector<vec3> const&                                       geometric_normals,
+        thrust::device_vector<vec3> const&                                       shading_normals,
+        thrust::device_vector<vec2> const&                                       tex_coords,
+        thrust::device_vector<generic_material_t> const&                         materials,
+        thrust::device_vector<vec3> const&                                       colors,
+        thrust::device_vector<cuda_texture_t> const&                             textures,
+        aligned_vector<generic_light_t> const&                                   lights,
+        unsigned                                                                 bounces,
+        float                                                                    epsilon,
+        vec4                                                                     bgcolor,
+        vec4                                                                     ambient,
+        host_device_rt&                                                          rt,
+        cuda_sched<ray_type_gpu>&                                                sched,
+        camera_t const&                                                          cam,
+        unsigned&                                                                frame_num,
+        algorithm                                                                algo,
+        unsigned                                                                 ssaa_samples,
+        device_environment_light const&                                          env_light
         );
 #endif
 
 #if VSNRAY_COMMON_HAVE_PTEX
 // With ptex textures
 void render_instances_ptex_cpp(
-        index_bvh<index_bvh<basic_triangle<3, float>>::bvh_inst>& bvh,
-        aligned_vector<vec3> const&                               /*geometric_normals*/,
-        aligned_vector<vec3> const&                               shading_normals,
-        aligned_vector<ptex::face_id_t> const&                    face_ids,
-        aligned_vector<generic_material_t> const&                 materials,
-        aligned_vector<vec3> const&                               colors,
-        aligned_vector<ptex::texture> const&                      textures,
-        aligned_vector<generic_light_t> const&                    lights,
-        unsigned                                                  bounces,
-        float                                                     epsilon,
-        vec4                                                      bgcolor,
-        vec4                                                      ambient,
-        host_device_rt&                                           rt,
-        host_sched_t<ray_type_cpu>&                               sched,
-        camera_t const&                                           cam,
-        unsigned&                                                 frame_num,
-        algorithm                                                 algo,
-        unsigned                                                  ssaa_samples,
-        host_environment_light const&                             env_light
+        index_bvh<index_bvh<basic_indexed_triangle<float>>::bvh_inst>& bvh,
+        aligned_vector<vec3> const&                                    vertices,
+        aligned_vector<vec3> const&                                    /*geometric_normals*/,
+        aligned_vector<vec3> const&                                    shading_normals,
+        aligned_vector<ptex::face_id_t> const&                         face_ids,
+        aligned_vector<generic_material_t> const&                      materials,
+        aligned_vector<vec3> const&                                    colors,
+        aligned_vector<ptex::texture> const&                           textures,
+        aligned_vector<generic_light_t> const&                         lights,
+        unsigned                                                       bounces,
+        float                                                          epsilon,
+        vec4                                                           bgcolor,
+        vec4                                                           ambient,
+        host_device_rt&                                                rt,
+        host_sched_t<ray_type_cpu>&                                    sched,
+        wavefront_state&                                               wavefront,
+        camera_t const&                                                cam,
+        unsigned&                                                      frame_num,
+        algorithm                                                      algo,
+        unsigned                                                       ssaa_samples,
+        host_environment_light const&                                  env_light
         );
 #endif
 
@@ -7,19 +7,21 @@ namespace visionaray
 {
 
 void render_generic_material_cpp(
-        index_bvh<basic_triangle<3, float>> const&                         bvh,
+        index_bvh<basic_triangle<3, float>>::bvh_ref                       bvh,
         aligned_vector<vec3> const&                                        geometric_normals,
         aligned_vector<vec3> const&                                        shading_normals,
         aligned_vector<vec2> const&                                        tex_coords,
         aligned_vector<generic_material_t> const&                          materials,
         aligned_vector<texture_t> const&                                   textures,
         aligned_vector<area_light<float, basic_triangle<3, float>>> const& lights,
+        area_light_samplers const&                                         light_samplers,
         unsigned                                                           bounces,
         float                                                              epsilon,
         vec4                                                               bgcolor,
         vec4                                                               ambient,
         host_device_rt&                                                    rt,
         host_sched_t<ray_type_cpu>&                                        sched,
+        wavefront_state&                                                   wavefront,
         camera_t const&                                                    cam,
         unsigned&                                                          frame_num,
         algorithm                                                          algo,
@@ -30,7 +32,7 @@ void render_generic_material_cpp(
 
     aligned_vector<bvh_ref> primitives;
 
-    primitives.push_back(bvh.ref());
+    primitives.push_back(bvh);
 
     auto kparams = make_kernel_params(
             normals_per_vertex_binding{},
@@ -49,7 +51,20 @@ void render_generic_material_cpp(
             ambient
             );
 
-    call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+    if (light_samplers.strategy == PowerLightSampling)
+    {
+        auto kp = with_light_sampler(kparams, light_samplers.power.ref());
+        call_kernel( algo, sched, &wavefront, kp, frame_num, ssaa_samples, cam, rt );
+    }
+    else if (light_samplers.strategy == LightBVHSampling)
+    {
+        auto kp = with_light_sampler(kparams, light_samplers.bvh.ref());
+        call_kernel( algo, sched, &wavefront, kp, frame_num, ssaa_samples, cam, rt );
+    }
+    else
+    {
+        call_kernel( algo, sched, &wavefront, kparams, frame_num, ssaa_samples, cam, rt );
+    }
 }
 
 } // visionaray
@@ -55,7 +55,7 @@ void render_generic_material_cu(
             ambient
             );
 
-    call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+    call_kernel( algo, sched, nullptr, kparams, frame_num, ssaa_samples, cam, rt );
 #endif
 }
 
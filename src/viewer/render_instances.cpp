@@ -9,33 +9,38 @@ namespace visionaray
 {
 
 void render_instances_cpp(
-        index_bvh<index_bvh<basic_triangle<3, float>>::bvh_inst>& bvh,
-        aligned_vector<vec3> const&                               geometric_normals,
-        aligned_vector<vec3> const&                               shading_normals,
-        aligned_vector<vec2> const&                               tex_coords,
-        aligned_vector<generic_material_t> const&                 materials,
-        aligned_vector<vec3> const&                               colors,
-        aligned_vector<texture_t> const&                          textures,
-        aligned_vector<generic_light_t> const&                    lights,
-        unsigned                                                  bounces,
-        float                                                     epsilon,
-        vec4                                                      bgcolor,
-        vec4                                                      ambient,
-        host_device_rt&                                           rt,
-        host_sched_t<ray_type_cpu>&                               sched,
-        camera_t const&                                           cam,
-        unsigned&                                                 frame_num,
-        algorithm                                                 algo,
-        unsigned                                                  ssaa_samples,
-        host_environment_light const&                             env_light
+        index_bvh<index_bvh<basic_indexed_triangle<float>>::bvh_inst>& bvh,
+        aligned_vector<vec3> const&                                    vertices,
+        aligned_vector<vec3> const&                                    geometric_normals,
+        aligned_vector<vec3> const&                                    shading_normals,
+        aligned_vector<vec2> const&                                    tex_coords,
+        aligned_vector<generic_material_t> const&                      materials,
+        aligned_vector<vec3> const&                                    colors,
+        aligned_vector<texture_t> const&                               textures,
+        aligned_vector<generic_light_t> const&                         lights,
+        unsigned                                                       bounces,
+        float                                                          epsilon,
+        vec4                                                           bgcolor,
+        vec4                                                           ambient,
+        host_device_rt&                                                rt,
+        host_sched_t<ray_type_cpu>&                                    sched,
+        wavefront_state&                                               wavefront,
+        camera_t const&                                                cam,
+        unsigned&                                                      frame_num,
+        algorithm                                                      algo,
+        unsigned                                                       ssaa_samples,
+        host_environment_light const&                                  env_light
         )
 {
-    using bvh_ref = index_bvh<index_bvh<basic_triangle<3, float>>::bvh_inst>::bvh_ref;
+    using bvh_ref = index_bvh<index_bvh<basic_indexed_triangle<float>>::bvh_inst>::bvh_ref;
 
     aligned_vector<bvh_ref> primitives;
 
     primitives.push_back(bvh.ref());
 
+    // The indexed triangles only store vertex indices, the intersector has the vertices
+    indexed_triangle_intersector<float> isect(vertices.data());
+
     if (env_light.texture())
     {
         auto kparams = make_kernel_params(
@@ -57,7 +62,7 @@ void render_instances_cpp(
                 epsilon
                 );
 
-        call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+        call_kernel( algo, sched, &wavefront, kparams, frame_num, ssaa_samples, cam, rt, isect );
     }
     else
     {
@@ -80,7 +85,7 @@ void render_instances_cpp(
                 ambient
                 );
 
-        call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+        call_kernel( algo, sched, &wavefront, kparams, frame_num, ssaa_samples, cam, rt, isect );
     }
 }
 
@@ -9,33 +9,37 @@ namespace visionaray
 {
 
 void render_instances_cu(
-        cuda_index_bvh<cuda_index_bvh<basic_triangle<3, float>>::bvh_inst>& bvh,
-        thrust::device_vector<vec3> const&                                  geometric_normals,
-        thrust::device_vector<vec3> const&                                  shading_normals,
-        thrust::device_vector<vec2> const&                                  tex_coords,
-        thrust::device_vector<generic_material_t> const&                    materials,
-        thrust::device_vector<vec3> const&                                  colors,
-        thrust::device_vector<cuda_texture_t> const&                        textures,
-        aligned_vector<generic_light_t> const&                              host_lights,
-        unsigned                                                            bounces,
-        float                                                               epsilon,
-        vec4                                                                bgcolor,
-        vec4                                                                ambient,
-        host_device_rt&                                                     rt,
-        cuda_sched<ray_type_gpu>&                                           sched,
-        camera_t const&                                                     cam,
-        unsigned&                                                           frame_num,
-        algorithm                                                           algo,
-        unsigned                                                            ssaa_samples,
-        device_environment_light const&                                     env_light
+        cuda_index_bvh<cuda_index_bvh<basic_indexed_triangle<float>>::bvh_inst>& bvh,
+        thrust::device_vector<vec3> const&                                       vertices,
+        thrust::device_vector<vec3> const&                                       geometric_normals,
+        thrust::device_vector<vec3> const&                                       shading_normals,
+        thrust::device_vector<vec2> const&                                       tex_coords,
+        thrust::device_vector<generic_material_t> const&                         materials,
+        thrust::device_vector<vec3> const&                                       colors,
+        thrust::device_vector<cuda_texture_t> const&                             textures,
+        aligned_vector<generic_light_t> const&                                   host_lights,
+        unsigned                                                                 bounces,
+        float                                                                    epsilon,
+        vec4                                                                     bgcolor,
+        vec4                                                                     ambient,
+        host_device_rt&                                                          rt,
+        cuda_sched<ray_type_gpu>&                                                sched,
+        camera_t const&                                                          cam,
+        unsigned&                                                                frame_num,
+        algorithm                                                                algo,
+        unsigned                                                                 ssaa_samples,
+        device_environment_light const&                                          env_light
         )
 {
-    using bvh_ref = cuda_index_bvh<cuda_index_bvh<basic_triangle<3, float>>::bvh_inst>::bvh_ref;
+    using bvh_ref = cuda_index_bvh<cuda_index_bvh<basic_indexed_triangle<float>>::bvh_inst>::bvh_ref;
 
     thrust::device_vector<bvh_ref> primitives;
 
     primitives.push_back(bvh.ref());
 
+    // The indexed triangles only store vertex indices, the intersector has the vertices
+    indexed_triangle_intersector<float> isect(thrust::raw_pointer_cast(vertices.data()));
+
     thrust::device_vector<generic_light_t> device_lights = host_lights;
 
     if (env_light.texture())
@@ -59,7 +63,7 @@ void render_instances_cu(
                 epsilon
                 );
 
-        call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+        call_kernel( algo, sched, nullptr, kparams, frame_num, ssaa_samples, cam, rt, isect );
     }
     else
     {
@@ -82,7 +86,7 @@ void render_instances_cu(
                 ambient
                 );
 
-        call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+        call_kernel( algo, sched, nullptr, kparams, frame_num, ssaa_samples, cam, rt, isect );
     }
 }
 
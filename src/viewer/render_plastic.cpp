@@ -9,30 +9,31 @@ namespace visionaray
 {
 
 void render_plastic_cpp(
-        index_bvh<basic_triangle<3, float>> const& bvh,
-        aligned_vector<vec3> const&                geometric_normals,
-        aligned_vector<vec3> const&                shading_normals,
-        aligned_vector<vec2> const&                tex_coords,
-        aligned_vector<plastic_t> const&           materials,
-        aligned_vector<texture_t> const&           textures,
-        aligned_vector<point_light<float>> const&  lights,
-        unsigned                                   bounces,
-        float                                      epsilon,
-        vec4                                       bgcolor,
-        vec4                                       ambient,
-        host_device_rt&                            rt,
-        host_sched_t<ray_type_cpu>&                sched,
-        camera_t const&                            cam,
-        unsigned&                                  frame_num,
-        algorithm                                  algo,
-        unsigned                                   ssaa_samples
+        index_bvh<basic_triangle<3, float>>::bvh_ref bvh,
+        aligned_vector<vec3> const&                 geometric_normals,
+        aligned_vector<vec3> const&                 shading_normals,
+        aligned_vector<vec2> const&                 tex_coords,
+        aligned_vector<plastic_t> const&            materials,
+        aligned_vector<texture_t> const&            textures,
+        aligned_vector<point_light<float>> const&   lights,
+        unsigned                                    bounces,
+        float                                       epsilon,
+        vec4                                        bgcolor,
+        vec4                                        ambient,
+        host_device_rt&                             rt,
+        host_sched_t<ray_type_cpu>&                 sched,
+        wavefront_state&                            wavefront,
+        camera_t const&                             cam,
+        unsigned&                                   frame_num,
+        algorithm                                   algo,
+        unsigned                                    ssaa_samples
         )
 {
     using bvh_ref = index_bvh<basic_triangle<3, float>>::bvh_ref;
 
     aligned_vector<bvh_ref> primitives;
 
-    primitives.push_back(bvh.ref());
+    primitives.push_back(bvh);
 
     auto kparams = make_kernel_params(
             normals_per_vertex_binding{},
@@ -51,7 +52,7 @@ void render_plastic_cpp(
             ambient
             );
 
-    call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+    call_kernel( algo, sched, &wavefront, kparams, frame_num, ssaa_samples, cam, rt );
 }
 
 } // visionaray
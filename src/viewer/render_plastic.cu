@@ -53,7 +53,7 @@ void render_plastic_cu(
             ambient
             );
 
-    call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+    call_kernel( algo, sched, nullptr, kparams, frame_num, ssaa_samples, cam, rt );
 }
 
 } // visionaray
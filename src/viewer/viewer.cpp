@@ -10,8 +10,11 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <functional>
 #include <future>
 #include <iomanip>
 #include <iostream>
@@ -25,6 +28,7 @@
 #include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/filesystem.hpp>
@@ -32,6 +36,7 @@
 #ifdef __CUDACC__
 #include <cuda_runtime_api.h>
 #include <thrust/device_vector.h>
+#include <thrust/for_each.h>
 #endif
 
 #include <imgui.h>
@@ -39,12 +44,15 @@
 #include <Support/CmdLine.h>
 #include <Support/CmdLineUtil.h>
 
+#include <visionaray/detail/thread_pool.h>
 #include <visionaray/gl/debug_callback.h>
 #include <visionaray/math/math.h>
 #include <visionaray/texture/texture.h>
 #include <visionaray/aligned_vector.h>
 #include <visionaray/area_light.h>
+#include <visionaray/array_ref.h>
 #include <visionaray/bvh.h>
+#include <visionaray/distribution_2d.h>
 #include <visionaray/environment_light.h>
 #include <visionaray/generic_material.h>
 #include <visionaray/kernels.h>
@@ -63,6 +71,7 @@
 #include <common/manip/arcball_manipulator.h>
 #include <common/manip/pan_manipulator.h>
 #include <common/manip/zoom_manipulator.h>
+#include <common/bvh_cache.h>
 #include <common/bvh_outline_renderer.h>
 #include <common/inifile.h>
 #include <common/make_materials.h>
@@ -99,6 +108,16 @@ enum class copy_kind
     DeviceToDevice,
 };
 
+template <typename DestBVHs, typename SourceBVHs>
+static void copy_bvhs(DestBVHs& dest_bvhs, SourceBVHs const& source_bvhs)
+{
+    dest_bvhs.resize(source_bvhs.size());
+    for (size_t i = 0; i < source_bvhs.size(); ++i)
+    {
+        dest_bvhs[i] = typename DestBVHs::value_type(source_bvhs[i]);
+    }
+}
+
 template <typename DestInstances, typename DestTopLevel, typename SourceInstances, typename SourceTopLevel>
 static void copy_bvhs(
         DestInstances&         dest_instance_bvhs,
@@ -109,11 +128,7 @@ static void copy_bvhs(
         )
 {
     // Build up lower level bvhs first
-    dest_instance_bvhs.resize(source_instance_bvhs.size());
-    for (size_t i = 0; i < source_instance_bvhs.size(); ++i)
-    {
-        dest_instance_bvhs[i] = typename DestInstances::value_type(source_instance_bvhs[i]);
-    }
+    copy_bvhs(dest_instance_bvhs, source_instance_bvhs);
 
     // Make a deep copy of the top level bvh
     if (source_top_level_bvh.num_primitives() > 0)
@@ -219,12 +234,25 @@ static void copy_bvhs(
 struct renderer : viewer_type
 {
     using primitive_type            = model::triangle_type;
+    using indexed_primitive_type    = basic_indexed_triangle<float>;
     using normal_type               = model::normal_type;
     using tex_coord_type            = model::tex_coord_type;
     using color_type                = model::color_type;
     using host_bvh_type             = index_bvh<primitive_type>;
+    using host_bvh_view_type        = index_bvh_t<
+                                            array_ref<primitive_type>,
+                                            array_ref<bvh_node>,
+                                            array_ref<unsigned>
+                                            >;
+    using host_indexed_bvh_type     = index_bvh<indexed_primitive_type>;
+    using host_indexed_bvh_view_type = index_bvh_t<
+                                            array_ref<indexed_primitive_type>,
+                                            array_ref<bvh_node>,
+                                            array_ref<unsigned>
+                                            >;
 #ifdef __CUDACC__
     using device_bvh_type           = cuda_index_bvh<primitive_type>;
+    using device_indexed_bvh_type   = cuda_index_bvh<indexed_primitive_type>;
     using device_tex_type           = cuda_texture<vector<4, unorm<8>>, 2>;
     using device_tex_ref_type       = typename device_tex_type::ref_type;
 #endif
@@ -234,6 +262,7 @@ struct renderer : viewer_type
         Binned = 0, // Binned SAH builder, no spatial splits
         Split,      // Split BVH, also binned and with SAH
         LBVH,       // LBVH builder on the CPU
+        PLOC,       // PLOC builder on the CPU
     };
 
     enum texture_format { Ptex, UV };
@@ -299,7 +328,8 @@ struct renderer : viewer_type
                 { "simple",             Simple,         "Simple ray casting kernel" },
                 { "whitted",            Whitted,        "Whitted style ray tracing kernel" },
                 { "pathtracing",        Pathtracing,    "Pathtracing global illumination kernel" },
-                { "costs",              Costs,          "BVH cost kernel" }
+                { "costs",              Costs,          "BVH cost kernel" },
+                { "wavefront",          Wavefront,      "Wavefront path tracer (CPU only)" }
             },
             "algorithm",
             cl::Desc("Rendering algorithm"),
@@ -310,7 +340,8 @@ struct renderer : viewer_type
         add_cmdline_option( cl::makeOption<bvh_build_strategy&>({
                 { "default",            Binned,         "Binned SAH" },
                 { "split",              Split,          "Binned SAH with spatial splits" },
-                { "lbvh",               LBVH,           "LBVH (CPU)" }
+                { "lbvh",               LBVH,           "LBVH (CPU)" },
+                { "ploc",               PLOC,           "PLOC (CPU)" }
             },
             "bvh",
             cl::Desc("BVH build strategy"),
@@ -318,6 +349,25 @@ struct renderer : viewer_type
             cl::init(this->build_strategy)
             ) );
 
+        add_cmdline_option( cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "bvhcache",
+            cl::Desc("Directory to store BVHs in and to load them from on subsequent runs"),
+            cl::ArgRequired,
+            cl::init(this->bvh_cache_dir)
+            ) );
+
+        add_cmdline_option( cl::makeOption<light_sampling_strategy&>({
+                { "uniform",            UniformLightSampling,   "Select lights with uniform probability" },
+                { "power",              PowerLightSampling,     "Select lights proportional to their power" },
+                { "bvh",                LightBVHSampling,       "Select lights with a light BVH" }
+            },
+            "light_sampling",
+            cl::Desc("Light selection strategy for path tracing with area lights (CPU only)"),
+            cl::ArgRequired,
+            cl::init(this->area_light_sampling.strategy)
+            ) );
+
         // The following two options both manipulate spp
         add_cmdline_option( cl::makeOption<unsigned&>({
                 { "1",      1,      "1x supersampling" },
@@ -450,6 +500,10 @@ struct renderer : viewer_type
                     {
                         this->algo = Costs;
                     }
+                    else if (algo == "wavefront")
+                    {
+                        this->algo = Wavefront;
+                    }
                 }
 
                 // ambient
@@ -501,6 +555,10 @@ struct renderer : viewer_type
                     {
                         build_strategy = LBVH;
                     }
+                    else if (bvh == "ploc")
+                    {
+                        build_strategy = PLOC;
+                    }
                 }
 
                 // color space
@@ -640,26 +698,39 @@ struct renderer : viewer_type
     std::string                                 initial_camera;
     std::string                                 current_cam;
     std::string                                 screenshot_file_base = "screenshot";
+    std::string                                 bvh_cache_dir;
 
     model                                       mod;
     vec3                                        ambient         = vec3(-1.0f);
 
-    index_bvh<host_bvh_type::bvh_inst>          host_top_level_bvh;
-    aligned_vector<host_bvh_type>               host_bvhs;
-    aligned_vector<host_bvh_type::bvh_inst>     host_instances;
+    index_bvh<host_indexed_bvh_type::bvh_inst>  host_top_level_bvh;
+    // Views on BVHs in host_bvh_storage or mapped from the BVH cache
+    aligned_vector<host_bvh_view_type>          host_bvhs;
+    std::deque<host_bvh_type>                   host_bvh_storage;
+    // Views on the instanced BVHs over indexed triangles, same as above
+    aligned_vector<host_indexed_bvh_view_type>  host_indexed_bvhs;
+    std::deque<host_indexed_bvh_type>           host_indexed_bvh_storage;
+    std::unique_ptr<bvh_cache>                  host_bvh_cache;
+    aligned_vector<host_indexed_bvh_type::bvh_inst> host_instances;
+    // Vertices that the indexed triangles refer to, per-vertex attributes are stored
+    // in mod.shading_normals, mod.tex_coords, and mod.colors
+    aligned_vector<vec3>                        vertices;
     aligned_vector<plastic<float>>              plastic_materials;
     aligned_vector<generic_material_t>          generic_materials;
     aligned_vector<point_light<float>>          point_lights;
     aligned_vector<spot_light<float>>           spot_lights;
     aligned_vector<area_light<float,
                    basic_triangle<3, float>>>   area_lights;
+    area_light_samplers                         area_light_sampling;
 #if VSNRAY_COMMON_HAVE_PTEX
     aligned_vector<ptex::face_id_t>             ptex_tex_coords;
     aligned_vector<ptex::texture>               ptex_textures;
 #endif
 #ifdef __CUDACC__
-    cuda_index_bvh<device_bvh_type::bvh_inst>   device_top_level_bvh;
+    cuda_index_bvh<device_indexed_bvh_type::bvh_inst> device_top_level_bvh;
     std::vector<device_bvh_type>                device_bvhs;
+    std::vector<device_indexed_bvh_type>        device_indexed_bvhs;
+    thrust::device_vector<vec3>                 device_vertices;
     thrust::device_vector<normal_type>          device_geometric_normals;
     thrust::device_vector<normal_type>          device_shading_normals;
     thrust::device_vector<tex_coord_type>       device_tex_coords;
@@ -671,6 +742,7 @@ struct renderer : viewer_type
 #endif
 
     host_sched_t<ray_type_cpu>                  host_sched;
+    wavefront_state                             host_wavefront;
     host_device_rt                              rt;
 #ifdef __CUDACC__
     cuda_sched<ray_type_gpu>                    device_sched;
@@ -680,6 +752,7 @@ struct renderer : viewer_type
     std::string                                 env_map_filename;
     visionaray::texture<vec4, 2>                env_map;
     host_environment_light                      env_light;
+    distribution_2d                             env_distribution;
 #ifdef __CUDACC__
     visionaray::cuda_texture<vec4, 2>           device_env_map;
     device_environment_light                    device_env_light;
@@ -888,8 +961,9 @@ inline std::ostream& operator<<(std::ostream& out, pinhole_camera const& cam)
 
 struct icosahedron
 {
-    aligned_vector<basic_triangle<3, float>> triangles;
+    aligned_vector<vec3> vertices;
     aligned_vector<vec3> normals;
+    aligned_vector<vec3i> indices;
 };
 
 inline icosahedron make_icosahedron()
@@ -936,33 +1010,13 @@ inline icosahedron make_icosahedron()
         { 7, 2, 11 }
         };
 
-    auto make_triangle = [&](int index)
-    {
-        vec3i idx = indices[index];
-        return basic_triangle<3, float>(
-                vertices[idx.x],
-                vertices[idx.y] - vertices[idx.x],
-                vertices[idx.z] - vertices[idx.x]
-                );
-    };
-
     icosahedron result;
-    result.triangles.resize(20);
-    result.normals.resize(20 * 3);
+    result.vertices.assign(std::begin(vertices), std::end(vertices));
+    result.indices.assign(std::begin(indices), std::end(indices));
 
-    for (int i = 0; i < 20; ++i)
+    for (auto const& v : result.vertices)
     {
-        result.triangles[i] = make_triangle(i);
-
-        vec3i idx = indices[i];
-
-        vec3 v1 = vertices[idx.x];
-        vec3 v2 = vertices[idx.y];
-        vec3 v3 = vertices[idx.z];
-
-        result.normals[i * 3] = normalize(v1);
-        result.normals[i * 3 + 1] = normalize(v2);
-        result.normals[i * 3 + 2] = normalize(v3);
+        result.normals.push_back(normalize(v));
     }
 
     return result;
@@ -1018,6 +1072,289 @@ struct instance
 };
 
 
+//-------------------------------------------------------------------------------------------------
+// Convert the triangle soup of a model without a scene graph to indexed triangles
+//
+// Triangle corners with the same position and attributes become one shared vertex.
+// Per-corner attributes (stored at prim_id * 3 + corner) are replaced with per-vertex
+// attributes that are parallel to vertices, as the instanced render path expects.
+//
+
+struct corner_hash
+{
+    size_t operator()(std::array<uint32_t, 11> const& key) const
+    {
+        size_t seed = 0;
+
+        for (uint32_t bits : key)
+        {
+            seed ^= std::hash<uint32_t>()(bits) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+
+        return seed;
+    }
+};
+
+static aligned_vector<renderer::indexed_primitive_type> make_indexed_triangles(
+        model&                  mod,
+        aligned_vector<vec3>&   vertices
+        )
+{
+    bool has_normals    = !mod.shading_normals.empty();
+    bool has_tex_coords = !mod.tex_coords.empty();
+    bool has_colors     = !mod.colors.empty();
+
+    model::normal_list shading_normals;
+    model::tex_coord_list tex_coords;
+    model::color_list colors;
+
+    std::unordered_map<std::array<uint32_t, 11>, unsigned, corner_hash> unique_vertices;
+
+    auto get_index = [&](vec3 const& v, size_t corner)
+    {
+        // Corners without attributes, e.g. of the ground plane, get the same
+        // defaults as in build_scene_visitor::add_vertex()
+        vec3 n = corner < mod.shading_normals.size() ? mod.shading_normals[corner] : vec3(0.0f);
+        vec2 tc = corner < mod.tex_coords.size() ? mod.tex_coords[corner] : vec2(0.0f);
+        vec3 c = corner < mod.colors.size() ? mod.colors[corner] : vec3(1.0f);
+
+        float values[11] = { v.x, v.y, v.z, n.x, n.y, n.z, tc.x, tc.y, c.x, c.y, c.z };
+
+        std::array<uint32_t, 11> key;
+        std::memcpy(key.data(), values, sizeof(values));
+
+        auto it = unique_vertices.find(key);
+
+        if (it == unique_vertices.end())
+        {
+            unsigned index = static_cast<unsigned>(vertices.size());
+
+            vertices.push_back(v);
+
+            if (has_normals)
+            {
+                shading_normals.push_back(n);
+            }
+
+            if (has_tex_coords)
+            {
+                tex_coords.push_back(tc);
+            }
+
+            if (has_colors)
+            {
+                colors.push_back(c);
+            }
+
+            it = unique_vertices.insert(std::make_pair(key, index)).first;
+        }
+
+        return it->second;
+    };
+
+    aligned_vector<renderer::indexed_primitive_type> triangles(mod.primitives.size());
+
+    for (size_t i = 0; i < mod.primitives.size(); ++i)
+    {
+        auto const& tri = mod.primitives[i];
+        size_t corner = static_cast<size_t>(tri.prim_id) * 3;
+
+        unsigned i1 = get_index(tri.v1, corner);
+        unsigned i2 = get_index(tri.v1 + tri.e1, corner + 1);
+        unsigned i3 = get_index(tri.v1 + tri.e2, corner + 2);
+
+        triangles[i] = renderer::indexed_primitive_type(i1, i2, i3);
+        triangles[i].prim_id = tri.prim_id;
+        triangles[i].geom_id = tri.geom_id;
+    }
+
+    if (has_normals)
+    {
+        mod.shading_normals = std::move(shading_normals);
+    }
+
+    if (has_tex_coords)
+    {
+        mod.tex_coords = std::move(tex_coords);
+    }
+
+    if (has_colors)
+    {
+        mod.colors = std::move(colors);
+    }
+
+    return triangles;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Make a view on a host BVH that is stored elsewhere
+//
+
+template <typename P>
+static index_bvh_t<array_ref<P>, array_ref<bvh_node>, array_ref<unsigned>> make_host_bvh_view(index_bvh<P>& tree)
+{
+    index_bvh_t<array_ref<P>, array_ref<bvh_node>, array_ref<unsigned>> result;
+
+    result.primitives() = array_ref<P>(tree.primitives().data(), tree.num_primitives());
+    result.nodes()      = array_ref<bvh_node>(tree.nodes().data(), tree.num_nodes());
+    result.indices()    = array_ref<unsigned>(tree.indices().data(), tree.num_indices());
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Build a host BVH, or map it from the BVH cache if it was built from the same inputs before
+//
+// Newly built BVHs are appended to storage (a deque, so existing views stay valid), the
+// returned view refers either to storage or to the mapped cache file.
+//
+
+static std::string bvh_cache_params(renderer::bvh_build_strategy build_strategy)
+{
+    std::string params = "strategy=" + std::to_string(static_cast<int>(build_strategy));
+
+    if (build_strategy == renderer::LBVH)
+    {
+        params += ";treelets=7;order=depth_first";
+    }
+
+    return params;
+}
+
+template <typename P>
+static void build_index_bvh(
+        P*                              primitives,
+        size_t                          num_primitives,
+        renderer::bvh_build_strategy    build_strategy,
+        std::deque<index_bvh<P>>&       storage,
+        thread_pool&                    pool
+        )
+{
+    if (build_strategy == renderer::LBVH)
+    {
+        lbvh_builder builder;
+
+        storage.emplace_back(builder.build(index_bvh<P>{}, primitives, num_primitives, -1, pool));
+
+        // Restructure treelets to get close to SAH quality
+        bvh_treelet_optimizer optimizer;
+        optimizer.optimize(storage.back(), pool);
+
+        // Morton order is not the order in which nodes are traversed
+        reorder_nodes(storage.back(), DepthFirstOrder);
+    }
+    else if (build_strategy == renderer::PLOC)
+    {
+        ploc_builder builder;
+
+        storage.emplace_back(builder.build(index_bvh<P>{}, primitives, num_primitives, -1, pool));
+    }
+    else
+    {
+        binned_sah_builder builder;
+        builder.enable_spatial_splits(build_strategy == renderer::Split);
+
+        storage.emplace_back(builder.build(index_bvh<P>{}, primitives, num_primitives, -1, pool));
+    }
+}
+
+static renderer::host_bvh_view_type build_host_bvh(
+        renderer::primitive_type*               primitives,
+        size_t                                  num_primitives,
+        renderer::bvh_build_strategy            build_strategy,
+        std::deque<renderer::host_bvh_type>&    storage,
+        bvh_cache*                              cache,
+        thread_pool&                            pool
+        )
+{
+    renderer::host_bvh_view_type result;
+
+    uint64_t key = 0;
+
+    if (cache != nullptr)
+    {
+        key = bvh_cache::make_key(primitives, num_primitives, bvh_cache_params(build_strategy));
+
+        if (cache->load(key, result))
+        {
+            return result;
+        }
+    }
+
+    build_index_bvh(primitives, num_primitives, build_strategy, storage, pool);
+
+    if (cache != nullptr && !cache->store(key, storage.back()))
+    {
+        std::cerr << "Could not write BVH to cache\n";
+    }
+
+    return make_host_bvh_view(storage.back());
+}
+
+// Indexed triangles only store vertex indices, builders need primitives with their own
+// vertices. The BVH is built over triangles with the same order and ids, its nodes and
+// indices then refer to the indexed triangles as well. The cache key is computed from the
+// indexed triangles and from these triangles, i.e. from the vertices they refer to
+static renderer::host_indexed_bvh_view_type build_host_bvh(
+        renderer::indexed_primitive_type*               primitives,
+        size_t                                          num_primitives,
+        aligned_vector<vec3> const&                     vertices,
+        renderer::bvh_build_strategy                    build_strategy,
+        std::deque<renderer::host_indexed_bvh_type>&    storage,
+        bvh_cache*                                      cache,
+        thread_pool&                                    pool
+        )
+{
+    renderer::host_indexed_bvh_view_type result;
+
+    aligned_vector<renderer::primitive_type> triangles(num_primitives);
+
+    for (size_t i = 0; i < num_primitives; ++i)
+    {
+        auto v = compute_vertices(primitives[i], vertices.data());
+
+        triangles[i] = renderer::primitive_type(v[0], v[1] - v[0], v[2] - v[0]);
+        triangles[i].prim_id = primitives[i].prim_id;
+        triangles[i].geom_id = primitives[i].geom_id;
+    }
+
+    uint64_t key = 0;
+
+    if (cache != nullptr)
+    {
+        key = bvh_cache::make_key(
+                primitives,
+                num_primitives,
+                triangles.data(),
+                triangles.size(),
+                bvh_cache_params(build_strategy)
+                );
+
+        if (cache->load(key, result))
+        {
+            return result;
+        }
+    }
+
+    std::deque<renderer::host_bvh_type> triangle_storage;
+    build_index_bvh(triangles.data(), num_primitives, build_strategy, triangle_storage, pool);
+
+    storage.emplace_back();
+    storage.back().primitives() = aligned_vector<renderer::indexed_primitive_type>(primitives, primitives + num_primitives);
+    storage.back().nodes()      = std::move(triangle_storage.back().nodes());
+    storage.back().indices()    = std::move(triangle_storage.back().indices());
+
+    if (cache != nullptr && !cache->store(key, storage.back()))
+    {
+        std::cerr << "Could not write BVH to cache\n";
+    }
+
+    return make_host_bvh_view(storage.back());
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Traverse the scene graph to construct geometry, materials and BVH instances
 //
@@ -1027,10 +1364,13 @@ struct build_scene_visitor : sg::node_visitor
     using node_visitor::apply;
 
     build_scene_visitor(
-            aligned_vector<renderer::host_bvh_type>& bvhs,
+            aligned_vector<renderer::host_indexed_bvh_view_type>& bvhs,
+            std::deque<renderer::host_indexed_bvh_type>& bvh_storage,
+            bvh_cache* cache,
             aligned_vector<instance>& instances,
-            aligned_vector<vec3>& shading_normals,
+            aligned_vector<vec3>& vertices,
             aligned_vector<vec3>& geometric_normals,
+            aligned_vector<vec3>& shading_normals,
             aligned_vector<vec2>& tex_coords,
             aligned_vector<vec3>& colors,
 #if VSNRAY_COMMON_HAVE_PTEX
@@ -1041,12 +1381,16 @@ struct build_scene_visitor : sg::node_visitor
             aligned_vector<spot_light<float>>& spot_lights,
             visionaray::texture<vec4, 2>& env_map,
             host_environment_light& env_light,
-            renderer::bvh_build_strategy build_strategy
+            renderer::bvh_build_strategy build_strategy,
+            thread_pool& pool
             )
         : bvhs_(bvhs)
+        , bvh_storage_(bvh_storage)
+        , cache_(cache)
         , instances_(instances)
-        , shading_normals_(shading_normals)
+        , vertices_(vertices)
         , geometric_normals_(geometric_normals)
+        , shading_normals_(shading_normals)
         , tex_coords_(tex_coords)
         , colors_(colors)
 #if VSNRAY_COMMON_HAVE_PTEX
@@ -1058,6 +1402,7 @@ struct build_scene_visitor : sg::node_visitor
         , env_map_(env_map)
         , env_light_(env_light)
         , build_strategy_(build_strategy)
+        , pool_(pool)
     {
     }
 
@@ -1156,39 +1501,24 @@ struct build_scene_visitor : sg::node_visitor
         {
             auto ico = make_icosahedron();
 
-            shading_normals_.insert(shading_normals_.end(), ico.normals.begin(), ico.normals.end());
+            unsigned first_vertex = static_cast<unsigned>(vertices_.size());
 
-            for (size_t i = 0; i < ico.triangles.size(); ++i)
+            for (size_t i = 0; i < ico.vertices.size(); ++i)
             {
-                auto& tri = ico.triangles[i];
-
-                tri.prim_id = current_prim_id_++;
-                tri.geom_id = current_geom_id_;
-
-                vec3 n = normalize(cross(tri.e1, tri.e2));
-
-                geometric_normals_.emplace_back(n);
-                tex_coords_.emplace_back(0.0f, 0.0f);
-                tex_coords_.emplace_back(0.0f, 0.0f);
-                tex_coords_.emplace_back(0.0f, 0.0f);
+                add_vertex(ico.vertices[i], &ico.normals[i], nullptr, nullptr);
             }
 
-            // Build single bvh
-            if (build_strategy_ == renderer::LBVH)
-            {
-                lbvh_builder builder;
+            aligned_vector<renderer::indexed_primitive_type> triangles(ico.indices.size());
 
-                bvhs_.emplace_back(builder.build(renderer::host_bvh_type{}, ico.triangles.data(), ico.triangles.size()));
-            }
-            else
+            for (size_t i = 0; i < ico.indices.size(); ++i)
             {
-                binned_sah_builder builder;
-                builder.enable_spatial_splits(build_strategy_ == renderer::Split);
-
-                bvhs_.emplace_back(builder.build(renderer::host_bvh_type{}, ico.triangles.data(), ico.triangles.size()));
+                vec3i idx = ico.indices[i];
+                triangles[i] = make_triangle(first_vertex + idx.x, first_vertex + idx.y, first_vertex + idx.z);
             }
 
-            sph.flags() = ~(bvhs_.size() - 1);
+            meshes_.push_back(std::move(triangles));
+
+            sph.flags() = ~(meshes_.size() - 1);
         }
 
         instances_.push_back({ static_cast<int>(~sph.flags()), current_transform_ });
@@ -1202,61 +1532,34 @@ struct build_scene_visitor : sg::node_visitor
         {
             assert(tm.vertices.size() % 3 == 0);
 
-            aligned_vector<basic_triangle<3, float>> triangles(tm.vertices.size() / 3);
-
-            size_t first_geometric_normal = geometric_normals_.size();
-            geometric_normals_.resize(geometric_normals_.size() + tm.vertices.size() / 3);
-
-            shading_normals_.insert(shading_normals_.end(), tm.normals.begin(), tm.normals.end());
-
-            tex_coords_.insert(tex_coords_.end(), tm.tex_coords.begin(), tm.tex_coords.end());
+            // Triangles do not share vertices
+            unsigned first_vertex = static_cast<unsigned>(vertices_.size());
 
-            size_t first_color = colors_.size();
-            if (tm.colors.size() > 0)
+            for (size_t i = 0; i < tm.vertices.size(); ++i)
             {
-                colors_.resize(first_color + tm.colors.size());
-                for (size_t i = 0; i < tm.colors.size(); ++i)
-                {
-                    colors_[first_color + i] = vec3(tm.colors[i]);
-                }
+                add_vertex(
+                        tm.vertices[i],
+                        i < tm.normals.size() ? &tm.normals[i] : nullptr,
+                        i < tm.tex_coords.size() ? &tm.tex_coords[i] : nullptr,
+                        i < tm.colors.size() ? &tm.colors[i] : nullptr
+                        );
             }
 
 #if VSNRAY_COMMON_HAVE_PTEX
             face_ids_.insert(face_ids_.end(), tm.face_ids.begin(), tm.face_ids.end());
 #endif
 
-            for (size_t i = 0; i < tm.vertices.size(); i += 3)
-            {
-                vec3 v1 = tm.vertices[i];
-                vec3 v2 = tm.vertices[i + 1];
-                vec3 v3 = tm.vertices[i + 2];
+            aligned_vector<renderer::indexed_primitive_type> triangles(tm.vertices.size() / 3);
 
-                basic_triangle<3, float> tri(v1, v2 - v1, v3 - v1);
-                tri.prim_id = current_prim_id_++;
-                tri.geom_id = current_geom_id_;
-                triangles[i / 3] = tri;
-
-                vec3 gn = normalize(cross(v2 - v1, v3 - v1));
-
-                geometric_normals_[first_geometric_normal + i / 3] = gn;
-            }
-
-            // Build single bvh
-            if (build_strategy_ == renderer::LBVH)
+            for (size_t i = 0; i < triangles.size(); ++i)
             {
-                lbvh_builder builder;
-
-                bvhs_.emplace_back(builder.build(renderer::host_bvh_type{}, triangles.data(), triangles.size()));
+                unsigned i1 = first_vertex + static_cast<unsigned>(i * 3);
+                triangles[i] = make_triangle(i1, i1 + 1, i1 + 2);
             }
-            else
-            {
-                binned_sah_builder builder;
-                builder.enable_spatial_splits(build_strategy_ == renderer::Split);
 
-                bvhs_.emplace_back(builder.build(renderer::host_bvh_type{}, triangles.data(), triangles.size()));
-            }
+            meshes_.push_back(std::move(triangles));
 
-            tm.flags() = ~(bvhs_.size() - 1);
+            tm.flags() = ~(meshes_.size() - 1);
         }
 
         instances_.push_back({ static_cast<int>(~tm.flags()), current_transform_ });
@@ -1269,109 +1572,196 @@ struct build_scene_visitor : sg::node_visitor
         if (itm.flags() == 0 && itm.vertex_indices.size() > 0)
         {
             assert(itm.vertex_indices.size() % 3 == 0);
+            assert(itm.normal_indices.size() == 0 || itm.normal_indices.size() == itm.vertex_indices.size());
+            assert(itm.tex_coord_indices.size() == 0 || itm.tex_coord_indices.size() == itm.vertex_indices.size());
+            assert(itm.color_indices.size() == 0 || itm.color_indices.size() == itm.vertex_indices.size());
 
-            aligned_vector<basic_triangle<3, float>> triangles(itm.vertex_indices.size() / 3);
-
-            size_t first_geometric_normal = geometric_normals_.size();
-            geometric_normals_.resize(geometric_normals_.size() + itm.vertex_indices.size() / 3);
+            aligned_vector<renderer::indexed_primitive_type> triangles(itm.vertex_indices.size() / 3);
 
-            size_t first_shading_normal = shading_normals_.size();
-            if (itm.normal_indices.size() > 0)
+            auto has_attribute = [&](aligned_vector<int> const& indices, void const* attributes)
             {
-                assert(itm.normal_indices.size() % 3 == 0);
-                shading_normals_.resize(shading_normals_.size() + itm.normal_indices.size());
-            }
-            else
-            {
-                shading_normals_.resize(shading_normals_.size() + itm.vertex_indices.size());
-            }
+                return indices.size() > 0 && attributes != nullptr;
+            };
 
-            size_t first_tex_coord = tex_coords_.size();
-            if (itm.tex_coord_indices.size() > 0)
-            {
-                assert(itm.tex_coord_indices.size() % 3 == 0);
-                tex_coords_.resize(tex_coords_.size() + itm.tex_coord_indices.size());
-            }
+            vec3 const* normals = has_attribute(itm.normal_indices, itm.normals.get())
+                    ? itm.normals->data() : nullptr;
+            vec2 const* tex_coords = has_attribute(itm.tex_coord_indices, itm.tex_coords.get())
+                    ? itm.tex_coords->data() : nullptr;
+            vector<3, unorm<8>> const* colors = has_attribute(itm.color_indices, itm.colors.get())
+                    ? itm.colors->data() : nullptr;
 
-            size_t first_color = colors_.size();
-            if (itm.color_indices.size() > 0)
-            {
-                assert(itm.color_indices.size() % 3 == 0);
-                colors_.resize(first_color + itm.color_indices.size());
-            }
+            bool same_indices = (normals == nullptr || itm.normal_indices == itm.vertex_indices)
+                             && (tex_coords == nullptr || itm.tex_coord_indices == itm.vertex_indices)
+                             && (colors == nullptr || itm.color_indices == itm.vertex_indices);
 
-            for (size_t i = 0; i < itm.vertex_indices.size(); i += 3)
+            if (same_indices)
             {
-                vec3 v1 = (*itm.vertices)[itm.vertex_indices[i]];
-                vec3 v2 = (*itm.vertices)[itm.vertex_indices[i + 1]];
-                vec3 v3 = (*itm.vertices)[itm.vertex_indices[i + 2]];
+                // Attributes are indexed like the vertices: append the vertex array as is, and
+                // only once if several meshes share it
+                std::array<void const*, 4> arrays = {{ itm.vertices->data(), normals, tex_coords, colors }};
 
-                basic_triangle<3, float> tri(v1, v2 - v1, v3 - v1);
-                tri.prim_id = current_prim_id_++;
-                tri.geom_id = current_geom_id_;
-                triangles[i / 3] = tri;
+                auto it = shared_vertices_.find(arrays);
 
-                vec3 gn = normalize(cross(v2 - v1, v3 - v1));
+                if (it == shared_vertices_.end())
+                {
+                    unsigned first_vertex = static_cast<unsigned>(vertices_.size());
 
-                geometric_normals_[first_geometric_normal + i / 3] = gn;
+                    for (size_t i = 0; i < itm.vertices->size(); ++i)
+                    {
+                        add_vertex(
+                                (*itm.vertices)[i],
+                                normals && i < itm.normals->size() ? &normals[i] : nullptr,
+                                tex_coords && i < itm.tex_coords->size() ? &tex_coords[i] : nullptr,
+                                colors && i < itm.colors->size() ? &colors[i] : nullptr
+                                );
+                    }
 
-                if (itm.normal_indices.size() == 0)
+                    it = shared_vertices_.insert(std::make_pair(arrays, first_vertex)).first;
+                }
+
+                unsigned first_vertex = it->second;
+
+                for (size_t i = 0; i < triangles.size(); ++i)
                 {
-                    shading_normals_[first_shading_normal + i]     = gn;
-                    shading_normals_[first_shading_normal + i + 1] = gn;
-                    shading_normals_[first_shading_normal + i + 2] = gn;
+                    triangles[i] = make_triangle(
+                            first_vertex + itm.vertex_indices[i * 3],
+                            first_vertex + itm.vertex_indices[i * 3 + 1],
+                            first_vertex + itm.vertex_indices[i * 3 + 2]
+                            );
                 }
             }
-
-            for (size_t i = 0; i < itm.normal_indices.size(); i += 3)
+            else
             {
-                shading_normals_[first_shading_normal + i]     = (*itm.normals)[itm.normal_indices[i]];
-                shading_normals_[first_shading_normal + i + 1] = (*itm.normals)[itm.normal_indices[i + 1]];
-                shading_normals_[first_shading_normal + i + 2] = (*itm.normals)[itm.normal_indices[i + 2]];
-            }
+                // Separate indices per attribute, add a vertex for each distinct combination
+                std::unordered_map<std::array<int, 4>, unsigned, index_tuple_hash> unique_vertices;
 
-            for (size_t i = 0; i < itm.tex_coord_indices.size(); i += 3)
-            {
-                tex_coords_[first_tex_coord + i]     = (*itm.tex_coords)[itm.tex_coord_indices[i]];
-                tex_coords_[first_tex_coord + i + 1] = (*itm.tex_coords)[itm.tex_coord_indices[i + 1]];
-                tex_coords_[first_tex_coord + i + 2] = (*itm.tex_coords)[itm.tex_coord_indices[i + 2]];
-            }
+                auto get_index = [&](size_t i)
+                {
+                    std::array<int, 4> key = {{
+                            itm.vertex_indices[i],
+                            normals ? itm.normal_indices[i] : -1,
+                            tex_coords ? itm.tex_coord_indices[i] : -1,
+                            colors ? itm.color_indices[i] : -1
+                            }};
 
-            for (size_t i = 0; i < itm.color_indices.size(); i += 3)
-            {
-                colors_[first_color + i]     = vec3((*itm.colors)[itm.color_indices[i]]);
-                colors_[first_color + i + 1] = vec3((*itm.colors)[itm.color_indices[i + 1]]);
-                colors_[first_color + i + 2] = vec3((*itm.colors)[itm.color_indices[i + 2]]);
+                    auto it = unique_vertices.find(key);
+
+                    if (it == unique_vertices.end())
+                    {
+                        unsigned index = static_cast<unsigned>(vertices_.size());
+
+                        add_vertex(
+                                (*itm.vertices)[key[0]],
+                                normals ? &normals[key[1]] : nullptr,
+                                tex_coords ? &tex_coords[key[2]] : nullptr,
+                                colors ? &colors[key[3]] : nullptr
+                                );
+
+                        it = unique_vertices.insert(std::make_pair(key, index)).first;
+                    }
+
+                    return it->second;
+                };
+
+                for (size_t i = 0; i < triangles.size(); ++i)
+                {
+                    unsigned i1 = get_index(i * 3);
+                    unsigned i2 = get_index(i * 3 + 1);
+                    unsigned i3 = get_index(i * 3 + 2);
+                    triangles[i] = make_triangle(i1, i2, i3);
+                }
             }
 
 #if VSNRAY_COMMON_HAVE_PTEX
             face_ids_.insert(face_ids_.end(), itm.face_ids.begin(), itm.face_ids.end());
 #endif
 
+            meshes_.push_back(std::move(triangles));
 
-            // Build single bvh
-            if (build_strategy_ == renderer::LBVH)
-            {
-                lbvh_builder builder;
+            itm.flags() = ~(meshes_.size() - 1);
+        }
 
-                bvhs_.emplace_back(builder.build(renderer::host_bvh_type{}, triangles.data(), triangles.size()));
-            }
-            else
-            {
-                binned_sah_builder builder;
-                builder.enable_spatial_splits(build_strategy_ == renderer::Split);
+        instances_.push_back({ static_cast<int>(~itm.flags()), current_transform_ });
 
-                bvhs_.emplace_back(builder.build(renderer::host_bvh_type{}, triangles.data(), triangles.size()));
-            }
+        node_visitor::apply(itm);
+    }
+
+    // Build one BVH per mesh, call after traversal
+    void build_bvhs()
+    {
+        for (auto& triangles : meshes_)
+        {
+            bvhs_.push_back(build_host_bvh(
+                    triangles.data(),
+                    triangles.size(),
+                    vertices_,
+                    build_strategy_,
+                    bvh_storage_,
+                    cache_,
+                    pool_
+                    ));
 
-            itm.flags() = ~(bvhs_.size() - 1);
+            // BVHs store a copy of the primitives
+            triangles = aligned_vector<renderer::indexed_primitive_type>();
         }
 
-        instances_.push_back({ static_cast<int>(~itm.flags()), current_transform_ });
+        meshes_.clear();
+    }
 
-        node_visitor::apply(itm);
+    // Add vertex, attributes that are not present are padded so that the attribute
+    // arrays stay parallel to the vertex array. The zero normal makes get_surface()
+    // fall back to the geometric normal. Colors are only stored once there are any.
+    void add_vertex(
+            vec3 const&                 v,
+            vec3 const*                 n,
+            vec2 const*                 tc,
+            vector<3, unorm<8>> const*  c
+            )
+    {
+        if (c != nullptr && colors_.empty())
+        {
+            colors_.resize(vertices_.size(), vec3(1.0f));
+        }
+
+        vertices_.push_back(v);
+        shading_normals_.push_back(n ? *n : vec3(0.0f));
+        tex_coords_.push_back(tc ? *tc : vec2(0.0f));
+
+        if (!colors_.empty())
+        {
+            colors_.push_back(c ? vec3(*c) : vec3(1.0f));
+        }
+    }
+
+    // Make triangle from vertices that were already added, also adds its face normal
+    renderer::indexed_primitive_type make_triangle(unsigned i1, unsigned i2, unsigned i3)
+    {
+        renderer::indexed_primitive_type tri(i1, i2, i3);
+        tri.prim_id = current_prim_id_++;
+        tri.geom_id = current_geom_id_;
+
+        vec3 e1 = vertices_[i2] - vertices_[i1];
+        vec3 e2 = vertices_[i3] - vertices_[i1];
+        geometric_normals_.push_back(normalize(cross(e1, e2)));
+
+        return tri;
     }
 
+    struct index_tuple_hash
+    {
+        size_t operator()(std::array<int, 4> const& key) const
+        {
+            size_t seed = 0;
+
+            for (int index : key)
+            {
+                seed ^= std::hash<int>()(index) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+
+            return seed;
+        }
+    };
+
     // List of surface properties to derive geom_ids from
     std::vector<std::pair<std::shared_ptr<sg::material>, std::shared_ptr<sg::texture>>> surfaces;
 
@@ -1380,21 +1770,36 @@ struct build_scene_visitor : sg::node_visitor
 
 
     // Storage bvhs
-    aligned_vector<renderer::host_bvh_type>& bvhs_;
+    aligned_vector<renderer::host_indexed_bvh_view_type>& bvhs_;
+
+    // Storage for BVHs that were not found in the cache
+    std::deque<renderer::host_indexed_bvh_type>& bvh_storage_;
+
+    // Triangles of the meshes that BVHs are built for in build_bvhs()
+    std::vector<aligned_vector<renderer::indexed_primitive_type>> meshes_;
+
+    // First vertex of vertex and attribute arrays that several meshes share
+    std::map<std::array<void const*, 4>, unsigned> shared_vertices_;
+
+    // BVH cache, may be nullptr
+    bvh_cache* cache_;
 
     // Instances (BVH index + transform)
     aligned_vector<instance>& instances_;
 
-    // Shading normals
-    aligned_vector<vec3>& shading_normals_;
+    // Vertices shared by the indexed triangles
+    aligned_vector<vec3>& vertices_;
 
-    // Geometric normals
+    // Geometric normals, per face
     aligned_vector<vec3>& geometric_normals_;
 
-    // Texture coordinates
+    // Shading normals, per vertex
+    aligned_vector<vec3>& shading_normals_;
+
+    // Texture coordinates, per vertex
     aligned_vector<vec2>& tex_coords_;
 
-    // Vertex colors
+    // Vertex colors, per vertex or empty
     aligned_vector<vec3>& colors_;
 
 #if VSNRAY_COMMON_HAVE_PTEX
@@ -1426,6 +1831,9 @@ struct build_scene_visitor : sg::node_visitor
     // BVH build strategy
     renderer::bvh_build_strategy build_strategy_;
 
+    // Thread pool for parallel BVH builds
+    thread_pool& pool_;
+
 };
 
 
@@ -1439,44 +1847,15 @@ void renderer::build_scene()
 
     std::cout << "Creating BVH...\n";
 
-    if (mod.scene_graph == nullptr)
-    {
-        // Single BVH
-        if (build_strategy == LBVH && rt.mode() == host_device_rt::CPU)
-        {
-            host_bvhs.resize(1);
-
-            lbvh_builder builder;
-
-            //timer t;
-            host_bvhs[0] = builder.build(host_bvh_type{}, mod.primitives.data(), mod.primitives.size());
-            //std::cout << t.elapsed() << '\n';
-        }
-#ifdef __CUDACC__
-        else if (build_strategy == LBVH && rt.mode() == host_device_rt::GPU)
-        {
-            device_bvhs.resize(1);
-
-            lbvh_builder builder;
+    thread_pool pool(std::thread::hardware_concurrency());
 
-            //cuda::timer t;
-            thrust::device_vector<primitive_type> primitives(mod.primitives);
-            device_bvhs[0] = builder.build(device_bvh_type{}, thrust::raw_pointer_cast(primitives.data()), mod.primitives.size());
-            //std::cout << t.elapsed() << '\n';
-        }
-#endif
-        else
-        {
-            host_bvhs.resize(1);
-
-            binned_sah_builder builder;
-            builder.enable_spatial_splits(build_strategy == Split);
-
-            //timer t;
-            host_bvhs[0] = builder.build(host_bvh_type{}, mod.primitives.data(), mod.primitives.size());
-            //std::cout << t.elapsed() << '\n';
-        }
+    if (!bvh_cache_dir.empty())
+    {
+        host_bvh_cache.reset(new bvh_cache(bvh_cache_dir));
+    }
 
+    if (mod.scene_graph == nullptr)
+    {
         if (!env_map_filename.empty() && boost::filesystem::exists(env_map_filename))
         {
             image img;
@@ -1493,18 +1872,72 @@ void renderer::build_scene()
             }
 
             // When we have an environment light , enforce the code path
-            // with instances which will also support the light source
-            host_instances.push_back(host_bvhs[0].inst(mat4x3(mat3::identity(), vec3(0.0))));
+            // with instances which will also support the light source.
+            // Only the instanced BVH over indexed triangles is built,
+            // corners that coincide share their vertex
+            auto triangles = make_indexed_triangles(mod, vertices);
+
+            host_indexed_bvhs.push_back(build_host_bvh(
+                    triangles.data(),
+                    triangles.size(),
+                    vertices,
+                    build_strategy,
+                    host_indexed_bvh_storage,
+                    host_bvh_cache.get(),
+                    pool
+                    ));
+
+            host_instances.push_back(host_indexed_bvhs[0].inst(mat4x3(mat3::identity(), vec3(0.0))));
 
             // Any builder will suffice, we only have one instance..
             lbvh_builder builder;
 
             host_top_level_bvh = builder.build(
-                    index_bvh<host_bvh_type::bvh_inst>{},
+                    index_bvh<host_indexed_bvh_type::bvh_inst>{},
                     host_instances.data(),
                     host_instances.size()
                     );
         }
+        // Single BVH
+        else if (build_strategy == LBVH && rt.mode() == host_device_rt::CPU)
+        {
+            //timer t;
+            host_bvhs.push_back(build_host_bvh(
+                    mod.primitives.data(),
+                    mod.primitives.size(),
+                    build_strategy,
+                    host_bvh_storage,
+                    host_bvh_cache.get(),
+                    pool
+                    ));
+            //std::cout << t.elapsed() << '\n';
+        }
+#ifdef __CUDACC__
+        else if (build_strategy == LBVH && rt.mode() == host_device_rt::GPU)
+        {
+            device_bvhs.resize(1);
+
+            lbvh_builder builder;
+
+            //cuda::timer t;
+            thrust::device_vector<primitive_type> primitives(mod.primitives);
+            device_bvhs[0] = builder.build(device_bvh_type{}, thrust::raw_pointer_cast(primitives.data()), mod.primitives.size());
+            //std::cout << t.elapsed() << '\n';
+        }
+#endif
+        else
+        {
+            //timer t;
+            host_bvhs.push_back(build_host_bvh(
+                    mod.primitives.data(),
+                    mod.primitives.size(),
+                    build_strategy,
+                    host_bvh_storage,
+                    host_bvh_cache.get(),
+                    pool
+                    ));
+            //std::cout << t.elapsed() << '\n';
+        }
     }
     else
     {
@@ -1514,10 +1947,13 @@ void renderer::build_scene()
         aligned_vector<instance> instances;
 
         build_scene_visitor build_visitor(
-                host_bvhs,
+                host_indexed_bvhs,
+                host_indexed_bvh_storage,
+                host_bvh_cache.get(),
                 instances,
-                mod.shading_normals, // TODO!!!
+                vertices,
                 mod.geometric_normals,
+                mod.shading_normals,
                 mod.tex_coords,
                 mod.colors,
 #if VSNRAY_COMMON_HAVE_PTEX
@@ -1528,15 +1964,17 @@ void renderer::build_scene()
                 spot_lights,
                 env_map,
                 env_light,
-                build_strategy
+                build_strategy,
+                pool
                 );
         mod.scene_graph->accept(build_visitor);
+        build_visitor.build_bvhs();
 
         host_instances.resize(instances.size());
         for (size_t i = 0; i < instances.size(); ++i)
         {
             size_t index = instances[i].index;
-            host_instances[i] = host_bvhs[index].inst(mat4x3(top_left(instances[i].transform), instances[i].transform(3).xyz()));
+            host_instances[i] = host_indexed_bvhs[index].inst(mat4x3(top_left(instances[i].transform), instances[i].transform(3).xyz()));
         }
 
         // Single BVH
@@ -1545,7 +1983,7 @@ void renderer::build_scene()
             lbvh_builder builder;
 
             host_top_level_bvh = builder.build(
-                    index_bvh<host_bvh_type::bvh_inst>{},
+                    index_bvh<host_indexed_bvh_type::bvh_inst>{},
                     host_instances.data(),
                     host_instances.size()
                     );
@@ -1556,9 +1994,11 @@ void renderer::build_scene()
             builder.enable_spatial_splits(false);
 
             host_top_level_bvh = builder.build(
-                    index_bvh<host_bvh_type::bvh_inst>{},
+                    index_bvh<host_indexed_bvh_type::bvh_inst>{},
                     host_instances.data(),
-                    host_instances.size()
+                    host_instances.size(),
+                    -1,
+                    pool
                     );
         }
 
@@ -1702,7 +2142,7 @@ void renderer::init_bvh_outlines()
     {
         if (device_top_level_bvh.num_nodes() > 0)
         {
-            index_bvh<host_bvh_type::bvh_inst> temp(device_top_level_bvh);
+            index_bvh<host_indexed_bvh_type::bvh_inst> temp(device_top_level_bvh);
             outlines.init(temp);
         }
         else
@@ -1728,7 +2168,7 @@ void renderer::clear_frame()
 
     frame_num = 0;
 
-    if (algo == Pathtracing)
+    if (is_progressive(algo))
     {
         rt.clear_color_buffer();
     }
@@ -1851,20 +2291,23 @@ void renderer::render_hud()
     float focal_dist = cam.get_focal_distance();
     float lens_radius = cam.get_lens_radius();
 
-    if (!host_bvhs.empty())
+    auto count_nodes = [&](bvh_node const& node)
     {
-        traverse_depth_first(
-            host_bvhs[0],
-            [&](renderer::host_bvh_type::node_type const& node)
-            {
-                ++num_nodes;
+        ++num_nodes;
 
-                if (is_leaf(node))
-                {
-                    ++num_leaves;
-                }
-            }
-            );
+        if (is_leaf(node))
+        {
+            ++num_leaves;
+        }
+    };
+
+    if (!host_bvhs.empty())
+    {
+        traverse_depth_first(host_bvhs[0], count_nodes);
+    }
+    else if (!host_indexed_bvhs.empty())
+    {
+        traverse_depth_first(host_indexed_bvhs[0], count_nodes);
     }
 
 
@@ -1907,11 +2350,12 @@ void renderer::render_hud()
     ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
     ImGui::Begin("Settings", &show_hud);
 
-    std::array<char const*, 4> algo_names = {{
+    std::array<char const*, 5> algo_names = {{
             "Simple",
             "Whitted",
             "Path Tracing",
-            "Costs"
+            "Costs",
+            "Wavefront Path Tracing"
             }};
 
     std::array<char const*, 4> ssaa_modes = {{
@@ -1952,7 +2396,7 @@ void renderer::render_hud()
             ImGui::SameLine();
             ImGui::Spacing();
             ImGui::SameLine();
-            if (algo == Pathtracing)
+            if (is_progressive(algo))
             {
                 ImGui::Text("Frames: %7u", std::max(1U, frame_num));
             }
@@ -2029,7 +2473,7 @@ void renderer::render_hud()
                         if (ssaa_modes[i] == ssaa_modes[0])
                         {
                             spp = 1;
-                            if (algo != Pathtracing)
+                            if (!is_progressive(algo))
                             {
                                 counter.reset();
                                 clear_frame();
@@ -2038,7 +2482,7 @@ void renderer::render_hud()
                         else if (ssaa_modes[i] == ssaa_modes[1])
                         {
                             spp = 2;
-                            if (algo != Pathtracing)
+                            if (!is_progressive(algo))
                             {
                                 counter.reset();
                                 clear_frame();
@@ -2047,7 +2491,7 @@ void renderer::render_hud()
                         else if (ssaa_modes[i] == ssaa_modes[2])
                         {
                             spp = 4;
-                            if (algo != Pathtracing)
+                            if (!is_progressive(algo))
                             {
                                 counter.reset();
                                 clear_frame();
@@ -2057,7 +2501,7 @@ void renderer::render_hud()
                         {
 
                             spp = 8;
-                            if (algo != Pathtracing)
+                            if (!is_progressive(algo))
                             {
                                 counter.reset();
                                 clear_frame();
@@ -2123,6 +2567,17 @@ void renderer::render_hud()
                             counter.reset();
                             clear_frame();
                         }
+                        else if (i == 4)
+                        {
+                            if (render_future.valid())
+                            {
+                                render_future.wait();
+                            }
+                            rt.set_double_buffering(false);
+                            algo = Wavefront;
+                            counter.reset();
+                            clear_frame();
+                        }
                     }
 
                     if (selected)
@@ -2251,12 +2706,12 @@ void renderer::render_hud()
             if (ImGui::InputFloat("Lens radius", &lens_radius))
             {
                 cam.set_lens_radius(lens_radius);
-                if (use_dof && algo == Pathtracing)
+                if (use_dof && is_progressive(algo))
                 {
                     clear_frame();
                 }
 
-                if (algo != Pathtracing)
+                if (!is_progressive(algo))
                 {
                     std::cerr << "Warning: setting only affects pathtracing algorithm\n";
                 }
@@ -2266,12 +2721,12 @@ void renderer::render_hud()
             ImGui::Spacing();
             if (ImGui::Checkbox("DoF", &use_dof))
             {
-                if (use_dof && algo == Pathtracing) 
+                if (use_dof && is_progressive(algo)) 
                 {
                     clear_frame();
                 }
 
-                if (algo != Pathtracing)
+                if (!is_progressive(algo))
                 {
                     std::cerr << "Warning: setting only affects pathtracing algorithm\n";
                 }
@@ -2281,12 +2736,12 @@ void renderer::render_hud()
             if (ImGui::SliderFloat("##Focal", &focal_dist, 0.1, 100.0f, "Focal Dist. %.1f"))
             {
                 cam.set_focal_distance(focal_dist);
-                if (use_dof && algo == Pathtracing)
+                if (use_dof && is_progressive(algo))
                 {
                     clear_frame();
                 }
 
-                if (algo != Pathtracing)
+                if (!is_progressive(algo))
                 {
                     std::cerr << "Warning: setting only affects pathtracing algorithm\n";
                 }
@@ -2331,7 +2786,7 @@ void renderer::render_impl()
 
     auto bounds     = mod.bbox;
     auto diagonal   = bounds.max - bounds.min;
-    auto bounces    = this->bounces ? this->bounces : algo == Pathtracing ? 10U : 4U;
+    auto bounces    = this->bounces ? this->bounces : is_progressive(algo) ? 10U : 4U;
     auto epsilon    = std::max( 1E-3f, length(diagonal) * 1E-5f );
     auto amb        = ambient.x >= 0.0f // if set via cmdline
                             ? vec4(ambient, 1.0f)
@@ -2339,7 +2794,7 @@ void renderer::render_impl()
                             ;
 
     camera_t camx;
-    if (use_dof && algo == Pathtracing)
+    if (use_dof && is_progressive(algo))
     {
         camx = cam;
     }
@@ -2371,6 +2826,7 @@ void renderer::render_impl()
             {
                 render_instances_cpp(
                         host_top_level_bvh,
+                        vertices,
                         mod.geometric_normals,
                         mod.shading_normals,
                         mod.tex_coords,
@@ -2384,6 +2840,7 @@ void renderer::render_impl()
                         amb,
                         rt,
                         host_sched,
+                        host_wavefront,
                         camx,
                         frame_num,
                         algo,
@@ -2396,6 +2853,7 @@ void renderer::render_impl()
             {
                 render_instances_ptex_cpp(
                         host_top_level_bvh,
+                        vertices,
                         mod.geometric_normals,
                         mod.shading_normals,
                         ptex_tex_coords,
@@ -2409,6 +2867,7 @@ void renderer::render_impl()
                         amb,
                         rt,
                         host_sched,
+                        host_wavefront,
                         camx,
                         frame_num,
                         algo,
@@ -2418,22 +2877,24 @@ void renderer::render_impl()
             }
 #endif
         }
-        else if (area_lights.size() > 0 && algo == Pathtracing)
+        else if (area_lights.size() > 0 && is_progressive(algo))
         {
             render_generic_material_cpp(
-                    host_bvhs[0],
+                    host_bvhs[0].ref(),
                     mod.geometric_normals,
                     mod.shading_normals,
                     mod.tex_coords,
                     generic_materials,
                     mod.textures,
                     area_lights,
+                    area_light_sampling,
                     bounces,
                     epsilon,
                     vec4(background_color(), 1.0f),
                     amb,
                     rt,
                     host_sched,
+                    host_wavefront,
                     camx,
                     frame_num,
                     algo,
@@ -2443,7 +2904,7 @@ void renderer::render_impl()
         else
         {
             render_plastic_cpp(
-                    host_bvhs[0],
+                    host_bvhs[0].ref(),
                     mod.geometric_normals,
                     mod.shading_normals,
                     mod.tex_coords,
@@ -2456,6 +2917,7 @@ void renderer::render_impl()
                     amb,
                     rt,
                     host_sched,
+                    host_wavefront,
                     camx,
                     frame_num,
                     algo,
@@ -2489,6 +2951,7 @@ void renderer::render_impl()
             {
                 render_instances_cu(
                         device_top_level_bvh,
+                        device_vertices,
                         device_geometric_normals,
                         device_shading_normals,
                         device_tex_coords,
@@ -2510,7 +2973,7 @@ void renderer::render_impl()
                         );
             }
         }
-        else if (area_lights.size() > 0 && algo == Pathtracing)
+        else if (area_lights.size() > 0 && is_progressive(algo))
         {
             render_generic_material_cu(
                     device_bvhs[0],
@@ -2702,6 +3165,18 @@ void renderer::on_key_press(key_event const& event)
         clear_frame();
         break;
 
+    case '5':
+        std::cout << "Switching algorithm: wavefront path tracing\n";
+        if (render_future.valid())
+        {
+            render_future.wait();
+        }
+        rt.set_double_buffering(false);
+        algo = Wavefront;
+        counter.reset();
+        clear_frame();
+        break;
+
     case 'b':
         show_bvh = !show_bvh;
 
@@ -2739,12 +3214,14 @@ void renderer::on_key_press(key_event const& event)
         {
             rt.mode() = host_device_rt::GPU;
 
-            if (device_bvhs.empty())
+            if (device_bvhs.empty() && device_indexed_bvhs.empty())
             {
+                copy_bvhs(device_bvhs, host_bvhs);
+
                 copy_bvhs(
-                    device_bvhs,
+                    device_indexed_bvhs,
                     device_top_level_bvh,
-                    host_bvhs,
+                    host_indexed_bvhs,
                     host_top_level_bvh,
                     copy_kind::HostToDevice
                     );
@@ -2754,15 +3231,27 @@ void renderer::on_key_press(key_event const& event)
         {
             rt.mode() = host_device_rt::CPU;
 
-            if (host_bvhs.empty())
+            if (host_bvhs.empty() && host_indexed_bvhs.empty())
             {
+                copy_bvhs(host_bvh_storage, device_bvhs);
+
                 copy_bvhs(
-                    host_bvhs,
+                    host_indexed_bvh_storage,
                     host_top_level_bvh,
-                    device_bvhs,
+                    device_indexed_bvhs,
                     device_top_level_bvh,
                     copy_kind::DeviceToHost
                     );
+
+                for (auto& tree : host_bvh_storage)
+                {
+                    host_bvhs.push_back(make_host_bvh_view(tree));
+                }
+
+                for (auto& tree : host_indexed_bvh_storage)
+                {
+                    host_indexed_bvhs.push_back(make_host_bvh_view(tree));
+                }
             }
         }
         counter.reset();
@@ -2786,7 +3275,7 @@ void renderer::on_key_press(key_event const& event)
             spp = 1;
         }
 
-        if (algo != Pathtracing)
+        if (!is_progressive(algo))
         {
             counter.reset();
             clear_frame();
@@ -2873,7 +3362,7 @@ void renderer::on_space_mouse_move(visionaray::space_mouse_event const& event)
 
 void renderer::on_resize(int w, int h)
 {
-    if (render_future.valid() && algo != Pathtracing)
+    if (render_future.valid() && !is_progressive(algo))
     {
         render_future.wait();
     }
@@ -2889,6 +3378,32 @@ void renderer::on_resize(int w, int h)
     viewer_type::on_resize(w, h);
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Area lights store standalone triangles
+//
+
+static basic_triangle<3, float> make_area_light_geometry(
+        basic_triangle<3, float> const& tri,
+        aligned_vector<vec3> const&     /* */
+        )
+{
+    return tri;
+}
+
+static basic_triangle<3, float> make_area_light_geometry(
+        basic_indexed_triangle<float> const&    tri,
+        aligned_vector<vec3> const&             vertices
+        )
+{
+    auto v = compute_vertices(tri, vertices.data());
+
+    basic_triangle<3, float> result(v[0], v[1] - v[0], v[2] - v[0]);
+    result.prim_id = tri.prim_id;
+    result.geom_id = tri.geom_id;
+    return result;
+}
+
 int main(int argc, char** argv)
 {
     renderer rend;
@@ -2919,7 +3434,7 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 
-    if (rend.algo == Pathtracing)
+    if (is_progressive(rend.algo))
     {
         // Double buffering does not work in case of pathtracing
         // because destination and source buffers need to be the same
@@ -3029,61 +3544,53 @@ int main(int argc, char** argv)
 
 
     // Loop over all triangles, check if their
-    // material is emissive, and if so, build
-    // BVHs to create area lights from.
+    // material is emissive, and if so, create
+    // area lights from them. The instanced BVHs
+    // are only visited if they are the only ones
+    // that store the scene's triangles.
 
-    struct range
+    auto add_area_lights = [&](auto const& bvhs)
     {
-        std::size_t begin;
-        std::size_t end;
-        unsigned    bvh_id;
-        unsigned    geom_id;
-    };
-
-    std::vector<range> ranges;
-
-    for (unsigned b = 0; b < rend.host_bvhs.size(); ++b)
-    {
-        for (std::size_t i = 0; i < rend.host_bvhs[b].primitives().size(); ++i)
+        for (auto const& tree : bvhs)
         {
-            auto pi = rend.host_bvhs[b].primitives()[i];
-            if (rend.generic_materials[pi.geom_id].as<emissive<float>>() != nullptr)
+            for (auto const& prim : tree.primitives())
             {
-                range r;
-                r.begin = i;
+                auto mat = rend.generic_materials[prim.geom_id].template as<emissive<float>>();
 
-                std::size_t j = i + 1;
-                for (;j < rend.host_bvhs[b].primitives().size(); ++j)
+                if (mat != nullptr)
                 {
-                    auto pii = rend.host_bvhs[b].primitives()[j];
-                    if (rend.generic_materials[pii.geom_id].as<emissive<float>>() == nullptr
-                                    || pii.geom_id != pi.geom_id)
-                    {
-                        break;
-                    }
+                    area_light<float, basic_triangle<3, float>> light(make_area_light_geometry(prim, rend.vertices));
+                    light.set_cl(to_rgb(mat->ce()));
+                    light.set_kl(mat->ls());
+                    rend.area_lights.push_back(light);
                 }
-
-                r.end = j;
-                r.bvh_id = b;
-                r.geom_id = pi.geom_id;
-                ranges.push_back(r);
-
-                i = r.end - 1;
             }
         }
+    };
+
+    if (!rend.host_bvhs.empty())
+    {
+        add_area_lights(rend.host_bvhs);
+    }
+    else
+    {
+        add_area_lights(rend.host_indexed_bvhs);
     }
 
-    // Build vector with area light sources
-    for (auto r : ranges)
+    if (rend.area_light_sampling.strategy == PowerLightSampling)
     {
-        for (std::size_t i = r.begin; i != r.end; ++i)
-        {
-            area_light<float, basic_triangle<3, float>> light(rend.host_bvhs[r.bvh_id].primitives()[i]);
-            auto mat = *rend.generic_materials[r.geom_id].as<emissive<float>>();
-            light.set_cl(to_rgb(mat.ce()));
-            light.set_kl(mat.ls());
-            rend.area_lights.push_back(light);
-        }
+        rend.area_light_sampling.power.reset(rend.area_lights.begin(), rend.area_lights.end());
+    }
+    else if (rend.area_light_sampling.strategy == LightBVHSampling)
+    {
+        rend.area_light_sampling.bvh.reset(rend.area_lights.begin(), rend.area_lights.end());
+    }
+
+    // Importance sampling for the environment light
+    if (rend.env_map)
+    {
+        rend.env_distribution = make_environment_light_distribution(rend.env_map);
+        rend.env_light.set_distribution(rend.env_distribution.ref());
     }
 
     std::cout << "Ready\n";
@@ -3092,12 +3599,16 @@ int main(int argc, char** argv)
     // Copy data to GPU
     try
     {
+        rend.device_vertices = rend.vertices;
+
         if (rend.rt.mode() == host_device_rt::GPU && rend.build_strategy != renderer::LBVH)
         {
+            copy_bvhs(rend.device_bvhs, rend.host_bvhs);
+
             copy_bvhs(
-                rend.device_bvhs,
+                rend.device_indexed_bvhs,
                 rend.device_top_level_bvh,
-                rend.host_bvhs,
+                rend.host_indexed_bvhs,
                 rend.host_top_level_bvh,
                 copy_kind::HostToDevice
                 );
@@ -3185,6 +3696,10 @@ int main(int argc, char** argv)
         std::cerr << "GPU memory allocation failed" << std::endl;
         rend.device_bvhs.clear();
         rend.device_bvhs.shrink_to_fit();
+        rend.device_indexed_bvhs.clear();
+        rend.device_indexed_bvhs.shrink_to_fit();
+        rend.device_vertices.clear();
+        rend.device_vertices.shrink_to_fit();
         rend.device_geometric_normals.clear();
         rend.device_geometric_normals.shrink_to_fit();
         rend.device_shading_normals.clear();
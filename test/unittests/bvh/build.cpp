@@ -1,12 +1,18 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <algorithm>
+#include <thread>
+
+#include <visionaray/detail/thread_pool.h>
 #include <visionaray/aligned_vector.h>
 #include <visionaray/array_ref.h>
 #include <visionaray/bvh.h>
 
 #include <gtest/gtest.h>
 
+#include "random_scene.h"
+
 using namespace visionaray;
 
 
@@ -120,3 +126,153 @@ TEST(BVH, BuildArrayRefBvh)
     EXPECT_TRUE(triangle_bvh.primitives().size() == triangles.size());
     EXPECT_TRUE(sphere_bvh.primitives().size()   == spheres.size());
 }
+
+// parallel build -----------------------------------------
+
+TEST(BVH, BuildParallel)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    // Large enough so that the top levels are split in parallel
+    auto triangles = make_random_triangles(300000);
+
+    for (bool spatial_splits : { false, true })
+    {
+        binned_sah_builder builder;
+        builder.enable_spatial_splits(spatial_splits);
+
+        auto serial = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+        auto parallel = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), -1, pool);
+
+        // Same splits, only the node order may differ
+        EXPECT_EQ(serial.num_nodes(), parallel.num_nodes());
+        EXPECT_EQ(serial.num_indices(), parallel.num_indices());
+        EXPECT_NEAR(sah_cost(serial), sah_cost(parallel), sah_cost(serial) * 1.0e-5f);
+        EXPECT_TRUE(serial.node(0).get_bounds() == parallel.node(0).get_bounds());
+
+        // All leaves are reachable and reference valid primitives
+        size_t num_refs = 0;
+        traverse_leaves(parallel, [&](bvh_node const& n)
+        {
+            for (unsigned i = n.get_indices().first; i != n.get_indices().last; ++i)
+            {
+                EXPECT_LT(parallel.indices()[i], triangles.size());
+            }
+
+            num_refs += n.get_num_primitives();
+        });
+        EXPECT_EQ(num_refs, parallel.num_indices());
+    }
+
+    // Large, overlapping triangles, so that nodes above ParallelSplitThreshold
+    // are split spatially
+    {
+        auto large = make_random_triangles(100000, 100.0f, 40.0f);
+
+        binned_sah_builder builder;
+        builder.enable_spatial_splits(true);
+
+        auto serial = builder.build(index_bvh<triangle_t>{}, large.data(), large.size());
+        auto parallel = builder.build(index_bvh<triangle_t>{}, large.data(), large.size(), -1, pool);
+
+        EXPECT_GT(serial.num_indices(), large.size());
+        EXPECT_EQ(serial.num_nodes(), parallel.num_nodes());
+        EXPECT_EQ(serial.num_indices(), parallel.num_indices());
+        EXPECT_NEAR(sah_cost(serial), sah_cost(parallel), sah_cost(serial) * 1.0e-5f);
+        EXPECT_TRUE(serial.node(0).get_bounds() == parallel.node(0).get_bounds());
+
+        // Every primitive is referenced
+        std::vector<int> referenced(large.size(), 0);
+        traverse_leaves(parallel, [&](bvh_node const& n)
+        {
+            for (unsigned i = n.get_indices().first; i != n.get_indices().last; ++i)
+            {
+                referenced[parallel.indices()[i]] = 1;
+            }
+        });
+        EXPECT_EQ(std::count(referenced.begin(), referenced.end(), 1), static_cast<long>(large.size()));
+    }
+
+    // bvh w/o indices
+    {
+        binned_sah_builder builder;
+
+        auto serial = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+        auto parallel = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size(), -1, pool);
+
+        EXPECT_EQ(serial.num_nodes(), parallel.num_nodes());
+        EXPECT_NEAR(sah_cost(serial), sah_cost(parallel), sah_cost(serial) * 1.0e-5f);
+
+        std::vector<unsigned> prim_ids;
+        for (auto const& t : parallel.primitives())
+        {
+            prim_ids.push_back(t.prim_id);
+        }
+        std::sort(prim_ids.begin(), prim_ids.end());
+
+        for (size_t i = 0; i < prim_ids.size(); ++i)
+        {
+            EXPECT_EQ(prim_ids[i], i);
+        }
+    }
+}
+
+// parallel lbvh build ------------------------------------
+
+template <typename BVH>
+static void check_bvh(BVH const& b, size_t num_prims, int max_leaf_size)
+{
+    std::vector<int> refs(num_prims, 0);
+
+    traverse_depth_first(b, [&](bvh_node const& n)
+    {
+        if (is_inner(n))
+        {
+            auto const& l = b.node(n.get_child(0));
+            auto const& r = b.node(n.get_child(1));
+
+            EXPECT_TRUE(n.get_bounds().contains(l.get_bounds()));
+            EXPECT_TRUE(n.get_bounds().contains(r.get_bounds()));
+        }
+        else
+        {
+            EXPECT_LE(static_cast<int>(n.get_num_primitives()), max_leaf_size);
+
+            for (unsigned i = n.get_indices().first; i != n.get_indices().last; ++i)
+            {
+                EXPECT_TRUE(n.get_bounds().contains(get_bounds(b.primitive(i))));
+                ++refs[b.primitive(i).prim_id];
+            }
+        }
+    });
+
+    for (size_t i = 0; i < num_prims; ++i)
+    {
+        EXPECT_EQ(refs[i], 1);
+    }
+}
+
+TEST(BVH, BuildLBVHParallel)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    for (size_t num_prims : { 1, 3, 4, 5, 1000, 100000 })
+    {
+        auto triangles = make_random_triangles(num_prims);
+
+        lbvh_builder builder;
+
+        auto serial = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+        auto parallel = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), 4, pool);
+        auto parallel_bvh = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size(), 4, pool);
+
+        EXPECT_EQ(parallel.num_indices(), num_prims);
+        EXPECT_EQ(parallel_bvh.num_primitives(), num_prims);
+
+        check_bvh(parallel, num_prims, 4);
+        check_bvh(parallel_bvh, num_prims, 4);
+
+        // Same morton order, trees only differ where morton codes are equal
+        EXPECT_NEAR(sah_cost(serial), sah_cost(parallel), sah_cost(serial) * 0.01f);
+    }
+}
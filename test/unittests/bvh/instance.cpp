@@ -0,0 +1,223 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/get_area.h>
+#include <visionaray/get_primitive.h>
+
+#include <gtest/gtest.h>
+
+#include "random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+static triangle_t transform_triangle(mat4 const& m, triangle_t const& t)
+{
+    vec3 v1 = (m * vec4(t.v1, 1.0f)).xyz();
+    vec3 v2 = (m * vec4(t.v1 + t.e1, 1.0f)).xyz();
+    vec3 v3 = (m * vec4(t.v1 + t.e2, 1.0f)).xyz();
+
+    return triangle_t(v1, v2 - v1, v3 - v1);
+}
+
+// Minimal kernel params to look up primitives
+template <typename P>
+struct params
+{
+    using primitive_type = P;
+
+    struct
+    {
+        P const* begin;
+    } prims;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Two levels of instances over a shared bottom-level BVH, compared against the same
+// scene with all instance transforms applied to the triangles
+//
+
+template <template <typename> class BVH>
+static void test_two_levels()
+{
+    size_t const NumTriangles = 50;
+    size_t const NumInner = 8; // instances of the bottom-level BVH
+    size_t const NumOuter = 6; // instances of the mid-level BVH
+
+    auto triangles = make_random_triangles(NumTriangles, 10.0f, 2.0f);
+
+    mat4 inner_transforms[NumInner];
+    mat4 outer_transforms[NumOuter];
+
+    for (auto& m : inner_transforms)
+    {
+        m = make_random_transform(30.0f);
+    }
+
+    for (auto& m : outer_transforms)
+    {
+        m = make_random_transform(60.0f);
+    }
+
+    binned_sah_builder builder;
+
+    using blas_type = BVH<triangle_t>;
+    using mid_type = BVH<typename blas_type::bvh_inst>;
+    using top_type = BVH<typename mid_type::bvh_inst>;
+
+    auto blas = builder.build(blas_type{}, triangles.data(), triangles.size());
+
+    aligned_vector<typename blas_type::bvh_inst> inner;
+
+    for (auto const& m : inner_transforms)
+    {
+        inner.push_back(blas.inst(to_mat4x3(m)));
+    }
+
+    auto mid = builder.build(mid_type{}, inner.data(), inner.size());
+
+    aligned_vector<typename mid_type::bvh_inst> outer;
+
+    for (auto const& m : outer_transforms)
+    {
+        outer.push_back(mid.inst(to_mat4x3(m)));
+    }
+
+    auto top = builder.build(top_type{}, outer.data(), outer.size());
+
+    // Flattened reference, prim_id encodes the instance path
+    aligned_vector<triangle_t> flat;
+
+    for (size_t o = 0; o < NumOuter; ++o)
+    {
+        for (size_t i = 0; i < NumInner; ++i)
+        {
+            for (size_t t = 0; t < NumTriangles; ++t)
+            {
+                auto tri = transform_triangle(outer_transforms[o] * inner_transforms[i], triangles[t]);
+                tri.prim_id = static_cast<unsigned>((o * NumInner + i) * NumTriangles + t);
+                tri.geom_id = 0;
+                flat.push_back(tri);
+            }
+        }
+    }
+
+    auto reference = builder.build(bvh<triangle_t>{}, flat.data(), flat.size());
+
+    auto top_ref = top.ref();
+    params<typename top_type::bvh_ref> p{ { &top_ref } };
+
+    int num_hits = 0;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto r = make_random_ray();
+
+        auto hr1 = intersect(r, reference);
+        auto hr2 = intersect(r, top);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (!hr1.hit || !hr2.hit)
+        {
+            continue;
+        }
+
+        ++num_hits;
+
+        EXPECT_NEAR(hr1.t, hr2.t, hr1.t * 1e-4f);
+
+        // Instance path: outer instance, inner instance, triangle
+        auto path = get_instance_path(hr2);
+        static_assert(path.size() == 3, "Size mismatch");
+
+        auto const& o = top.primitive(path[0]);
+        auto const& inst = o.primitive(path[1]);
+        auto const& tri = inst.primitive(path[2]);
+
+        // Instances are copied into the BVHs, find the originals
+        unsigned outer_index = 0;
+        unsigned inner_index = 0;
+
+        for (size_t j = 0; j < NumOuter; ++j)
+        {
+            if (outer[j] == o)
+            {
+                outer_index = static_cast<unsigned>(j);
+            }
+        }
+
+        for (size_t j = 0; j < NumInner; ++j)
+        {
+            if (inner[j] == inst)
+            {
+                inner_index = static_cast<unsigned>(j);
+            }
+        }
+
+        EXPECT_EQ(hr1.prim_id, (outer_index * NumInner + inner_index) * NumTriangles + tri.prim_id);
+        EXPECT_EQ(hr2.prim_id, tri.prim_id);
+
+        // Primitive lookup follows the instance path down to the bottom-level BVH
+        auto const& prim = get_primitive(p, hr2);
+        EXPECT_EQ(&prim, &tri);
+
+        EXPECT_FLOAT_EQ(get_area(&top_ref, hr2), area(tri));
+    }
+
+    EXPECT_GT(num_hits, 0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test nested instances
+//
+
+TEST(Instance, TwoLevels)
+{
+    test_two_levels<bvh>();
+    test_two_levels<index_bvh>();
+}
+
+TEST(Instance, PathOneLevel)
+{
+    aligned_vector<triangle_t> triangles;
+    triangles.emplace_back(vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+    triangles.emplace_back(vec3(0.0f, 0.0f, -1.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+    triangles[0].prim_id = 0;
+    triangles[1].prim_id = 1;
+
+    binned_sah_builder builder;
+
+    auto blas = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    aligned_vector<index_bvh<triangle_t>::bvh_inst> instances;
+    instances.push_back(blas.inst(mat4x3(mat3::identity(), vec3(0.0f, 0.0f, 0.0f))));
+    instances.push_back(blas.inst(mat4x3(mat3::identity(), vec3(5.0f, 0.0f, 0.0f))));
+
+    auto top = builder.build(index_bvh<index_bvh<triangle_t>::bvh_inst>{}, instances.data(), instances.size());
+
+    basic_ray<float> r(vec3(5.25f, 0.25f, 1.0f), vec3(0.0f, 0.0f, -1.0f));
+
+    auto hr = intersect(r, top);
+    ASSERT_TRUE(hr.hit);
+
+    auto path = get_instance_path(hr);
+    static_assert(path.size() == 2, "Size mismatch");
+
+    EXPECT_EQ(path[0], hr.primitive_list_index);
+    EXPECT_EQ(path[1], hr.primitive_list_index_inst);
+    EXPECT_TRUE(top.primitive(path[0]) == instances[1]);
+    EXPECT_EQ(top.primitive(path[0]).primitive(path[1]).prim_id, 0U);
+}
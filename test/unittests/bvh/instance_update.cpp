@@ -0,0 +1,267 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <gtest/gtest.h>
+
+#include "random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+using blas_type = index_bvh<triangle_t>;
+using inst_type = blas_type::bvh_inst;
+using top_type = index_bvh<inst_type>;
+
+// Node bounds are the exact union of their children, all indices are referenced once
+static aabb check_tree(top_type const& tree, std::vector<int>& referenced, unsigned index = 0)
+{
+    auto const& node = tree.node(index);
+
+    aabb expected;
+    expected.invalidate();
+
+    if (node.is_inner())
+    {
+        expected = combine(
+                check_tree(tree, referenced, node.get_child(0)),
+                check_tree(tree, referenced, node.get_child(1))
+                );
+    }
+    else
+    {
+        auto indices = node.get_indices();
+
+        for (unsigned i = indices.first; i != indices.last; ++i)
+        {
+            expected.insert(get_bounds(tree.primitive(i)));
+            ++referenced[i];
+        }
+    }
+
+    EXPECT_EQ(node.get_bounds().min, expected.min);
+    EXPECT_EQ(node.get_bounds().max, expected.max);
+
+    return expected;
+}
+
+static void check_tree(top_type const& tree)
+{
+    std::vector<int> referenced(tree.num_indices(), 0);
+
+    check_tree(tree, referenced);
+
+    for (int r : referenced)
+    {
+        EXPECT_EQ(r, 1);
+    }
+}
+
+// Compare closest hits with a tree that is built from scratch
+template <typename Builder>
+static void check_intersect(top_type const& tree, Builder& builder, float extent)
+{
+    auto instances = tree.primitives();
+    auto reference = builder.build(top_type{}, instances.data(), instances.size());
+
+    int num_hits = 0;
+
+    for (int i = 0; i < 500; ++i)
+    {
+        auto r = make_random_ray(extent);
+
+        auto hr1 = intersect(r, reference);
+        auto hr2 = intersect(r, tree);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            ++num_hits;
+
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_TRUE(reference.primitive(hr1.primitive_list_index) == tree.primitive(hr2.primitive_list_index));
+        }
+    }
+
+    EXPECT_GT(num_hits, 0);
+}
+
+template <typename Builder>
+static void test_update(Builder builder)
+{
+    size_t const NumInstances = 1000;
+    float const Extent = 200.0f;
+
+    auto triangles = make_random_triangles(20, 5.0f);
+    auto blas = builder.build(blas_type{}, triangles.data(), triangles.size());
+
+    aligned_vector<inst_type> instances;
+
+    for (size_t i = 0; i < NumInstances; ++i)
+    {
+        instances.push_back(blas.inst(to_mat4x3(make_random_transform(Extent))));
+    }
+
+    auto tree = builder.build(top_type{}, instances.data(), instances.size());
+
+    // Never rebuild, so that only reinsertion is tested
+    bvh_instance_updater updater(0.0f);
+
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        auto num_nodes = tree.num_nodes();
+
+        std::vector<unsigned> indices;
+        std::vector<mat4x3> transforms;
+
+        for (int i = 0; i < 20; ++i)
+        {
+            indices.push_back(static_cast<unsigned>(rand() % NumInstances));
+            transforms.push_back(to_mat4x3(make_random_transform(Extent)));
+        }
+
+        auto result = updater.update(tree, builder, indices.data(), transforms.data(), indices.size());
+
+        EXPECT_FALSE(result.rebuilt);
+        EXPECT_GT(result.num_reinserted, 0U);
+        EXPECT_NEAR(result.sah, sah_cost(tree), result.sah * 1e-3f);
+        // Instances that shared a leaf were given a leaf of their own
+        EXPECT_GE(tree.num_nodes(), num_nodes);
+        EXPECT_LE(tree.num_nodes(), num_nodes + 2 * result.num_reinserted);
+
+        // Transforms were set in place, instances keep their indices
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            auto expected = blas.inst(transforms[i]);
+
+            // Later entries may have moved the same instance again
+            if (std::find(indices.begin() + i + 1, indices.end(), indices[i]) == indices.end())
+            {
+                EXPECT_TRUE(tree.primitives()[indices[i]] == expected);
+            }
+        }
+
+        check_tree(tree);
+        check_intersect(tree, builder, Extent);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test bvh_instance_updater
+//
+
+TEST(InstanceUpdate, Reinsert)
+{
+    test_update(binned_sah_builder{});
+    test_update(lbvh_builder{});
+}
+
+TEST(InstanceUpdate, Rebuild)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    size_t const NumInstances = 500;
+
+    auto triangles = make_random_triangles(20, 5.0f);
+
+    srand(1);
+
+    binned_sah_builder builder;
+    builder.enable_spatial_splits(false);
+
+    auto blas = builder.build(blas_type{}, triangles.data(), triangles.size());
+
+    aligned_vector<inst_type> instances;
+
+    for (size_t i = 0; i < NumInstances; ++i)
+    {
+        instances.push_back(blas.inst(to_mat4x3(make_random_transform(100.0f))));
+    }
+
+    auto tree = builder.build(top_type{}, instances.data(), instances.size(), -1, pool);
+
+    bvh_instance_updater updater(1.1f);
+
+    // Moving a single instance stays below the threshold
+    {
+        unsigned index = 0;
+        mat4x3 transform = to_mat4x3(make_random_transform(100.0f));
+
+        auto result = updater.update(tree, builder, &index, &transform, 1, pool);
+
+        EXPECT_FALSE(result.rebuilt);
+        EXPECT_EQ(result.num_reinserted, 1U);
+        EXPECT_LE(result.sah, result.sah_build * 1.1f);
+
+        check_tree(tree);
+    }
+
+    // Moving all instances into a much larger volume degrades the tree, so that
+    // reinsertion is not sufficient and it is rebuilt
+    std::vector<unsigned> indices(NumInstances);
+    std::vector<mat4x3> transforms(NumInstances);
+
+    for (size_t i = 0; i < NumInstances; ++i)
+    {
+        indices[i] = static_cast<unsigned>(i);
+        transforms[i] = to_mat4x3(make_random_transform(i % 2 ? 100.0f : 10000.0f));
+    }
+
+    updater.set_rebuild_threshold(1.0001f);
+
+    auto result = updater.update(tree, builder, indices.data(), transforms.data(), indices.size(), pool);
+
+    EXPECT_TRUE(result.rebuilt);
+    EXPECT_FLOAT_EQ(result.sah, sah_cost(tree));
+
+    for (size_t i = 0; i < NumInstances; ++i)
+    {
+        EXPECT_TRUE(tree.primitives()[i] == blas.inst(transforms[i]));
+    }
+
+    check_tree(tree);
+    check_intersect(tree, builder, 100.0f);
+}
+
+TEST(InstanceUpdate, SingleInstance)
+{
+    auto triangles = make_random_triangles(10, 5.0f);
+
+    lbvh_builder builder;
+
+    auto blas = builder.build(blas_type{}, triangles.data(), triangles.size());
+
+    aligned_vector<inst_type> instances;
+    instances.push_back(blas.inst(mat4x3(mat3::identity(), vec3(0.0f))));
+
+    auto tree = builder.build(top_type{}, instances.data(), instances.size());
+
+    bvh_instance_updater updater;
+
+    unsigned index = 0;
+    mat4x3 transform(mat3::identity(), vec3(10.0f, 0.0f, 0.0f));
+
+    auto result = updater.update(tree, builder, &index, &transform, 1);
+
+    EXPECT_EQ(result.num_reinserted, 0U);
+    EXPECT_FALSE(result.rebuilt);
+
+    check_tree(tree);
+    EXPECT_TRUE(tree.node(0).get_bounds().min.x >= 10.0f);
+}
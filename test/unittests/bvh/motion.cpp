@@ -0,0 +1,467 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstdlib>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/kernels.h>
+#include <visionaray/spectrum.h>
+
+#include <gtest/gtest.h>
+
+#include "random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+static triangle_t make_random_triangle(vec3 v1, unsigned prim_id)
+{
+    vec3 v2 = v1 + rnd_vec3(10.0f);
+    vec3 v3 = v1 + rnd_vec3(10.0f);
+
+    triangle_t t(v1, v2 - v1, v3 - v1);
+    t.prim_id = prim_id;
+    t.geom_id = 0;
+    return t;
+}
+
+// Triangles that move and deform between K keyframes
+template <size_t K>
+static aligned_vector<basic_motion_triangle<K, float>> make_random_motion_triangles(size_t num_triangles)
+{
+    aligned_vector<basic_motion_triangle<K, float>> result;
+
+    for (size_t i = 0; i < num_triangles; ++i)
+    {
+        triangle_t keyframes[K];
+
+        vec3 v1 = rnd_vec3(100.0f);
+
+        for (size_t k = 0; k < K; ++k)
+        {
+            keyframes[k] = make_random_triangle(v1 + rnd_vec3(20.0f) * float(k), static_cast<unsigned>(i));
+        }
+
+        result.emplace_back(keyframes);
+    }
+
+    return result;
+}
+
+static basic_motion_ray<float> make_random_motion_ray()
+{
+    vec3 ori(-10.0f, -10.0f, 150.0f);
+    vec3 dst = rnd_vec3(120.0f);
+    return basic_motion_ray<float>(ori, normalize(dst - ori), 0.0f, numeric_limits<float>::max(), rnd());
+}
+
+// Closest hit with the triangles interpolated for the time of the ray
+template <typename Triangles>
+static hit_record<ray, primitive<unsigned>> intersect_reference(
+        basic_motion_ray<float> const&  r,
+        Triangles const&                triangles
+        )
+{
+    hit_record<ray, primitive<unsigned>> result;
+
+    for (auto const& mt : triangles)
+    {
+        ray rr(r.ori, r.dir);
+        auto hr = intersect(rr, get_triangle(mt, r.time));
+
+        if (hr.hit && hr.t < result.t)
+        {
+            result = hr;
+        }
+    }
+
+    return result;
+}
+
+template <size_t K, typename Tree>
+static void test_motion_bvh(Tree const& tree, aligned_vector<basic_motion_triangle<K, float>> const& triangles)
+{
+    // Node bounds at each keyframe contain the primitives at that keyframe
+    traverse_leaves(tree, [&](typename Tree::node_type const& n)
+    {
+        for (auto i = n.get_indices().first; i != n.get_indices().last; ++i)
+        {
+            for (unsigned k = 0; k < K; ++k)
+            {
+                aabb prim_bounds = get_bounds(tree.primitive(i), k);
+                aabb node_bounds = n.get_bounds(k);
+
+                EXPECT_TRUE(node_bounds.contains(prim_bounds.min));
+                EXPECT_TRUE(node_bounds.contains(prim_bounds.max));
+            }
+        }
+    });
+
+    int num_hits = 0;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto r = make_random_motion_ray();
+
+        auto hr1 = intersect_reference(r, triangles);
+        auto hr2 = intersect(r, tree);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            ++num_hits;
+
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+    }
+
+    EXPECT_GT(num_hits, 0);
+}
+
+template <size_t K, typename Builder>
+static void test_build(Builder builder)
+{
+    srand(0);
+
+    auto triangles = make_random_motion_triangles<K>(2000);
+
+    test_motion_bvh<K>(
+            builder.build(motion_bvh<basic_motion_triangle<K, float>, K>{}, triangles.data(), triangles.size()),
+            triangles
+            );
+
+    test_motion_bvh<K>(
+            builder.build(index_motion_bvh<basic_motion_triangle<K, float>, K>{}, triangles.data(), triangles.size()),
+            triangles
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Traverse motion BVHs built from keyframed triangles
+//
+
+TEST(Motion, Build)
+{
+    test_build<2>(binned_sah_builder{});
+    test_build<3>(binned_sah_builder{});
+    test_build<2>(lbvh_builder{});
+    test_build<4>(ploc_builder{});
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Rays without a time sample see the first keyframe
+//
+
+TEST(Motion, NoTime)
+{
+    srand(1);
+
+    auto triangles = make_random_motion_triangles<2>(500);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(motion_bvh<basic_motion_triangle<2, float>>{}, triangles.data(), triangles.size());
+
+    for (int i = 0; i < 200; ++i)
+    {
+        auto r = make_random_motion_ray();
+        r.time = 0.0f;
+
+        ray rr(r.ori, r.dir);
+
+        auto hr1 = intersect(r, tree);
+        auto hr2 = intersect(rr, tree);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// SIMD lanes interpolate for their own time samples
+//
+
+TEST(Motion, SIMD)
+{
+    srand(2);
+
+    auto triangles = make_random_motion_triangles<3>(500);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(motion_bvh<basic_motion_triangle<3, float>, 3>{}, triangles.data(), triangles.size());
+
+    for (int i = 0; i < 200; ++i)
+    {
+        basic_motion_ray<float> rays[4];
+
+        simd::aligned_array_t<simd::float4> ori_x;
+        simd::aligned_array_t<simd::float4> ori_y;
+        simd::aligned_array_t<simd::float4> ori_z;
+        simd::aligned_array_t<simd::float4> dir_x;
+        simd::aligned_array_t<simd::float4> dir_y;
+        simd::aligned_array_t<simd::float4> dir_z;
+        simd::aligned_array_t<simd::float4> time;
+
+        for (int j = 0; j < 4; ++j)
+        {
+            rays[j] = make_random_motion_ray();
+
+            ori_x[j] = rays[j].ori.x;
+            ori_y[j] = rays[j].ori.y;
+            ori_z[j] = rays[j].ori.z;
+            dir_x[j] = rays[j].dir.x;
+            dir_y[j] = rays[j].dir.y;
+            dir_z[j] = rays[j].dir.z;
+            time[j] = rays[j].time;
+        }
+
+        basic_motion_ray<simd::float4> r4(
+                vector<3, simd::float4>(simd::float4(ori_x), simd::float4(ori_y), simd::float4(ori_z)),
+                vector<3, simd::float4>(simd::float4(dir_x), simd::float4(dir_y), simd::float4(dir_z)),
+                simd::float4(0.0f),
+                simd::float4(numeric_limits<float>::max()),
+                simd::float4(time)
+                );
+
+        auto hr4 = intersect(r4, tree);
+
+        simd::aligned_array_t<simd::float4> t;
+        simd::aligned_array_t<simd::float4> hit;
+        store(t, hr4.t);
+        store(hit, select(hr4.hit, simd::float4(1.0f), simd::float4(0.0f)));
+
+        for (int j = 0; j < 4; ++j)
+        {
+            auto hr = intersect(rays[j], tree);
+
+            ASSERT_EQ(hr.hit, hit[j] != 0.0f);
+
+            if (hr.hit)
+            {
+                EXPECT_FLOAT_EQ(hr.t, t[j]);
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Motion instances interpolate their transforms, compared against the instanced triangles
+// transformed with the interpolated transform
+//
+
+TEST(Motion, Instances)
+{
+    srand(3);
+
+    size_t const NumTriangles = 50;
+    size_t const NumInstances = 10;
+
+    aligned_vector<triangle_t> triangles;
+
+    for (size_t i = 0; i < NumTriangles; ++i)
+    {
+        triangles.push_back(make_random_triangle(rnd_vec3(10.0f), static_cast<unsigned>(i)));
+    }
+
+    binned_sah_builder builder;
+
+    auto blas = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    using inst_type = index_bvh<triangle_t>::bvh_motion_inst<2>;
+
+    aligned_vector<inst_type> instances;
+
+    mat4x3 transforms[NumInstances][2];
+
+    for (size_t i = 0; i < NumInstances; ++i)
+    {
+        // Translate and rotate slightly over the shutter interval
+        mat4 m = make_random_transform(80.0f);
+        mat4 d = mat4::translation(rnd_vec3(10.0f)) * mat4::rotation(vec3(0.0f, 1.0f, 0.0f), rnd() * 0.2f);
+
+        transforms[i][0] = to_mat4x3(m);
+        transforms[i][1] = to_mat4x3(d * m);
+
+        instances.push_back(blas.motion_inst(transforms[i]));
+    }
+
+    auto top = builder.build(motion_bvh<inst_type>{}, instances.data(), instances.size());
+
+    int num_hits = 0;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto r = make_random_motion_ray();
+
+        // Reference: triangles transformed with the interpolated transforms
+        hit_record<ray, primitive<unsigned>> hr1;
+        ray rr(r.ori, r.dir);
+
+        for (size_t j = 0; j < NumInstances; ++j)
+        {
+            mat3 a0 = top_left(transforms[j][0]);
+            mat3 a1 = top_left(transforms[j][1]);
+
+            mat3 affine(
+                    lerp(a0.col0, a1.col0, r.time),
+                    lerp(a0.col1, a1.col1, r.time),
+                    lerp(a0.col2, a1.col2, r.time)
+                    );
+            vec3 trans = lerp(transforms[j][0](3), transforms[j][1](3), r.time);
+
+            for (auto const& t : triangles)
+            {
+                vec3 v1 = affine * t.v1 + trans;
+                vec3 v2 = affine * (t.v1 + t.e1) + trans;
+                vec3 v3 = affine * (t.v1 + t.e2) + trans;
+
+                auto hr = intersect(rr, triangle_t(v1, v2 - v1, v3 - v1));
+
+                if (hr.hit && hr.t < hr1.t)
+                {
+                    hr1 = hr;
+                }
+            }
+        }
+
+        auto hr2 = intersect(r, top);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            ++num_hits;
+
+            EXPECT_NEAR(hr1.t, hr2.t, hr1.t * 1e-4f);
+        }
+    }
+
+    EXPECT_GT(num_hits, 0);
+
+    // The bounds at each keyframe contain the transformed bottom-level bounds
+    for (auto const& inst : instances)
+    {
+        aabb bounds = get_bounds(inst);
+
+        for (unsigned k = 0; k < 2; ++k)
+        {
+            aabb kb = get_bounds(inst, k);
+            EXPECT_TRUE(bounds.contains(kb.min));
+            EXPECT_TRUE(bounds.contains(kb.max));
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Shadow rays of the path tracer see the scene at the time of the path
+//
+
+// Surface that reflects all light, only visibility matters
+struct white_surface
+{
+    spectrum<float> shade(vec3 const& /* */, vec3 const& /* */, vec3 const& /* */) const
+    {
+        return spectrum<float>(1.0f);
+    }
+
+    float pdf(vec3 const& /* */, vec3 const& /* */, int /* */) const
+    {
+        return 1.0f;
+    }
+};
+
+template <typename Primitives>
+struct shadow_test_params
+{
+    struct
+    {
+        Primitives begin;
+        Primitives end;
+    } prims;
+
+    float epsilon;
+};
+
+TEST(Motion, ShadowRayTime)
+{
+    // Occluder above the origin at shutter close, far off to the side at shutter open
+    triangle_t keyframes[2];
+    keyframes[1] = triangle_t(vec3(-1.0f, 1.0f, -1.0f), vec3(4.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 4.0f));
+    keyframes[0] = keyframes[1];
+    keyframes[0].v1 += vec3(100.0f, 0.0f, 0.0f);
+
+    aligned_vector<basic_motion_triangle<2, float>> triangles;
+    triangles.emplace_back(keyframes);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(motion_bvh<basic_motion_triangle<2, float>>{}, triangles.data(), triangles.size());
+    auto tree_ref = tree.ref();
+
+    using params_type = shadow_test_params<decltype(&tree_ref)>;
+    params_type params;
+    params.prims.begin = &tree_ref;
+    params.prims.end = &tree_ref + 1;
+    params.epsilon = 1e-3f;
+
+    pathtracing::kernel<params_type> k{ params };
+
+    // Point light above the shading point at the origin
+    light_sample<float> ls;
+    ls.pos = vec3(0.0f, 2.0f, 0.0f);
+    ls.intensity = vec3(1.0f);
+    ls.normal = vec3(0.0f, -1.0f, 0.0f);
+    ls.area = 1.0f;
+    ls.delta_light = true;
+
+    default_intersector isect;
+    white_surface surf;
+
+    vec3 view_dir = normalize(vec3(1.0f, 1.0f, 0.0f));
+
+    for (float time : { 0.0f, 0.5f, 1.0f })
+    {
+        // Ray that hit the shading point
+        basic_motion_ray<float> r(vec3(1.0f, 1.0f, 0.0f), -view_dir, 0.0f, numeric_limits<float>::max(), time);
+
+        auto c = k.light_contribution<basic_motion_ray<float>>(
+                isect,
+                r,
+                surf,
+                0,
+                vec3(0.0f),
+                vec3(0.0f, 1.0f, 0.0f),
+                view_dir,
+                spectrum<float>(1.0f),
+                ls,
+                1.0f
+                );
+
+        // The occluder crosses the shadow ray between time 0.5 and 1
+        if (time < 0.75f)
+        {
+            EXPECT_GT(c.samples()[0], 0.0f);
+        }
+        else
+        {
+            EXPECT_EQ(c.samples()[0], 0.0f);
+        }
+    }
+}
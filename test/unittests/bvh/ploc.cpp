@@ -0,0 +1,123 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <thread>
+#include <vector>
+
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <gtest/gtest.h>
+
+#include "random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+
+// check node bounds and primitive references -------------
+
+template <typename Tree>
+static void check_tree(Tree const& tree, size_t num_prims, int max_leaf_size)
+{
+    std::vector<int> refs(num_prims, 0);
+
+    traverse_depth_first(tree, [&](bvh_node const& node)
+    {
+        aabb expected;
+        expected.invalidate();
+
+        if (node.is_inner())
+        {
+            expected = combine(tree.node(node.get_child(0)).get_bounds(), tree.node(node.get_child(1)).get_bounds());
+        }
+        else
+        {
+            EXPECT_LE(node.get_num_primitives(), static_cast<unsigned>(max_leaf_size));
+
+            auto indices = node.get_indices();
+
+            for (unsigned i = indices.first; i != indices.last; ++i)
+            {
+                expected.insert(get_bounds(tree.primitive(i)));
+                ++refs[tree.primitive(i).prim_id];
+            }
+        }
+
+        EXPECT_EQ(node.get_bounds().min, expected.min);
+        EXPECT_EQ(node.get_bounds().max, expected.max);
+    });
+
+    for (int r : refs)
+    {
+        EXPECT_EQ(r, 1);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test ploc_builder
+//
+
+TEST(BVH, BuildPLOC)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    auto triangles = make_sphere_triangles(50000);
+
+    ploc_builder builder;
+
+    auto serial = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto parallel = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), -1, pool);
+
+    check_tree(serial, triangles.size(), 4);
+    check_tree(parallel, triangles.size(), 4);
+
+    // Deterministic
+    EXPECT_EQ(serial.num_nodes(), parallel.num_nodes());
+    EXPECT_FLOAT_EQ(sah_cost(serial), sah_cost(parallel));
+
+    // Between LBVH and binned SAH
+    lbvh_builder lbvh;
+    auto lbvh_tree = lbvh.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), -1, pool);
+
+    binned_sah_builder sah;
+    auto sah_tree = sah.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), -1, pool);
+
+    EXPECT_LT(sah_cost(parallel), sah_cost(lbvh_tree));
+    EXPECT_LT(sah_cost(parallel), 1.05f * sah_cost(sah_tree));
+
+    // bvh, with other leaf size and search radius
+    builder.set_search_radius(4);
+    auto tree = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size(), 8, pool);
+    check_tree(tree, triangles.size(), 8);
+}
+
+TEST(BVH, BuildPLOCSmall)
+{
+    auto triangles = make_sphere_triangles(3);
+
+    ploc_builder builder;
+
+    for (size_t n = 0; n <= triangles.size(); ++n)
+    {
+        auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), n, 1);
+
+        if (n == 0)
+        {
+            EXPECT_EQ(tree.num_nodes(), 0U);
+        }
+        else
+        {
+            EXPECT_EQ(tree.num_nodes(), 2 * n - 1);
+            check_tree(tree, n, 1);
+        }
+    }
+}
@@ -0,0 +1,248 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+
+// small triangles and a few long, thin diagonal ones ------
+
+static aligned_vector<triangle_t, 32> make_sliver_triangles(size_t count, size_t num_slivers)
+{
+    srand(0);
+
+    auto rnd = []()
+    {
+        return static_cast<float>(rand()) / RAND_MAX;
+    };
+
+    aligned_vector<triangle_t, 32> triangles(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 v1(rnd() * 100.0f, rnd() * 100.0f, rnd() * 100.0f);
+        vec3 e1(rnd(), rnd(), rnd());
+        vec3 e2(rnd(), rnd(), rnd());
+
+        if (i < num_slivers)
+        {
+            // Spans the scene diagonally, but has a small surface area
+            e1 = vec3(100.0f, 100.0f, 100.0f) - v1;
+        }
+
+        triangles[i] = triangle_t(v1, e1, e2);
+        triangles[i].prim_id = static_cast<unsigned>(i);
+    }
+
+    return triangles;
+}
+
+// rays hit the same primitives as with the reference tree -
+
+template <typename Tree, typename Reference>
+static void check_intersect(Tree const& tree, Reference const& reference)
+{
+    srand(1);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        vec3 ori(-10.0f, -10.0f, 110.0f);
+
+        vec3 dst(
+                rand() / static_cast<float>(RAND_MAX) * 100.0f,
+                rand() / static_cast<float>(RAND_MAX) * 100.0f,
+                rand() / static_cast<float>(RAND_MAX) * 100.0f
+                );
+
+        basic_ray<float> r(ori, normalize(dst - ori));
+
+        auto hr1 = intersect(r, reference);
+        auto hr2 = intersect(r, tree);
+
+        // Rays that graze an edge may miss the bounds of the primitive due to
+        // rounding errors, with either tree
+        auto near_edge = [](decltype(hr1) const& hr)
+        {
+            return hr.hit && min(min(hr.u, hr.v), 1.0f - hr.u - hr.v) < 1e-3f;
+        };
+
+        if (near_edge(hr1) || near_edge(hr2))
+        {
+            continue;
+        }
+
+        EXPECT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test bvh_presplitter
+//
+
+TEST(BVH, PresplitReferences)
+{
+    auto triangles = make_sliver_triangles(10000, 100);
+
+    bvh_presplitter presplitter;
+    presplitter.split(triangles.data(), triangles.size());
+
+    // Number of references is within budget
+    EXPECT_GT(presplitter.size(), triangles.size());
+    EXPECT_LE(presplitter.size(), triangles.size() * (1.0f + presplitter.budget()));
+    EXPECT_EQ(presplitter.indices().size(), presplitter.size());
+
+    std::vector<int> refs(triangles.size(), 0);
+
+    for (size_t i = 0; i < presplitter.size(); ++i)
+    {
+        unsigned index = presplitter.indices()[i];
+        ASSERT_LT(index, triangles.size());
+
+        ++refs[index];
+
+        // Reference bounds are contained in the primitive bounds
+        aabb bounds = get_bounds(triangles[index]);
+        aabb ref = presplitter.bounds()[i];
+
+        EXPECT_TRUE(ref.valid());
+        EXPECT_GE(ref.min.x, bounds.min.x);
+        EXPECT_GE(ref.min.y, bounds.min.y);
+        EXPECT_GE(ref.min.z, bounds.min.z);
+        EXPECT_LE(ref.max.x, bounds.max.x);
+        EXPECT_LE(ref.max.y, bounds.max.y);
+        EXPECT_LE(ref.max.z, bounds.max.z);
+    }
+
+    // Every primitive is referenced, the slivers are split most often
+    int max_small_refs = 0;
+
+    for (size_t i = 100; i < triangles.size(); ++i)
+    {
+        EXPECT_GE(refs[i], 1);
+        max_small_refs = std::max(max_small_refs, refs[i]);
+    }
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        EXPECT_GT(refs[i], max_small_refs);
+    }
+
+    // No budget, no splits
+    presplitter.set_budget(0.0f);
+    presplitter.split(triangles.data(), triangles.size());
+    EXPECT_EQ(presplitter.size(), triangles.size());
+
+    // Same references with a thread pool
+    thread_pool pool(4);
+
+    bvh_presplitter serial;
+    bvh_presplitter parallel;
+
+    serial.split(triangles.data(), triangles.size());
+    parallel.split(triangles.data(), triangles.size(), pool);
+
+    ASSERT_EQ(serial.size(), parallel.size());
+
+    for (size_t i = 0; i < serial.size(); ++i)
+    {
+        EXPECT_EQ(serial.indices()[i], parallel.indices()[i]);
+        EXPECT_EQ(serial.bounds()[i].min, parallel.bounds()[i].min);
+        EXPECT_EQ(serial.bounds()[i].max, parallel.bounds()[i].max);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test builders with pre-splitting enabled
+//
+
+TEST(BVH, PresplitSah)
+{
+    auto triangles = make_sliver_triangles(10000, 100);
+
+    binned_sah_builder builder;
+    auto reference = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    builder.enable_presplits(true);
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    EXPECT_EQ(tree.num_primitives(), triangles.size());
+    EXPECT_EQ(tree.indices().size(), builder.presplitter.size());
+    EXPECT_LT(sah_cost(tree), sah_cost(reference));
+
+    check_intersect(tree, reference);
+
+    // Primitives of a bvh are duplicated
+    thread_pool pool(4);
+
+    auto tree2 = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size(), -1, pool);
+
+    EXPECT_EQ(tree2.num_primitives(), builder.presplitter.size());
+    EXPECT_LT(sah_cost(tree2), sah_cost(reference));
+
+    check_intersect(tree2, reference);
+}
+
+TEST(BVH, PresplitLbvh)
+{
+    auto triangles = make_sliver_triangles(10000, 100);
+
+    binned_sah_builder reference_builder;
+    auto reference = reference_builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    lbvh_builder builder;
+    auto unsplit = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    builder.enable_presplits(true);
+
+    thread_pool pool(4);
+
+    // Serial build
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    EXPECT_EQ(tree.indices().size(), builder.presplitter.size());
+    EXPECT_LT(sah_cost(tree), sah_cost(unsplit));
+
+    check_intersect(tree, reference);
+
+    // Parallel build
+    auto tree2 = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), -1, pool);
+
+    EXPECT_EQ(tree2.indices().size(), builder.presplitter.size());
+    EXPECT_LT(sah_cost(tree2), sah_cost(unsplit));
+
+    check_intersect(tree2, reference);
+
+    // Primitives of a bvh are duplicated
+    auto tree3 = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto tree4 = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size(), -1, pool);
+
+    EXPECT_EQ(tree3.num_primitives(), builder.presplitter.size());
+    EXPECT_EQ(tree4.num_primitives(), builder.presplitter.size());
+
+    check_intersect(tree3, reference);
+    check_intersect(tree4, reference);
+}
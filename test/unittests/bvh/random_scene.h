@@ -0,0 +1,162 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TEST_UNITTESTS_BVH_RANDOM_SCENE_H
+#define VSNRAY_TEST_UNITTESTS_BVH_RANDOM_SCENE_H 1
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+
+#include <gtest/gtest.h>
+
+
+//-------------------------------------------------------------------------------------------------
+// Random scene content shared by the BVH and primitive tests
+//
+
+// random number in [0..1] from the rand() sequence -------
+
+inline float rnd()
+{
+    return static_cast<float>(rand()) / RAND_MAX;
+}
+
+// random point in [0..extent]^3 --------------------------
+
+inline visionaray::vec3 rnd_vec3(float extent)
+{
+    return visionaray::vec3(rnd() * extent, rnd() * extent, rnd() * extent);
+}
+
+// generate a random triangle soup ------------------------
+//
+// The first vertex of each triangle lies in [0..extent]^3, the edges are
+// at most edge_length long along each axis. Geometry ids cycle through
+// [0..num_geometries). Reseeds rand() so that the same triangles are
+// generated on every call.
+//
+
+inline visionaray::aligned_vector<visionaray::basic_triangle<3, float>, 32> make_random_triangles(
+        size_t      count,
+        float       extent          = 100.0f,
+        float       edge_length     = 1.0f,
+        unsigned    num_geometries  = 1
+        )
+{
+    using visionaray::vec3;
+
+    srand(0);
+
+    visionaray::aligned_vector<visionaray::basic_triangle<3, float>, 32> triangles(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 v1 = rnd_vec3(extent);
+        vec3 v2 = v1 + rnd_vec3(edge_length);
+        vec3 v3 = v1 + rnd_vec3(edge_length);
+
+        triangles[i] = visionaray::basic_triangle<3, float>(v1, v2 - v1, v3 - v1);
+        triangles[i].prim_id = static_cast<unsigned>(i);
+        triangles[i].geom_id = static_cast<unsigned>(i % num_geometries);
+    }
+
+    return triangles;
+}
+
+// small triangles on the surfaces of three spheres --------
+//
+// Spheres of very different sizes, so that builders see clusters of primitives
+// with different densities
+//
+
+inline visionaray::aligned_vector<visionaray::basic_triangle<3, float>, 32> make_sphere_triangles(size_t count)
+{
+    using visionaray::vec3;
+
+    auto triangles = make_random_triangles(count);
+
+    float radii[] = { 40.0f, 5.0f, 1.0f };
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        float phi = rnd() * visionaray::constants::two_pi<float>();
+        float theta = rnd() * visionaray::constants::pi<float>();
+
+        vec3 center(static_cast<float>(i % 3) * 30.0f, 0.0f, 0.0f);
+        vec3 dir(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+
+        triangles[i].v1 = center + dir * radii[i % 3];
+        triangles[i].e1 *= 0.1f;
+        triangles[i].e2 *= 0.1f;
+    }
+
+    return triangles;
+}
+
+// random ray into [0..extent]^3 --------------------------
+
+inline visionaray::basic_ray<float> make_random_ray(float extent = 100.0f)
+{
+    visionaray::vec3 ori(-10.0f, -10.0f, extent + 10.0f);
+    visionaray::vec3 dst = rnd_vec3(extent);
+    return visionaray::basic_ray<float>(ori, normalize(dst - ori));
+}
+
+// random rotation and translation ------------------------
+
+inline visionaray::mat4 make_random_transform(float extent)
+{
+    using visionaray::mat4;
+
+    visionaray::vec3 axis = normalize(visionaray::vec3(rnd() + 0.1f, rnd(), rnd()));
+    return mat4::translation(rnd_vec3(extent)) * mat4::rotation(axis, rnd() * 6.0f);
+}
+
+// affine part of a 4x4 transform -------------------------
+
+inline visionaray::mat4x3 to_mat4x3(visionaray::mat4 const& m)
+{
+    return visionaray::mat4x3(top_left(m), m(3).xyz());
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Checks shared by the BVH tests
+//
+
+// node bounds enclose the children exactly ---------------
+
+template <typename Tree>
+inline visionaray::aabb check_bounds(Tree const& tree, unsigned index = 0)
+{
+    auto const& node = tree.node(index);
+
+    visionaray::aabb expected;
+    expected.invalidate();
+
+    if (node.is_inner())
+    {
+        expected = combine(check_bounds(tree, node.get_child(0)), check_bounds(tree, node.get_child(1)));
+    }
+    else
+    {
+        auto indices = node.get_indices();
+
+        for (unsigned i = indices.first; i != indices.last; ++i)
+        {
+            expected.insert(get_bounds(tree.primitive(i)));
+        }
+    }
+
+    EXPECT_EQ(node.get_bounds().min, expected.min);
+    EXPECT_EQ(node.get_bounds().max, expected.max);
+
+    return expected;
+}
+
+#endif // VSNRAY_TEST_UNITTESTS_BVH_RANDOM_SCENE_H
@@ -0,0 +1,191 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <gtest/gtest.h>
+
+#include "random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+
+// move triangles, differently for each frame -------------
+
+static void deform(triangle_t* triangles, size_t count, int frame)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float t = static_cast<float>(frame + i % 7);
+        triangles[i].v1 += vec3(sin(t), cos(t), sin(0.5f * t)) * 10.0f;
+        triangles[i].e1 *= 1.0f + 0.1f * frame;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test bvh_refitter
+//
+
+TEST(BVH, RefitIndexBvh)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    auto triangles = make_random_triangles(10000);
+
+    lbvh_builder builder;
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    auto num_nodes = tree.num_nodes();
+
+    // Repeated calls reuse parent links and counters
+    bvh_refitter refitter;
+
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        deform(triangles.data(), triangles.size(), frame);
+
+        if (frame % 2 == 0)
+        {
+            refitter.refit(tree, triangles.data(), triangles.size(), pool);
+        }
+        else
+        {
+            refitter.refit(tree, triangles.data(), triangles.size());
+        }
+
+        EXPECT_EQ(tree.num_nodes(), num_nodes);
+
+        aabb root = check_bounds(tree);
+
+        aabb expected;
+        expected.invalidate();
+
+        for (auto const& t : triangles)
+        {
+            expected.insert(get_bounds(t));
+        }
+
+        EXPECT_EQ(root.min, expected.min);
+        EXPECT_EQ(root.max, expected.max);
+    }
+}
+
+TEST(BVH, RefitBvh)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    auto triangles = make_random_triangles(10000);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    bvh_refitter refitter;
+
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        // Primitives are deformed in place, in the order of the tree
+        deform(tree.primitives().data(), tree.primitives().size(), frame);
+
+        refitter.refit(tree, pool);
+
+        check_bounds(tree);
+    }
+
+    // Tree rebuilt in place
+    tree = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+    refitter.reset();
+    refitter.refit(tree, pool);
+
+    check_bounds(tree);
+
+    // Single leaf
+    auto single = builder.build(bvh<triangle_t>{}, triangles.data(), 1);
+    deform(single.primitives().data(), 1, 1);
+    refitter.refit(single);
+
+    check_bounds(single);
+}
+
+TEST(BVH, RefitRotations)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    auto triangles = make_random_triangles(10000);
+    auto original = triangles;
+
+    binned_sah_builder builder;
+    auto refitted = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto rotated = refitted;
+
+    bvh_refitter refitter1;
+    bvh_refitter refitter2;
+
+    // Parts of the scene move through each other
+    static const int NumFrames = 30;
+
+    for (int frame = 1; frame <= NumFrames; ++frame)
+    {
+        float s = static_cast<float>(frame) / NumFrames;
+
+        for (size_t i = 0; i < triangles.size(); ++i)
+        {
+            vec3 v1 = original[i].v1;
+            triangles[i].v1 = v1 + vec3(v1.x < 50.0f ? 50.0f : 0.0f, v1.x < 50.0f ? 0.0f : 50.0f, v1.z < 30.0f ? 60.0f : 0.0f) * s;
+        }
+
+        refitter1.refit(refitted, triangles.data(), triangles.size(), pool);
+        refitter2.refit(rotated, triangles.data(), triangles.size(), pool);
+
+        auto result = refitter2.optimize(rotated);
+
+        EXPECT_LE(result.sah_after, result.sah_before);
+        EXPECT_GT(result.num_visited, 0U);
+    }
+
+    EXPECT_LT(sah_cost(rotated), 0.95f * sah_cost(refitted));
+
+    // Small budget, only part of the tree is visited
+    auto result = refitter2.optimize(rotated, 1e-6f);
+    EXPECT_LT(result.num_visited, rotated.num_nodes() / 2);
+    EXPECT_LE(result.sah_after, result.sah_before);
+
+    check_bounds(rotated);
+
+    // All primitives are still referenced exactly once
+    std::vector<int> refs(triangles.size(), 0);
+
+    traverse_leaves(rotated, [&](bvh_node const& leaf)
+    {
+        auto indices = leaf.get_indices();
+
+        for (unsigned i = indices.first; i != indices.last; ++i)
+        {
+            ++refs[rotated.indices()[i]];
+        }
+    });
+
+    for (int r : refs)
+    {
+        EXPECT_EQ(r, 1);
+    }
+
+    // Parent links were updated by the rotations
+    deform(triangles.data(), triangles.size(), 1);
+    refitter2.refit(rotated, triangles.data(), triangles.size(), pool);
+
+    check_bounds(rotated);
+}
@@ -0,0 +1,210 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstdlib>
+#include <vector>
+
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <gtest/gtest.h>
+
+#include "random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+
+// check structure and primitive references ---------------
+
+template <typename Tree>
+static void check_layout(Tree const& tree, size_t num_prims)
+{
+    std::vector<int> refs(num_prims, 0);
+    unsigned next_prim = 0;
+
+    for (size_t i = 0; i < tree.num_nodes(); ++i)
+    {
+        auto const& node = tree.node(i);
+
+        if (node.is_inner())
+        {
+            // Parents precede their children
+            EXPECT_GT(node.get_child(0), i);
+            EXPECT_LT(node.get_child(1), tree.num_nodes());
+
+            aabb bounds = combine(
+                    tree.node(node.get_child(0)).get_bounds(),
+                    tree.node(node.get_child(1)).get_bounds()
+                    );
+
+            EXPECT_EQ(node.get_bounds().min, bounds.min);
+            EXPECT_EQ(node.get_bounds().max, bounds.max);
+        }
+        else
+        {
+            // Primitive ranges are consecutive in node order
+            auto indices = node.get_indices();
+            EXPECT_EQ(indices.first, next_prim);
+            next_prim = indices.last;
+
+            for (unsigned j = indices.first; j != indices.last; ++j)
+            {
+                ++refs[tree.primitive(j).prim_id];
+            }
+        }
+    }
+
+    for (int r : refs)
+    {
+        EXPECT_EQ(r, 1);
+    }
+}
+
+// rays hit the same primitives as with the original tree -
+
+template <typename Tree>
+static void check_intersect(Tree const& tree, Tree const& reference)
+{
+    srand(1);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        vec3 ori(-10.0f, -10.0f, -10.0f);
+        vec3 dst = rnd_vec3(100.0f);
+
+        basic_ray<float> r(ori, normalize(dst - ori));
+
+        auto hr1 = intersect(r, reference);
+        auto hr2 = intersect(r, tree);
+
+        EXPECT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test reorder_nodes()
+//
+
+TEST(BVH, ReorderDepthFirst)
+{
+    auto triangles = make_random_triangles(10000);
+
+    binned_sah_builder builder;
+    auto reference = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto tree = reference;
+
+    reorder_nodes(tree, DepthFirstOrder);
+
+    EXPECT_EQ(tree.num_nodes(), reference.num_nodes());
+
+    // Same topology, only the summation order differs
+    EXPECT_NEAR(sah_cost(tree), sah_cost(reference), 1e-5f * sah_cost(reference));
+
+    check_layout(tree, triangles.size());
+    check_intersect(tree, reference);
+
+    // Primitives keep their order, indices are ascending within leaves
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        EXPECT_EQ(tree.primitives()[i].prim_id, i);
+    }
+
+    for (auto const& node : tree.nodes())
+    {
+        if (node.is_inner())
+        {
+            // The pair below the larger child directly follows its parent's pair
+            auto const& c0 = tree.node(node.get_child(0));
+            auto const& c1 = tree.node(node.get_child(1));
+
+            auto const& larger = surface_area(c0.get_bounds()) >= surface_area(c1.get_bounds()) ? c0 : c1;
+
+            if (larger.is_inner())
+            {
+                EXPECT_EQ(larger.get_child(0), node.get_child(0) + 2);
+            }
+        }
+        else
+        {
+            auto indices = node.get_indices();
+
+            for (unsigned i = indices.first + 1; i < indices.last; ++i)
+            {
+                EXPECT_LT(tree.indices()[i - 1], tree.indices()[i]);
+            }
+        }
+    }
+}
+
+TEST(BVH, ReorderVanEmdeBoas)
+{
+    auto triangles = make_random_triangles(10000);
+
+    lbvh_builder builder;
+    auto reference = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto tree = reference;
+
+    reorder_nodes(tree, VanEmdeBoasOrder);
+
+    EXPECT_EQ(tree.num_nodes(), reference.num_nodes());
+
+    // Same topology, only the summation order differs
+    EXPECT_NEAR(sah_cost(tree), sah_cost(reference), 1e-5f * sah_cost(reference));
+
+    check_layout(tree, triangles.size());
+    check_intersect(tree, reference);
+
+    // The root's pair comes first, followed by the pair below the larger child
+    auto const& c0 = tree.node(1);
+    auto const& c1 = tree.node(2);
+
+    auto const& larger = surface_area(c0.get_bounds()) >= surface_area(c1.get_bounds()) ? c0 : c1;
+
+    EXPECT_EQ(tree.node(0).get_child(0), 1U);
+    EXPECT_EQ(larger.get_child(0), 3U);
+}
+
+TEST(BVH, ReorderBvh)
+{
+    auto triangles = make_random_triangles(1000);
+
+    binned_sah_builder builder;
+    auto reference = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    for (auto order : { DepthFirstOrder, VanEmdeBoasOrder })
+    {
+        auto tree = reference;
+        reorder_nodes(tree, order);
+
+        EXPECT_EQ(tree.num_nodes(), reference.num_nodes());
+
+        check_layout(tree, triangles.size());
+        check_intersect(tree, reference);
+    }
+
+    // Nodes that are not referenced are dropped
+    auto tree = reference;
+    tree.nodes().emplace_back();
+    reorder_nodes(tree);
+    EXPECT_EQ(tree.num_nodes(), reference.num_nodes());
+
+    // Single leaf
+    auto single = builder.build(bvh<triangle_t>{}, triangles.data(), 1);
+    reorder_nodes(single, VanEmdeBoasOrder);
+    EXPECT_EQ(single.num_nodes(), 1U);
+    check_layout(single, 1);
+}
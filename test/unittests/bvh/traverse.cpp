@@ -1,6 +1,11 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <cmath>
+#include <cstdlib>
+
+#include <visionaray/math/simd/simd.h>
+#include <visionaray/aligned_vector.h>
 #include <visionaray/bvh.h>
 
 #include <gtest/gtest.h>
@@ -346,3 +351,398 @@ TEST(BVH, TraverseParents)
         }
         );
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that wide BVHs report the same hits as the binary BVHs they were collapsed from
+//
+
+template <typename BVH, typename WideBVH>
+static void test_intersect_wide(BVH const& tree, WideBVH const& wide)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        vec3 ori(
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f,
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f,
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f
+                );
+
+        vec3 dir(
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f,
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f,
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f
+                );
+
+        basic_ray<float> r(ori, normalize(dir));
+
+        auto hr1 = intersect(r, tree);
+        auto hr2 = intersect(r, wide);
+
+        EXPECT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+
+        // Ray packet with the same ray in all lanes
+        simd::ray4 r4(vector<3, simd::float4>(ori), vector<3, simd::float4>(normalize(dir)));
+
+        auto hr4 = intersect(r4, wide);
+
+        EXPECT_EQ(hr1.hit, all(hr4.hit));
+
+        if (hr1.hit)
+        {
+            EXPECT_TRUE(all(abs(hr4.t - simd::float4(hr1.t)) < simd::float4(1e-5f)));
+        }
+
+        // Any hit
+        default_intersector isect;
+        auto hr3 = intersect<detail::AnyHit>(r, wide, isect);
+        EXPECT_EQ(hr1.hit, hr3.hit);
+    }
+
+    // Axis-parallel rays, the inverse direction has infinite components
+    for (int i = 0; i < 300; ++i)
+    {
+        int axis = i % 3;
+
+        vec3 ori(
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f,
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f,
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f
+                );
+        ori[axis] = -2.0f;
+
+        vec3 dir(0.0f);
+        dir[axis] = 1.0f;
+
+        basic_ray<float> r(ori, dir);
+
+        auto hr1 = intersect(r, tree);
+        auto hr2 = intersect(r, wide);
+
+        EXPECT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+    }
+}
+
+TEST(BVH, IntersectWide)
+{
+    srand(0);
+
+    aligned_vector<basic_triangle<3, float>> triangles(5000);
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        vec3 v1(
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f,
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f,
+                rand() / static_cast<float>(RAND_MAX) * 2.0f - 1.0f
+                );
+
+        vec3 e1(
+                rand() / static_cast<float>(RAND_MAX) * 0.1f,
+                rand() / static_cast<float>(RAND_MAX) * 0.1f,
+                rand() / static_cast<float>(RAND_MAX) * 0.1f
+                );
+
+        vec3 e2(
+                rand() / static_cast<float>(RAND_MAX) * 0.1f,
+                rand() / static_cast<float>(RAND_MAX) * 0.1f,
+                rand() / static_cast<float>(RAND_MAX) * 0.1f
+                );
+
+        triangles[i] = basic_triangle<3, float>(v1, e1, e2);
+        triangles[i].prim_id = static_cast<unsigned>(i);
+    }
+
+    binned_sah_builder builder;
+
+    auto tree = builder.build(bvh<basic_triangle<3, float>>{}, triangles.data(), triangles.size());
+    auto index_tree = builder.build(index_bvh<basic_triangle<3, float>>{}, triangles.data(), triangles.size());
+
+    bvh4<basic_triangle<3, float>> tree4 = collapse<4>(tree);
+    bvh8<basic_triangle<3, float>> tree8 = collapse<8>(tree);
+    index_bvh4<basic_triangle<3, float>> index_tree4 = collapse<4>(index_tree);
+
+    EXPECT_LT(tree4.num_nodes(), tree.num_nodes());
+    EXPECT_LT(tree8.num_nodes(), tree4.num_nodes());
+
+    // All primitives are still referenced exactly once
+    size_t num_referenced = 0;
+
+    for (auto const& n : tree8.nodes())
+    {
+        for (unsigned i = 0; i < n.get_num_children(); ++i)
+        {
+            if (n.is_leaf(i))
+            {
+                num_referenced += n.get_indices(i).last - n.get_indices(i).first;
+            }
+        }
+    }
+
+    EXPECT_EQ(num_referenced, triangles.size());
+
+    test_intersect_wide(tree, tree4);
+    test_intersect_wide(tree, tree8);
+    test_intersect_wide(index_tree, index_tree4);
+    test_intersect_wide(tree.ref(), tree4.ref());
+
+    // Quantized child bounds are conservative, the same primitives are hit
+    bvh4q<basic_triangle<3, float>> tree4q = quantize(tree4);
+    bvh8q<basic_triangle<3, float>> tree8q = quantize(tree8);
+    index_bvh4q<basic_triangle<3, float>> index_tree4q = quantize(index_tree4);
+
+    EXPECT_EQ(tree8q.num_nodes(), tree8.num_nodes());
+
+    test_intersect_wide(tree, tree4q);
+    test_intersect_wide(tree, tree8q);
+    test_intersect_wide(index_tree, index_tree4q);
+    test_intersect_wide(tree.ref(), tree8q.ref());
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test wide traversal of a deep tree that fills the traversal stack
+//
+// Each node of the spine has a smaller spine node and a bush as children. The bush is a
+// complete binary tree with four levels of inner nodes whose boxes are larger than the
+// rest of the spine, so that collapsing gathers the spine node and seven inner bush
+// nodes into each wide node. Rays along the x axis enter the spine first and hit all
+// boxes, so each wide level pushes seven more nodes than it pops.
+//
+
+struct deep_tree_builder
+{
+    using triangle_t = basic_triangle<3, float>;
+
+    enum { SpineLength = 12, BushDepth = 4 };
+
+    aligned_vector<bvh_node, 32> nodes;
+    aligned_vector<triangle_t> primitives;
+
+    // The triangle at the end of the spine
+    unsigned hit_prim_id;
+
+    static float scale(int level)
+    {
+        return std::ldexp(1.0f, -level);
+    }
+
+    // Distance that boxes of spine level reach to negative x, grows towards the end of the spine
+    static float reach(int level)
+    {
+        return std::ldexp(1.0f, -SpineLength - 1) * (1.0f + level / static_cast<float>(SpineLength));
+    }
+
+    unsigned alloc_pair()
+    {
+        nodes.resize(nodes.size() + 2);
+        return static_cast<unsigned>(nodes.size() - 2);
+    }
+
+    // Leaf with a triangle that rays along the x axis miss
+    void make_leaf(unsigned index, aabb const& box)
+    {
+        vec3 v1(box.center().x, box.max.y * 0.9f, 0.0f);
+        triangle_t t(v1, vec3(0.0f, box.max.y * 0.01f, 0.0f), vec3(0.0f, 0.0f, box.max.y * 0.01f));
+        t.prim_id = static_cast<unsigned>(primitives.size());
+        t.geom_id = 0;
+
+        nodes[index].set_leaf(box, static_cast<unsigned>(primitives.size()), 1);
+        primitives.push_back(t);
+    }
+
+    // Children are slightly smaller than their parent, so that wider levels are collapsed first
+    void make_bush(unsigned index, aabb const& box, int depth)
+    {
+        if (depth == BushDepth)
+        {
+            make_leaf(index, box);
+            return;
+        }
+
+        aabb child_box(box.min * vec3(1.0f, 0.99f, 0.99f), box.max * vec3(1.0f, 0.99f, 0.99f));
+
+        unsigned first = alloc_pair();
+        nodes[index].set_inner(box, first);
+
+        make_bush(first, child_box, depth + 1);
+        make_bush(first + 1, child_box, depth + 1);
+    }
+
+    aabb bush_bounds(int level) const
+    {
+        float s = scale(level);
+        return aabb(vec3(-reach(level), -s, -s), vec3(s, s, s));
+    }
+
+    // The spine ends with a triangle in the plane x = 0 that all rays along the x axis hit
+    aabb make_spine(unsigned index, int level)
+    {
+        if (level == SpineLength)
+        {
+            float s = scale(level) * 0.5f;
+
+            triangle_t t(vec3(0.0f, -s, -s), vec3(0.0f, 2.0f * s, 0.0f), vec3(0.0f, s, 2.0f * s));
+            t.prim_id = static_cast<unsigned>(primitives.size());
+            t.geom_id = 0;
+            hit_prim_id = t.prim_id;
+
+            aabb box(vec3(-reach(level), -s, -s), vec3(0.0f, s, s));
+            nodes[index].set_leaf(box, static_cast<unsigned>(primitives.size()), 1);
+            primitives.push_back(t);
+
+            return box;
+        }
+
+        unsigned first = alloc_pair();
+
+        aabb spine = make_spine(first, level + 1);
+        aabb bush = bush_bounds(level);
+        make_bush(first + 1, bush, 0);
+
+        aabb box = combine(spine, bush);
+        nodes[index].set_inner(box, first);
+
+        return box;
+    }
+
+    bvh<triangle_t> build()
+    {
+        nodes.resize(1);
+        make_spine(0, 0);
+
+        bvh<triangle_t> tree;
+        tree.nodes() = nodes;
+        tree.primitives() = primitives;
+        return tree;
+    }
+};
+
+TEST(BVH, IntersectWideDeep)
+{
+    using triangle_t = basic_triangle<3, float>;
+
+    deep_tree_builder builder;
+    auto tree = builder.build();
+
+    bvh4<triangle_t> tree4 = collapse<4>(tree);
+    bvh8<triangle_t> tree8 = collapse<8>(tree);
+    bvh8q<triangle_t> tree8q = quantize(tree8);
+
+    // Every wide level along the spine adds seven stack entries, more than the 64 entries
+    // that a stack sized for the depth of binary trees holds
+    EXPECT_GE(tree8.nodes()[0].get_num_children(), 8U);
+    EXPECT_GT(detail::max_traversal_stack_size(tree8.nodes()), 64U);
+    EXPECT_LE(detail::max_traversal_stack_size(tree8.nodes()), static_cast<unsigned>(detail::wide_traversal_stack<8>::Size));
+    EXPECT_LE(detail::max_traversal_stack_size(tree4.nodes()), static_cast<unsigned>(detail::wide_traversal_stack<4>::Size));
+
+    for (int i = 0; i < 10; ++i)
+    {
+        float y = (i - 5) * 1e-5f;
+
+        basic_ray<float> r(vec3(-1.0f, y, 0.0f), vec3(1.0f, 0.0f, 0.0f));
+
+        auto hr = intersect(r, tree);
+        ASSERT_TRUE(hr.hit);
+        EXPECT_FLOAT_EQ(hr.t, 1.0f);
+        EXPECT_EQ(hr.prim_id, builder.hit_prim_id);
+
+        auto hr4 = intersect(r, tree4);
+        auto hr8 = intersect(r, tree8);
+        auto hr8q = intersect(r, tree8q);
+
+        EXPECT_TRUE(hr4.hit && hr4.t == hr.t && hr4.prim_id == hr.prim_id);
+        EXPECT_TRUE(hr8.hit && hr8.t == hr.t && hr8.prim_id == hr.prim_id);
+        EXPECT_TRUE(hr8q.hit && hr8q.t == hr.t && hr8q.prim_id == hr.prim_id);
+    }
+
+    // Rays that miss the final triangle visit every node
+    basic_ray<float> miss(vec3(-1.0f, 1e-3f, 0.0f), vec3(1.0f, 0.0f, 0.0f));
+
+    EXPECT_FALSE(intersect(miss, tree).hit);
+    EXPECT_FALSE(intersect(miss, tree8).hit);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that quantized child bounds enclose the original bounds and are not much larger
+//
+
+TEST(BVH, QuantizedNode)
+{
+    srand(0);
+
+    auto rnd = []()
+    {
+        return rand() / static_cast<float>(RAND_MAX);
+    };
+
+    for (int n = 0; n < 100; ++n)
+    {
+        // Nodes far from the origin and of different scales
+        vec3 offset = (vec3(rnd(), rnd(), rnd()) - vec3(0.5f)) * 1e4f;
+        float size = n < 50 ? 1e-2f + rnd() * 10.0f : 1e3f * rnd();
+
+        aabb children[8];
+        aabb bounds;
+        bounds.invalidate();
+
+        for (int i = 0; i < 8; ++i)
+        {
+            vec3 v1 = offset + vec3(rnd(), rnd(), rnd()) * size;
+            vec3 v2 = offset + vec3(rnd(), rnd(), rnd()) * size;
+
+            children[i] = aabb(min(v1, v2), max(v1, v2));
+            bounds.insert(children[i]);
+        }
+
+        // One flat child
+        children[7].max.y = children[7].min.y;
+
+        bvh8q_node node;
+        node.set_grid(bounds);
+
+        for (unsigned i = 0; i < 7; ++i)
+        {
+            node.set_inner(i, children[i], i);
+        }
+
+        node.set_leaf(7, children[7], 0, 1);
+
+        vec3 cell = node.get_scale();
+
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            aabb q = node.get_bounds(i);
+
+            for (int a = 0; a < 3; ++a)
+            {
+                EXPECT_LE(q.min[a], children[i].min[a]);
+                EXPECT_GE(q.max[a], children[i].max[a]);
+                EXPECT_LE(children[i].min[a] - q.min[a], 2.0f * cell[a]);
+                EXPECT_LE(q.max[a] - children[i].max[a], 2.0f * cell[a]);
+            }
+        }
+
+        // At most twice as coarse as 1/255 of the extent
+        for (int a = 0; a < 3; ++a)
+        {
+            EXPECT_LE(cell[a], 2.0f * (bounds.max[a] - bounds.min[a]) / 255.0f);
+        }
+
+        EXPECT_TRUE(node.is_leaf(7));
+        EXPECT_EQ(node.get_num_children(), 8U);
+    }
+}
@@ -0,0 +1,120 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <thread>
+#include <vector>
+
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <gtest/gtest.h>
+
+#include "random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+
+// all primitives are referenced exactly once -------------
+
+template <typename Tree>
+static void check_primitives(Tree const& tree, size_t num_prims)
+{
+    std::vector<int> refs(num_prims, 0);
+    size_t num_leaves = 0;
+
+    traverse_leaves(tree, [&](bvh_node const& leaf)
+    {
+        auto indices = leaf.get_indices();
+
+        for (unsigned i = indices.first; i != indices.last; ++i)
+        {
+            ++refs[tree.primitive(i).prim_id];
+        }
+
+        ++num_leaves;
+    });
+
+    for (int r : refs)
+    {
+        EXPECT_EQ(r, 1);
+    }
+
+    EXPECT_EQ(tree.num_nodes(), 2 * num_leaves - 1);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test bvh_treelet_optimizer
+//
+
+TEST(BVH, TreeletOptimizeLBVH)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    auto triangles = make_sphere_triangles(50000);
+
+    lbvh_builder lbvh;
+    auto serial = lbvh.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto parallel = serial;
+
+    binned_sah_builder sah;
+    auto reference = sah.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    float cost_lbvh = sah_cost(serial);
+    float cost_sah = sah_cost(reference);
+
+    bvh_treelet_optimizer optimizer;
+    optimizer.optimize(serial);
+    optimizer.optimize(parallel, pool);
+
+    // Treelets are independent, the result does not depend on the order of processing
+    EXPECT_FLOAT_EQ(sah_cost(serial), sah_cost(parallel));
+
+    float cost_opt = sah_cost(parallel);
+
+    // Close to or better than binned SAH
+    EXPECT_LT(cost_opt, cost_lbvh);
+    EXPECT_LT(cost_opt, 1.02f * cost_sah);
+
+    check_bounds(parallel);
+    check_primitives(parallel, triangles.size());
+
+    // Can be traversed and optimized again
+    float cost_before = sah_cost(parallel);
+    optimizer.set_treelet_size(5);
+    optimizer.set_num_rounds(1);
+    optimizer.optimize(parallel, pool);
+    EXPECT_LE(sah_cost(parallel), cost_before);
+    check_bounds(parallel);
+}
+
+TEST(BVH, TreeletOptimizeBvh)
+{
+    auto triangles = make_random_triangles(1000);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    float cost_before = sah_cost(tree);
+
+    bvh_treelet_optimizer optimizer;
+    optimizer.optimize(tree);
+
+    EXPECT_LE(sah_cost(tree), cost_before);
+
+    check_bounds(tree);
+    check_primitives(tree, triangles.size());
+
+    // Too small to optimize
+    auto small = builder.build(bvh<triangle_t>{}, triangles.data(), 2);
+    optimizer.optimize(small);
+    check_bounds(small);
+}
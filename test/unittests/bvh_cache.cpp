@@ -0,0 +1,262 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ios>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/array_ref.h>
+#include <visionaray/bvh.h>
+
+#include <common/bvh_cache.h>
+
+#include <gtest/gtest.h>
+
+#include "bvh/random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+using index_bvh_view = index_bvh_t<array_ref<triangle_t>, array_ref<bvh_node>, array_ref<unsigned>>;
+using bvh_view = bvh_t<array_ref<triangle_t>, array_ref<bvh_node>>;
+
+// Cache directory that is removed when the test ends
+struct temp_directory
+{
+    temp_directory()
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    {
+    }
+
+    ~temp_directory()
+    {
+        boost::filesystem::remove_all(path);
+    }
+
+    // The only cache file in the directory
+    std::string cache_file() const
+    {
+        boost::filesystem::directory_iterator it(path);
+        return it->path().string();
+    }
+
+    boost::filesystem::path path;
+};
+
+// Overwrite a header field of a cache file without changing the file size
+static void patch_header(std::string const& filename, size_t offset, uint64_t value)
+{
+    std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test bvh_cache
+//
+
+TEST(BVHCache, RoundTrip)
+{
+    auto triangles = make_random_triangles(500, 10.0f);
+
+    binned_sah_builder builder;
+
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto plain = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    temp_directory dir;
+    bvh_cache cache(dir.path.string());
+
+    uint64_t key = bvh_cache::make_key(triangles.data(), triangles.size(), "index");
+    uint64_t plain_key = bvh_cache::make_key(triangles.data(), triangles.size(), "plain");
+    EXPECT_NE(key, plain_key);
+
+    ASSERT_TRUE(cache.store(key, tree));
+    ASSERT_TRUE(cache.store(plain_key, plain));
+
+    index_bvh_view view;
+    ASSERT_TRUE(cache.load(key, view));
+
+    ASSERT_EQ(view.num_primitives(), tree.num_primitives());
+    ASSERT_EQ(view.num_nodes(), tree.num_nodes());
+    ASSERT_EQ(view.num_indices(), tree.num_indices());
+
+    for (size_t i = 0; i < tree.num_indices(); ++i)
+    {
+        EXPECT_EQ(view.indices()[i], tree.indices()[i]);
+    }
+
+    for (size_t i = 0; i < tree.num_nodes(); ++i)
+    {
+        EXPECT_EQ(view.node(i).get_bounds().min, tree.node(i).get_bounds().min);
+        EXPECT_EQ(view.node(i).get_bounds().max, tree.node(i).get_bounds().max);
+    }
+
+    bvh_view plain_view;
+    ASSERT_TRUE(cache.load(plain_key, plain_view));
+
+    ASSERT_EQ(plain_view.num_primitives(), plain.num_primitives());
+    ASSERT_EQ(plain_view.num_nodes(), plain.num_nodes());
+
+    // The mapped BVHs are traversed like the original ones
+    for (int i = 0; i < 100; ++i)
+    {
+        vec3 dst(i % 10 + 0.5f, i / 10 + 0.5f, 5.0f);
+        vec3 ori(-5.0f, -5.0f, 20.0f);
+        basic_ray<float> r(ori, normalize(dst - ori));
+
+        auto hr1 = intersect(r, tree);
+        auto hr2 = intersect(r, view);
+        auto hr3 = intersect(r, plain_view);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+        ASSERT_EQ(hr1.hit, hr3.hit);
+
+        if (hr1.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_FLOAT_EQ(hr1.t, hr3.t);
+        }
+    }
+}
+
+TEST(BVHCache, KeyMismatch)
+{
+    auto triangles = make_random_triangles(100, 10.0f);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    temp_directory dir;
+    bvh_cache cache(dir.path.string());
+
+    uint64_t key = bvh_cache::make_key(triangles.data(), triangles.size(), "params");
+    ASSERT_TRUE(cache.store(key, tree));
+
+    // Different builder parameters and different primitives give different keys
+    uint64_t other_params = bvh_cache::make_key(triangles.data(), triangles.size(), "other");
+    uint64_t other_prims = bvh_cache::make_key(triangles.data(), triangles.size() - 1, "params");
+
+    EXPECT_NE(key, other_params);
+    EXPECT_NE(key, other_prims);
+
+    index_bvh_view view;
+    EXPECT_FALSE(cache.load(other_params, view));
+    EXPECT_FALSE(cache.load(other_prims, view));
+
+    // A file that is found under a key but stores another one is rejected
+    std::string fn = dir.cache_file();
+    patch_header(fn, offsetof(bvh_cache::header, key), other_params);
+    EXPECT_FALSE(cache.load(key, view));
+
+    // Element sizes must match the BVH type
+    patch_header(fn, offsetof(bvh_cache::header, key), key);
+    EXPECT_TRUE(cache.load(key, view));
+
+    bvh_t<array_ref<basic_triangle<3, double>>, array_ref<bvh_node>> wrong_type;
+    EXPECT_FALSE(cache.load(key, wrong_type));
+}
+
+TEST(BVHCache, Truncated)
+{
+    auto triangles = make_random_triangles(100, 10.0f);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    temp_directory dir;
+    uint64_t key = bvh_cache::make_key(triangles.data(), triangles.size(), "params");
+
+    {
+        bvh_cache cache(dir.path.string());
+        ASSERT_TRUE(cache.store(key, tree));
+    }
+
+    std::string fn = dir.cache_file();
+    auto size = boost::filesystem::file_size(fn);
+
+    // Truncated files are rejected, also if not even the header is left
+    for (auto new_size : { size - 1, size / 2, uintmax_t(16) })
+    {
+        boost::filesystem::resize_file(fn, new_size);
+
+        bvh_cache cache(dir.path.string());
+        index_bvh_view view;
+        EXPECT_FALSE(cache.load(key, view));
+    }
+}
+
+TEST(BVHCache, CorruptHeader)
+{
+    auto triangles = make_random_triangles(100, 10.0f);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    temp_directory dir;
+    uint64_t key = bvh_cache::make_key(triangles.data(), triangles.size(), "params");
+
+    {
+        bvh_cache cache(dir.path.string());
+        ASSERT_TRUE(cache.store(key, tree));
+    }
+
+    std::string fn = dir.cache_file();
+
+    bvh_cache::header hdr;
+
+    {
+        std::ifstream file(fn, std::ios::binary);
+        file.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+    }
+
+    // Offsets and counts that would make the views reach outside the file, the
+    // file size stays the same
+    struct field
+    {
+        size_t offset;
+        uint64_t original;
+        uint64_t corrupt;
+    };
+
+    field fields[] = {
+        { offsetof(bvh_cache::header, num_primitives),    hdr.num_primitives,    hdr.num_primitives * 4 },
+        { offsetof(bvh_cache::header, num_nodes),         hdr.num_nodes,         ~uint64_t(0) / 2 },
+        { offsetof(bvh_cache::header, num_indices),       hdr.num_indices,       hdr.num_indices + 1000 },
+        { offsetof(bvh_cache::header, primitives_offset), hdr.primitives_offset, hdr.file_size },
+        { offsetof(bvh_cache::header, nodes_offset),      hdr.nodes_offset,      hdr.nodes_offset + 64 },
+        { offsetof(bvh_cache::header, indices_offset),    hdr.indices_offset,    hdr.file_size - 4 }
+    };
+
+    for (auto const& f : fields)
+    {
+        patch_header(fn, f.offset, f.corrupt);
+
+        {
+            bvh_cache cache(dir.path.string());
+            index_bvh_view view;
+            EXPECT_FALSE(cache.load(key, view));
+        }
+
+        patch_header(fn, f.offset, f.original);
+
+        {
+            bvh_cache cache(dir.path.string());
+            index_bvh_view view;
+            EXPECT_TRUE(cache.load(key, view));
+        }
+    }
+}
@@ -6,15 +6,89 @@
 #include <algorithm>
 #include <array>
 #include <cstdlib>
+#include <thread>
 #include <vector>
 
 #include <visionaray/detail/parallel_algorithm.h>
+#include <visionaray/detail/thread_pool.h>
 
 #include <gtest/gtest.h>
 
 using namespace visionaray;
 
 
+//-------------------------------------------------------------------------------------------------
+// Test counting_sort() and radix_sort() w/ thread pool
+//
+
+TEST(ParallelAlgorithm, CountingSortPool)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    static const size_t N = 1000000;
+    static const size_t K = 256;
+
+    // Pairs of (key, original position) to test stability
+    std::vector<std::pair<int, int>> a(N);
+    std::vector<std::pair<int, int>> b(N);
+    std::vector<int> counts(K);
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        a[i] = { rand() % K, static_cast<int>(i) };
+    }
+
+    paralgo::counting_sort(
+            pool,
+            a.begin(),
+            a.end(),
+            b.begin(),
+            counts,
+            [](std::pair<int, int> const& val) { return val.first; }
+            );
+
+    std::stable_sort(
+            a.begin(),
+            a.end(),
+            [](std::pair<int, int> const& val1, std::pair<int, int> const& val2) { return val1.first < val2.first; }
+            );
+    EXPECT_TRUE(a == b);
+
+    // Start offsets
+    for (size_t m = 0; m < K; ++m)
+    {
+        auto it = std::find_if(b.begin(), b.end(), [&](std::pair<int, int> const& val) { return val.first == (int)m; });
+        EXPECT_EQ(counts[m], it - b.begin());
+    }
+}
+
+TEST(ParallelAlgorithm, RadixSortPool)
+{
+    thread_pool pool(std::thread::hardware_concurrency());
+
+    for (unsigned num_bits : { 8u, 24u, 30u, 32u })
+    {
+        static const size_t N = 100000;
+
+        std::vector<unsigned> a(N);
+        std::vector<unsigned> temp(N);
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            a[i] = (static_cast<unsigned>(rand()) * 7919u + static_cast<unsigned>(rand()))
+                 & (num_bits == 32 ? ~0u : (1u << num_bits) - 1);
+        }
+
+        std::vector<unsigned> b(a);
+
+        paralgo::radix_sort(pool, a.begin(), a.end(), temp.begin(), num_bits);
+
+        std::sort(b.begin(), b.end());
+        EXPECT_TRUE(a == b);
+    }
+}
+
+
 #if VSNRAY_HAVE_TBB
 
 //-------------------------------------------------------------------------------------------------
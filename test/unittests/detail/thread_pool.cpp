@@ -0,0 +1,167 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <visionaray/config.h>
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <visionaray/detail/parallel_for.h>
+#include <visionaray/detail/range.h>
+#include <visionaray/detail/thread_pool.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper: parallel fork/join fibonacci
+//
+
+static long fib(long n, thread_pool& pool)
+{
+    if (n < 2)
+    {
+        return n;
+    }
+
+    if (n < 12)
+    {
+        return fib(n - 1, pool) + fib(n - 2, pool);
+    }
+
+    long a = 0;
+    long b = 0;
+
+    task_group tg(pool);
+    tg.run([&]() { a = fib(n - 1, pool); });
+    b = fib(n - 2, pool);
+    tg.wait();
+
+    return a + b;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test thread_pool::run()
+//
+
+TEST(ThreadPool, Run)
+{
+    for (unsigned num_threads : { 0U, 1U, 4U, std::thread::hardware_concurrency() })
+    {
+        thread_pool pool(num_threads);
+
+        for (long n : { 0L, 1L, 7L, 1000L, 100000L })
+        {
+            std::vector<std::atomic<int>> visited(n);
+
+            for (auto& v : visited)
+            {
+                v = 0;
+            }
+
+            pool.run([&](long i) { ++visited[i]; }, n);
+
+            for (auto const& v : visited)
+            {
+                EXPECT_EQ(v.load(), 1);
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test nested parallel_for() calls
+//
+
+TEST(ThreadPool, Nested)
+{
+    thread_pool pool(4);
+
+    static const int N = 64;
+
+    std::vector<std::atomic<int>> visited(N * N);
+
+    for (auto& v : visited)
+    {
+        v = 0;
+    }
+
+    parallel_for(
+        pool,
+        tiled_range1d<int>(0, N, 1),
+        [&](range1d<int> const& r)
+        {
+            for (int i = r.begin(); i != r.end(); ++i)
+            {
+                parallel_for(
+                    pool,
+                    tiled_range1d<int>(0, N, 4),
+                    [&](range1d<int> const& r2)
+                    {
+                        for (int j = r2.begin(); j != r2.end(); ++j)
+                        {
+                            ++visited[i * N + j];
+                        }
+                    });
+            }
+        });
+
+    for (auto const& v : visited)
+    {
+        EXPECT_EQ(v.load(), 1);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test fork/join with task_group
+//
+
+TEST(ThreadPool, TaskGroup)
+{
+    thread_pool pool(4);
+
+    EXPECT_EQ(fib(25, pool), 75025);
+
+    // Many independent tasks
+    std::atomic<long> sum(0);
+
+    {
+        task_group tg(pool);
+
+        for (long i = 0; i < 10000; ++i)
+        {
+            tg.run([&sum, i]() { sum += i; });
+        }
+
+        tg.wait();
+    }
+
+    EXPECT_EQ(sum.load(), 10000L * 9999L / 2);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the pool can be reset and reused repeatedly
+//
+
+TEST(ThreadPool, Reset)
+{
+    thread_pool pool(2);
+
+    for (unsigned i = 0; i < 20; ++i)
+    {
+        pool.reset(i % 5);
+
+        std::atomic<long> count(0);
+        pool.run([&](long) { ++count; }, 1000);
+
+        EXPECT_EQ(count.load(), 1000L);
+    }
+}
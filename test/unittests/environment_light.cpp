@@ -0,0 +1,276 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <vector>
+
+#include <visionaray/math/simd/simd.h>
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/distribution_2d.h>
+#include <visionaray/environment_light.h>
+#include <visionaray/light_sampler.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/sampling.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+using env_light_type = environment_light<float, texture_ref<vec4, 2>>;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+// Lat-long map with a dim sky and a small, bright sun
+static texture<vec4, 2> make_env_map(int width, int height)
+{
+    std::vector<vec4> texels(width * height, vec4(0.1f, 0.2f, 0.3f, 1.0f));
+    texels[(height / 4) * width + width / 3] = vec4(1000.0f, 900.0f, 800.0f, 1.0f);
+
+    texture<vec4, 2> tex(width, height);
+    tex.reset(texels.data());
+    tex.set_address_mode(Clamp);
+    tex.set_filter_mode(Nearest);
+    return tex;
+}
+
+// Estimate the integral of pdf() over the sphere with uniformly distributed directions
+template <typename Light>
+static float integrate_pdf(Light const& light)
+{
+    static const int NumSamples = 200000;
+
+    random_generator<float> rng(0U);
+
+    double sum = 0.0;
+
+    for (int i = 0; i < NumSamples; ++i)
+    {
+        float u1 = rng.next();
+        float u2 = rng.next();
+        sum += light.pdf(uniform_sample_sphere(u1, u2));
+    }
+
+    return static_cast<float>(sum / NumSamples * 4.0 * constants::pi<double>());
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test distribution_2d
+//
+
+TEST(Distribution2D, Sample)
+{
+    static const int NumSamples = 100000;
+
+    // 4 x 2 function, with zero entries and a zero row
+    float func[] = {
+        1.0f, 0.0f, 3.0f, 4.0f,
+        0.0f, 0.0f, 0.0f, 0.0f
+        };
+
+    distribution_2d dist(func, 4, 2);
+    auto ref = dist.ref();
+
+    // Integral of the function over [0..1)^2 is 8 / 8
+    EXPECT_FLOAT_EQ(ref.pdf(vec2(0.1f, 0.1f)), 1.0f);
+    EXPECT_FLOAT_EQ(ref.pdf(vec2(0.3f, 0.4f)), 0.0f);
+    EXPECT_FLOAT_EQ(ref.pdf(vec2(0.9f, 0.2f)), 4.0f);
+    EXPECT_FLOAT_EQ(ref.pdf(vec2(0.9f, 0.7f)), 0.0f);
+
+    random_generator<float> rng(0U);
+
+    int counts[4] = { 0, 0, 0, 0 };
+
+    for (int i = 0; i < NumSamples; ++i)
+    {
+        float pdf = 0.0f;
+        auto uv = ref.sample(rng.next(), rng.next(), pdf);
+
+        ASSERT_GE(uv.x, 0.0f);
+        ASSERT_LT(uv.x, 1.0f);
+        ASSERT_GE(uv.y, 0.0f);
+        ASSERT_LT(uv.y, 0.5f);
+
+        EXPECT_FLOAT_EQ(pdf, ref.pdf(uv));
+        EXPECT_GT(pdf, 0.0f);
+
+        ++counts[static_cast<int>(uv.x * 4.0f)];
+    }
+
+    EXPECT_NEAR(counts[0] / static_cast<float>(NumSamples), 0.125f, 0.01f);
+    EXPECT_EQ(counts[1], 0);
+    EXPECT_NEAR(counts[2] / static_cast<float>(NumSamples), 0.375f, 0.01f);
+    EXPECT_NEAR(counts[3] / static_cast<float>(NumSamples), 0.5f, 0.01f);
+
+    // SIMD pdf
+    vector<2, simd::float4> uv4(
+            simd::float4(0.1f, 0.3f, 0.9f, 0.9f),
+            simd::float4(0.1f, 0.4f, 0.2f, 0.7f)
+            );
+
+    simd::aligned_array_t<simd::float4> pdfs;
+    simd::store(pdfs, ref.pdf(uv4));
+
+    EXPECT_FLOAT_EQ(pdfs[0], 1.0f);
+    EXPECT_FLOAT_EQ(pdfs[1], 0.0f);
+    EXPECT_FLOAT_EQ(pdfs[2], 4.0f);
+    EXPECT_FLOAT_EQ(pdfs[3], 0.0f);
+}
+
+TEST(Distribution2D, Zero)
+{
+    // Zero functions are sampled uniformly
+    float func[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    distribution_2d dist(func, 2, 2);
+    auto ref = dist.ref();
+
+    EXPECT_FLOAT_EQ(ref.pdf(vec2(0.2f, 0.7f)), 1.0f);
+
+    float pdf = 0.0f;
+    auto uv = ref.sample(0.6f, 0.3f, pdf);
+    EXPECT_FLOAT_EQ(pdf, 1.0f);
+    EXPECT_NEAR(uv.x, 0.3f, 1e-6f);
+    EXPECT_NEAR(uv.y, 0.6f, 1e-6f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test environment_light sampling
+//
+
+TEST(EnvironmentLight, Sample)
+{
+    auto tex = make_env_map(64, 32);
+
+    env_light_type light;
+    light.texture() = texture_ref<vec4, 2>(tex);
+    light.scale() = from_rgb(vec3(1.0f));
+    light.set_light_to_world_transform(mat4::rotation(normalize(vec3(1.0f, 2.0f, 3.0f)), 0.7f));
+
+    // Uniform sampling without distribution
+    EXPECT_NEAR(integrate_pdf(light), 1.0f, 1e-4f);
+
+    auto dist = make_environment_light_distribution(tex);
+    light.set_distribution(dist.ref());
+
+    EXPECT_NEAR(integrate_pdf(light), 1.0f, 0.02f);
+
+    random_generator<float> rng(0U);
+
+    int sun_samples = 0;
+    int mismatches = 0;
+    int num_samples = 10000;
+
+    for (int i = 0; i < num_samples; ++i)
+    {
+        auto ls = light.sample(rng);
+
+        vec3 dir = normalize(ls.pos);
+        EXPECT_NEAR(length(ls.pos), env_light_type::sample_distance(), 1.0f);
+        EXPECT_FLOAT_EQ(dot(ls.normal, -dir), 1.0f);
+        EXPECT_FALSE(ls.delta_light);
+
+        // area is chosen so that the solid angle density matches pdf(). Directions
+        // close to texel borders may round trip to the neighboring texel
+        float d = env_light_type::sample_distance();
+        float pdf = light.pdf(dir);
+
+        if (std::abs(d * d / ls.area - pdf) > pdf * 1e-3f)
+        {
+            ++mismatches;
+        }
+
+        vec3 intensity = light.intensity(dir);
+        EXPECT_FLOAT_EQ(ls.intensity.x, intensity.x);
+
+        if (intensity.x > 100.0f)
+        {
+            ++sun_samples;
+        }
+    }
+
+    EXPECT_LT(mismatches, num_samples / 100);
+
+    // The sun has most of the power
+    EXPECT_GT(sun_samples, num_samples / 2);
+
+    // SIMD pdf
+    vec3 dirs[] = {
+        normalize(vec3( 1.0f, 0.0f, 0.0f)),
+        normalize(vec3( 0.0f, 1.0f, 1.0f)),
+        normalize(vec3(-1.0f, 0.3f, 0.2f)),
+        normalize(vec3( 0.2f,-1.0f, 0.1f))
+        };
+
+    vector<3, simd::float4> dir4(
+            simd::float4(dirs[0].x, dirs[1].x, dirs[2].x, dirs[3].x),
+            simd::float4(dirs[0].y, dirs[1].y, dirs[2].y, dirs[3].y),
+            simd::float4(dirs[0].z, dirs[1].z, dirs[2].z, dirs[3].z)
+            );
+
+    simd::aligned_array_t<simd::float4> pdfs;
+    simd::store(pdfs, light.pdf(dir4));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_NEAR(pdfs[i], light.pdf(dirs[i]), light.pdf(dirs[i]) * 1e-3f);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that samples are placed relative to the shading point, not to the origin
+//
+
+TEST(EnvironmentLight, SampleFromShadingPoint)
+{
+    auto tex = make_env_map(64, 32);
+    auto dist = make_environment_light_distribution(tex);
+
+    env_light_type light;
+    light.texture() = texture_ref<vec4, 2>(tex);
+    light.scale() = from_rgb(vec3(1.0f));
+    light.set_light_to_world_transform(mat4::identity());
+    light.set_distribution(dist.ref());
+
+    // Far from the origin, compared to sample_distance()
+    vec3 pos(3.0e5f, -2.0e5f, 1.0e5f);
+    vec3 n(0.0f, 1.0f, 0.0f);
+
+    random_generator<float> rng(0U);
+
+    int mismatches = 0;
+    int num_samples = 1000;
+
+    for (int i = 0; i < num_samples; ++i)
+    {
+        float select_pdf = 0.0f;
+        auto ls = sample_light(&light, &light + 1, uniform_light_sampler{}, pos, n, select_pdf, rng);
+
+        EXPECT_FLOAT_EQ(select_pdf, 1.0f);
+
+        vec3 L = ls.pos - pos;
+        float ld = length(L);
+        L /= ld;
+
+        // Direction seen from pos is the sampled direction
+        EXPECT_NEAR(ld, env_light_type::sample_distance(), 1.0f);
+        EXPECT_NEAR(dot(ls.normal, -L), 1.0f, 1e-5f);
+        EXPECT_FLOAT_EQ(ls.intensity.x, light.intensity(L).x);
+
+        // Solid angle density seen from pos matches pdf()
+        float pdf = light.pdf(L);
+
+        if (std::abs(ld * ld / (ls.area * dot(ls.normal, -L)) - pdf) > pdf * 1e-3f)
+        {
+            ++mismatches;
+        }
+    }
+
+    EXPECT_LT(mismatches, num_samples / 100);
+}
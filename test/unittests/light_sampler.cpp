@@ -0,0 +1,215 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/simd/simd.h>
+#include <visionaray/math/math.h>
+#include <visionaray/area_light.h>
+#include <visionaray/get_normal.h>
+#include <visionaray/light_sampler.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/sampling.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+using triangle_type = basic_triangle<3, float>;
+using light_type    = area_light<float, triangle_type>;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+static light_type make_light(vec3 v1, vec3 e1, vec3 e2, float kl, unsigned prim_id)
+{
+    triangle_type t(v1, e1, e2);
+    t.prim_id = prim_id;
+    t.geom_id = 0;
+
+    light_type l(t);
+    l.set_cl(vec3(1.0f));
+    l.set_kl(kl);
+    return l;
+}
+
+// Lights scattered in the unit cube, with varying power and orientation
+static std::vector<light_type> make_random_lights(int num_lights)
+{
+    random_generator<float> rng(4711U);
+
+    std::vector<light_type> lights;
+
+    for (int i = 0; i < num_lights; ++i)
+    {
+        vec3 v1(rng.next(), rng.next(), rng.next());
+        vec3 e1 = vec3(rng.next(), rng.next(), rng.next()) * 0.1f;
+        vec3 e2 = vec3(rng.next(), rng.next(), rng.next()) * 0.1f;
+
+        // Prim ids are not contiguous, not all primitives are lights
+        lights.push_back(make_light(v1, e1, e2, 1.0f + 10.0f * rng.next(), 2 * i + 1));
+    }
+
+    return lights;
+}
+
+// Check that the selection frequencies and pdfs of a light sampler are consistent
+template <typename Sampler>
+static void test_selection(
+        Sampler const&                  sampler,
+        std::vector<light_type> const&  lights,
+        vec3 const&                     pos,
+        vec3 const&                     n
+        )
+{
+    static const int NumSamples = 200000;
+
+    int num_lights = static_cast<int>(lights.size());
+
+    // pdf() sums to one over all lights
+    float sum = 0.0f;
+
+    for (auto const& l : lights)
+    {
+        sum += sampler.pdf(num_lights, l.geometry().prim_id, pos, n);
+    }
+
+    EXPECT_NEAR(sum, 1.0f, 1e-4f);
+
+    // select() reports the pdf of the selected light
+    random_generator<float> rng(0U);
+
+    std::vector<int> counts(lights.size(), 0);
+
+    for (int i = 0; i < NumSamples; ++i)
+    {
+        float pdf = 0.0f;
+        int light_id = sampler.select(num_lights, pos, n, rng.next(), pdf);
+
+        ASSERT_GE(light_id, 0);
+        ASSERT_LT(light_id, num_lights);
+
+        float expected = sampler.pdf(num_lights, lights[light_id].geometry().prim_id, pos, n);
+        EXPECT_NEAR(pdf, expected, 1e-5f);
+        EXPECT_GT(pdf, 0.0f);
+
+        ++counts[light_id];
+    }
+
+    // Frequencies match the pdfs
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        float expected = sampler.pdf(num_lights, lights[i].geometry().prim_id, pos, n);
+        float freq = static_cast<float>(counts[i]) / NumSamples;
+        EXPECT_NEAR(freq, expected, 0.01f);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test light samplers
+//
+
+TEST(LightSampler, Uniform)
+{
+    auto lights = make_random_lights(16);
+
+    uniform_light_sampler sampler;
+
+    test_selection(sampler, lights, vec3(0.5f), vec3(0.0f, 1.0f, 0.0f));
+
+    float pdf = 0.0f;
+    EXPECT_EQ(sampler.select(16, vec3(0.0f), vec3(0.0f), 0.99999994f, pdf), 15);
+    EXPECT_FLOAT_EQ(pdf, 1.0f / 16.0f);
+}
+
+TEST(LightSampler, Power)
+{
+    // Four lights with power 1:2:3:4
+    std::vector<light_type> lights;
+    lights.push_back(make_light(vec3(0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), 1.0f, 3));
+    lights.push_back(make_light(vec3(0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), 2.0f, 0));
+    lights.push_back(make_light(vec3(0.0f), vec3(2.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), 1.5f, 7));
+    lights.push_back(make_light(vec3(0.0f), vec3(2.0f, 0.0f, 0.0f), vec3(0.0f, 2.0f, 0.0f), 1.0f, 5));
+
+    power_light_sampler sampler(lights.begin(), lights.end());
+    auto ref = sampler.ref();
+
+    vec3 pos(0.0f);
+    vec3 n(0.0f);
+
+    EXPECT_NEAR(ref.pdf(4, 3, pos, n), 0.1f, 1e-6f);
+    EXPECT_NEAR(ref.pdf(4, 0, pos, n), 0.2f, 1e-6f);
+    EXPECT_NEAR(ref.pdf(4, 7, pos, n), 0.3f, 1e-6f);
+    EXPECT_NEAR(ref.pdf(4, 5, pos, n), 0.4f, 1e-6f);
+
+    // Primitives that are not lights
+    EXPECT_EQ(ref.pdf(4, 1, pos, n), 0.0f);
+    EXPECT_EQ(ref.pdf(4, 8, pos, n), 0.0f);
+    EXPECT_EQ(ref.pdf(4, -1, pos, n), 0.0f);
+
+    test_selection(ref, lights, pos, n);
+
+    lights = make_random_lights(100);
+    sampler.reset(lights.begin(), lights.end());
+    test_selection(sampler.ref(), lights, pos, n);
+}
+
+TEST(LightSampler, LightBVH)
+{
+    auto lights = make_random_lights(100);
+
+    light_bvh bvh(lights.begin(), lights.end());
+    EXPECT_EQ(bvh.nodes().size(), 2 * lights.size() - 1);
+
+    auto ref = bvh.ref();
+
+    // Shading points inside and outside the light bounds, with and without normal
+    test_selection(ref, lights, vec3(0.5f), vec3(0.0f, 1.0f, 0.0f));
+    test_selection(ref, lights, vec3(0.1f, 0.9f, 0.2f), vec3(0.0f));
+    test_selection(ref, lights, vec3(3.0f, 0.5f, -2.0f), normalize(vec3(-1.0f, 0.0f, 1.0f)));
+
+    // Lights behind the shading point are not selected
+    std::vector<light_type> two_lights;
+    two_lights.push_back(make_light(vec3(0.0f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), 1.0f, 0));
+    two_lights.push_back(make_light(vec3(0.0f,-1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), 1.0f, 1));
+
+    light_bvh bvh2(two_lights.begin(), two_lights.end());
+
+    vec3 pos(0.25f, 0.0f, 0.25f);
+    vec3 n(0.0f, 1.0f, 0.0f);
+    EXPECT_FLOAT_EQ(bvh2.ref().pdf(2, 0, pos, n), 1.0f);
+    EXPECT_FLOAT_EQ(bvh2.ref().pdf(2, 1, pos, n), 0.0f);
+}
+
+TEST(LightSampler, SampleLight)
+{
+    auto lights = make_random_lights(32);
+
+    power_light_sampler sampler(lights.begin(), lights.end());
+    auto ref = sampler.ref();
+
+    // Scalar
+    random_generator<float> rng(0U);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        float select_pdf = 0.0f;
+        auto ls = sample_light(lights.data(), lights.data() + lights.size(), ref, vec3(0.5f), vec3(0.0f), select_pdf, rng);
+        EXPECT_GT(select_pdf, 0.0f);
+        EXPECT_GT(ls.area, 0.0f);
+    }
+
+    // SIMD
+    simd::int4 prim_ids(1, 3, 4, 63);
+    simd::aligned_array_t<simd::float4> pdfs;
+    simd::store(pdfs, light_select_pdf(ref, 32, prim_ids, vector<3, simd::float4>(0.0f), vector<3, simd::float4>(0.0f)));
+
+    EXPECT_FLOAT_EQ(pdfs[0], ref.pdf(32, 1, vec3(0.0f), vec3(0.0f)));
+    EXPECT_FLOAT_EQ(pdfs[1], ref.pdf(32, 3, vec3(0.0f), vec3(0.0f)));
+    EXPECT_FLOAT_EQ(pdfs[2], 0.0f);
+    EXPECT_FLOAT_EQ(pdfs[3], ref.pdf(32, 63, vec3(0.0f), vec3(0.0f)));
+}
@@ -0,0 +1,308 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstdlib>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/get_color.h>
+#include <visionaray/get_normal.h>
+#include <visionaray/get_shading_normal.h>
+#include <visionaray/get_surface.h>
+#include <visionaray/get_tex_coord.h>
+#include <visionaray/intersector.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/point_light.h>
+
+#include <gtest/gtest.h>
+
+#include "../bvh/random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+using indexed_triangle_t = basic_indexed_triangle<float>;
+
+// Random mesh with shared vertices, and the same mesh made up of standalone triangles
+struct mesh
+{
+    aligned_vector<vec3> vertices;
+    aligned_vector<indexed_triangle_t> indexed_triangles;
+    aligned_vector<triangle_t> triangles;
+};
+
+static mesh make_random_mesh(size_t num_vertices, size_t num_triangles)
+{
+    srand(0);
+
+    mesh result;
+
+    for (size_t i = 0; i < num_vertices; ++i)
+    {
+        result.vertices.push_back(rnd_vec3(100.0f));
+    }
+
+    for (size_t i = 0; i < num_triangles; ++i)
+    {
+        unsigned i1 = rand() % num_vertices;
+        unsigned i2 = rand() % num_vertices;
+        unsigned i3 = rand() % num_vertices;
+
+        indexed_triangle_t it(i1, i2, i3);
+        it.prim_id = static_cast<unsigned>(i);
+        it.geom_id = 0;
+        result.indexed_triangles.push_back(it);
+
+        vec3 v1 = result.vertices[i1];
+        vec3 v2 = result.vertices[i2];
+        vec3 v3 = result.vertices[i3];
+
+        triangle_t t(v1, v2 - v1, v3 - v1);
+        t.prim_id = static_cast<unsigned>(i);
+        t.geom_id = 0;
+        result.triangles.push_back(t);
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test geometric functions
+//
+
+TEST(IndexedTriangle, Geometry)
+{
+    vec3 vertices[] = {
+        { 0.0f, 0.0f, 0.0f },
+        { 9.0f, 9.0f, 9.0f }, // unreferenced
+        { 2.0f, 0.0f, 2.0f },
+        { 1.0f, 2.0f, 1.0f }
+        };
+
+    indexed_triangle_t tri(0, 2, 3);
+
+    EXPECT_FLOAT_EQ(area(tri, vertices), 2.8284271f);
+
+    aabb bounds = get_bounds(tri, vertices);
+    EXPECT_FLOAT_EQ(bounds.min.x, 0.0f);
+    EXPECT_FLOAT_EQ(bounds.min.y, 0.0f);
+    EXPECT_FLOAT_EQ(bounds.min.z, 0.0f);
+    EXPECT_FLOAT_EQ(bounds.max.x, 2.0f);
+    EXPECT_FLOAT_EQ(bounds.max.y, 2.0f);
+    EXPECT_FLOAT_EQ(bounds.max.z, 2.0f);
+
+    auto verts = compute_vertices(tri, vertices);
+    EXPECT_TRUE(verts[0] == vertices[0]);
+    EXPECT_TRUE(verts[1] == vertices[2]);
+    EXPECT_TRUE(verts[2] == vertices[3]);
+
+    // Only the three 32-bit indices and the ids are stored
+    EXPECT_EQ(sizeof(indexed_triangle_t), 5 * sizeof(unsigned));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Intersections are the same as with standalone triangles
+//
+
+TEST(IndexedTriangle, Intersect)
+{
+    auto m = make_random_mesh(100, 1000);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto r = make_random_ray();
+
+        size_t index = rand() % m.triangles.size();
+
+        auto hr1 = intersect(r, m.triangles[index]);
+        auto hr2 = intersect(r, m.indexed_triangles[index], m.vertices.data());
+
+        EXPECT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit && hr2.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_FLOAT_EQ(hr1.u, hr2.u);
+            EXPECT_FLOAT_EQ(hr1.v, hr2.v);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// BVHs over indexed triangles, with and without spatial splits
+//
+// The builders need the vertex positions, the BVH is built over the standalone triangles
+// and then refers to the indexed triangles in the same order
+//
+
+TEST(IndexedTriangle, BVH)
+{
+    auto m = make_random_mesh(1000, 5000);
+
+    binned_sah_builder builder;
+
+    auto reference = builder.build(
+            index_bvh<triangle_t>{},
+            m.triangles.data(),
+            m.triangles.size()
+            );
+
+    indexed_triangle_intersector<float> isect(m.vertices.data());
+
+    for (bool spatial_splits : { false, true })
+    {
+        builder.enable_spatial_splits(spatial_splits);
+
+        auto triangle_tree = builder.build(
+                index_bvh<triangle_t>{},
+                m.triangles.data(),
+                m.triangles.size()
+                );
+
+        index_bvh<indexed_triangle_t> tree;
+        tree.primitives() = m.indexed_triangles;
+        tree.nodes()      = triangle_tree.nodes();
+        tree.indices()    = triangle_tree.indices();
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto r = make_random_ray();
+
+            auto hr1 = intersect(r, reference);
+            auto hr2 = intersect(r, tree, isect);
+
+            EXPECT_EQ(hr1.hit, hr2.hit);
+
+            if (hr1.hit && hr2.hit)
+            {
+                EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+                EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Per-vertex attributes are looked up through the vertex indices
+//
+
+TEST(IndexedTriangle, Attributes)
+{
+    vec3 vertices[] = {
+        { 0.0f, 0.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f },
+        { 1.0f, 1.0f, 0.0f }
+        };
+
+    vec3 normals[] = {
+        { 0.0f, 0.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f }
+        };
+
+    vec2 tex_coords[] = {
+        { 0.0f, 0.0f },
+        { 1.0f, 0.0f },
+        { 0.0f, 1.0f },
+        { 1.0f, 1.0f }
+        };
+
+    vec3 colors[] = {
+        { 0.0f, 0.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f }
+        };
+
+    // Geometric normals are stored per face
+    vec3 face_normals[] = {
+        { 0.0f, 0.0f, 1.0f },
+        { 0.0f, 0.0f, 1.0f }
+        };
+
+    indexed_triangle_t tri(1, 3, 2);
+    tri.prim_id = 0;
+    tri.geom_id = 0;
+
+    basic_ray<float> r(vec3(0.75f, 0.5f, 1.0f), vec3(0.0f, 0.0f, -1.0f));
+
+    auto hr = intersect(r, tri, vertices);
+    ASSERT_TRUE(hr.hit);
+
+    float w = 1.0f - hr.u - hr.v;
+
+    vec3 n = get_normal(face_normals, hr, tri);
+    EXPECT_FLOAT_EQ(n.z, 1.0f);
+
+    vec3 expected_sn = normalize(normals[1] * w + normals[3] * hr.u + normals[2] * hr.v);
+    vec3 sn = get_shading_normal(normals, hr, tri, normals_per_vertex_binding{});
+    EXPECT_FLOAT_EQ(sn.x, expected_sn.x);
+    EXPECT_FLOAT_EQ(sn.y, expected_sn.y);
+    EXPECT_FLOAT_EQ(sn.z, expected_sn.z);
+
+    vec2 tc = get_tex_coord(tex_coords, hr, tri);
+    EXPECT_FLOAT_EQ(tc.x, 0.75f);
+    EXPECT_FLOAT_EQ(tc.y, 0.5f);
+
+    vec3 c = get_color(colors, hr, tri, colors_per_vertex_binding{});
+    EXPECT_FLOAT_EQ(c.x, w);
+    EXPECT_FLOAT_EQ(c.y, hr.v);
+    EXPECT_FLOAT_EQ(c.z, hr.u);
+
+    // Vertices w/o shading normals store the zero vector, get_surface() then falls back
+    // to the geometric normal
+    indexed_triangle_t triangles[] = { tri, indexed_triangle_t(0, 1, 2) };
+    triangles[1].prim_id = 1;
+    triangles[1].geom_id = 0;
+
+    vec3 shading_normals[] = {
+        { 0.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f }
+        };
+
+    basic_ray<float> r2(vec3(0.25f, 0.25f, 1.0f), vec3(0.0f, 0.0f, -1.0f));
+
+    auto hr2 = intersect(r2, triangles[1], vertices);
+    ASSERT_TRUE(hr2.hit);
+
+    vec3 sn2 = get_shading_normal(shading_normals, hr2, triangles[1], normals_per_vertex_binding{});
+    EXPECT_FLOAT_EQ(length(sn2), 0.0f);
+
+    plastic<float> materials[1];
+    point_light<float> lights[1];
+
+    auto kparams = make_kernel_params(
+            normals_per_vertex_binding{},
+            &triangles[0],
+            &triangles[0] + 2,
+            &face_normals[0],
+            &shading_normals[0],
+            &materials[0],
+            &lights[0],
+            &lights[0] + 1
+            );
+
+    auto surf2 = get_surface(hr2, kparams);
+    EXPECT_FLOAT_EQ(surf2.geometric_normal.z, 1.0f);
+    EXPECT_FLOAT_EQ(surf2.shading_normal.z, 1.0f);
+
+    // Shading normals that are present are interpolated
+    auto surf = get_surface(hr, kparams);
+    EXPECT_FLOAT_EQ(surf.shading_normal.z, 1.0f);
+}
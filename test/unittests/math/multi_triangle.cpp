@@ -0,0 +1,240 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/get_normal.h>
+
+#include <gtest/gtest.h>
+
+#include "../bvh/random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+// Closest hit with basic_triangle
+template <typename R>
+static hit_record<R, primitive<unsigned>> intersect_reference(R const& r, triangle_t const* triangles, size_t count)
+{
+    hit_record<R, primitive<unsigned>> result;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto hr = intersect(r, triangles[i]);
+
+        if (hr.hit && hr.t >= r.tmin && hr.t <= r.tmax && hr.t < result.t)
+        {
+            result = hr;
+        }
+    }
+
+    return result;
+}
+
+template <size_t N>
+static void test_intersect()
+{
+    auto triangles = make_random_triangles(N * 50, 100.0f, 10.0f, 3);
+
+    for (size_t count = 1; count <= N; ++count)
+    {
+        for (size_t first = 0; first + count <= triangles.size(); first += N)
+        {
+            basic_multi_triangle<N, float> multi(triangles.data() + first, count);
+
+            for (int i = 0; i < 20; ++i)
+            {
+                auto r = make_random_ray();
+
+                if (i % 2)
+                {
+                    // Restrict the ray interval
+                    r.tmin = 80.0f;
+                    r.tmax = 120.0f;
+                }
+
+                auto hr1 = intersect_reference(r, triangles.data() + first, count);
+                auto hr2 = intersect(r, multi);
+
+                ASSERT_EQ(hr1.hit, hr2.hit);
+
+                if (hr1.hit && hr2.hit)
+                {
+                    EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+                    EXPECT_FLOAT_EQ(hr1.u, hr2.u);
+                    EXPECT_FLOAT_EQ(hr1.v, hr2.v);
+                    EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+                    EXPECT_EQ(hr1.geom_id, hr2.geom_id);
+                }
+            }
+        }
+    }
+}
+
+template <size_t N, typename Builder>
+static void test_bvh(Builder builder)
+{
+    auto triangles = make_random_triangles(5000, 100.0f, 10.0f, 3);
+
+    auto reference = builder.build(
+            bvh<triangle_t>{},
+            triangles.data(),
+            triangles.size()
+            );
+
+    auto tree = builder.build(
+            bvh<basic_multi_triangle<N, float>>{},
+            triangles.data(),
+            triangles.size()
+            );
+
+    auto index_tree = builder.build(
+            index_bvh<basic_multi_triangle<N, float>>{},
+            triangles.data(),
+            triangles.size()
+            );
+
+    // Each triangle was packed into a multi triangle, leaves with up to N triangles
+    // are intersected in a single test
+    std::vector<bool> packed(triangles.size(), false);
+
+    for (auto const& multi : tree.primitives())
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            packed[multi.prim_id[i]] = true;
+        }
+    }
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        EXPECT_TRUE(packed[i]);
+    }
+
+    traverse_leaves(tree, [&](bvh_node const& n)
+    {
+        EXPECT_EQ(n.get_num_primitives(), 1U);
+    });
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto r = make_random_ray();
+
+        auto hr1 = intersect(r, reference);
+        auto hr2 = intersect(r, tree);
+        auto hr3 = intersect(r, index_tree);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+        ASSERT_EQ(hr1.hit, hr3.hit);
+
+        if (hr1.hit && hr2.hit && hr3.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_FLOAT_EQ(hr1.t, hr3.t);
+
+            // The geometric normal is looked up by prim_id
+            auto n1 = get_normal(hr1, triangles[hr1.prim_id]);
+            auto n2 = get_normal(hr2, tree.primitive(hr2.primitive_list_index));
+            EXPECT_FLOAT_EQ(n1.x, n2.x);
+            EXPECT_FLOAT_EQ(n1.y, n2.y);
+            EXPECT_FLOAT_EQ(n1.z, n2.z);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test geometric functions
+//
+
+TEST(MultiTriangle, Geometry)
+{
+    auto triangles = make_random_triangles(3, 100.0f, 10.0f, 3);
+
+    triangle4 multi(triangles.data(), triangles.size());
+
+    // Unused lanes repeat the last triangle
+    for (size_t i = 0; i < 4; ++i)
+    {
+        auto t = get_triangle(multi, i);
+        auto const& ref = triangles[i < 3 ? i : 2];
+
+        EXPECT_TRUE(t.v1 == ref.v1);
+        EXPECT_TRUE(t.e1 == ref.e1);
+        EXPECT_TRUE(t.e2 == ref.e2);
+        EXPECT_EQ(t.prim_id, ref.prim_id);
+        EXPECT_EQ(t.geom_id, ref.geom_id);
+    }
+
+    aabb bounds;
+    bounds.invalidate();
+
+    for (auto const& t : triangles)
+    {
+        bounds.insert(get_bounds(t));
+    }
+
+    aabb multi_bounds = get_bounds(multi);
+    EXPECT_TRUE(multi_bounds.min == bounds.min);
+    EXPECT_TRUE(multi_bounds.max == bounds.max);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Intersections are the same as the closest hit with the individual triangles
+//
+
+TEST(MultiTriangle, Intersect)
+{
+    test_intersect<4>();
+    test_intersect<8>();
+}
+
+TEST(MultiTriangle, IntersectSIMD)
+{
+    auto triangles = make_random_triangles(4, 100.0f, 10.0f, 3);
+
+    triangle4 multi(triangles.data(), triangles.size());
+
+    for (int i = 0; i < 100; ++i)
+    {
+        auto r = make_random_ray();
+
+        basic_ray<simd::float4> r4(vector<3, simd::float4>(r.ori), vector<3, simd::float4>(r.dir));
+
+        auto hr1 = intersect_reference(r, triangles.data(), triangles.size());
+        auto hr2 = intersect(r4, multi);
+
+        simd::aligned_array_t<simd::float4> t;
+        store(t, hr2.t);
+
+        EXPECT_EQ(hr1.hit, any(hr2.hit));
+
+        if (hr1.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, t[0]);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Builders emit multi triangle leaves
+//
+
+TEST(MultiTriangle, BVH)
+{
+    test_bvh<4>(binned_sah_builder{});
+    test_bvh<8>(binned_sah_builder{});
+    test_bvh<4>(lbvh_builder{});
+    test_bvh<8>(ploc_builder{});
+}
@@ -2,6 +2,8 @@
 // See the LICENSE file for details.
 
 #include <cfloat>
+#include <cmath>
+#include <cstdlib>
 
 #include <visionaray/math/math.h>
 
@@ -9,6 +11,106 @@
 
 using namespace visionaray;
 
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+// Error of a float result in ulp, relative to a double precision reference
+static double ulp_error(float value, double ref)
+{
+    float ref_float = static_cast<float>(ref);
+    double ulp = std::nextafter(std::abs(ref_float), FLT_MAX) - std::abs(ref_float);
+    return std::abs(value - ref) / ulp;
+}
+
+// Test SIMD function against libm with random arguments in [lo..hi)
+template <typename F, typename SimdFunc, typename RefFunc>
+static void test_accuracy(SimdFunc simd_func, RefFunc ref_func, float lo, float hi, double max_ulp)
+{
+    using float_array = simd::aligned_array_t<F>;
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        float_array x;
+        float_array result;
+
+        for (unsigned j = 0; j < simd::num_elements<F>::value; ++j)
+        {
+            x[j] = lo + (hi - lo) * (static_cast<float>(rand()) / RAND_MAX);
+        }
+
+        store(result, simd_func(F(x)));
+
+        for (unsigned j = 0; j < simd::num_elements<F>::value; ++j)
+        {
+            EXPECT_LE(ulp_error(result[j], ref_func(static_cast<double>(x[j]))), max_ulp) << "x: " << x[j];
+        }
+    }
+}
+
+template <typename F>
+static void test_trig_accuracy()
+{
+    // Bounds for the default (not VSNRAY_SIMD_FAST_TRANS) implementation
+
+    test_accuracy<F>(
+            [](F const& x) { return sin(x); },
+            [](double x) { return std::sin(x); },
+            -8192.0f,
+            8192.0f,
+            3.0
+            );
+
+    test_accuracy<F>(
+            [](F const& x) { return cos(x); },
+            [](double x) { return std::cos(x); },
+            -8192.0f,
+            8192.0f,
+            3.0
+            );
+
+    test_accuracy<F>(
+            [](F const& x) { return tan(x); },
+            [](double x) { return std::tan(x); },
+            -8192.0f,
+            8192.0f,
+            4.0
+            );
+
+    test_accuracy<F>(
+            [](F const& x) { return asin(x); },
+            [](double x) { return std::asin(x); },
+            -1.0f,
+            1.0f,
+            3.0
+            );
+
+    test_accuracy<F>(
+            [](F const& x) { return acos(x); },
+            [](double x) { return std::acos(x); },
+            -1.0f,
+            1.0f,
+            2.0
+            );
+
+    test_accuracy<F>(
+            [](F const& x) { return atan(x); },
+            [](double x) { return std::atan(x); },
+            -100.0f,
+            100.0f,
+            2.0
+            );
+
+    test_accuracy<F>(
+            [](F const& x) { return atan2(F(-0.3f), x); },
+            [](double x) { return std::atan2(static_cast<double>(-0.3f), x); },
+            -10.0f,
+            10.0f,
+            4.0
+            );
+}
+
 TEST(SIMD, Trans)
 {
     // TODO: valid range for aXXX functions
@@ -248,3 +350,32 @@ TEST(SIMD, Trans)
 //  EXPECT_FLOAT_EQ( simd::get<14>(atan16), atanf(arr[14]) );
 //  EXPECT_FLOAT_EQ( simd::get<15>(atan16), atanf(arr[15]) );
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Test accuracy of the SIMD trigonometric functions
+//
+
+TEST(SIMD, TransAccuracy)
+{
+    test_trig_accuracy<simd::float4>();
+    test_trig_accuracy<simd::float8>();
+    test_trig_accuracy<simd::float16>();
+
+
+    // Special cases
+
+    VSNRAY_ALIGN(16) float y[] = { 0.0f, -0.0f,  0.0f, -0.0f };
+    VSNRAY_ALIGN(16) float x[] = { 0.0f,  0.0f, -0.0f, -0.0f };
+
+    simd::float4 a = atan2(simd::float4(y), simd::float4(x));
+
+    EXPECT_FLOAT_EQ( simd::get<0>(a), atan2f(y[0], x[0]) );
+    EXPECT_FLOAT_EQ( simd::get<1>(a), atan2f(y[1], x[1]) );
+    EXPECT_FLOAT_EQ( simd::get<2>(a), atan2f(y[2], x[2]) );
+    EXPECT_FLOAT_EQ( simd::get<3>(a), atan2f(y[3], x[3]) );
+
+    EXPECT_TRUE( std::isnan(simd::get<0>(asin(simd::float4(2.0f)))) );
+    EXPECT_TRUE( std::isnan(simd::get<0>(acos(simd::float4(-2.0f)))) );
+    EXPECT_TRUE( std::isnan(simd::get<0>(sin(simd::float4(INFINITY)))) );
+}
@@ -0,0 +1,349 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <type_traits>
+#include <vector>
+
+#include <visionaray/math/simd/simd.h>
+#include <visionaray/array.h>
+#include <visionaray/blue_noise_generator.h>
+#include <visionaray/halton_generator.h>
+#include <visionaray/make_generator.h>
+#include <visionaray/pcg_generator.h>
+#include <visionaray/pixel_sampler_types.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/sobol_generator.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+// Check that SIMD lanes match scalar generators and that values are in [0..1)
+template <typename F>
+static void test_pcg_lanes()
+{
+    using float_array = simd::aligned_array_t<F>;
+
+    static const int Size = simd::num_elements<F>::value;
+
+    visionaray::array<unsigned, Size> seed;
+
+    for (int i = 0; i < Size; ++i)
+    {
+        seed[i] = i * 4711;
+    }
+
+    pcg_generator<F> gen(seed);
+
+    visionaray::array<pcg_generator<float>, Size> ref;
+
+    for (int i = 0; i < Size; ++i)
+    {
+        ref[i] = pcg_generator<float>(seed[i]);
+    }
+
+    double sum = 0.0;
+    static const int N = 10000;
+
+    for (int n = 0; n < N; ++n)
+    {
+        float_array values;
+        store(values, gen.next());
+
+        for (int i = 0; i < Size; ++i)
+        {
+            EXPECT_EQ(values[i], ref[i].next());
+            EXPECT_GE(values[i], 0.0f);
+            EXPECT_LT(values[i], 1.0f);
+
+            sum += values[i];
+        }
+
+        // Stepping a single lane with the scalar generator must
+        // not desynchronize the lane from its reference
+        if (n % 7 == 0)
+        {
+            EXPECT_EQ(gen.get_generator(n % Size).next(), ref[n % Size].next());
+        }
+    }
+
+    EXPECT_NEAR(sum / (N * Size), 0.5, 0.01);
+}
+
+// Check that the first N samples of two successive dimensions are stratified
+// in a grid of Rows x (N / Rows) cells, i.e. each cell contains one sample
+template <typename Generator>
+static void test_stratified_2d(Generator gen, unsigned dim, unsigned N, unsigned rows)
+{
+    unsigned cols = N / rows;
+
+    std::vector<int> cells(N, 0);
+
+    for (unsigned i = 0; i < N; ++i)
+    {
+        gen.begin_sample(i);
+
+        for (unsigned d = 0; d < dim; ++d)
+        {
+            gen.next();
+        }
+
+        float u = gen.next();
+        float v = gen.next();
+
+        ASSERT_GE(u, 0.0f);
+        ASSERT_LT(u, 1.0f);
+        ASSERT_GE(v, 0.0f);
+        ASSERT_LT(v, 1.0f);
+
+        ++cells[static_cast<unsigned>(v * rows) * cols + static_cast<unsigned>(u * cols)];
+    }
+
+    for (unsigned i = 0; i < N; ++i)
+    {
+        EXPECT_EQ(cells[i], 1);
+    }
+}
+
+// Check that SIMD lanes match scalar generators
+template <template <typename...> class Generator, typename F>
+static void test_low_discrepancy_lanes()
+{
+    using float_array = simd::aligned_array_t<F>;
+    using I = simd::int_type_t<F>;
+    using int_array = simd::aligned_array_t<I>;
+
+    static const int Size = simd::num_elements<F>::value;
+
+    visionaray::array<unsigned, Size> seed;
+    int_array x;
+    int_array y;
+
+    for (int i = 0; i < Size; ++i)
+    {
+        seed[i] = i * 4711;
+        x[i] = i;
+        y[i] = 3 * i + 1;
+    }
+
+    Generator<F> gen(seed, I(x), I(y), 16);
+
+    visionaray::array<Generator<float>, Size> ref;
+
+    for (int i = 0; i < Size; ++i)
+    {
+        ref[i] = Generator<float>(seed[i], x[i], y[i], 16);
+    }
+
+    for (unsigned s = 0; s < 8; ++s)
+    {
+        gen.begin_sample(s);
+
+        for (int i = 0; i < Size; ++i)
+        {
+            ref[i].begin_sample(s);
+        }
+
+        for (int d = 0; d < 10; ++d)
+        {
+            float_array values;
+            store(values, gen.next());
+
+            for (int i = 0; i < Size; ++i)
+            {
+                EXPECT_EQ(values[i], ref[i].next());
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test pcg_generator
+//
+
+TEST(RandomGenerator, PCG)
+{
+    test_pcg_lanes<simd::float4>();
+    test_pcg_lanes<simd::float8>();
+    test_pcg_lanes<simd::float16>();
+
+    // Different seeds generate different sequences
+    pcg_generator<float> gen1(0);
+    pcg_generator<float> gen2(1);
+
+    int num_equal = 0;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        num_equal += gen1.next() == gen2.next();
+    }
+
+    EXPECT_LT(num_equal, 5);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test generator selection with make_generator()
+//
+
+TEST(RandomGenerator, MakeGenerator)
+{
+    pixel_sampler::jittered_blend_type sampler;
+
+    auto gen1 = make_generator(float{}, sampler, 0U);
+    auto gen2 = make_generator<pcg_generator>(float{}, sampler, 0U);
+    auto gen3 = make_generator(simd::float4{}, sampler, visionaray::array<unsigned, 4>{{ 0U, 1U, 2U, 3U }});
+
+    static_assert(std::is_same<decltype(gen1), random_generator<float>>::value, "Type mismatch");
+    static_assert(std::is_same<decltype(gen2), pcg_generator<float>>::value, "Type mismatch");
+    static_assert(std::is_same<decltype(gen3), random_generator<simd::float4>>::value, "Type mismatch");
+
+    EXPECT_GE(gen1.next(), 0.0f);
+    EXPECT_GE(gen2.next(), 0.0f);
+    EXPECT_TRUE(all(gen3.next() >= simd::float4(0.0f)));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test low-discrepancy generators
+//
+
+TEST(RandomGenerator, Sobol)
+{
+    for (unsigned seed = 0; seed < 4; ++seed)
+    {
+        // Pairs of dimensions are stratified
+        for (unsigned dim = 0; dim <= 6; dim += 2)
+        {
+            test_stratified_2d(sobol_generator<float>(seed), dim, 256, 1);
+            test_stratified_2d(sobol_generator<float>(seed), dim, 256, 16);
+            test_stratified_2d(sobol_generator<float>(seed), dim, 256, 256);
+        }
+    }
+
+    // Different seeds are scrambled differently
+    sobol_generator<float> gen1(0);
+    sobol_generator<float> gen2(1);
+
+    EXPECT_NE(gen1.next(), gen2.next());
+
+    test_low_discrepancy_lanes<sobol_generator, simd::float4>();
+    test_low_discrepancy_lanes<sobol_generator, simd::float8>();
+}
+
+TEST(RandomGenerator, Halton)
+{
+    for (unsigned seed = 0; seed < 4; ++seed)
+    {
+        // Dimensions are stratified in 1D, random shifts do not change that
+        test_stratified_2d(halton_generator<float>(seed), 0, 256, 1);
+
+        test_stratified_2d(halton_generator<float>(seed), 1, 243, 1);
+    }
+
+    test_low_discrepancy_lanes<halton_generator, simd::float4>();
+    test_low_discrepancy_lanes<halton_generator, simd::float8>();
+}
+
+TEST(RandomGenerator, BlueNoise)
+{
+    // Tile contains each rank once
+    std::vector<int> ranks(detail::BlueNoiseTileSize * detail::BlueNoiseTileSize, 0);
+
+    for (int y = 0; y < detail::BlueNoiseTileSize; ++y)
+    {
+        for (int x = 0; x < detail::BlueNoiseTileSize; ++x)
+        {
+            ++ranks[detail::blue_noise_rank(x, y)];
+        }
+    }
+
+    for (int r : ranks)
+    {
+        EXPECT_EQ(r, 1);
+    }
+
+    // Tile wraps around
+    EXPECT_EQ(detail::blue_noise_rank(-1, -1), detail::blue_noise_rank(63, 63));
+    EXPECT_EQ(detail::blue_noise_rank(64, 130), detail::blue_noise_rank(0, 2));
+
+    // In each sample and dimension, the pixels of a tile are stratified
+    for (unsigned s = 0; s < 4; ++s)
+    {
+        for (unsigned d = 0; d < 4; ++d)
+        {
+            std::vector<int> cells(detail::BlueNoiseTileSize * detail::BlueNoiseTileSize, 0);
+
+            for (int y = 0; y < detail::BlueNoiseTileSize; ++y)
+            {
+                for (int x = 0; x < detail::BlueNoiseTileSize; ++x)
+                {
+                    blue_noise_generator<float> gen(x + 7, y + 13);
+                    gen.begin_sample(s);
+
+                    for (unsigned i = 0; i < d; ++i)
+                    {
+                        gen.next();
+                    }
+
+                    ++cells[gen.next_uint() >> 20];
+                }
+            }
+
+            for (int c : cells)
+            {
+                EXPECT_EQ(c, 1);
+            }
+        }
+    }
+
+    test_low_discrepancy_lanes<blue_noise_generator, simd::float4>();
+    test_low_discrepancy_lanes<blue_noise_generator, simd::float8>();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that pixel generators continue the sequence in successive frames
+//
+
+TEST(RandomGenerator, MakePixelGenerator)
+{
+    pixel_sampler::sobol_blend_type sampler;
+    sampler.spp = 4;
+
+    auto gen0 = make_pixel_generator(float{}, sampler, 3, 5, 64, 0);
+    auto gen1 = make_pixel_generator(float{}, sampler, 3, 5, 64, 1);
+
+    static_assert(std::is_same<decltype(gen0), sobol_generator<float>>::value, "Type mismatch");
+
+    // Frame 1 starts with sample 4
+    gen0.begin_sample(4);
+    gen1.begin_sample(0);
+
+    for (int d = 0; d < 8; ++d)
+    {
+        EXPECT_EQ(gen0.next(), gen1.next());
+    }
+
+    // Jittered generators are reseeded per frame
+    pixel_sampler::jittered_blend_type jittered;
+
+    auto gen2 = make_pixel_generator(float{}, jittered, 3, 5, 64, 0);
+
+    static_assert(std::is_same<decltype(gen2), random_generator<float>>::value, "Type mismatch");
+
+    auto gen3 = make_pixel_generator(simd::float4{}, pixel_sampler::halton_blend_type{}, simd::int4(0), simd::int4(0), 64, 0);
+    auto gen4 = make_pixel_generator(simd::float4{}, pixel_sampler::blue_noise_blend_type{}, simd::int4(0), simd::int4(0), 64, 0);
+
+    static_assert(std::is_same<decltype(gen3), halton_generator<simd::float4>>::value, "Type mismatch");
+    static_assert(std::is_same<decltype(gen4), blue_noise_generator<simd::float4>>::value, "Type mismatch");
+
+    EXPECT_TRUE(all(gen3.next() >= simd::float4(0.0f)));
+    EXPECT_TRUE(all(gen4.next() < simd::float4(1.0f)));
+}
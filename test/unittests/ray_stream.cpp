@@ -0,0 +1,141 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <vector>
+
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/ray_stream.h>
+
+#include <gtest/gtest.h>
+
+#include "bvh/random_scene.h"
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+// Incoherent rays, like secondary rays of a path tracer. Some rays have
+// a limited extent, a number that is no multiple of the packet size.
+static aligned_vector<ray> make_rays(size_t count)
+{
+    aligned_vector<ray> rays(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 ori = rnd_vec3(100.0f);
+        vec3 dir(rnd() * 2.0f - 1.0f, rnd() * 2.0f - 1.0f, rnd() * 2.0f - 1.0f);
+
+        rays[i] = ray(ori, normalize(dir));
+
+        if (i % 3 == 0)
+        {
+            rays[i].tmax = rnd() * 20.0f;
+        }
+    }
+
+    return rays;
+}
+
+template <typename FloatT, typename BVH>
+static void test_ray_stream(BVH const& tree, aligned_vector<ray> const& rays)
+{
+    using HR = decltype(closest_hit(ray{}, &tree, &tree + 1));
+
+    thread_pool pool(4);
+    default_intersector isect;
+
+    basic_ray_stream<FloatT> stream;
+
+    for (int sorting = 0; sorting < 2; ++sorting)
+    {
+        stream.enable_sorting(sorting == 1);
+
+        // Closest hit, same results as with single rays (up to rounding,
+        // the SIMD triangle test computes the reciprocal differently)
+
+        std::vector<HR> hit_records(rays.size());
+        stream.closest_hit(rays.data(), rays.size(), &tree, &tree + 1, hit_records.data(), isect, pool);
+
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            auto ref = closest_hit(rays[i], &tree, &tree + 1);
+
+            EXPECT_EQ(hit_records[i].hit, ref.hit);
+
+            if (ref.hit)
+            {
+                EXPECT_NEAR(hit_records[i].t, ref.t, ref.t * 1e-5f);
+                EXPECT_EQ(hit_records[i].prim_id, ref.prim_id);
+            }
+        }
+
+        // Order is a permutation of the input rays
+        auto order = stream.order();
+        ASSERT_EQ(order.size(), rays.size());
+        std::sort(order.begin(), order.end());
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            EXPECT_EQ(order[i], i);
+        }
+
+        // Any hit, serial
+        std::vector<HR> occluded(rays.size());
+        stream.any_hit(rays.data(), rays.size(), &tree, &tree + 1, occluded.data());
+
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            EXPECT_EQ(occluded[i].hit, hit_records[i].hit);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test basic_ray_stream
+//
+
+TEST(RayStream, Traverse)
+{
+    auto triangles = make_random_triangles(5000, 100.0f, 5.0f);
+    auto rays = make_rays(10001);
+
+    binned_sah_builder builder;
+
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto tree_ref = tree.ref();
+
+    test_ray_stream<simd::float4>(tree_ref, rays);
+    test_ray_stream<simd::float8>(tree_ref, rays);
+
+    auto tree2 = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    test_ray_stream<simd::float4>(tree2, rays);
+
+    // Sorted packets are coherent, the rays in the first packet share their
+    // direction octant
+    ray_stream stream;
+    std::vector<decltype(closest_hit(ray{}, &tree_ref, &tree_ref + 1))> hit_records(rays.size());
+    stream.closest_hit(rays.data(), rays.size(), &tree_ref, &tree_ref + 1, hit_records.data());
+
+    auto octant = [](ray const& r)
+    {
+        return (r.dir.x < 0.0f ? 1 : 0) | (r.dir.y < 0.0f ? 2 : 0) | (r.dir.z < 0.0f ? 4 : 0);
+    };
+
+    for (int i = 1; i < ray_stream::PacketSize; ++i)
+    {
+        EXPECT_EQ(octant(rays[stream.order()[i]]), octant(rays[stream.order()[0]]));
+    }
+
+    // Empty streams are fine
+    stream.closest_hit(rays.data(), 0, &tree_ref, &tree_ref + 1, hit_records.data());
+}
@@ -94,6 +94,13 @@ TEST(VariantTest, General)
     EXPECT_TRUE( apply_visitor( is_double_visitor(), var_id1 ) );
 
 
+    // index of the stored type
+
+    EXPECT_EQ( var_id1.which(), 1U );
+    var_id1 = 23;
+    EXPECT_EQ( var_id1.which(), 0U );
+
+
     // struct with some members
 
     some_struct<double> sstruct;
@@ -0,0 +1,243 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/render_target.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/wavefront_pathtracer.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+using material_t = generic_material<emissive<float>, matte<float>, plastic<float>>;
+
+// RGBA32F render target in host memory
+struct test_rt
+{
+    using ref_type = render_target_ref<PF_RGBA32F>;
+
+    test_rt(int w, int h)
+        : w_(w)
+        , h_(h)
+        , color_(static_cast<size_t>(w) * h, vec4(0.0f))
+    {
+    }
+
+    int width() const { return w_; }
+    int height() const { return h_; }
+
+    void begin_frame() {}
+    void end_frame() {}
+
+    ref_type ref()
+    {
+        return { color_.data(), nullptr, w_, h_ };
+    }
+
+    vec4 const& color(int x, int y) const
+    {
+        return color_[y * w_ + x];
+    }
+
+    vec4 mean_color() const
+    {
+        vec4 result(0.0f);
+
+        for (auto const& c : color_)
+        {
+            result += c;
+        }
+
+        return result / static_cast<float>(color_.size());
+    }
+
+    int w_;
+    int h_;
+    aligned_vector<vec4> color_;
+};
+
+// Quad in the plane z = const, made up of two triangles
+static void add_quad(
+        aligned_vector<triangle_t>& triangles,
+        vec3 const&                 v1,
+        vec3 const&                 e1,
+        vec3 const&                 e2,
+        unsigned                    geom_id
+        )
+{
+    triangle_t t1(v1, e1, e2);
+    triangle_t t2(v1 + e1 + e2, -e1, -e2);
+
+    t1.prim_id = static_cast<unsigned>(triangles.size());
+    t1.geom_id = geom_id;
+    triangles.push_back(t1);
+
+    t2.prim_id = static_cast<unsigned>(triangles.size());
+    t2.geom_id = geom_id;
+    triangles.push_back(t2);
+}
+
+static pinhole_camera make_camera(int width, int height)
+{
+    pinhole_camera cam;
+    cam.perspective(45.0f * constants::degrees_to_radians<float>(), 1.0f, 0.001f, 1000.0f);
+    cam.set_viewport(0, 0, width, height);
+    cam.look_at(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    return cam;
+}
+
+static pixel_sampler::jittered_blend_type make_pixel_sampler(unsigned spp)
+{
+    pixel_sampler::jittered_blend_type ps;
+    ps.spp = spp;
+    ps.sfactor = 1.0f;
+    ps.dfactor = 0.0f;
+    return ps;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Primary rays that hit an emitter return its radiance, the other ones the background
+//
+
+TEST(WavefrontPathtracer, Emissive)
+{
+    aligned_vector<triangle_t> triangles;
+    add_quad(triangles, vec3(-0.5f, -0.5f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), 0);
+
+    binned_sah_builder builder;
+    auto bvh = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    emissive<float> em;
+    em.ce() = from_rgb(vec3(1.0f, 0.5f, 0.25f));
+    em.ls() = 1.0f;
+
+    aligned_vector<material_t> materials;
+    materials.push_back(em);
+
+    auto bvh_ref = bvh.ref();
+
+    auto kparams = make_kernel_params(
+            &bvh_ref,
+            &bvh_ref + 1,
+            materials.data(),
+            5,
+            1E-3f,
+            vec4(0.0f, 0.0f, 1.0f, 1.0f),
+            vec4(0.0f)
+            );
+
+    int width = 32;
+    int height = 32;
+
+    thread_pool pool(4);
+    test_rt rt(width, height);
+    auto cam = make_camera(width, height);
+
+    pathtracing::wavefront<decltype(kparams)> wf(kparams);
+    wf.frame(make_pixel_sampler(1), cam, rt, 0, pool);
+
+    vec4 center = rt.color(width / 2, height / 2);
+    EXPECT_FLOAT_EQ(center.x, 1.0f);
+    EXPECT_FLOAT_EQ(center.y, 0.5f);
+    EXPECT_FLOAT_EQ(center.z, 0.25f);
+
+    vec4 corner = rt.color(0, 0);
+    EXPECT_FLOAT_EQ(corner.x, 0.0f);
+    EXPECT_FLOAT_EQ(corner.y, 0.0f);
+    EXPECT_FLOAT_EQ(corner.z, 1.0f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Wavefront and per-packet path tracer converge to the same image
+//
+
+TEST(WavefrontPathtracer, MatchesKernel)
+{
+    aligned_vector<triangle_t> triangles;
+
+    // Matte back wall, plastic floor, emissive ceiling
+    add_quad(triangles, vec3(-2.0f, -1.0f, -1.0f), vec3(4.0f, 0.0f, 0.0f), vec3(0.0f, 2.0f, 0.0f), 1);
+    add_quad(triangles, vec3(-2.0f, -1.0f,  2.0f), vec3(4.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -3.0f), 2);
+    add_quad(triangles, vec3(-2.0f,  1.0f, -1.0f), vec3(4.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 3.0f), 0);
+
+    binned_sah_builder builder;
+    auto bvh = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    emissive<float> em;
+    em.ce() = from_rgb(vec3(1.0f));
+    em.ls() = 1.0f;
+
+    matte<float> ma;
+    ma.cd() = from_rgb(vec3(0.8f, 0.4f, 0.2f));
+    ma.kd() = 1.0f;
+
+    plastic<float> pl;
+    pl.cd() = from_rgb(vec3(0.2f, 0.6f, 0.8f));
+    pl.kd() = 1.0f;
+    pl.cs() = from_rgb(vec3(1.0f));
+    pl.ks() = 0.5f;
+    pl.specular_exp() = 32.0f;
+
+    aligned_vector<material_t> materials;
+    materials.push_back(em);
+    materials.push_back(ma);
+    materials.push_back(pl);
+
+    auto bvh_ref = bvh.ref();
+
+    auto kparams = make_kernel_params(
+            &bvh_ref,
+            &bvh_ref + 1,
+            materials.data(),
+            5,
+            1E-3f,
+            vec4(0.0f),
+            vec4(0.5f, 0.5f, 0.5f, 1.0f)
+            );
+
+    int width = 32;
+    int height = 32;
+    unsigned spp = 64;
+
+    auto cam = make_camera(width, height);
+
+    test_rt wavefront_rt(width, height);
+    test_rt kernel_rt(width, height);
+
+    thread_pool pool(4);
+    pathtracing::wavefront<decltype(kparams)> wf(kparams);
+    wf.frame(make_pixel_sampler(spp), cam, wavefront_rt, 0, pool);
+
+    tiled_sched<basic_ray<float>> sched(4);
+    sched.frame(
+            pathtracing::kernel<decltype(kparams)>({kparams}),
+            make_sched_params(make_pixel_sampler(spp), cam, kernel_rt)
+            );
+
+    vec4 expected = kernel_rt.mean_color();
+    vec4 actual = wavefront_rt.mean_color();
+
+    EXPECT_GT(expected.x, 0.1f);
+
+    EXPECT_NEAR(actual.x, expected.x, 0.02f * expected.x);
+    EXPECT_NEAR(actual.y, expected.y, 0.02f * expected.y);
+    EXPECT_NEAR(actual.z, expected.z, 0.02f * expected.z);
+}